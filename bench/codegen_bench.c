@@ -0,0 +1,318 @@
+/*
+ * Code Generation Benchmark
+ * CST-405 Compiler Design
+ *
+ * Compiles each kernel in bench/kernels at -O0 through -O3, runs it in
+ * cminus-sim and checks its output against the kernel's .out file. The
+ * dynamic machine instruction count, loads plus stores and static code
+ * size of every run are compared with a JSON baseline; the run fails if
+ * a kernel gives the wrong output, any count grows past the threshold, or
+ * an optimized build executes more instructions than the -O0 one. A
+ * baseline is not written while any of those hold but the growth.
+ *
+ * Usage: codegen_bench [options]
+ *   -u            write the counts as the new baseline
+ *   -t <percent>  allowed growth over the baseline (default 1)
+ *   -b <file>     baseline (default bench/codegen_baseline.json)
+ *   -k <dir>      kernels (default bench/kernels)
+ *   -c <path>     compiler (default ./cminus)
+ *   -s <path>     simulator (default ./cminus-sim)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define LEVEL_COUNT 4
+#define MAX_STEPS "1000000000"
+
+static const char *kernels[] = {
+    "sieve", "matmul", "quicksort", "binsearch", "fibonacci", "gcd", "bubble", "selection"
+};
+#define KERNEL_COUNT (int)(sizeof(kernels) / sizeof(kernels[0]))
+
+static char *levels[LEVEL_COUNT] = { "-O0", "-O1", "-O2", "-O3" };
+
+/* What one run of a kernel cost */
+typedef struct {
+    long long instructions;    /* Machine instructions executed */
+    long long memory_ops;      /* Loads plus stores executed */
+    long long code_words;      /* Machine words of code */
+} Counts;
+
+/* A baseline entry */
+typedef struct {
+    char kernel[32];
+    char level[8];
+    Counts counts;
+} BaselineEntry;
+
+/* Run a program with standard output and error on descriptors (-1 keeps
+ * the benchmark's own); returns its exit status */
+static int run_program(char *const argv[], int output, int errors) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid == 0) {
+        if (output >= 0) dup2(output, STDOUT_FILENO);
+        if (errors >= 0) dup2(errors, STDERR_FILENO);
+        execv(argv[0], argv);
+        fprintf(stderr, "Cannot run %s\n", argv[0]);
+        _exit(127);
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0) {
+        perror("waitpid");
+        exit(1);
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+/* Whole contents of a file, or NULL */
+static char *read_file(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *text = (char *)malloc(size + 1);
+    if (text == NULL || fread(text, 1, size, file) != (size_t)size) {
+        fprintf(stderr, "Cannot read %s\n", filename);
+        exit(1);
+    }
+    text[size] = '\0';
+    fclose(file);
+    return text;
+}
+
+static int write_file(const char *filename, const char *text) {
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL) return -1;
+    fputs(text, file);
+    return fclose(file);
+}
+
+/* A number from cminus-sim's --json line */
+static long long json_number(const char *stats, const char *key) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+    const char *at = strstr(stats, pattern);
+    return at ? strtoll(at + strlen(pattern), NULL, 10) : -1;
+}
+
+/* Entries of a baseline file, one kernel and level per line */
+static int load_baseline(const char *filename, BaselineEntry **entries) {
+    *entries = NULL;
+    char *text = read_file(filename);
+    if (text == NULL) return 0;
+
+    int count = 0;
+    *entries = (BaselineEntry *)calloc(KERNEL_COUNT * LEVEL_COUNT + 1, sizeof(BaselineEntry));
+    for (char *line = strtok(text, "\n"); line; line = strtok(NULL, "\n")) {
+        BaselineEntry entry;
+        if (count < KERNEL_COUNT * LEVEL_COUNT &&
+            sscanf(line, " {\"kernel\": \"%31[^\"]\", \"level\": \"%7[^\"]\", \"instructions\": %lld, "
+                         "\"memory_ops\": %lld, \"code_words\": %lld",
+                   entry.kernel, entry.level, &entry.counts.instructions,
+                   &entry.counts.memory_ops, &entry.counts.code_words) == 5) {
+            (*entries)[count++] = entry;
+        }
+    }
+    free(text);
+    return count;
+}
+
+static Counts *find_baseline(BaselineEntry *entries, int count, const char *kernel, const char *level) {
+    for (int e = 0; e < count; e++) {
+        if (strcmp(entries[e].kernel, kernel) == 0 && strcmp(entries[e].level, level) == 0) {
+            return &entries[e].counts;
+        }
+    }
+    return NULL;
+}
+
+static int save_baseline(const char *filename, Counts counts[KERNEL_COUNT][LEVEL_COUNT]) {
+    FILE *file = fopen(filename, "w");
+    if (file == NULL) return -1;
+    fprintf(file, "{\n  \"kernels\": [\n");
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        for (int l = 0; l < LEVEL_COUNT; l++) {
+            fprintf(file, "    {\"kernel\": \"%s\", \"level\": \"%s\", \"instructions\": %lld, "
+                          "\"memory_ops\": %lld, \"code_words\": %lld}%s\n",
+                    kernels[k], levels[l], counts[k][l].instructions, counts[k][l].memory_ops,
+                    counts[k][l].code_words,
+                    (k == KERNEL_COUNT - 1 && l == LEVEL_COUNT - 1) ? "" : ",");
+        }
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file);
+}
+
+/* Print a count and its change; returns 1 if it grew past the threshold */
+static int report_count(long long value, const long long *baseline, double threshold) {
+    if (baseline == NULL || *baseline <= 0) {
+        printf(" %12lld %8s", value, "");
+        return 0;
+    }
+    double change = 100.0 * (value - *baseline) / *baseline;
+    printf(" %12lld %+7.1f%%", value, change);
+    return change > threshold;
+}
+
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [-u] [-t percent] [-b baseline] [-k kernels] [-c compiler]\n"
+                    "       [-s simulator]\n", program);
+}
+
+int main(int argc, char *argv[]) {
+    const char *baseline_name = "bench/codegen_baseline.json";
+    const char *kernel_dir = "bench/kernels";
+    char *compiler = "./cminus";
+    char *simulator = "./cminus-sim";
+    double threshold = 1.0;
+    int update = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "ut:b:k:c:s:h")) != -1) {
+        switch (opt) {
+            case 'u': update = 1; break;
+            case 't': threshold = atof(optarg); break;
+            case 'b': baseline_name = optarg; break;
+            case 'k': kernel_dir = optarg; break;
+            case 'c': compiler = optarg; break;
+            case 's': simulator = optarg; break;
+            case 'h':
+                usage(argv[0]);
+                return 0;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    BaselineEntry *baseline;
+    int baseline_count = load_baseline(baseline_name, &baseline);
+
+    /* The compiler writes its assembly next to the source, so kernels
+     * are compiled from a scratch directory */
+    char directory[] = "/tmp/codegen_bench_XXXXXX";
+    if (mkdtemp(directory) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    char source[64], assembly[64], output[64], stats[64];
+    snprintf(source, sizeof(source), "%s/kernel.cm", directory);
+    snprintf(assembly, sizeof(assembly), "%s/kernel.s", directory);
+    snprintf(output, sizeof(output), "%s/output.txt", directory);
+    snprintf(stats, sizeof(stats), "%s/stats.json", directory);
+    int null_fd = open("/dev/null", O_WRONLY);
+
+    printf("Code generation benchmark\n");
+    printf("  Compiler: %s, simulator: %s\n", compiler, simulator);
+    printf("  Baseline: %s (%s), threshold %.1f%%\n\n", baseline_name,
+           baseline_count ? "loaded" : "none", threshold);
+    printf("%-10s %5s %12s %8s %12s %8s %12s %8s  %s\n", "Kernel", "Level",
+           "Instructions", "change", "Memory ops", "change", "Code words", "change", "Status");
+
+    static Counts counts[KERNEL_COUNT][LEVEL_COUNT];
+    int failures = 0, regressions = 0, slower = 0;
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s.cm", kernel_dir, kernels[k]);
+        char *program = read_file(path);
+        snprintf(path, sizeof(path), "%s/%s.out", kernel_dir, kernels[k]);
+        char *expected = read_file(path);
+        if (program == NULL || expected == NULL || write_file(source, program) != 0) {
+            fprintf(stderr, "Cannot set up kernel %s from %s\n", kernels[k], kernel_dir);
+            return 1;
+        }
+
+        for (int l = 0; l < LEVEL_COUNT; l++) {
+            const char *status = "ok";
+            char *compile[] = { compiler, "-q", levels[l], source, NULL };
+            unlink(assembly);
+            if (run_program(compile, null_fd, null_fd) != 0) {
+                status = "FAILED (compile)";
+            } else {
+                int out_fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                int stats_fd = open(stats, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                char *run[] = { simulator, "-j", "-m", MAX_STEPS, assembly, NULL };
+                int result = run_program(run, out_fd, stats_fd);
+                close(out_fd);
+                close(stats_fd);
+
+                char *printed = read_file(output);
+                char *numbers = read_file(stats);
+                counts[k][l].instructions = json_number(numbers, "machine_instructions");
+                counts[k][l].memory_ops = json_number(numbers, "loads") + json_number(numbers, "stores");
+                counts[k][l].code_words = json_number(numbers, "code_words");
+                if (result != 0) {
+                    status = "FAILED (run)";
+                } else if (strcmp(printed, expected) != 0) {
+                    status = "FAILED (output)";
+                }
+                free(printed);
+                free(numbers);
+            }
+
+            Counts *base = find_baseline(baseline, baseline_count, kernels[k], levels[l]);
+            printf("%-10s %5s", kernels[k], levels[l]);
+            int grew = report_count(counts[k][l].instructions, base ? &base->instructions : NULL, threshold);
+            grew |= report_count(counts[k][l].memory_ops, base ? &base->memory_ops : NULL, threshold);
+            grew |= report_count(counts[k][l].code_words, base ? &base->code_words : NULL, threshold);
+            if (strcmp(status, "ok") != 0) {
+                failures++;
+            } else if (l > 0 && counts[k][l].instructions > counts[k][0].instructions) {
+                status = "SLOWER THAN -O0";
+                slower++;
+            } else if (base == NULL) {
+                status = "new";
+            } else if (grew) {
+                status = "REGRESSED";
+                regressions++;
+            }
+            printf("  %s\n", status);
+            fflush(stdout);
+        }
+        free(program);
+        free(expected);
+    }
+
+    unlink(source);
+    unlink(assembly);
+    unlink(output);
+    unlink(stats);
+    rmdir(directory);
+    close(null_fd);
+    free(baseline);
+
+    printf("\n");
+    if (failures > 0) {
+        printf("%d run(s) failed\n", failures);
+        return 1;
+    }
+    if (slower > 0) {
+        printf("%d optimized run(s) executed more instructions than -O0\n", slower);
+        return 1;
+    }
+    if (update) {
+        if (save_baseline(baseline_name, counts) != 0) {
+            perror(baseline_name);
+            return 1;
+        }
+        printf("Baseline written to %s\n", baseline_name);
+        return 0;
+    }
+    if (regressions > 0) {
+        printf("%d run(s) regressed more than %.1f%% over the baseline\n", regressions, threshold);
+        return 1;
+    }
+    printf("All kernels correct, none regressed\n");
+    return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ * Compile Throughput Benchmark
+ * CST-405 Compiler Design
+ *
+ * Generates synthetic programs of 1K, 10K, 100K and 1M lines with
+ * gen_program and compiles each at -O0, -O1 and -O2. Reports lines per
+ * second and the compiler's peak resident set size for every size and
+ * level, along with the wall time of each phase taken from the
+ * compiler's --time-report=json output, giving a scaling curve per phase.
+ *
+ * Usage: compile_bench [max_lines] [compiler] [generator]
+ *   max_lines defaults to 1000000; sizes above it are skipped.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define PHASE_COUNT 5
+
+static const char *phase_names[PHASE_COUNT] = {
+    "parse", "semantic analysis", "tac generation", "optimization", "mips emission"
+};
+static const char *phase_labels[PHASE_COUNT] = {
+    "parse", "semantic", "tac", "optimize", "mips"
+};
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Run a program with its standard output on a descriptor; returns its exit status */
+static int run_program(char *const argv[], int output, struct rusage *usage) {
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid == 0) {
+        dup2(output, STDOUT_FILENO);
+        close(output);
+        execv(argv[0], argv);
+        fprintf(stderr, "Cannot run %s\n", argv[0]);
+        _exit(127);
+    }
+
+    int status;
+    if (wait4(pid, &status, 0, usage) < 0) {
+        perror("wait4");
+        exit(1);
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+/* Run the compiler, collecting its standard output into a buffer */
+static int run_compiler(char *const argv[], char **report, struct rusage *usage) {
+    char template[] = "/tmp/compile_bench_report_XXXXXX";
+    int fd = mkstemp(template);
+    if (fd < 0) {
+        perror("mkstemp");
+        exit(1);
+    }
+    unlink(template);
+
+    int status = run_program(argv, fd, usage);
+
+    off_t size = lseek(fd, 0, SEEK_END);
+    *report = (char *)malloc(size + 1);
+    if (*report == NULL || pread(fd, *report, size, 0) != size) {
+        fprintf(stderr, "Cannot read compiler report\n");
+        exit(1);
+    }
+    (*report)[size] = '\0';
+    close(fd);
+    return status;
+}
+
+/* Wall milliseconds of a top-level phase in a --time-report=json line */
+static double phase_wall_ms(const char *report, const char *name) {
+    char key[96];
+    snprintf(key, sizeof(key), "\"name\": \"%s\", \"depth\": 0,", name);
+    const char *at = strstr(report, key);
+    if (at == NULL) return 0;
+    at = strstr(at, "\"wall_ms\": ");
+    return at ? strtod(at + strlen("\"wall_ms\": "), NULL) : 0;
+}
+
+static long count_lines(const char *filename) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) return 0;
+    long lines = 0;
+    int c;
+    while ((c = getc(file)) != EOF) {
+        if (c == '\n') lines++;
+    }
+    fclose(file);
+    return lines;
+}
+
+int main(int argc, char *argv[]) {
+    long max_lines = (argc > 1) ? atol(argv[1]) : 1000000;
+    char *compiler = (argc > 2) ? argv[2] : "./cminus";
+    char *generator = (argc > 3) ? argv[3] : "./bench/gen_program";
+    static const long sizes[] = { 1000, 10000, 100000, 1000000 };
+    static char *levels[] = { "-O0", "-O1", "-O2" };
+
+    char directory[] = "/tmp/compile_bench_XXXXXX";
+    if (mkdtemp(directory) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    char source[64], assembly[64];
+    snprintf(source, sizeof(source), "%s/program.cm", directory);
+    snprintf(assembly, sizeof(assembly), "%s/program.s", directory);
+
+    printf("Compile throughput benchmark\n");
+    printf("  Compiler: %s, generator: %s\n\n", compiler, generator);
+    printf("%9s %5s %9s %11s %12s", "Lines", "Level", "Wall s", "Lines/s", "Peak RSS MB");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        printf(" %9s", phase_labels[p]);
+    }
+    printf("   (phase ms)\n");
+
+    int status = 0;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]) && sizes[s] <= max_lines; s++) {
+        char target[32];
+        snprintf(target, sizeof(target), "%ld", sizes[s]);
+        char *generate[] = { generator, "-L", target, NULL };
+        int fd = open(source, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        struct rusage usage;
+        if (fd < 0 || run_program(generate, fd, &usage) != 0) {
+            fprintf(stderr, "Cannot generate a %ld-line program\n", sizes[s]);
+            return 1;
+        }
+        close(fd);
+        long lines = count_lines(source);
+
+        for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+            char *compile[] = { compiler, "-q", "--time-report=json", levels[l], source, NULL };
+            char *report;
+            double start = now_seconds();
+            int result = run_compiler(compile, &report, &usage);
+            double seconds = now_seconds() - start;
+
+            printf("%9ld %5s %9.3f %11.0f %12.1f", lines, levels[l], seconds,
+                   lines / seconds, usage.ru_maxrss / 1024.0);
+            for (int p = 0; p < PHASE_COUNT; p++) {
+                printf(" %9.1f", phase_wall_ms(report, phase_names[p]));
+            }
+            if (result != 0) {
+                printf("   FAILED (exit %d)", result);
+                status = 1;
+            }
+            printf("\n");
+            fflush(stdout);
+            free(report);
+        }
+    }
+
+    unlink(source);
+    unlink(assembly);
+    rmdir(directory);
+    return status;
+}
@@ -0,0 +1,381 @@
+/*
+ * Synthetic C-Minus Program Generator
+ * CST-405 Compiler Design
+ *
+ * Writes a valid C-Minus program of any size for scaling and throughput
+ * measurements. Every function takes two scalars and an array, mixes
+ * straight-line arithmetic, conditionals, nested counted loops, array
+ * traffic and calls to its neighbour, and returns an accumulator; main
+ * calls each function once and outputs the running total. Programs always
+ * terminate, never divide by zero and never index out of bounds, so they
+ * can be run as well as compiled.
+ *
+ * Usage: gen_program [options] > program.cm
+ *   -f <n>  functions (default 10)
+ *   -s <n>  statements per function (default 20)
+ *   -d <n>  expression depth (default 3)
+ *   -l <n>  loop nesting (default 2)
+ *   -a <n>  percent of statements that use arrays (default 20)
+ *   -t <n>  temporaries kept live across each block (default 4)
+ *   -L <n>  add functions until the program has about n lines
+ *   -r <n>  random seed (default 1)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define ARRAY_SIZE 16          /* Elements in every array */
+#define LOOP_TRIPS 4           /* Iterations of every generated loop */
+#define CALL_CHAIN 8           /* Longest run of functions calling the previous one */
+
+typedef struct {
+    int functions;
+    int statements;
+    int depth;
+    int loops;
+    int arrays;
+    int temps;
+    long lines;
+} Knobs;
+
+static unsigned int rng_state = 1;
+static long lines_written = 0;
+static FILE *out;                  /* Where the program text goes */
+static int loops_used;             /* Loop counters the current function needs */
+
+/* Deterministic pseudo-random numbers */
+static unsigned int next_random(void) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return (rng_state >> 8) & 0xffffff;
+}
+
+static int chance(int percent) {
+    return (int)(next_random() % 100) < percent;
+}
+
+/* Start a line at an indentation level */
+static void indent(int level) {
+    fprintf(out, "%*s", 4 * level, "");
+}
+
+static void end_line(void) {
+    fputc('\n', out);
+    lines_written++;
+}
+
+/* A leaf operand: a parameter, a local, an array element or a constant */
+static void emit_leaf(const Knobs *knobs, int loop_level) {
+    switch (next_random() % 6) {
+        case 0: fprintf(out, "a"); break;
+        case 1: fprintf(out, "b"); break;
+        case 2: fprintf(out, "acc"); break;
+        case 3:
+            if (knobs->temps > 0) {
+                fprintf(out, "t%d", (int)(next_random() % knobs->temps));
+            } else {
+                fprintf(out, "a");
+            }
+            break;
+        case 4:
+            if (chance(knobs->arrays)) {
+                /* Loop counters never reach ARRAY_SIZE */
+                if (loop_level > 0 && chance(50)) {
+                    fprintf(out, "%s[i%d]", chance(50) ? "v" : "buf", loop_level - 1);
+                } else {
+                    fprintf(out, "%s[%d]", chance(50) ? "v" : "buf", (int)(next_random() % ARRAY_SIZE));
+                }
+                break;
+            }
+            /* fall through */
+        default:
+            fprintf(out, "%d", (int)(next_random() % 10));
+            break;
+    }
+}
+
+/* An expression tree of the given depth
+ *
+ * Multiplication and division only take a small constant on the right,
+ * so values grow slowly and no divisor is ever zero.
+ */
+static void emit_expression(const Knobs *knobs, int depth, int loop_level) {
+    if (depth <= 0) {
+        emit_leaf(knobs, loop_level);
+        return;
+    }
+
+    unsigned int shape = next_random() % 8;
+    if (shape < 5) {
+        fprintf(out, "(");
+        emit_expression(knobs, depth - 1, loop_level);
+        fprintf(out, shape < 3 ? " + " : " - ");
+        emit_expression(knobs, depth - 1, loop_level);
+        fprintf(out, ")");
+    } else {
+        fprintf(out, "(");
+        emit_expression(knobs, depth - 1, loop_level);
+        fprintf(out, shape == 7 ? " / %d)" : " * %d)", 2 + (int)(next_random() % 2));
+    }
+}
+
+/* Assign every temporary, then combine them so all are live at once */
+static void emit_block(const Knobs *knobs, int level, int loop_level) {
+    for (int t = 0; t < knobs->temps; t++) {
+        indent(level);
+        fprintf(out, "t%d = ", t);
+        emit_expression(knobs, knobs->depth, loop_level);
+        fprintf(out, ";");
+        end_line();
+    }
+    indent(level);
+    fprintf(out, "acc = acc");
+    for (int t = 0; t < knobs->temps; t++) {
+        fprintf(out, " %c t%d", (t % 2 == 0) ? '+' : '-', t);
+    }
+    fprintf(out, ";");
+    end_line();
+}
+
+/* One statement of a function body */
+static void emit_statement(const Knobs *knobs, int level, int loop_level) {
+    unsigned int kind = next_random() % 5;
+
+    if (kind == 0 && loop_level < knobs->loops) {
+        int counter = loop_level;
+        if (counter + 1 > loops_used) loops_used = counter + 1;
+        indent(level);
+        fprintf(out, "i%d = 0;", counter);
+        end_line();
+        indent(level);
+        fprintf(out, "while (i%d < %d) {", counter, LOOP_TRIPS);
+        end_line();
+        emit_statement(knobs, level + 1, loop_level + 1);
+        if (chance(knobs->arrays)) {
+            indent(level + 1);
+            fprintf(out, "buf[i%d] = ", counter);
+            emit_expression(knobs, knobs->depth, loop_level + 1);
+            fprintf(out, ";");
+            end_line();
+        }
+        indent(level + 1);
+        fprintf(out, "i%d = i%d + 1;", counter, counter);
+        end_line();
+        indent(level);
+        fprintf(out, "}");
+        end_line();
+    } else if (kind == 1) {
+        indent(level);
+        fprintf(out, "if (");
+        emit_expression(knobs, knobs->depth > 1 ? knobs->depth - 1 : 0, loop_level);
+        fprintf(out, " < ");
+        emit_expression(knobs, knobs->depth > 1 ? knobs->depth - 1 : 0, loop_level);
+        fprintf(out, ") {");
+        end_line();
+        emit_block(knobs, level + 1, loop_level);
+        indent(level);
+        fprintf(out, "} else {");
+        end_line();
+        indent(level + 1);
+        fprintf(out, "acc = acc - ");
+        emit_expression(knobs, knobs->depth, loop_level);
+        fprintf(out, ";");
+        end_line();
+        indent(level);
+        fprintf(out, "}");
+        end_line();
+    } else if (kind == 2 && chance(knobs->arrays)) {
+        indent(level);
+        fprintf(out, "buf[%d] = ", (int)(next_random() % ARRAY_SIZE));
+        emit_expression(knobs, knobs->depth, loop_level);
+        fprintf(out, ";");
+        end_line();
+    } else if (kind == 3) {
+        emit_block(knobs, level, loop_level);
+    } else {
+        indent(level);
+        fprintf(out, "acc = acc + ");
+        emit_expression(knobs, knobs->depth, loop_level);
+        fprintf(out, ";");
+        end_line();
+    }
+}
+
+/* One function; the body is written first so only counters it uses are declared */
+static void emit_function(const Knobs *knobs, int index) {
+    char *body;
+    size_t body_size;
+    FILE *program = out;
+    out = open_memstream(&body, &body_size);
+    if (out == NULL) {
+        perror("open_memstream");
+        exit(1);
+    }
+    loops_used = 1;
+
+    /* Temporaries and the local array start out defined */
+    indent(1);
+    fprintf(out, "acc = a + b;");
+    end_line();
+    for (int t = 0; t < knobs->temps; t++) {
+        indent(1);
+        fprintf(out, "t%d = b;", t);
+        end_line();
+    }
+    indent(1);
+    fprintf(out, "i0 = 0;");
+    end_line();
+    indent(1);
+    fprintf(out, "while (i0 < %d) {", ARRAY_SIZE);
+    end_line();
+    indent(2);
+    fprintf(out, "buf[i0] = v[i0] + i0;");
+    end_line();
+    indent(2);
+    fprintf(out, "i0 = i0 + 1;");
+    end_line();
+    indent(1);
+    fprintf(out, "}");
+    end_line();
+
+    for (int s = 0; s < knobs->statements; s++) {
+        emit_statement(knobs, 1, 0);
+    }
+
+    /* Call the previous function; chains stay short so runs stay cheap */
+    if (index % CALL_CHAIN != 0) {
+        indent(1);
+        fprintf(out, "acc = acc + f%d(acc, ", index - 1);
+        emit_expression(knobs, knobs->depth > 1 ? 1 : 0, 0);
+        fprintf(out, ", buf);");
+        end_line();
+    }
+
+    indent(1);
+    fprintf(out, "return acc;");
+    end_line();
+    fprintf(out, "}");
+    end_line();
+    end_line();
+    fclose(out);
+    out = program;
+
+    fprintf(out, "/* generated function %d */", index);
+    end_line();
+    fprintf(out, "int f%d(int a, int b, int v[]) {", index);
+    end_line();
+    indent(1);
+    fprintf(out, "int acc;");
+    end_line();
+    for (int l = 0; l < loops_used; l++) {
+        indent(1);
+        fprintf(out, "int i%d;", l);
+        end_line();
+    }
+    for (int t = 0; t < knobs->temps; t++) {
+        indent(1);
+        fprintf(out, "int t%d;", t);
+        end_line();
+    }
+    indent(1);
+    fprintf(out, "int buf[%d];", ARRAY_SIZE);
+    end_line();
+    fwrite(body, 1, body_size, out);
+    free(body);
+}
+
+static void emit_main(int functions) {
+    fprintf(out, "void main(void) {");
+    end_line();
+    indent(1);
+    fprintf(out, "int data[%d];", ARRAY_SIZE);
+    end_line();
+    indent(1);
+    fprintf(out, "int i;");
+    end_line();
+    indent(1);
+    fprintf(out, "int total;");
+    end_line();
+    indent(1);
+    fprintf(out, "i = 0;");
+    end_line();
+    indent(1);
+    fprintf(out, "while (i < %d) {", ARRAY_SIZE);
+    end_line();
+    indent(2);
+    fprintf(out, "data[i] = i * 3;");
+    end_line();
+    indent(2);
+    fprintf(out, "i = i + 1;");
+    end_line();
+    indent(1);
+    fprintf(out, "}");
+    end_line();
+    indent(1);
+    fprintf(out, "total = 0;");
+    end_line();
+    for (int f = 0; f < functions; f++) {
+        indent(1);
+        fprintf(out, "total = total + f%d(total, %d, data);", f, f);
+        end_line();
+    }
+    indent(1);
+    fprintf(out, "output(total);");
+    end_line();
+    fprintf(out, "}");
+    end_line();
+}
+
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [-f functions] [-s statements] [-d depth] [-l loops]\n"
+                    "       [-a array_percent] [-t temps] [-L lines] [-r seed]\n", program);
+}
+
+int main(int argc, char *argv[]) {
+    Knobs knobs = { 10, 20, 3, 2, 20, 4, 0 };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:s:d:l:a:t:L:r:h")) != -1) {
+        switch (opt) {
+            case 'f': knobs.functions = atoi(optarg); break;
+            case 's': knobs.statements = atoi(optarg); break;
+            case 'd': knobs.depth = atoi(optarg); break;
+            case 'l': knobs.loops = atoi(optarg); break;
+            case 'a': knobs.arrays = atoi(optarg); break;
+            case 't': knobs.temps = atoi(optarg); break;
+            case 'L': knobs.lines = atol(optarg); break;
+            case 'r': rng_state = (unsigned int)strtoul(optarg, NULL, 10); break;
+            case 'h':
+                usage(argv[0]);
+                return 0;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    if (knobs.functions < 0 || knobs.statements < 0 || knobs.depth < 0 ||
+        knobs.loops < 0 || knobs.temps < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    out = stdout;
+    fprintf(out, "/* Generated by gen_program */");
+    end_line();
+    end_line();
+
+    int functions = 0;
+    if (knobs.lines > 0) {
+        /* main takes about one line per function plus a few */
+        while (lines_written + functions + 12 < knobs.lines) {
+            emit_function(&knobs, functions++);
+        }
+    } else {
+        while (functions < knobs.functions) {
+            emit_function(&knobs, functions++);
+        }
+    }
+    emit_main(functions);
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+/*
+ * Identifier Interning Microbenchmark
+ * CST-405 Compiler Design
+ *
+ * Replays an identifier-heavy token stream through the three name lookups
+ * the compiler performs most often: the symbol table hash chains, the
+ * optimizer propagation tables and the MIPS register file. Each lookup is
+ * run once with copied strings compared by strcmp (the old scheme) and
+ * once with interned names compared by pointer.
+ *
+ * Usage: intern_bench [distinct_names] [references]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "context.h"
+
+#define TABLE_BUCKETS 211
+#define PROPAGATION_ENTRIES 100
+#define REGISTER_COUNT 16
+
+typedef struct Entry {
+    char *name;
+    struct Entry *next;
+} Entry;
+
+static unsigned int rng_state = 12345;
+
+/* Deterministic pseudo-random numbers */
+static unsigned int next_random(void) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return (rng_state >> 8) & 0xffffff;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* The symbol table's original PJW hash */
+static int pjw_hash(const char *name) {
+    unsigned int hash = 0;
+    while (*name) {
+        hash = (hash << 4) + *name++;
+        unsigned int g = hash & 0xf0000000;
+        if (g) {
+            hash ^= g >> 24;
+            hash &= ~g;
+        }
+    }
+    return hash % TABLE_BUCKETS;
+}
+
+/* Run every lookup for one scheme; returns a checksum so work is not elided */
+static long run_lookups(char **stream, int references, Entry **table,
+                        char **propagation, char **registers, int interned) {
+    long hits = 0;
+
+    for (int i = 0; i < references; i++) {
+        char *name = stream[i];
+
+        /* Symbol table lookup */
+        int bucket = interned ? intern_id(name) % TABLE_BUCKETS : pjw_hash(name);
+        for (Entry *e = table[bucket]; e; e = e->next) {
+            if (interned ? e->name == name : strcmp(e->name, name) == 0) {
+                hits++;
+                break;
+            }
+        }
+
+        /* Propagation table scan */
+        for (int j = 0; j < PROPAGATION_ENTRIES; j++) {
+            if (interned ? propagation[j] == name : strcmp(propagation[j], name) == 0) {
+                hits++;
+                break;
+            }
+        }
+
+        /* Register file scan */
+        for (int j = 0; j < REGISTER_COUNT; j++) {
+            if (interned ? registers[j] == name : strcmp(registers[j], name) == 0) {
+                hits++;
+                break;
+            }
+        }
+    }
+
+    return hits;
+}
+
+int main(int argc, char *argv[]) {
+    int distinct = (argc > 1) ? atoi(argv[1]) : 2000;
+    int references = (argc > 2) ? atoi(argv[2]) : 2000000;
+    if (distinct < REGISTER_COUNT + PROPAGATION_ENTRIES) {
+        distinct = REGISTER_COUNT + PROPAGATION_ENTRIES;
+    }
+
+    /* Only the regions and the interner are used; no full compilation */
+    CompilationContext context;
+    memset(&context, 0, sizeof(context));
+    CompilationContext *ctx = &context;
+    init_regions(ctx);
+
+    /* Long shared prefixes make strcmp work as it does on generated code */
+    char **names = (char **)safe_malloc(distinct * sizeof(char *));
+    char buffer[64];
+    for (int i = 0; i < distinct; i++) {
+        snprintf(buffer, sizeof(buffer), "generated_variable_%06d", i);
+        names[i] = copy_string(buffer);
+    }
+
+    char **copied = (char **)safe_malloc(references * sizeof(char *));
+    char **interned = (char **)safe_malloc(references * sizeof(char *));
+    int *picks = (int *)safe_malloc(references * sizeof(int));
+    for (int i = 0; i < references; i++) {
+        picks[i] = next_random() % distinct;
+    }
+
+    /* Lexing: copy every occurrence vs intern it */
+    double start = now_seconds();
+    for (int i = 0; i < references; i++) {
+        copied[i] = copy_string(names[picks[i]]);
+    }
+    double copy_time = now_seconds() - start;
+
+    start = now_seconds();
+    for (int i = 0; i < references; i++) {
+        interned[i] = intern_string(ctx, names[picks[i]]);
+    }
+    double intern_time = now_seconds() - start;
+
+    /* Build both versions of the lookup structures */
+    Entry **table_copied = (Entry **)safe_calloc(TABLE_BUCKETS, sizeof(Entry *));
+    Entry **table_interned = (Entry **)safe_calloc(TABLE_BUCKETS, sizeof(Entry *));
+    for (int i = 0; i < distinct; i++) {
+        Entry *a = (Entry *)safe_malloc(sizeof(Entry));
+        a->name = copy_string(names[i]);
+        a->next = table_copied[pjw_hash(a->name)];
+        table_copied[pjw_hash(a->name)] = a;
+
+        Entry *b = (Entry *)safe_malloc(sizeof(Entry));
+        b->name = intern_string(ctx, names[i]);
+        b->next = table_interned[intern_id(b->name) % TABLE_BUCKETS];
+        table_interned[intern_id(b->name) % TABLE_BUCKETS] = b;
+    }
+
+    char *prop_copied[PROPAGATION_ENTRIES], *prop_interned[PROPAGATION_ENTRIES];
+    for (int j = 0; j < PROPAGATION_ENTRIES; j++) {
+        prop_copied[j] = copy_string(names[j]);
+        prop_interned[j] = intern_string(ctx, names[j]);
+    }
+
+    char *regs_copied[REGISTER_COUNT], *regs_interned[REGISTER_COUNT];
+    for (int j = 0; j < REGISTER_COUNT; j++) {
+        regs_copied[j] = copy_string(names[PROPAGATION_ENTRIES + j]);
+        regs_interned[j] = intern_string(ctx, names[PROPAGATION_ENTRIES + j]);
+    }
+
+    start = now_seconds();
+    long hits_copied = run_lookups(copied, references, table_copied,
+                                   prop_copied, regs_copied, 0);
+    double strcmp_time = now_seconds() - start;
+
+    start = now_seconds();
+    long hits_interned = run_lookups(interned, references, table_interned,
+                                     prop_interned, regs_interned, 1);
+    double pointer_time = now_seconds() - start;
+
+    if (hits_copied != hits_interned) {
+        fprintf(stderr, "Mismatch: %ld vs %ld hits\n", hits_copied, hits_interned);
+        return 1;
+    }
+
+    printf("Identifier interning benchmark\n");
+    printf("  Distinct names: %d\n", distinct);
+    printf("  References:     %d\n\n", references);
+    printf("%-28s %12s %12s\n", "Phase", "strcmp", "interned");
+    printf("%-28s %10.1fns %10.1fns\n", "Lexer copy / intern",
+           copy_time * 1e9 / references, intern_time * 1e9 / references);
+    printf("%-28s %10.1fns %10.1fns\n", "Lookups per reference",
+           strcmp_time * 1e9 / references, pointer_time * 1e9 / references);
+    printf("\nLookup speedup: %.2fx\n", strcmp_time / pointer_time);
+
+    release_all_regions(ctx);
+    return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * Scanner Input Throughput Benchmark
+ * CST-405 Compiler Design
+ *
+ * Lexes a large corpus to completion twice: once from a memory-mapped
+ * buffer handed to yy_scan_buffer, and once through the scanner's default
+ * buffered YY_INPUT (the path pipes and stdin still take). Reports the
+ * best of several runs in MB/s for each path.
+ *
+ * Usage: lex_bench [megabytes | source_file] [runs]
+ *   With a number (default 64), a synthetic corpus of that size is written
+ *   to a temporary file first.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "context.h"
+#include "parser.tab.h"
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Write a corpus of roughly the given size; returns bytes written */
+static long write_corpus(FILE *out, long target) {
+    long written = 0;
+    for (int f = 0; written < target; f++) {
+        written += fprintf(out,
+            "/* generated function %d */\n"
+            "int function%d(int argumentA, int values[]) {\n"
+            "    int local%d;\n"
+            "    local%d = argumentA * %d + values[%d];\n"
+            "    while (local%d >= 100) {\n"
+            "        if (local%d != 7) { local%d = local%d - 3; }\n"
+            "        else { local%d = local%d / 2; }\n"
+            "    }\n"
+            "    return local%d;\n"
+            "}\n\n",
+            f, f, f, f, f % 1000, f % 10, f, f, f, f, f, f, f);
+    }
+    return written;
+}
+
+/* Lex a file to the end; returns the token count */
+static long lex_file(CompilationContext *ctx, const char *filename,
+                     Boolean allow_map, double *seconds) {
+    YYSTYPE value;
+    long tokens = 0;
+
+    double start = now_seconds();
+    if (open_source(filename, &ctx->source, allow_map) != 0) {
+        fprintf(stderr, "Cannot open %s\n", filename);
+        exit(1);
+    }
+    scan_source(ctx);
+    while (yylex(&value, ctx->scanner) != 0) {
+        tokens++;
+    }
+    finish_scan(ctx);
+    close_source(&ctx->source);
+    *seconds = now_seconds() - start;
+
+    return tokens;
+}
+
+int main(int argc, char *argv[]) {
+    const char *arg = (argc > 1) ? argv[1] : "64";
+    int runs = (argc > 2) ? atoi(argv[2]) : 3;
+    char corpus[] = "/tmp/lex_bench_XXXXXX";
+    const char *filename = arg;
+    int generated = 0;
+
+    /* Only the regions and the interner are used; no full compilation */
+    CompilationContext context;
+    memset(&context, 0, sizeof(context));
+    CompilationContext *ctx = &context;
+    ctx->report = stdout;
+    ctx->diagnostics = stderr;
+    init_regions(ctx);
+
+    char *end;
+    long megabytes = strtol(arg, &end, 10);
+    if (*end == '\0') {
+        int fd = mkstemp(corpus);
+        FILE *out = (fd >= 0) ? fdopen(fd, "w") : NULL;
+        if (out == NULL) {
+            fprintf(stderr, "Cannot create corpus file\n");
+            return 1;
+        }
+        write_corpus(out, megabytes * 1024 * 1024);
+        fclose(out);
+        filename = corpus;
+        generated = 1;
+    }
+
+    FILE *probe = fopen(filename, "r");
+    if (probe == NULL) {
+        fprintf(stderr, "Cannot open %s\n", filename);
+        return 1;
+    }
+    fseek(probe, 0, SEEK_END);
+    double size_mb = ftell(probe) / (1024.0 * 1024.0);
+    fclose(probe);
+
+    double best_mapped = 0, best_buffered = 0;
+    long tokens_mapped = 0, tokens_buffered = 0;
+    for (int r = 0; r < runs; r++) {
+        double seconds;
+        tokens_mapped = lex_file(ctx, filename, TRUE, &seconds);
+        if (best_mapped == 0 || seconds < best_mapped) best_mapped = seconds;
+        tokens_buffered = lex_file(ctx, filename, FALSE, &seconds);
+        if (best_buffered == 0 || seconds < best_buffered) best_buffered = seconds;
+    }
+
+    if (generated) {
+        unlink(corpus);
+    }
+
+    if (tokens_mapped != tokens_buffered) {
+        fprintf(stderr, "Mismatch: %ld vs %ld tokens\n", tokens_mapped, tokens_buffered);
+        return 1;
+    }
+
+    printf("Scanner input benchmark\n");
+    printf("  Corpus: %.1f MB, %ld tokens, best of %d\n\n", size_mb, tokens_mapped, runs);
+    printf("%-28s %10s %10s\n", "Input path", "seconds", "MB/s");
+    printf("%-28s %10.3f %10.1f\n", "Buffered YY_INPUT",
+           best_buffered, size_mb / best_buffered);
+    printf("%-28s %10.3f %10.1f\n", "mmap + yy_scan_buffer",
+           best_mapped, size_mb / best_mapped);
+    printf("\nSpeedup: %.2fx\n", best_buffered / best_mapped);
+
+    release_all_regions(ctx);
+    return 0;
+}
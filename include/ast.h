@@ -6,7 +6,9 @@
  * CST-405 Compiler Design
  */
 
+#include <stdint.h>
 #include "globals.h"
+#include "util.h"
 
 /* AST Node Types */
 typedef enum {
@@ -51,69 +53,112 @@ typedef enum {
     TYPE_ERROR
 } DataType;
 
-/* AST Node Structure */
+/* AST Node Structure
+ *
+ * Nodes live in one growable array and refer to each other by 32-bit
+ * index; index 0 (NO_NODE) means "no node". Each node keeps only what
+ * its kind needs. Source positions, symbol links and code-generation
+ * attributes are cold and kept in side tables indexed the same way.
+ *
+ * Payload by kind:
+ *   NUM                          value = literal
+ *   ID, ARRAY_ACCESS, CALL,
+ *   PARAM, VAR_DECL, FUNC_DECL   value = intern ID of the name
+ *   BINARY_OP                    value = intern ID of the operator
+ *   VAR_DECL                     array_size (instead of children)
+ *   FUNC_DECL                    return_type
+ *   PROGRAM, PARAM_LIST,
+ *   LOCAL_DECLS, STMT_LIST,
+ *   ARG_LIST                     list (instead of children)
+ */
+typedef uint32_t NodeId;
+#define NO_NODE 0
+
 typedef struct ASTNode {
-    NodeType node_type;
-    DataType data_type;
+    uint8_t node_type;         /* NodeType */
+    uint8_t data_type;         /* DataType */
+    uint8_t return_type;       /* DataType returned (FUNC_DECL) */
+    uint8_t reserved;
+    int32_t value;             /* Literal or interned name/operator ID */
     
-    /* Node specific data */
     union {
-        int int_val;           /* For NUM nodes */
-        char *string_val;      /* For ID nodes and operators */
         struct {
-            char *name;
-            int size;          /* For array declarations */
-        } var_decl;
+            NodeId left;
+            NodeId right;
+            NodeId next;       /* Else branch of IF_STMT */
+        };
+        int32_t array_size;    /* For VAR_DECL nodes */
         struct {
-            char *name;
-            DataType return_type;
-        } func_decl;
-    } value;
-    
-    /* Tree structure */
-    struct ASTNode *left;
-    struct ASTNode *right;
-    struct ASTNode *next;      /* For lists */
-    
-    /* Source location */
-    int line_number;
-    int column_number;
-    
-    /* Symbol table entry (filled during semantic analysis) */
-    void *symbol;
-    
-    /* Code generation attributes */
+            NodeId *items;     /* Children in source order */
+            int32_t count;
+        } list;                /* For list nodes */
+    };
+} ASTNode;
+
+/* Code generation attributes (side table, allocated on first use) */
+typedef struct {
     int temp_var;              /* Temporary variable number */
     char *code;                /* Generated code */
-    
-} ASTNode;
+} ASTCodeInfo;
+
+/* A compilation's node array and side tables (index 0 is unused)
+ * All of them live in the parse region.
+ */
+typedef struct {
+    ASTNode *nodes;            /* Valid until the next node is created */
+    int *lines;
+    int *columns;
+    void **symbols;
+    ASTCodeInfo *codes;
+    NodeId count;
+    NodeId capacity;
+} ASTStore;
+
+#define AST(ctx, id)         ((id) != NO_NODE ? &(ctx)->ast.nodes[(id)] : NULL)
+#define AST_ID(ctx, node)    ((NodeId)((node) - (ctx)->ast.nodes))
+#define AST_NAME(ctx, node)  intern_name((ctx), (node)->value)
+
+/* Side tables */
+int ast_line(CompilationContext *ctx, ASTNode *node);
+int ast_column(CompilationContext *ctx, ASTNode *node);
+void *ast_symbol(CompilationContext *ctx, ASTNode *node);
+void ast_set_symbol(CompilationContext *ctx, ASTNode *node, void *symbol);
+ASTCodeInfo *ast_code_info(CompilationContext *ctx, ASTNode *node);
 
 /* AST Construction Functions */
-ASTNode *create_node(NodeType type);
-ASTNode *create_var_decl_node(char *type, char *name, int array_size);
-ASTNode *create_func_decl_node(char *type, char *name, ASTNode *params, ASTNode *body);
-ASTNode *create_param_node(char *type, char *name, int is_array);
-ASTNode *create_compound_stmt_node(ASTNode *local_decls, ASTNode *stmt_list);
-ASTNode *create_if_node(ASTNode *condition, ASTNode *then_stmt, ASTNode *else_stmt);
-ASTNode *create_while_node(ASTNode *condition, ASTNode *body);
-ASTNode *create_return_node(ASTNode *expr);
-ASTNode *create_assign_node(ASTNode *var, ASTNode *expr);
-ASTNode *create_binary_op_node(char *op, ASTNode *left, ASTNode *right);
-ASTNode *create_call_node(char *name, ASTNode *args);
-ASTNode *create_id_node(char *name);
-ASTNode *create_array_access_node(char *name, ASTNode *index);
-ASTNode *create_num_node(int value);
+NodeId create_node(CompilationContext *ctx, NodeType type);
+NodeId create_list_node(CompilationContext *ctx, NodeType type);
+NodeId append_to_list(CompilationContext *ctx, NodeId list, NodeId item);
+NodeId create_var_decl_node(CompilationContext *ctx, char *type, char *name, int array_size);
+NodeId create_func_decl_node(CompilationContext *ctx, char *type, char *name, NodeId params, NodeId body);
+NodeId create_param_node(CompilationContext *ctx, char *type, char *name, int is_array);
+NodeId create_compound_stmt_node(CompilationContext *ctx, NodeId local_decls, NodeId stmt_list);
+NodeId create_if_node(CompilationContext *ctx, NodeId condition, NodeId then_stmt, NodeId else_stmt);
+NodeId create_while_node(CompilationContext *ctx, NodeId condition, NodeId body);
+NodeId create_return_node(CompilationContext *ctx, NodeId expr);
+NodeId create_expr_stmt_node(CompilationContext *ctx, NodeId expr);
+NodeId create_assign_node(CompilationContext *ctx, NodeId var, NodeId expr);
+NodeId create_binary_op_node(CompilationContext *ctx, char *op, NodeId left, NodeId right);
+NodeId create_call_node(CompilationContext *ctx, char *name, NodeId args);
+NodeId create_id_node(CompilationContext *ctx, char *name);
+NodeId create_array_access_node(CompilationContext *ctx, char *name, NodeId index);
+NodeId create_num_node(CompilationContext *ctx, int value);
+
+/* List nodes */
+int is_list_node(ASTNode *node);
+#define LIST_COUNT(node) ((node) ? (node)->list.count : 0)
+#define LIST_ITEM(ctx, node, i) AST((ctx), (node)->list.items[(i)])
 
 /* AST Traversal and Display */
-void print_ast(ASTNode *node, int indent);
-void print_ast_dot(ASTNode *node, FILE *file);
-void free_ast(ASTNode *node);
+void print_ast(CompilationContext *ctx, ASTNode *node, int indent);
+void print_ast_dot(CompilationContext *ctx, ASTNode *node, FILE *file);
+void free_ast(CompilationContext *ctx, ASTNode *node);
 
 /* AST Analysis */
-int get_ast_height(ASTNode *node);
-int count_ast_nodes(ASTNode *node);
+int get_ast_height(CompilationContext *ctx, ASTNode *node);
+int count_ast_nodes(CompilationContext *ctx, ASTNode *node);
 
 /* Parse Tree vs AST Demonstration */
-void show_parse_tree_vs_ast(void);
+void show_parse_tree_vs_ast(CompilationContext *ctx);
 
 #endif /* AST_H */
\ No newline at end of file
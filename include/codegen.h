@@ -47,75 +47,119 @@ typedef enum {
     
     /* Function definition */
     TAC_FUNC_BEGIN, /* begin_func f */
-    TAC_FUNC_END    /* end_func */
+    TAC_FUNC_END,   /* end_func */
+    
+    /* Removed instruction (tombstone until the stream is compacted) */
+    TAC_NOP
 } TACOpcode;
 
+/* Operand kinds */
+typedef enum {
+    OPERAND_NONE,      /* Unused operand slot */
+    OPERAND_TEMP,      /* Temporary tN (value = N) */
+    OPERAND_VAR,       /* Named variable (value = symbol ID) */
+    OPERAND_CONST,     /* Integer immediate (value = the constant) */
+    OPERAND_LABEL,     /* Label LN (value = N) */
+    OPERAND_FUNC       /* Function name (value = symbol ID) */
+} OperandKind;
+
+/* Fixed-size operand stored inline in each instruction */
+typedef struct {
+    OperandKind kind;
+    int value;
+} TACOperand;
+
+/* Buffer size large enough for any formatted non-name operand */
+#define OPERAND_BUFFER_SIZE 16
+
 /* Three-address code instruction */
 typedef struct TACInstruction {
     TACOpcode opcode;
-    char *result;      /* Result operand */
-    char *arg1;        /* First argument */
-    char *arg2;        /* Second argument */
+    TACOperand result; /* Result operand */
+    TACOperand arg1;   /* First argument */
+    TACOperand arg2;   /* Second argument */
     int label;         /* Label number (for jumps) */
-    struct TACInstruction *next;
 } TACInstruction;
 
-/* Three-address code generation context */
+/* Three-address code generation context
+ *
+ * Instructions live in one contiguous array, grown in the TAC region.
+ * Passes remove an instruction in O(1) by turning it into a TAC_NOP
+ * tombstone; compact_tac squeezes the tombstones out in a single linear
+ * pass.
+ */
 typedef struct {
-    TACInstruction *head;     /* First instruction */
-    TACInstruction *tail;     /* Last instruction */
+    TACInstruction *code;     /* Instruction stream */
+    int count;                /* Slots in use (including tombstones) */
+    int capacity;             /* Allocated slots */
+    int removed;              /* Tombstones awaiting compaction */
     int temp_count;           /* Temporary variable counter */
     int label_count;          /* Label counter */
 } TACContext;
 
-/* Global TAC context */
-extern TACContext *tac_context;
+/* One function's run of the TAC stream: code[start] .. code[start + count - 1] */
+typedef struct {
+    int start;
+    int count;
+} TACRange;
 
 /* TAC generation functions */
-void init_tac_generation(void);
-void generate_tac(ASTNode *tree);
-TACInstruction *gen_tac_node(ASTNode *node);
+void init_tac_generation(CompilationContext *ctx);
+void generate_tac(CompilationContext *ctx, ASTNode *tree);
+TACInstruction *gen_tac_node(CompilationContext *ctx, ASTNode *node);
 
 /* Expression code generation */
-char *gen_tac_expression(ASTNode *node);
-char *gen_tac_binary_op(ASTNode *node);
-char *gen_tac_assignment(ASTNode *node);
-char *gen_tac_call(ASTNode *node);
-char *gen_tac_var(ASTNode *node);
-
-/* Statement code generation */
-void gen_tac_statement(ASTNode *node);
-void gen_tac_if(ASTNode *node);
-void gen_tac_while(ASTNode *node);
-void gen_tac_return(ASTNode *node);
-void gen_tac_compound(ASTNode *node);
+TACOperand gen_tac_expression(CompilationContext *ctx, ASTNode *node);
+
+/* Statement code generation; children and the code that follows them
+ * are scheduled on gen_tac_node's work stack */
+void gen_tac_if(CompilationContext *ctx, ASTNode *node, WorkStack *pending);
+void gen_tac_while(CompilationContext *ctx, ASTNode *node, WorkStack *pending);
+void gen_tac_return(CompilationContext *ctx, ASTNode *node);
+void gen_tac_compound(CompilationContext *ctx, ASTNode *node, WorkStack *pending);
 
 /* Declaration code generation */
-void gen_tac_func_decl(ASTNode *node);
-void gen_tac_var_decl(ASTNode *node);
+void gen_tac_func_decl(CompilationContext *ctx, ASTNode *node, WorkStack *pending);
+void gen_tac_var_decl(CompilationContext *ctx, ASTNode *node);
 
 /* TAC instruction creation */
-TACInstruction *create_tac(TACOpcode op, char *result, char *arg1, char *arg2);
-void emit_tac(TACInstruction *instr);
-void emit_label(int label);
-void emit_goto(int label);
-void emit_conditional(char *cond, int label, int if_true);
+TACInstruction create_tac(TACOpcode op, TACOperand result, TACOperand arg1, TACOperand arg2);
+TACInstruction *emit_tac(CompilationContext *ctx, TACInstruction instr);
+void emit_label(CompilationContext *ctx, int label);
+void emit_goto(CompilationContext *ctx, int label);
+void emit_conditional(CompilationContext *ctx, TACOperand cond, int label, int if_true);
+
+/* Operand construction and inspection */
+TACOperand operand_none(void);
+TACOperand operand_temp(int number);
+TACOperand operand_var(SymbolEntry *symbol);
+TACOperand operand_const(int value);
+TACOperand operand_func(SymbolEntry *symbol);
+SymbolEntry *operand_symbol(CompilationContext *ctx, TACOperand op);
+int operand_equal(TACOperand a, TACOperand b);
+char *operand_name(CompilationContext *ctx, TACOperand op);
+const char *format_operand(CompilationContext *ctx, TACOperand op, char *buffer);
 
 /* Temporary variable and label management */
-char *new_temp(void);
-int new_label(void);
-char *make_string(const char *format, ...);
+TACOperand new_temp(CompilationContext *ctx);
+int new_label(CompilationContext *ctx);
 
 /* TAC output */
-void print_tac(void);
-void print_tac_instruction(TACInstruction *instr);
-void write_tac_to_file(FILE *file);
+void print_tac(CompilationContext *ctx);
+void print_tac_instruction(CompilationContext *ctx, TACInstruction *instr);
+void write_tac_to_file(CompilationContext *ctx, FILE *file);
 
 /* TAC optimization hooks */
-TACInstruction *get_tac_list(void);
-void set_tac_list(TACInstruction *list);
+TACInstruction *get_tac_list(CompilationContext *ctx);
+int get_tac_count(CompilationContext *ctx);
+void set_tac_list(CompilationContext *ctx, TACInstruction *list, int count);
+void remove_tac(CompilationContext *ctx, int index);
+int next_tac_index(CompilationContext *ctx, int index);
+int prev_tac_index(CompilationContext *ctx, int index);
+void compact_tac(CompilationContext *ctx);
+int split_tac_functions(TACInstruction *code, int count, TACRange **ranges);
 
 /* Memory management */
-void free_tac(void);
+void free_tac(CompilationContext *ctx);
 
 #endif /* CODEGEN_H */
\ No newline at end of file
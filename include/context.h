@@ -0,0 +1,64 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+/*
+ * Compilation Context for C-Minus Compiler
+ * CST-405 Compiler Design
+ */
+
+#include <stdio.h>
+#include "globals.h"
+#include "util.h"
+#include "source.h"
+#include "ast.h"
+#include "symtab.h"
+#include "codegen.h"
+#include "optimize.h"
+#include "mips.h"
+#include "timing.h"
+
+/* State of one compilation unit
+ *
+ * Everything a compilation reads or writes hangs off this structure: the
+ * scanner, the tree, the symbol table, the TAC stream, the back end and
+ * the memory regions and interned names backing them. Nothing is shared
+ * between two contexts, so separate files can be compiled by separate
+ * threads at once. Command-line options are the only process-wide state;
+ * they are set before any compilation starts and only read afterwards.
+ */
+struct CompilationContext {
+    const char *filename;      /* Source file name ("-" for stdin) */
+    SourceInput source;        /* Open source text */
+    void *scanner;             /* Reentrant flex scanner (yyscan_t) */
+    int line;                  /* Scanner position */
+    int column;
+    FILE *output;              /* Assembly output */
+    FILE *report;              /* Progress and trace output (stdout) */
+    FILE *diagnostics;         /* Errors and warnings (stderr) */
+    
+    RegionSet memory;          /* Per-phase regions */
+    InternTable names;         /* Interned identifiers */
+    
+    ASTStore ast;              /* Syntax tree */
+    NodeId ast_root;
+    
+    SymbolTable symtab;        /* Scopes and symbols */
+    SymbolEntry *current_function; /* Function being analyzed */
+    
+    TACContext tac;            /* Three-address code */
+    OptimizationStats opt_stats;
+    MIPSContext mips;          /* Target code generation */
+    TimeReport timing;         /* Per-phase costs for --time-report */
+    
+    int error_count;           /* Diagnostics reported */
+    int warning_count;
+};
+
+CompilationContext *create_context(const char *filename);
+void free_context(CompilationContext *ctx);
+
+/* Per-function contexts for processing one unit's functions in parallel */
+CompilationContext *create_function_context(CompilationContext *parent);
+void finish_function_context(CompilationContext *parent, CompilationContext *child);
+
+#endif /* CONTEXT_H */
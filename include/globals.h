@@ -17,13 +17,10 @@ typedef enum { FALSE, TRUE } Boolean;
 #define MAX_ID_LENGTH 256
 #define MAX_STRING_LENGTH 1024
 
-/* Error handling */
-extern int error_count;
-extern int warning_count;
+/* State of one compilation unit (see context.h) */
+typedef struct CompilationContext CompilationContext;
 
 /* File handles */
-extern FILE *source_file;
-extern FILE *output_file;
 extern FILE *listing_file;
 
 /* Compilation flags */
@@ -32,14 +29,15 @@ extern Boolean trace_parse;
 extern Boolean trace_semantic;
 extern Boolean trace_code;
 extern Boolean generate_code;
-
-/* Current line and column numbers */
-extern int linenum;
-extern int colnum;
+extern Boolean report_memory;
+extern Boolean report_registers;  /* Spills and reloads per function */
+extern Boolean quiet_mode;     /* No phase banners or TAC dumps */
+extern int optimization_level;  /* -O level, see OptimizationLevel */
+extern int function_jobs;      /* Functions optimized/emitted at once, 0 = one per core */
 
 /* Utility functions */
-void error(const char *message, ...);
-void warning(const char *message, ...);
+void error(CompilationContext *ctx, const char *message, ...);
+void warning(CompilationContext *ctx, const char *message, ...);
 void fatal_error(const char *message, ...);
 char *copy_string(const char *s);
 
@@ -8,6 +8,7 @@
 
 #include "codegen.h"
 #include "symtab.h"
+#include "regalloc.h"
 
 /* MIPS Registers */
 typedef enum {
@@ -68,54 +69,90 @@ typedef enum {
     REG_RA = 31     /* $31 - return address */
 } MIPSRegister;
 
-/* Register allocation info */
+/* Growable in-memory assembly text
+ *
+ * The back end formats into buffers rather than a FILE, one per function,
+ * and the finished buffers go to the output file in a single writev.
+ */
+typedef struct {
+    char *data;
+    size_t length;          /* Bytes of text */
+    size_t capacity;        /* Bytes allocated */
+} AsmBuffer;
+
+/* Stack frame of the current function
+ *
+ * From the base register upwards: one word per stack slot, the local
+ * arrays the function uses, the $s registers it uses, then $ra and the
+ * caller's $fp if they need saving. Scalars and temporaries kept in
+ * registers take no space, and a leaf function with nothing in memory
+ * has no frame at all.
+ */
 typedef struct {
-    char *var_name;         /* Variable/temp mapped to this register */
-    int is_dirty;           /* Need to write back to memory */
-    int last_use;           /* Last instruction that used this register */
-} RegisterInfo;
+    int size;               /* Bytes, a multiple of 8; 0 for no frame */
+    MIPSRegister base;      /* $sp, or $fp if calls push arguments below the frame */
+    unsigned int saved_mask; /* Bit per callee-saved register the prologue saves */
+    int saved_offset;       /* Offset of the first of them */
+    int ra_offset;          /* Offset of the saved $ra, -1 if not saved */
+    int fp_offset;          /* Offset of the caller's $fp, -1 if not saved */
+    int array_base;         /* Lowest symbol ID of a local array */
+    int array_count;        /* Symbol IDs from array_base on */
+    int *array_offset;      /* Offset of each local array, -1 if unused */
+    int returns;            /* 0 for main, which exits instead */
+} FrameLayout;
 
 /* MIPS generation context */
 typedef struct {
-    FILE *output;           /* Output file */
-    RegisterInfo regs[32]; /* Register allocation table */
-    int stack_offset;       /* Current stack offset */
+    AsmBuffer *out;         /* Buffer receiving the current function */
+    RegAllocation alloc;    /* Registers of the current function's values */
+    FrameLayout frame;      /* Stack slots of the current function */
     int param_offset;       /* Parameter offset */
     char *current_func;     /* Current function name */
+    int param_area;         /* Bytes pushed for arguments past the fourth */
+    MIPSRegister next_scratch; /* Register for the next operand loaded from memory */
+    int call_index;         /* User calls lowered so far in this function */
 } MIPSContext;
 
+/* Buffer size for a formatted memory operand such as "name($t9)" */
+#define MIPS_OPERAND_SIZE (MAX_ID_LENGTH + 16)
+
 /* Main MIPS generation function */
-void generate_mips(TACInstruction *tac_list, FILE *output);
+void generate_mips(CompilationContext *ctx, TACInstruction *tac_list, int tac_count, FILE *output);
 
 /* MIPS instruction generation */
-void gen_mips_instruction(TACInstruction *instr);
-void gen_mips_arithmetic(TACInstruction *instr);
-void gen_mips_assignment(TACInstruction *instr);
-void gen_mips_comparison(TACInstruction *instr);
-void gen_mips_branch(TACInstruction *instr);
-void gen_mips_function(TACInstruction *instr);
-void gen_mips_call(TACInstruction *instr);
-void gen_mips_return(TACInstruction *instr);
-void gen_mips_array(TACInstruction *instr);
+void gen_mips_instruction(CompilationContext *ctx, TACInstruction *instr);
+void gen_mips_arithmetic(CompilationContext *ctx, TACInstruction *instr);
+void gen_mips_assignment(CompilationContext *ctx, TACInstruction *instr);
+void gen_mips_comparison(CompilationContext *ctx, TACInstruction *instr);
+void gen_mips_branch(CompilationContext *ctx, TACInstruction *instr);
+void gen_mips_function(CompilationContext *ctx, TACInstruction *instr);
+void gen_mips_call(CompilationContext *ctx, TACInstruction *instr);
+void gen_mips_return(CompilationContext *ctx, TACInstruction *instr);
+void gen_mips_array(CompilationContext *ctx, TACInstruction *instr);
+
+/* Operands in registers */
+MIPSRegister get_register(CompilationContext *ctx, TACOperand var);
+MIPSRegister allocate_register(CompilationContext *ctx, TACOperand var);
+void store_result(CompilationContext *ctx, TACOperand var, MIPSRegister reg);
+void load_variable(CompilationContext *ctx, TACOperand var, MIPSRegister reg);
+void store_variable(CompilationContext *ctx, TACOperand var, MIPSRegister reg);
 
-/* Register allocation */
-MIPSRegister allocate_register(char *var);
-MIPSRegister get_register(char *var);
-void free_register(MIPSRegister reg);
-void spill_register(MIPSRegister reg);
-void load_variable(char *var, MIPSRegister reg);
-void store_variable(char *var, MIPSRegister reg);
+/* Assembly buffers */
+void asm_append(AsmBuffer *buffer, const char *text, size_t length);
+void asm_append_int(AsmBuffer *buffer, int value);
+void asm_free(AsmBuffer *buffer);
+int write_asm_buffers(int fd, AsmBuffer *buffers, int count);
 
 /* MIPS output functions */
-void emit_mips(const char *format, ...);
-void emit_label_mips(int label);
-void emit_data_section(void);
-void emit_text_section(void);
-void emit_syscall_functions(void);
+void emit_mips(CompilationContext *ctx, const char *format, ...);
+void emit_label_mips(CompilationContext *ctx, int label);
+void emit_data_section(CompilationContext *ctx);
+void emit_text_section(CompilationContext *ctx);
+void emit_syscall_functions(CompilationContext *ctx);
 
 /* Utility functions */
 char *reg_name(MIPSRegister reg);
-int get_var_offset(char *var);
-int is_global_var(char *var);
+int get_var_offset(CompilationContext *ctx, TACOperand var);
+int is_global_var(CompilationContext *ctx, TACOperand var);
 
 #endif /* MIPS_H */
\ No newline at end of file
@@ -12,14 +12,15 @@
 typedef enum {
     OPT_NONE = 0,
     OPT_BASIC = 1,      /* Basic optimizations */
-    OPT_AGGRESSIVE = 2  /* Aggressive optimizations */
+    OPT_AGGRESSIVE = 2, /* Aggressive optimizations */
+    OPT_GRAPH_COLORING = 3  /* As 2, registers allocated by graph coloring */
 } OptimizationLevel;
 
 /* Basic block structure for optimization */
 typedef struct BasicBlock {
     int id;
-    TACInstruction *start;
-    TACInstruction *end;
+    int start;              /* Index of first instruction in the TAC stream */
+    int end;                /* Index of last instruction */
     struct BasicBlock **predecessors;
     struct BasicBlock **successors;
     int pred_count;
@@ -33,52 +34,55 @@ typedef struct BasicBlock {
 } BasicBlock;
 
 /* Optimization passes */
-void optimize_tac(OptimizationLevel level);
+void optimize_tac(CompilationContext *ctx, OptimizationLevel level);
 
 /* Basic optimizations */
-void constant_folding(void);
-void constant_propagation(void);
-void dead_code_elimination(void);
-void copy_propagation(void);
-void algebraic_simplification(void);
+void constant_folding(CompilationContext *ctx);
+void constant_propagation(CompilationContext *ctx);
+void dead_code_elimination(CompilationContext *ctx);
+void copy_propagation(CompilationContext *ctx);
+void dead_copy_elimination(CompilationContext *ctx);
+void algebraic_simplification(CompilationContext *ctx);
 
 /* Peephole optimizations */
-void peephole_optimization(void);
-void remove_redundant_jumps(void);
-void combine_operations(void);
+void peephole_optimization(CompilationContext *ctx);
+void remove_redundant_jumps(CompilationContext *ctx);
+void combine_operations(CompilationContext *ctx);
 
 /* Control flow optimizations */
-void build_cfg(void);
-void remove_unreachable_code(void);
-void merge_basic_blocks(void);
+void build_cfg(CompilationContext *ctx);
+void remove_unreachable_code(CompilationContext *ctx);
+void merge_basic_blocks(CompilationContext *ctx);
 
 /* Common subexpression elimination */
-void common_subexpression_elimination(void);
+void common_subexpression_elimination(CompilationContext *ctx);
 
 /* Live variable analysis */
-void live_variable_analysis(void);
+void live_variable_analysis(CompilationContext *ctx);
 
 /* Register allocation preparation */
-void prepare_for_register_allocation(void);
+void prepare_for_register_allocation(CompilationContext *ctx);
 
 /* Utility functions */
-int is_constant(char *operand);
-int get_constant_value(char *operand);
-int is_temporary(char *operand);
-void replace_operand(TACInstruction *instr, char *old_op, char *new_op);
+int is_constant(TACOperand operand);
+int get_constant_value(TACOperand operand);
+int is_temporary(TACOperand operand);
+int defines_result(TACInstruction *instr);
+int uses_result(TACInstruction *instr);
+void replace_operand(TACInstruction *instr, TACOperand old_op, TACOperand new_op);
 
 /* Statistics */
 typedef struct {
     int constants_folded;
     int dead_code_removed;
     int copies_propagated;
+    int dead_copies_removed;
     int expressions_simplified;
     int subexpressions_eliminated;
     int original_instruction_count;
     int optimized_instruction_count;
 } OptimizationStats;
 
-extern OptimizationStats opt_stats;
-void print_optimization_stats(void);
+void print_optimization_stats(CompilationContext *ctx);
 
 #endif /* OPTIMIZE_H */
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef REGALLOC_H
+#define REGALLOC_H
+
+/*
+ * Register Allocation for C-Minus Compiler
+ * CST-405 Compiler Design
+ *
+ * Decides, for one function at a time, which register holds each
+ * temporary and local scalar, or that it lives in its stack slot.
+ */
+
+#include "codegen.h"
+
+/* Register of a value kept in memory for its whole lifetime */
+#define REG_SPILLED (-1)
+
+/* Registers a call may clobber ($t0-$t7) and ones it must preserve ($s0-$s7) */
+#define CALLER_SAVED(reg) ((reg) >= REG_T0 && (reg) <= REG_T7)
+#define CALLEE_SAVED(reg) ((reg) >= REG_S0 && (reg) <= REG_S7)
+
+/* Lifetime of one value over a function's instructions
+ *
+ * Instruction i reads its operands at position 2i and writes its result
+ * at 2i + 1, so a value last read by an instruction can share a register
+ * with the value that instruction defines.
+ */
+typedef struct {
+    int start;                 /* First position live; start > end if never live */
+    int end;                   /* Last position live */
+    double weight;             /* Uses and defs, scaled by loop depth */
+    int reg;                   /* Register, or REG_SPILLED */
+    int crosses_call;          /* Live across a call to a user function */
+    int slot;                  /* Spill slot when spilled, else -1 */
+    int hint;                  /* Value first copied into it, or -1 */
+    int defs;                  /* Instructions writing it, and FUNC_BEGIN for a parameter */
+} LiveInterval;
+
+/* Allocation for one function and what it cost */
+typedef struct {
+    int temp_base;             /* Lowest temporary the function uses */
+    int temp_count;            /* Temporaries from temp_base on */
+    int var_base;              /* Lowest symbol ID of a local or parameter */
+    int var_count;             /* Symbols from var_base on */
+    int value_count;           /* temp_count + var_count */
+    LiveInterval *intervals;   /* Indexed by value_index */
+    int slot_count;            /* Stack slots, shared by disjoint intervals */
+    unsigned int used_mask;    /* Bit per MIPS register handed out */
+
+    /* Values held in caller-saved registers across each call to a user
+     * function, in instruction order: those of call k are
+     * save_values[save_start[k] .. save_start[k + 1] - 1] */
+    int call_count;
+    int *save_start;
+    int *save_values;
+
+    /* Report */
+    int values;                /* Values live somewhere */
+    int spilled;               /* Values given no register */
+    int spilled_at_calls;      /* Of those, live across a call */
+    int registers_used;        /* Distinct registers handed out */
+    int reloads;               /* Loads of spilled values emitted */
+    int spill_stores;          /* Stores of spilled values emitted */
+    int coalesced;             /* Copies whose ends share a register */
+    int callee_saved;          /* $s registers saved by the prologue */
+    int caller_saves;          /* Registers saved around calls */
+} RegAllocation;
+
+/* Allocate registers for code[0..count-1], one whole function */
+void allocate_registers(CompilationContext *ctx, TACInstruction *code, int count, RegAllocation *alloc);
+void free_allocation(CompilationContext *ctx, RegAllocation *alloc);
+
+/* Value an operand names, or -1 for constants, globals, arrays and functions */
+int value_index(CompilationContext *ctx, RegAllocation *alloc, TACOperand operand);
+
+/* Register holding an operand for its lifetime, or REG_SPILLED */
+int value_register(CompilationContext *ctx, RegAllocation *alloc, TACOperand operand);
+
+#endif /* REGALLOC_H */
@@ -10,26 +10,26 @@
 #include "symtab.h"
 
 /* Semantic analysis functions */
-void semantic_analysis(ASTNode *tree);
-void analyze_node(ASTNode *node);
+void semantic_analysis(CompilationContext *ctx, ASTNode *tree);
+void analyze_node(CompilationContext *ctx, ASTNode *node);
 
 /* Declaration analysis */
-void analyze_var_decl(ASTNode *node);
-void analyze_func_decl(ASTNode *node);
-void analyze_params(ASTNode *params, SymbolEntry *func);
+void analyze_var_decl(CompilationContext *ctx, ASTNode *node);
+void analyze_func_decl(CompilationContext *ctx, ASTNode *node);
+void analyze_params(CompilationContext *ctx, ASTNode *params, SymbolEntry *func);
 
-/* Statement analysis */
-void analyze_compound_stmt(ASTNode *node);
-void analyze_if_stmt(ASTNode *node);
-void analyze_while_stmt(ASTNode *node);
-void analyze_return_stmt(ASTNode *node);
+/* Statement analysis; children are scheduled on analyze_node's work stack */
+void analyze_compound_stmt(CompilationContext *ctx, ASTNode *node, WorkStack *pending);
+void analyze_if_stmt(CompilationContext *ctx, ASTNode *node, WorkStack *pending);
+void analyze_while_stmt(CompilationContext *ctx, ASTNode *node, WorkStack *pending);
+void analyze_return_stmt(CompilationContext *ctx, ASTNode *node);
 
 /* Expression analysis and type checking */
-DataType analyze_expression(ASTNode *node);
-DataType analyze_binary_op(ASTNode *node);
-DataType analyze_assignment(ASTNode *node);
-DataType analyze_call(ASTNode *node);
-DataType analyze_var(ASTNode *node);
+DataType analyze_expression(CompilationContext *ctx, ASTNode *node);
+DataType analyze_binary_op(CompilationContext *ctx, ASTNode *node);
+DataType analyze_assignment(CompilationContext *ctx, ASTNode *node);
+DataType analyze_call(CompilationContext *ctx, ASTNode *node);
+DataType analyze_var(CompilationContext *ctx, ASTNode *node);
 
 /* Type checking utilities */
 DataType check_type_compatibility(DataType t1, DataType t2, char *op);
@@ -37,16 +37,12 @@ int types_compatible(DataType t1, DataType t2);
 char *type_to_string(DataType type);
 
 /* Semantic checks */
-void check_main_function(void);
-void check_return_paths(ASTNode *func_body, DataType return_type);
-void check_array_index(ASTNode *node);
-void check_function_args(SymbolEntry *func, ASTNode *args);
-
-/* Current function context */
-extern SymbolEntry *current_function;
+void check_main_function(CompilationContext *ctx);
+void check_return_paths(CompilationContext *ctx, ASTNode *func_body, DataType return_type);
+void check_array_index(CompilationContext *ctx, ASTNode *node);
 
 /* Error reporting */
-void semantic_error(ASTNode *node, const char *format, ...);
-void semantic_warning(ASTNode *node, const char *format, ...);
+void semantic_error(CompilationContext *ctx, ASTNode *node, const char *format, ...);
+void semantic_warning(CompilationContext *ctx, ASTNode *node, const char *format, ...);
 
 #endif /* SEMANTIC_H */
\ No newline at end of file
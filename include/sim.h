@@ -0,0 +1,129 @@
+#ifndef SIM_H
+#define SIM_H
+
+/*
+ * MIPS32 Simulator for C-Minus Compiler
+ * CST-405 Compiler Design
+ *
+ * Loads the assembly the back end writes and runs it, counting what the
+ * program executes. Used by cminus-sim and the code generation
+ * benchmarks in place of SPIM or MARS.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+/* Memory map, as in SPIM */
+#define SIM_TEXT_BASE   0x00400000u
+#define SIM_DATA_BASE   0x10010000u
+#define SIM_STACK_TOP   0x7ffffffcu
+#define SIM_STACK_SIZE  (8u * 1024 * 1024)
+
+/* Operations after pseudo-instructions are resolved */
+typedef enum {
+    /* rd = rs op (rt or immediate) */
+    SIM_ADD, SIM_SUB, SIM_AND, SIM_OR, SIM_XOR, SIM_NOR,
+    SIM_SLT, SIM_SLTU, SIM_SLE, SIM_SLEU, SIM_SGT, SIM_SGTU, SIM_SGE, SIM_SGEU,
+    SIM_SEQ, SIM_SNE, SIM_MUL, SIM_QUOT, SIM_QUOTU, SIM_REM, SIM_REMU,
+    SIM_SLL, SIM_SRL, SIM_SRA,
+
+    /* rd = f(rs) or rd = immediate */
+    SIM_MOVE, SIM_NEG, SIM_NOT, SIM_LI,
+
+    /* HI and LO */
+    SIM_MULT, SIM_MULTU, SIM_DIV, SIM_DIVU,
+    SIM_MFHI, SIM_MFLO, SIM_MTHI, SIM_MTLO,
+
+    /* Memory at rs + immediate */
+    SIM_LW, SIM_LH, SIM_LHU, SIM_LB, SIM_LBU, SIM_SW, SIM_SH, SIM_SB,
+
+    /* Branch to target when rs compares with (rt or immediate) */
+    SIM_BEQ, SIM_BNE, SIM_BLT, SIM_BLE, SIM_BGT, SIM_BGE,
+    SIM_BLTU, SIM_BLEU, SIM_BGTU, SIM_BGEU,
+
+    /* Jumps */
+    SIM_J, SIM_JAL, SIM_JR, SIM_JALR,
+
+    SIM_SYSCALL, SIM_NOP
+} SimOpcode;
+
+/* One instruction as written in the source */
+typedef struct {
+    SimOpcode op;
+    unsigned char rd, rs, rt;  /* Register operands */
+    unsigned char use_imm;     /* Second operand is imm rather than rt */
+    unsigned char native;      /* Machine instructions it expands to */
+    int32_t imm;               /* Immediate, offset or address */
+    int target;                /* Instruction index of a branch or jump */
+    int function;              /* Function it belongs to, -1 if none */
+    int line;                  /* Source line */
+} SimInstruction;
+
+/* A label in the text or data segment */
+typedef struct {
+    char *name;
+    int in_text;
+    uint32_t value;            /* Instruction index or data address */
+} SimLabel;
+
+/* Dynamic counts for one run */
+typedef struct {
+    long long instructions;    /* Instructions executed, as written */
+    long long native;          /* Machine instructions after expansion */
+    long long loads;
+    long long stores;
+    long long branches;        /* Conditional branches executed */
+    long long taken;           /* Conditional branches taken */
+    long long jumps;           /* j, jal, jr, jalr and b */
+    long long calls;           /* jal and jalr */
+    long long syscalls;
+} SimStats;
+
+/* Execution profile of one function */
+typedef struct {
+    const char *name;
+    int start;                 /* First instruction */
+    long long calls;
+    long long instructions;
+} SimFunction;
+
+/* A loaded program and its machine state */
+typedef struct {
+    SimInstruction *code;
+    int count;
+    int capacity;
+    SimLabel *labels;
+    int label_count;
+    int label_capacity;
+    SimFunction *functions;
+    int function_count;
+
+    unsigned char *data;       /* Data segment from SIM_DATA_BASE */
+    uint32_t data_size;
+    uint32_t data_capacity;
+    unsigned char *stack;      /* Stack ending at SIM_STACK_TOP */
+
+    int32_t regs[32];
+    int32_t hi, lo;
+    int pc;                    /* Index of the next instruction */
+
+    FILE *input;               /* Read by the input syscalls */
+    FILE *output;              /* Written by the print syscalls */
+    long long max_steps;       /* Stop after this many, 0 = no limit */
+    int exit_code;
+    SimStats stats;
+    char error[256];           /* Why loading or running failed */
+} MIPSMachine;
+
+/* Load an assembly file; returns 0, or -1 with machine->error set */
+int sim_load(MIPSMachine *machine, const char *filename);
+
+/* Run from main until exit; returns 0, or -1 with machine->error set */
+int sim_run(MIPSMachine *machine);
+
+void sim_free(MIPSMachine *machine);
+
+/* Static size: instructions as written and machine words they expand to */
+int sim_code_words(MIPSMachine *machine);
+
+#endif /* SIM_H */
@@ -0,0 +1,34 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+/*
+ * Source Input for C-Minus Compiler
+ * CST-405 Compiler Design
+ */
+
+#include <stdio.h>
+#include "globals.h"
+
+/* An open source file
+ *
+ * Regular files are memory-mapped and scanned in place with
+ * yy_scan_buffer; the mapping is followed by the two NUL sentinels flex
+ * requires. Anything that cannot be mapped (pipes, terminals, standard
+ * input) is read through the scanner's default buffered YY_INPUT.
+ */
+typedef struct {
+    char *text;                /* Mapped text plus sentinels, NULL if not mapped */
+    size_t size;               /* Bytes of source text (when mapped) */
+    size_t mapped;             /* Length of the mapping */
+    FILE *file;                /* Stream for buffered reads, NULL if mapped */
+} SourceInput;
+
+/* Open a source file; "-" is standard input. Returns 0 on success. */
+int open_source(const char *filename, SourceInput *source, Boolean allow_map);
+void close_source(SourceInput *source);
+
+/* Scanner hookup (defined in lexer.l); the compilation's source must be open */
+void scan_source(CompilationContext *ctx);
+void finish_scan(CompilationContext *ctx);
+
+#endif /* SOURCE_H */
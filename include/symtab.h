@@ -20,61 +20,93 @@ typedef enum {
 /* Symbol table entry */
 typedef struct SymbolEntry {
     char *name;                /* Symbol name */
+    int id;                    /* Dense ID (see symbol_by_id) */
     SymbolKind kind;           /* Kind of symbol */
     DataType type;             /* Data type */
     int scope_level;           /* Scope level (0 = global) */
     int memory_location;       /* Memory offset or address */
     int size;                  /* Size (for arrays) */
     int param_count;           /* Number of parameters (for functions) */
+    int frame_size;            /* Bytes of parameters and locals (for functions) */
     struct SymbolEntry *params; /* Parameter list (for functions) */
-    struct SymbolEntry *next;  /* Next entry in hash chain */
+    struct SymbolEntry *next;  /* Next parameter in a function's list */
+    struct SymbolEntry *shadowed; /* Outer binding of the same name */
+    struct SymbolEntry *scope_next; /* Next entry declared in the same scope */
     int line_number;           /* Line where declared */
     int is_used;               /* Flag for unused variable warning */
 } SymbolEntry;
 
-/* Scope management */
+/* Scope management
+ *
+ * All scopes share one hash table that maps each name to the stack of its
+ * visible bindings, innermost first (LeBlanc-Cook). A scope records the
+ * entries it declared in order; that list is the undo log exit_scope uses
+ * to pop exactly those bindings.
+ */
 typedef struct Scope {
     int level;
     int offset;                /* Current offset for local variables */
     struct Scope *parent;
-    SymbolEntry **table;       /* Hash table for this scope */
+    SymbolEntry *entries;      /* Entries declared here, in order */
+    SymbolEntry *last_entry;   /* Tail of entries */
 } Scope;
 
-/* Symbol table size */
-#define SYMTAB_SIZE 211        /* Prime number for better hashing */
+/* Binding table slot: a name and its innermost binding */
+typedef struct {
+    char *name;                /* Interned name, NULL if the slot is empty */
+    SymbolEntry *binding;      /* Innermost visible binding (may be NULL) */
+} Binding;
+
+/* Initial binding table size (power of two; grows when half full) */
+#define SYMTAB_SIZE 256
 
-/* Global symbol table and scope */
-extern Scope *current_scope;
-extern Scope *global_scope;
+/* A compilation's symbol table */
+typedef struct {
+    Binding *bindings;         /* Binding table shared by all scopes */
+    int binding_capacity;
+    int binding_count;
+    SymbolEntry **symbol_list; /* Every entry ever inserted, by ID */
+    int symbol_capacity;
+    int symbol_count;
+    Scope *current_scope;
+    Scope *global_scope;
+    int global_offset;         /* Next free global data offset */
+    SymbolEntry *input_func;   /* Built-in routines */
+    SymbolEntry *output_func;
+    SymbolEntry *main_func;    /* The program's main, once analysis found it */
+} SymbolTable;
 
 /* Symbol table operations */
-void init_symbol_table(void);
-void enter_scope(void);
-void exit_scope(void);
-SymbolEntry *insert_symbol(char *name, SymbolKind kind, DataType type);
-SymbolEntry *lookup_symbol(char *name);
-SymbolEntry *lookup_symbol_in_scope(char *name, Scope *scope);
+void init_symbol_table(CompilationContext *ctx);
+void enter_scope(CompilationContext *ctx);
+void exit_scope(CompilationContext *ctx);
+SymbolEntry *insert_symbol(CompilationContext *ctx, char *name, SymbolKind kind, DataType type);
+SymbolEntry *lookup_symbol(CompilationContext *ctx, char *name);
+SymbolEntry *lookup_symbol_in_scope(CompilationContext *ctx, char *name, Scope *scope);
 void set_symbol_type(SymbolEntry *symbol, DataType type);
 void add_param_to_function(SymbolEntry *func, SymbolEntry *param);
+SymbolEntry *symbol_by_id(CompilationContext *ctx, int id);
+int is_global_symbol(SymbolEntry *symbol);
+int is_builtin_function(CompilationContext *ctx, SymbolEntry *symbol);
 
 /* Symbol table display */
-void print_symbol_table(void);
-void print_scope(Scope *scope);
-void print_symbol(SymbolEntry *symbol);
+void print_symbol_table(CompilationContext *ctx);
+void print_scope(CompilationContext *ctx, Scope *scope);
+void print_symbol(CompilationContext *ctx, SymbolEntry *symbol);
 
 /* Symbol table analysis */
-void check_unused_symbols(void);
-int get_symbol_count(void);
-int get_scope_depth(void);
+void check_unused_symbols(CompilationContext *ctx);
+int get_symbol_count(CompilationContext *ctx);
+int get_scope_depth(CompilationContext *ctx);
 
 /* Memory management */
-int allocate_memory(int size);
-int get_current_offset(void);
+int allocate_memory(CompilationContext *ctx, int size);
+int get_current_offset(CompilationContext *ctx);
 
 /* Hash function */
-int hash_function(char *name);
+int hash_function(CompilationContext *ctx, char *name);
 
 /* Cleanup */
-void free_symbol_table(void);
+void free_symbol_table(CompilationContext *ctx);
 
 #endif /* SYMTAB_H */
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+/*
+ * Phase Timing for C-Minus Compiler
+ * CST-405 Compiler Design
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include "globals.h"
+
+/* --time-report output */
+typedef enum {
+    TIME_REPORT_NONE,
+    TIME_REPORT_TEXT,          /* Table on the progress report */
+    TIME_REPORT_JSON           /* One JSON object per file */
+} TimeReportFormat;
+
+extern TimeReportFormat time_report;
+
+#define MAX_TIMED_PHASES 32
+
+/* Cost of one phase, summed over every time it ran */
+typedef struct {
+    const char *name;
+    int depth;                 /* Nesting level under other phases */
+    int runs;                  /* Times the phase was entered */
+    double wall;               /* Elapsed seconds */
+    double cpu;                /* CPU seconds */
+    size_t allocations;        /* Region allocations made */
+    size_t peak_bytes;         /* Most region bytes live at once */
+} PhaseTiming;
+
+/* Phases of one compilation, in the order they first ran */
+typedef struct {
+    PhaseTiming phases[MAX_TIMED_PHASES];
+    int count;
+    int depth;                 /* Phases currently open */
+    Boolean thread_cpu;        /* Charge this thread's CPU time only */
+} TimeReport;
+
+/* An open phase; lives on the caller's stack */
+typedef struct {
+    int index;                 /* Row in the report, -1 when not timing */
+    double wall;               /* Clocks when the phase began */
+    double cpu;
+    size_t allocations;
+    size_t outer_peak;         /* Enclosing high-water mark, restored at the end */
+} PhaseClock;
+
+void begin_phase(CompilationContext *ctx, PhaseClock *clock, const char *name);
+void end_phase(CompilationContext *ctx, PhaseClock *clock);
+void merge_time_report(TimeReport *report, const TimeReport *other);
+void print_time_report(CompilationContext *ctx, FILE *out);
+
+#endif /* TIMING_H */
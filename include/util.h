@@ -7,15 +7,17 @@
  */
 
 #include <stdio.h>
+#include <stddef.h>
+#include "globals.h"
 
 /* String utilities */
 char *copy_string(const char *s);
 char *concat_strings(const char *s1, const char *s2);
 int string_equal(const char *s1, const char *s2);
 
-/* Error handling */
-void error(const char *format, ...);
-void warning(const char *format, ...);
+/* Error handling (counted per compilation) */
+void error(CompilationContext *ctx, const char *format, ...);
+void warning(CompilationContext *ctx, const char *format, ...);
 void fatal_error(const char *format, ...);
 
 /* Memory management */
@@ -23,6 +25,126 @@ void *safe_malloc(size_t size);
 void *safe_calloc(size_t count, size_t size);
 void *safe_realloc(void *ptr, size_t size);
 
+/* Region (arena) allocation
+ *
+ * Objects that live exactly as long as a compilation phase are bump-allocated
+ * from that phase's region and are never freed individually. Releasing a
+ * region hands its whole chunk list back to a free list in O(1), so tearing
+ * down an AST or a TAC stream no longer walks it node by node.
+ */
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;   /* Next (older) chunk in the region */
+    size_t size;               /* Usable bytes in data[] */
+    size_t used;               /* Bytes handed out so far */
+    _Alignas(max_align_t) char data[]; /* Aligned like malloc's blocks */
+} ArenaChunk;
+
+/* Usage summed over every region of a set */
+typedef struct {
+    size_t live_bytes;         /* Bytes handed out and not yet released */
+    size_t peak_bytes;         /* High-water mark of live_bytes */
+    size_t alloc_count;        /* Total allocations ever made */
+} RegionUsage;
+
+typedef struct {
+    const char *name;          /* Region name for reports */
+    ArenaChunk **free_list;    /* Where released chunks go (NULL: free them) */
+    RegionUsage *usage;        /* Set-wide counters to update (may be NULL) */
+    ArenaChunk *head;          /* Chunk currently being filled */
+    ArenaChunk *tail;          /* Oldest chunk (for O(1) release) */
+    size_t bytes_used;         /* Bytes handed out since last release */
+    size_t bytes_reserved;     /* Bytes held in chunks since last release */
+    size_t peak_bytes;         /* Largest bytes_used ever seen */
+    size_t alloc_count;        /* Total allocations ever made */
+    int release_count;         /* Number of times the region was released */
+} Arena;
+
+/* One region per compilation phase */
+typedef enum {
+    REGION_PARSE,              /* AST node array, side tables and child lists */
+    REGION_SEMANTIC,           /* Scopes and symbol table entries */
+    REGION_TAC,                /* Three-address code arrays */
+    REGION_OPTIMIZE,           /* Optimizer scratch tables */
+    REGION_BACKEND,            /* Register allocation and frame of one function */
+    REGION_NAMES,              /* Interned identifiers (whole compilation) */
+    REGION_COUNT
+} RegionId;
+
+/* A compilation's regions and the chunks they have released for reuse */
+typedef struct {
+    Arena regions[REGION_COUNT];
+    ArenaChunk *free_chunks;
+    RegionUsage usage;
+} RegionSet;
+
+#define REGION(ctx, id) (&(ctx)->memory.regions[(id)])
+
+void arena_init(Arena *arena, const char *name, ArenaChunk **free_list);
+void *arena_alloc(Arena *arena, size_t size);
+void *arena_calloc(Arena *arena, size_t count, size_t size);
+void *arena_grow(Arena *arena, void *ptr, size_t old_size, size_t new_size);
+char *arena_strdup(Arena *arena, const char *s);
+void arena_release(Arena *arena);
+
+void init_region_set(RegionSet *memory);
+void release_region_set(RegionSet *memory);
+void merge_region_usage(RegionSet *memory, const RegionSet *other);
+
+void init_regions(CompilationContext *ctx);
+void release_all_regions(CompilationContext *ctx);
+void print_region_report(CompilationContext *ctx, FILE *out);
+
+/* Identifier interning
+ *
+ * Every identifier, temporary and constant operand is stored exactly once.
+ * The returned pointer is canonical, so two names are equal exactly when
+ * their pointers are equal, and each name also carries a dense integer ID.
+ */
+typedef struct InternEntry {
+    unsigned int hash;         /* Cached hash of the name */
+    int id;                    /* Dense ID, 0..intern_count()-1 */
+    char name[];               /* NUL-terminated name */
+} InternEntry;
+
+/* Interned names of one compilation */
+typedef struct {
+    InternEntry **slots;       /* Open-addressing table, at most half full */
+    int capacity;              /* Slots allocated (power of two) */
+    InternEntry **by_id;       /* Entries indexed by ID */
+    int count;                 /* Names interned */
+    int id_capacity;           /* Entries allocated in by_id */
+} InternTable;
+
+char *intern_string(CompilationContext *ctx, const char *s);
+char *intern_name(CompilationContext *ctx, int id);
+int intern_id(const char *interned);
+int intern_count(CompilationContext *ctx);
+void reset_intern_table(CompilationContext *ctx);
+
+/* Work stacks
+ *
+ * Growable LIFO of fixed-size items on the heap, or in a region. Tree
+ * walkers use them in place of the C call stack so nesting depth is
+ * bounded only by memory.
+ */
+typedef struct {
+    char *items;               /* Item storage */
+    size_t item_size;          /* Bytes per item */
+    int count;                 /* Items on the stack */
+    int capacity;              /* Items allocated */
+    Arena *arena;              /* Region holding the items, or NULL for the heap */
+} WorkStack;
+
+void stack_init(WorkStack *stack, size_t item_size);
+void stack_init_in(WorkStack *stack, size_t item_size, Arena *arena);
+void *stack_push(WorkStack *stack);
+void *stack_top(WorkStack *stack);
+void *stack_pop(WorkStack *stack);
+void stack_free(WorkStack *stack);
+
+/* Parallel loops */
+void run_parallel(int count, int jobs, void (*task)(void *arg, int index), void *arg);
+
 /* File utilities */
 FILE *open_file(const char *filename, const char *mode);
 void close_file(FILE *file);
@@ -31,4 +153,4 @@ void close_file(FILE *file);
 void debug_print(const char *format, ...);
 void set_debug_mode(int enable);
 
-#endif /* UTIL_H */
\ No newline at end of file
+#endif /* UTIL_H */
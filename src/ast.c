@@ -6,36 +6,144 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "ast.h"
-#include "globals.h"
-
-extern int linenum;
-extern int colnum;
+#include "context.h"
 
 /* Create a generic AST node */
-ASTNode *create_node(NodeType type) {
-    ASTNode *node = (ASTNode *)malloc(sizeof(ASTNode));
-    if (node == NULL) {
-        fatal_error("Out of memory creating AST node");
+NodeId create_node(CompilationContext *ctx, NodeType type) {
+    ASTStore *ast = &ctx->ast;
+    if (ast->count == 0) {
+        ast->count = 1;  /* Reserve NO_NODE */
+    }
+    if (ast->count >= ast->capacity) {
+        Arena *parse = REGION(ctx, REGION_PARSE);
+        NodeId capacity = ast->capacity ? ast->capacity * 2 : 1024;
+        ast->nodes = (ASTNode *)arena_grow(parse, ast->nodes, ast->capacity * sizeof(ASTNode),
+                                           capacity * sizeof(ASTNode));
+        ast->lines = (int *)arena_grow(parse, ast->lines, ast->capacity * sizeof(int),
+                                       capacity * sizeof(int));
+        ast->columns = (int *)arena_grow(parse, ast->columns, ast->capacity * sizeof(int),
+                                         capacity * sizeof(int));
+        ast->capacity = capacity;
     }
     
+    NodeId id = ast->count++;
+    ASTNode *node = &ast->nodes[id];
+    memset(node, 0, sizeof(ASTNode));
     node->node_type = type;
     node->data_type = TYPE_VOID;
-    node->left = NULL;
-    node->right = NULL;
-    node->next = NULL;
-    node->line_number = linenum;
-    node->column_number = colnum;
-    node->symbol = NULL;
-    node->temp_var = -1;
-    node->code = NULL;
-    
-    return node;
+    ast->lines[id] = ctx->line;
+    ast->columns[id] = ctx->column;
+    
+    return id;
 }
 
+/* Source line of a node */
+int ast_line(CompilationContext *ctx, ASTNode *node) {
+    return ctx->ast.lines[AST_ID(ctx, node)];
+}
+
+/* Source column of a node */
+int ast_column(CompilationContext *ctx, ASTNode *node) {
+    return ctx->ast.columns[AST_ID(ctx, node)];
+}
+
+/* Symbol table entry bound to a node (filled during semantic analysis) */
+void *ast_symbol(CompilationContext *ctx, ASTNode *node) {
+    return ctx->ast.symbols ? ctx->ast.symbols[AST_ID(ctx, node)] : NULL;
+}
+
+/* Bind a symbol table entry to a node
+ * The table is sized once the tree is complete, on the first binding.
+ */
+void ast_set_symbol(CompilationContext *ctx, ASTNode *node, void *symbol) {
+    ASTStore *ast = &ctx->ast;
+    if (ast->symbols == NULL) {
+        ast->symbols = (void **)arena_calloc(REGION(ctx, REGION_PARSE), ast->count, sizeof(void *));
+    }
+    ast->symbols[AST_ID(ctx, node)] = symbol;
+}
+
+/* Code generation attributes of a node */
+ASTCodeInfo *ast_code_info(CompilationContext *ctx, ASTNode *node) {
+    ASTStore *ast = &ctx->ast;
+    if (ast->codes == NULL) {
+        ast->codes = (ASTCodeInfo *)arena_alloc(REGION(ctx, REGION_PARSE),
+                                                ast->count * sizeof(ASTCodeInfo));
+        for (NodeId i = 0; i < ast->count; i++) {
+            ast->codes[i].temp_var = -1;
+            ast->codes[i].code = NULL;
+        }
+    }
+    return &ast->codes[AST_ID(ctx, node)];
+}
+
+/* Create an empty list node */
+NodeId create_list_node(CompilationContext *ctx, NodeType type) {
+    NodeId id = create_node(ctx, type);
+    ctx->ast.nodes[id].list.items = NULL;
+    ctx->ast.nodes[id].list.count = 0;
+    return id;
+}
+
+/* Append a child to a list node
+ * The child array doubles in the parse region whenever its size reaches
+ * a power of two (starting at 4); outgrown arrays are reclaimed with the
+ * rest of the tree.
+ */
+NodeId append_to_list(CompilationContext *ctx, NodeId list, NodeId item) {
+    if (item == NO_NODE) return list;
+    
+    ASTNode *node = &ctx->ast.nodes[list];
+    int count = node->list.count;
+    if (count == 0 || (count >= 4 && (count & (count - 1)) == 0)) {
+        int capacity = count ? count * 2 : 4;
+        NodeId *items = (NodeId *)arena_alloc(REGION(ctx, REGION_PARSE), capacity * sizeof(NodeId));
+        if (count > 0) {
+            memcpy(items, node->list.items, count * sizeof(NodeId));
+        }
+        node->list.items = items;
+    }
+    
+    node->list.items[node->list.count++] = item;
+    return list;
+}
+
+/* Check if a node holds a child array */
+int is_list_node(ASTNode *node) {
+    switch (node->node_type) {
+        case NODE_PROGRAM:
+        case NODE_PARAM_LIST:
+        case NODE_LOCAL_DECLS:
+        case NODE_STMT_LIST:
+        case NODE_ARG_LIST:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/* Check if a node uses its left/right/next links */
+static int has_links(ASTNode *node) {
+    switch (node->node_type) {
+        case NODE_VAR_DECL:
+        case NODE_PARAM:
+        case NODE_ID:
+        case NODE_NUM:
+            return 0;
+        default:
+            return !is_list_node(node);
+    }
+}
+
+/*
+ * Identifier names handed to the constructors below come straight from the
+ * lexer and are already interned, so nodes store the name's intern ID.
+ */
+
 /* Create variable declaration node */
-ASTNode *create_var_decl_node(char *type, char *name, int array_size) {
-    ASTNode *node = create_node(NODE_VAR_DECL);
+NodeId create_var_decl_node(CompilationContext *ctx, char *type, char *name, int array_size) {
+    NodeId id = create_node(ctx, NODE_VAR_DECL);
+    ASTNode *node = &ctx->ast.nodes[id];
     
     if (strcmp(type, "int") == 0) {
         node->data_type = (array_size > 0) ? TYPE_ARRAY : TYPE_INT;
@@ -43,34 +151,36 @@ ASTNode *create_var_decl_node(char *type, char *name, int array_size) {
         node->data_type = TYPE_VOID;
     }
     
-    node->value.var_decl.name = copy_string(name);
-    node->value.var_decl.size = array_size;
+    node->value = intern_id(name);
+    node->array_size = array_size;
     
-    return node;
+    return id;
 }
 
 /* Create function declaration node */
-ASTNode *create_func_decl_node(char *type, char *name, ASTNode *params, ASTNode *body) {
-    ASTNode *node = create_node(NODE_FUNC_DECL);
+NodeId create_func_decl_node(CompilationContext *ctx, char *type, char *name, NodeId params, NodeId body) {
+    NodeId id = create_node(ctx, NODE_FUNC_DECL);
+    ASTNode *node = &ctx->ast.nodes[id];
     
     node->data_type = TYPE_FUNCTION;
-    node->value.func_decl.name = copy_string(name);
+    node->value = intern_id(name);
     
     if (strcmp(type, "int") == 0) {
-        node->value.func_decl.return_type = TYPE_INT;
+        node->return_type = TYPE_INT;
     } else {
-        node->value.func_decl.return_type = TYPE_VOID;
+        node->return_type = TYPE_VOID;
     }
     
     node->left = params;
     node->right = body;
     
-    return node;
+    return id;
 }
 
 /* Create parameter node */
-ASTNode *create_param_node(char *type, char *name, int is_array) {
-    ASTNode *node = create_node(NODE_PARAM);
+NodeId create_param_node(CompilationContext *ctx, char *type, char *name, int is_array) {
+    NodeId id = create_node(ctx, NODE_PARAM);
+    ASTNode *node = &ctx->ast.nodes[id];
     
     if (strcmp(type, "int") == 0) {
         node->data_type = is_array ? TYPE_ARRAY : TYPE_INT;
@@ -78,160 +188,191 @@ ASTNode *create_param_node(char *type, char *name, int is_array) {
         node->data_type = TYPE_VOID;
     }
     
-    node->value.string_val = copy_string(name);
+    node->value = intern_id(name);
     
-    return node;
+    return id;
 }
 
 /* Create compound statement node */
-ASTNode *create_compound_stmt_node(ASTNode *local_decls, ASTNode *stmt_list) {
-    ASTNode *node = create_node(NODE_COMPOUND_STMT);
-    node->left = local_decls;
-    node->right = stmt_list;
-    return node;
+NodeId create_compound_stmt_node(CompilationContext *ctx, NodeId local_decls, NodeId stmt_list) {
+    NodeId id = create_node(ctx, NODE_COMPOUND_STMT);
+    ctx->ast.nodes[id].left = local_decls;
+    ctx->ast.nodes[id].right = stmt_list;
+    return id;
 }
 
 /* Create if statement node */
-ASTNode *create_if_node(ASTNode *condition, ASTNode *then_stmt, ASTNode *else_stmt) {
-    ASTNode *node = create_node(NODE_IF_STMT);
-    node->left = condition;
-    node->right = then_stmt;
-    node->next = else_stmt;
-    return node;
+NodeId create_if_node(CompilationContext *ctx, NodeId condition, NodeId then_stmt, NodeId else_stmt) {
+    NodeId id = create_node(ctx, NODE_IF_STMT);
+    ctx->ast.nodes[id].left = condition;
+    ctx->ast.nodes[id].right = then_stmt;
+    ctx->ast.nodes[id].next = else_stmt;
+    return id;
 }
 
 /* Create while statement node */
-ASTNode *create_while_node(ASTNode *condition, ASTNode *body) {
-    ASTNode *node = create_node(NODE_WHILE_STMT);
-    node->left = condition;
-    node->right = body;
-    return node;
+NodeId create_while_node(CompilationContext *ctx, NodeId condition, NodeId body) {
+    NodeId id = create_node(ctx, NODE_WHILE_STMT);
+    ctx->ast.nodes[id].left = condition;
+    ctx->ast.nodes[id].right = body;
+    return id;
 }
 
 /* Create return statement node */
-ASTNode *create_return_node(ASTNode *expr) {
-    ASTNode *node = create_node(NODE_RETURN_STMT);
-    node->left = expr;
-    return node;
+NodeId create_return_node(CompilationContext *ctx, NodeId expr) {
+    NodeId id = create_node(ctx, NODE_RETURN_STMT);
+    ctx->ast.nodes[id].left = expr;
+    return id;
+}
+
+/* Create expression statement node */
+NodeId create_expr_stmt_node(CompilationContext *ctx, NodeId expr) {
+    NodeId id = create_node(ctx, NODE_EXPR_STMT);
+    ctx->ast.nodes[id].left = expr;
+    return id;
 }
 
 /* Create assignment node */
-ASTNode *create_assign_node(ASTNode *var, ASTNode *expr) {
-    ASTNode *node = create_node(NODE_ASSIGN);
-    node->left = var;
-    node->right = expr;
-    return node;
+NodeId create_assign_node(CompilationContext *ctx, NodeId var, NodeId expr) {
+    NodeId id = create_node(ctx, NODE_ASSIGN);
+    ctx->ast.nodes[id].left = var;
+    ctx->ast.nodes[id].right = expr;
+    return id;
 }
 
 /* Create binary operation node */
-ASTNode *create_binary_op_node(char *op, ASTNode *left, ASTNode *right) {
-    ASTNode *node = create_node(NODE_BINARY_OP);
-    node->value.string_val = copy_string(op);
-    node->left = left;
-    node->right = right;
-    return node;
+NodeId create_binary_op_node(CompilationContext *ctx, char *op, NodeId left, NodeId right) {
+    NodeId id = create_node(ctx, NODE_BINARY_OP);
+    ctx->ast.nodes[id].value = intern_id(intern_string(ctx, op));
+    ctx->ast.nodes[id].left = left;
+    ctx->ast.nodes[id].right = right;
+    return id;
 }
 
 /* Create function call node */
-ASTNode *create_call_node(char *name, ASTNode *args) {
-    ASTNode *node = create_node(NODE_CALL);
-    node->value.string_val = copy_string(name);
-    node->left = args;
-    return node;
+NodeId create_call_node(CompilationContext *ctx, char *name, NodeId args) {
+    NodeId id = create_node(ctx, NODE_CALL);
+    ctx->ast.nodes[id].value = intern_id(name);
+    ctx->ast.nodes[id].left = args;
+    return id;
 }
 
 /* Create identifier node */
-ASTNode *create_id_node(char *name) {
-    ASTNode *node = create_node(NODE_ID);
-    node->value.string_val = copy_string(name);
-    return node;
+NodeId create_id_node(CompilationContext *ctx, char *name) {
+    NodeId id = create_node(ctx, NODE_ID);
+    ctx->ast.nodes[id].value = intern_id(name);
+    return id;
 }
 
 /* Create array access node */
-ASTNode *create_array_access_node(char *name, ASTNode *index) {
-    ASTNode *node = create_node(NODE_ARRAY_ACCESS);
-    node->value.string_val = copy_string(name);
-    node->left = index;
-    return node;
+NodeId create_array_access_node(CompilationContext *ctx, char *name, NodeId index) {
+    NodeId id = create_node(ctx, NODE_ARRAY_ACCESS);
+    ctx->ast.nodes[id].value = intern_id(name);
+    ctx->ast.nodes[id].left = index;
+    return id;
 }
 
 /* Create number node */
-ASTNode *create_num_node(int value) {
-    ASTNode *node = create_node(NODE_NUM);
-    node->value.int_val = value;
-    node->data_type = TYPE_INT;
-    return node;
+NodeId create_num_node(CompilationContext *ctx, int value) {
+    NodeId id = create_node(ctx, NODE_NUM);
+    ctx->ast.nodes[id].value = value;
+    ctx->ast.nodes[id].data_type = TYPE_INT;
+    return id;
 }
 
 /* Print AST in text format */
-void print_ast(ASTNode *node, int indent) {
+void print_ast(CompilationContext *ctx, ASTNode *node, int indent) {
     if (node == NULL) return;
     
     /* Print indentation */
     for (int i = 0; i < indent; i++) {
-        printf("  ");
+        fprintf(ctx->report, "  ");
     }
     
     /* Print node type and value */
     switch (node->node_type) {
         case NODE_PROGRAM:
-            printf("PROGRAM\n");
+            fprintf(ctx->report, "PROGRAM\n");
+            break;
+        case NODE_PARAM_LIST:
+            fprintf(ctx->report, "PARAM_LIST\n");
+            break;
+        case NODE_LOCAL_DECLS:
+            fprintf(ctx->report, "LOCAL_DECLS\n");
+            break;
+        case NODE_STMT_LIST:
+            fprintf(ctx->report, "STMT_LIST\n");
+            break;
+        case NODE_ARG_LIST:
+            fprintf(ctx->report, "ARG_LIST\n");
+            break;
+        case NODE_EXPR_STMT:
+            fprintf(ctx->report, "EXPR_STMT\n");
             break;
         case NODE_VAR_DECL:
-            printf("VAR_DECL: %s", node->value.var_decl.name);
-            if (node->value.var_decl.size > 0) {
-                printf("[%d]", node->value.var_decl.size);
+            fprintf(ctx->report, "VAR_DECL: %s", AST_NAME(ctx, node));
+            if (node->array_size > 0) {
+                fprintf(ctx->report, "[%d]", node->array_size);
             }
-            printf("\n");
+            fprintf(ctx->report, "\n");
             break;
         case NODE_FUNC_DECL:
-            printf("FUNC_DECL: %s\n", node->value.func_decl.name);
+            fprintf(ctx->report, "FUNC_DECL: %s\n", AST_NAME(ctx, node));
             break;
         case NODE_PARAM:
-            printf("PARAM: %s\n", node->value.string_val);
+            fprintf(ctx->report, "PARAM: %s\n", AST_NAME(ctx, node));
             break;
         case NODE_COMPOUND_STMT:
-            printf("COMPOUND_STMT\n");
+            fprintf(ctx->report, "COMPOUND_STMT\n");
             break;
         case NODE_IF_STMT:
-            printf("IF_STMT\n");
+            fprintf(ctx->report, "IF_STMT\n");
             break;
         case NODE_WHILE_STMT:
-            printf("WHILE_STMT\n");
+            fprintf(ctx->report, "WHILE_STMT\n");
             break;
         case NODE_RETURN_STMT:
-            printf("RETURN_STMT\n");
+            fprintf(ctx->report, "RETURN_STMT\n");
             break;
         case NODE_ASSIGN:
-            printf("ASSIGN\n");
+            fprintf(ctx->report, "ASSIGN\n");
             break;
         case NODE_BINARY_OP:
-            printf("BINARY_OP: %s\n", node->value.string_val);
+            fprintf(ctx->report, "BINARY_OP: %s\n", AST_NAME(ctx, node));
             break;
         case NODE_CALL:
-            printf("CALL: %s\n", node->value.string_val);
+            fprintf(ctx->report, "CALL: %s\n", AST_NAME(ctx, node));
             break;
         case NODE_ID:
-            printf("ID: %s\n", node->value.string_val);
+            fprintf(ctx->report, "ID: %s\n", AST_NAME(ctx, node));
             break;
         case NODE_ARRAY_ACCESS:
-            printf("ARRAY_ACCESS: %s\n", node->value.string_val);
+            fprintf(ctx->report, "ARRAY_ACCESS: %s\n", AST_NAME(ctx, node));
             break;
         case NODE_NUM:
-            printf("NUM: %d\n", node->value.int_val);
+            fprintf(ctx->report, "NUM: %d\n", node->value);
             break;
         default:
-            printf("UNKNOWN_NODE\n");
+            fprintf(ctx->report, "UNKNOWN_NODE\n");
+    }
+    
+    /* Print list items in order */
+    if (is_list_node(node)) {
+        for (int i = 0; i < node->list.count; i++) {
+            print_ast(ctx, LIST_ITEM(ctx, node, i), indent + 1);
+        }
+        return;
     }
+    if (!has_links(node)) return;
     
     /* Recursively print children */
-    print_ast(node->left, indent + 1);
-    print_ast(node->right, indent + 1);
-    print_ast(node->next, indent);
+    print_ast(ctx, AST(ctx, node->left), indent + 1);
+    print_ast(ctx, AST(ctx, node->right), indent + 1);
+    print_ast(ctx, AST(ctx, node->next), indent);
 }
 
 /* Generate DOT format for GraphViz visualization */
-void print_ast_dot_helper(ASTNode *node, FILE *file, int *node_id) {
+static void print_ast_dot_helper(CompilationContext *ctx, ASTNode *node, FILE *file, int *node_id) {
     if (node == NULL) return;
     
     int current_id = (*node_id)++;
@@ -241,19 +382,19 @@ void print_ast_dot_helper(ASTNode *node, FILE *file, int *node_id) {
     
     switch (node->node_type) {
         case NODE_VAR_DECL:
-            fprintf(file, "VAR: %s", node->value.var_decl.name);
+            fprintf(file, "VAR: %s", AST_NAME(ctx, node));
             break;
         case NODE_FUNC_DECL:
-            fprintf(file, "FUNC: %s", node->value.func_decl.name);
+            fprintf(file, "FUNC: %s", AST_NAME(ctx, node));
             break;
         case NODE_ID:
-            fprintf(file, "ID: %s", node->value.string_val);
+            fprintf(file, "ID: %s", AST_NAME(ctx, node));
             break;
         case NODE_NUM:
-            fprintf(file, "NUM: %d", node->value.int_val);
+            fprintf(file, "NUM: %d", node->value);
             break;
         case NODE_BINARY_OP:
-            fprintf(file, "OP: %s", node->value.string_val);
+            fprintf(file, "OP: %s", AST_NAME(ctx, node));
             break;
         case NODE_IF_STMT:
             fprintf(file, "IF");
@@ -268,139 +409,162 @@ void print_ast_dot_helper(ASTNode *node, FILE *file, int *node_id) {
     fprintf(file, "\"];\n");
     
     /* Print edges and recurse */
+    if (is_list_node(node)) {
+        for (int i = 0; i < node->list.count; i++) {
+            int item_id = *node_id;
+            fprintf(file, "  node%d -> node%d [label=\"%d\"];\n", current_id, item_id, i);
+            print_ast_dot_helper(ctx, LIST_ITEM(ctx, node, i), file, node_id);
+        }
+        return;
+    }
+    if (!has_links(node)) return;
+    
     if (node->left) {
         int left_id = *node_id;
         fprintf(file, "  node%d -> node%d [label=\"L\"];\n", current_id, left_id);
-        print_ast_dot_helper(node->left, file, node_id);
+        print_ast_dot_helper(ctx, AST(ctx, node->left), file, node_id);
     }
     
     if (node->right) {
         int right_id = *node_id;
         fprintf(file, "  node%d -> node%d [label=\"R\"];\n", current_id, right_id);
-        print_ast_dot_helper(node->right, file, node_id);
+        print_ast_dot_helper(ctx, AST(ctx, node->right), file, node_id);
     }
     
     if (node->next) {
         int next_id = *node_id;
         fprintf(file, "  node%d -> node%d [label=\"N\"];\n", current_id, next_id);
-        print_ast_dot_helper(node->next, file, node_id);
+        print_ast_dot_helper(ctx, AST(ctx, node->next), file, node_id);
     }
 }
 
-void print_ast_dot(ASTNode *node, FILE *file) {
+void print_ast_dot(CompilationContext *ctx, ASTNode *node, FILE *file) {
     fprintf(file, "digraph AST {\n");
     fprintf(file, "  rankdir=TB;\n");
     fprintf(file, "  node [shape=box];\n");
     
     int node_id = 0;
-    print_ast_dot_helper(node, file, &node_id);
+    print_ast_dot_helper(ctx, node, file, &node_id);
     
     fprintf(file, "}\n");
 }
 
-/* Free AST memory */
-void free_ast(ASTNode *node) {
-    if (node == NULL) return;
+/* Free AST memory
+ * The node array, side tables and list arrays all live in the parse
+ * region and are released with it.
+ */
+void free_ast(CompilationContext *ctx, ASTNode *node) {
+    (void)node;
+    memset(&ctx->ast, 0, sizeof(ASTStore));
     
-    /* Free string values based on node type */
-    switch (node->node_type) {
-        case NODE_VAR_DECL:
-            if (node->value.var_decl.name) {
-                free(node->value.var_decl.name);
-            }
-            break;
-            
-        case NODE_FUNC_DECL:
-            if (node->value.func_decl.name) {
-                free(node->value.func_decl.name);
-            }
-            break;
-            
-        case NODE_ID:
-        case NODE_ARRAY_ACCESS:
-        case NODE_BINARY_OP:
-        case NODE_CALL:
-        case NODE_PARAM:
-            if (node->value.string_val) {
-                free(node->value.string_val);
-            }
-            break;
-            
-        default:
-            /* Other node types don't have string values to free */
-            break;
+    arena_release(REGION(ctx, REGION_PARSE));
+}
+
+/* Work item for the iterative tree metrics */
+typedef struct {
+    ASTNode *node;
+    int depth;
+} DepthItem;
+
+/* Push the children of a node at the given depth */
+static void push_children(CompilationContext *ctx, WorkStack *stack, ASTNode *node, int depth) {
+    if (is_list_node(node)) {
+        for (int i = node->list.count - 1; i >= 0; i--) {
+            DepthItem *item = (DepthItem *)stack_push(stack);
+            item->node = LIST_ITEM(ctx, node, i);
+            item->depth = depth;
+        }
+        return;
     }
-    
-    if (node->code) {
-        free(node->code);
+    if (!has_links(node)) return;
+    
+    NodeId children[3] = { node->left, node->right, node->next };
+    for (int i = 0; i < 3; i++) {
+        if (children[i] != NO_NODE) {
+            DepthItem *item = (DepthItem *)stack_push(stack);
+            item->node = AST(ctx, children[i]);
+            item->depth = depth;
+        }
     }
-    
-    /* Recursively free children */
-    free_ast(node->left);
-    free_ast(node->right);
-    free_ast(node->next);
-    
-    free(node);
 }
 
-/* Calculate AST height */
-int get_ast_height(ASTNode *node) {
+/* Calculate AST height (iterative, so deep trees cannot overflow the stack) */
+int get_ast_height(CompilationContext *ctx, ASTNode *node) {
     if (node == NULL) return 0;
     
-    int left_height = get_ast_height(node->left);
-    int right_height = get_ast_height(node->right);
-    int next_height = get_ast_height(node->next);
-    
-    int max_child = (left_height > right_height) ? left_height : right_height;
-    max_child = (max_child > next_height) ? max_child : next_height;
+    WorkStack stack;
+    stack_init(&stack, sizeof(DepthItem));
+    DepthItem *root = (DepthItem *)stack_push(&stack);
+    root->node = node;
+    root->depth = 1;
+    
+    int height = 0;
+    while (stack.count > 0) {
+        DepthItem item = *(DepthItem *)stack_pop(&stack);
+        if (item.depth > height) height = item.depth;
+        push_children(ctx, &stack, item.node, item.depth + 1);
+    }
     
-    return 1 + max_child;
+    stack_free(&stack);
+    return height;
 }
 
-/* Count nodes in AST */
-int count_ast_nodes(ASTNode *node) {
+/* Count nodes in AST (iterative) */
+int count_ast_nodes(CompilationContext *ctx, ASTNode *node) {
     if (node == NULL) return 0;
     
-    return 1 + count_ast_nodes(node->left) + 
-           count_ast_nodes(node->right) + 
-           count_ast_nodes(node->next);
+    WorkStack stack;
+    stack_init(&stack, sizeof(DepthItem));
+    DepthItem *root = (DepthItem *)stack_push(&stack);
+    root->node = node;
+    root->depth = 0;
+    
+    int count = 0;
+    while (stack.count > 0) {
+        DepthItem item = *(DepthItem *)stack_pop(&stack);
+        count++;
+        push_children(ctx, &stack, item.node, item.depth);
+    }
+    
+    stack_free(&stack);
+    return count;
 }
 
 /* Demonstrate difference between parse tree and AST */
-void show_parse_tree_vs_ast(void) {
-    printf("\n=== Parse Tree vs Abstract Syntax Tree ===\n\n");
-    
-    printf("For the expression: x = 2 + 3 * 4\n\n");
-    
-    printf("PARSE TREE (includes all grammar productions):\n");
-    printf("                    expression\n");
-    printf("                         |\n");
-    printf("                    assignment\n");
-    printf("                    /    |    \\\n");
-    printf("                  var   '='   simple-expr\n");
-    printf("                   |               |\n");
-    printf("                  ID:x        additive-expr\n");
-    printf("                              /    |    \\\n");
-    printf("                           term   '+'   term\n");
-    printf("                            |            |\n");
-    printf("                          factor    term '*' factor\n");
-    printf("                            |         |        |\n");
-    printf("                          NUM:2    factor    NUM:4\n");
-    printf("                                      |\n");
-    printf("                                    NUM:3\n\n");
-    
-    printf("ABSTRACT SYNTAX TREE (simplified, semantic structure):\n");
-    printf("                    ASSIGN\n");
-    printf("                    /    \\\n");
-    printf("                 ID:x     +\n");
-    printf("                        /   \\\n");
-    printf("                     NUM:2   *\n");
-    printf("                           /   \\\n");
-    printf("                        NUM:3  NUM:4\n\n");
-    
-    printf("Key Differences:\n");
-    printf("1. AST removes syntactic details (parentheses, keywords)\n");
-    printf("2. AST focuses on semantic meaning\n");
-    printf("3. AST is more compact and efficient for analysis\n");
-    printf("4. AST directly represents operator precedence\n\n");
+void show_parse_tree_vs_ast(CompilationContext *ctx) {
+    fprintf(ctx->report, "\n=== Parse Tree vs Abstract Syntax Tree ===\n\n");
+    
+    fprintf(ctx->report, "For the expression: x = 2 + 3 * 4\n\n");
+    
+    fprintf(ctx->report, "PARSE TREE (includes all grammar productions):\n");
+    fprintf(ctx->report, "                    expression\n");
+    fprintf(ctx->report, "                         |\n");
+    fprintf(ctx->report, "                    assignment\n");
+    fprintf(ctx->report, "                    /    |    \\\n");
+    fprintf(ctx->report, "                  var   '='   simple-expr\n");
+    fprintf(ctx->report, "                   |               |\n");
+    fprintf(ctx->report, "                  ID:x        additive-expr\n");
+    fprintf(ctx->report, "                              /    |    \\\n");
+    fprintf(ctx->report, "                           term   '+'   term\n");
+    fprintf(ctx->report, "                            |            |\n");
+    fprintf(ctx->report, "                          factor    term '*' factor\n");
+    fprintf(ctx->report, "                            |         |        |\n");
+    fprintf(ctx->report, "                          NUM:2    factor    NUM:4\n");
+    fprintf(ctx->report, "                                      |\n");
+    fprintf(ctx->report, "                                    NUM:3\n\n");
+    
+    fprintf(ctx->report, "ABSTRACT SYNTAX TREE (simplified, semantic structure):\n");
+    fprintf(ctx->report, "                    ASSIGN\n");
+    fprintf(ctx->report, "                    /    \\\n");
+    fprintf(ctx->report, "                 ID:x     +\n");
+    fprintf(ctx->report, "                        /   \\\n");
+    fprintf(ctx->report, "                     NUM:2   *\n");
+    fprintf(ctx->report, "                           /   \\\n");
+    fprintf(ctx->report, "                        NUM:3  NUM:4\n\n");
+    
+    fprintf(ctx->report, "Key Differences:\n");
+    fprintf(ctx->report, "1. AST removes syntactic details (parentheses, keywords)\n");
+    fprintf(ctx->report, "2. AST focuses on semantic meaning\n");
+    fprintf(ctx->report, "3. AST is more compact and efficient for analysis\n");
+    fprintf(ctx->report, "4. AST directly represents operator precedence\n\n");
 }
\ No newline at end of file
@@ -6,471 +6,741 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <stdarg.h>
-#include "codegen.h"
-#include "ast.h"
-#include "symtab.h"
-#include "globals.h"
-
-/* Global TAC context */
-TACContext *tac_context = NULL;
+#include "context.h"
 
 /* Initialize TAC generation */
-void init_tac_generation(void) {
-    tac_context = (TACContext *)malloc(sizeof(TACContext));
-    tac_context->head = NULL;
-    tac_context->tail = NULL;
-    tac_context->temp_count = 0;
-    tac_context->label_count = 0;
+void init_tac_generation(CompilationContext *ctx) {
+    ctx->tac.code = NULL;
+    ctx->tac.count = 0;
+    ctx->tac.capacity = 0;
+    ctx->tac.removed = 0;
+    ctx->tac.temp_count = 0;
+    ctx->tac.label_count = 0;
 }
 
 /* Generate TAC for entire AST */
-void generate_tac(ASTNode *tree) {
+void generate_tac(CompilationContext *ctx, ASTNode *tree) {
     if (tree == NULL) return;
     
-    printf("\n=== THREE-ADDRESS CODE GENERATION ===\n");
+    if (!quiet_mode) {
+        fprintf(ctx->report, "\n=== THREE-ADDRESS CODE GENERATION ===\n");
+    }
     
-    init_tac_generation();
-    gen_tac_node(tree);
+    init_tac_generation(ctx);
+    gen_tac_node(ctx, tree);
     
-    print_tac();
+    /* The unoptimized listing is part of the normal report */
+    if (!quiet_mode || trace_code) {
+        print_tac(ctx);
+    }
+}
+
+/* Work item for the statement walk: a node to generate, or code that
+ * follows the statements scheduled above it */
+typedef enum {
+    STMT_NODE,              /* Generate node */
+    STMT_LABEL,             /* Place label */
+    STMT_ELSE,              /* Jump to label past the else branch, place other */
+    STMT_LOOP,              /* Jump back to label, place other */
+    STMT_FUNC_END           /* End node's function */
+} StmtAction;
+
+typedef struct {
+    StmtAction action;
+    ASTNode *node;
+    int label;
+    int other;
+} StmtItem;
+
+/* Schedule a work item */
+static void push_stmt(WorkStack *pending, StmtAction action, ASTNode *node, int label, int other) {
+    if (action == STMT_NODE && node == NULL) return;
+    StmtItem *item = (StmtItem *)stack_push(pending);
+    item->action = action;
+    item->node = node;
+    item->label = label;
+    item->other = other;
 }
 
-/* Generate TAC for a node */
-TACInstruction *gen_tac_node(ASTNode *node) {
+/* Generate TAC for a node
+ *
+ * Statements are walked with an explicit work stack, like expressions:
+ * a statement emits its own code when popped and pushes, in reverse,
+ * its children and the jumps and labels that follow them. Code comes
+ * out in the order a recursive walk would give, and nesting depth is
+ * limited only by memory.
+ */
+TACInstruction *gen_tac_node(CompilationContext *ctx, ASTNode *node) {
     if (node == NULL) return NULL;
     
-    switch (node->node_type) {
-        case NODE_PROGRAM:
-            gen_tac_node(node->left);
-            gen_tac_node(node->right);
-            break;
-            
-        case NODE_FUNC_DECL:
-            gen_tac_func_decl(node);
-            break;
-            
-        case NODE_VAR_DECL:
-            gen_tac_var_decl(node);
-            break;
-            
-        case NODE_COMPOUND_STMT:
-            gen_tac_compound(node);
-            break;
-            
-        case NODE_IF_STMT:
-            gen_tac_if(node);
-            break;
-            
-        case NODE_WHILE_STMT:
-            gen_tac_while(node);
-            break;
-            
-        case NODE_RETURN_STMT:
-            gen_tac_return(node);
-            break;
-            
-        case NODE_EXPR_STMT:
-            if (node->left) {
-                gen_tac_expression(node->left);
+    WorkStack pending;
+    stack_init(&pending, sizeof(StmtItem));
+    push_stmt(&pending, STMT_NODE, node, -1, -1);
+    
+    while (pending.count > 0) {
+        StmtItem item = *(StmtItem *)stack_pop(&pending);
+        node = item.node;
+        
+        switch (item.action) {
+            case STMT_LABEL:
+                emit_label(ctx, item.label);
+                continue;
+                
+            case STMT_ELSE:
+                emit_goto(ctx, item.label);
+                emit_label(ctx, item.other);
+                continue;
+                
+            case STMT_LOOP:
+                /* Jump back to beginning, then the end of the loop */
+                emit_goto(ctx, item.label);
+                emit_label(ctx, item.other);
+                continue;
+                
+            case STMT_FUNC_END: {
+                SymbolEntry *func = (SymbolEntry *)ast_symbol(ctx, node);
+                emit_tac(ctx, create_tac(TAC_FUNC_END, operand_func(func), operand_none(), operand_none()));
+                continue;
             }
-            break;
-            
-        default:
-            gen_tac_node(node->left);
-            gen_tac_node(node->right);
-            gen_tac_node(node->next);
-            break;
+                
+            case STMT_NODE:
+                break;
+        }
+        
+        switch (node->node_type) {
+            case NODE_PROGRAM:
+            case NODE_PARAM_LIST:
+            case NODE_LOCAL_DECLS:
+            case NODE_STMT_LIST:
+            case NODE_ARG_LIST:
+                for (int i = node->list.count - 1; i >= 0; i--) {
+                    push_stmt(&pending, STMT_NODE, LIST_ITEM(ctx, node, i), -1, -1);
+                }
+                break;
+                
+            case NODE_FUNC_DECL:
+                gen_tac_func_decl(ctx, node, &pending);
+                break;
+                
+            case NODE_VAR_DECL:
+                gen_tac_var_decl(ctx, node);
+                break;
+                
+            case NODE_COMPOUND_STMT:
+                gen_tac_compound(ctx, node, &pending);
+                break;
+                
+            case NODE_IF_STMT:
+                gen_tac_if(ctx, node, &pending);
+                break;
+                
+            case NODE_WHILE_STMT:
+                gen_tac_while(ctx, node, &pending);
+                break;
+                
+            case NODE_RETURN_STMT:
+                gen_tac_return(ctx, node);
+                break;
+                
+            case NODE_EXPR_STMT:
+                if (node->left) {
+                    gen_tac_expression(ctx, AST(ctx, node->left));
+                }
+                break;
+                
+            default:
+                push_stmt(&pending, STMT_NODE, AST(ctx, node->next), -1, -1);
+                push_stmt(&pending, STMT_NODE, AST(ctx, node->right), -1, -1);
+                push_stmt(&pending, STMT_NODE, AST(ctx, node->left), -1, -1);
+                break;
+        }
     }
     
+    stack_free(&pending);
     return NULL;
 }
 
 /* Generate TAC for function declaration */
-void gen_tac_func_decl(ASTNode *node) {
-    char *func_name = node->value.func_decl.name;
+void gen_tac_func_decl(CompilationContext *ctx, ASTNode *node, WorkStack *pending) {
+    SymbolEntry *func = (SymbolEntry *)ast_symbol(ctx, node);
     
     /* Emit function begin */
-    emit_tac(create_tac(TAC_FUNC_BEGIN, func_name, NULL, NULL));
+    emit_tac(ctx, create_tac(TAC_FUNC_BEGIN, operand_func(func), operand_none(), operand_none()));
     
-    /* Generate code for function body */
-    gen_tac_node(node->right);
-    
-    /* Emit function end */
-    emit_tac(create_tac(TAC_FUNC_END, func_name, NULL, NULL));
+    /* Function body, then function end */
+    push_stmt(pending, STMT_FUNC_END, node, -1, -1);
+    push_stmt(pending, STMT_NODE, AST(ctx, node->right), -1, -1);
 }
 
 /* Generate TAC for variable declaration */
-void gen_tac_var_decl(ASTNode *node) {
+void gen_tac_var_decl(CompilationContext *ctx, ASTNode *node) {
     /* Variable declarations don't generate code in basic TAC */
     /* Memory allocation is handled by the symbol table */
 }
 
 /* Generate TAC for compound statement */
-void gen_tac_compound(ASTNode *node) {
-    /* Generate code for local declarations */
-    gen_tac_node(node->left);
-    
-    /* Generate code for statements */
-    gen_tac_node(node->right);
+void gen_tac_compound(CompilationContext *ctx, ASTNode *node, WorkStack *pending) {
+    /* Local declarations, then statements */
+    push_stmt(pending, STMT_NODE, AST(ctx, node->right), -1, -1);
+    push_stmt(pending, STMT_NODE, AST(ctx, node->left), -1, -1);
 }
 
-/* Generate TAC for expression */
-char *gen_tac_expression(ASTNode *node) {
-    if (node == NULL) return NULL;
-    
-    switch (node->node_type) {
-        case NODE_NUM:
-            {
-                char *temp = new_temp();
-                char *value = make_string("%d", node->value.int_val);
-                emit_tac(create_tac(TAC_LOAD_CONST, temp, value, NULL));
-                return temp;
-            }
-            
-        case NODE_ID:
-            return gen_tac_var(node);
-            
-        case NODE_ARRAY_ACCESS:
-            return gen_tac_var(node);
-            
-        case NODE_ASSIGN:
-            return gen_tac_assignment(node);
-            
-        case NODE_BINARY_OP:
-            return gen_tac_binary_op(node);
-            
-        case NODE_CALL:
-            return gen_tac_call(node);
-            
-        default:
-            return NULL;
+/* Work item for the iterative expression generator */
+typedef struct {
+    ASTNode *node;
+    int state;              /* Children generated so far */
+} GenFrame;
+
+/* Schedule a subexpression; a missing one yields no operand */
+static void push_gen(WorkStack *frames, WorkStack *values, ASTNode *node) {
+    if (node == NULL) {
+        *(TACOperand *)stack_push(values) = operand_none();
+        return;
     }
+    GenFrame *frame = (GenFrame *)stack_push(frames);
+    frame->node = node;
+    frame->state = 0;
 }
 
-/* Generate TAC for binary operation */
-char *gen_tac_binary_op(ASTNode *node) {
-    char *left = gen_tac_expression(node->left);
-    char *right = gen_tac_expression(node->right);
-    char *result = new_temp();
-    char *op = node->value.string_val;
-    
-    TACOpcode opcode;
-    if (strcmp(op, "+") == 0) opcode = TAC_ADD;
-    else if (strcmp(op, "-") == 0) opcode = TAC_SUB;
-    else if (strcmp(op, "*") == 0) opcode = TAC_MUL;
-    else if (strcmp(op, "/") == 0) opcode = TAC_DIV;
-    else if (strcmp(op, "<") == 0) opcode = TAC_LT;
-    else if (strcmp(op, "<=") == 0) opcode = TAC_LTE;
-    else if (strcmp(op, ">") == 0) opcode = TAC_GT;
-    else if (strcmp(op, ">=") == 0) opcode = TAC_GTE;
-    else if (strcmp(op, "==") == 0) opcode = TAC_EQ;
-    else if (strcmp(op, "!=") == 0) opcode = TAC_NEQ;
-    else opcode = TAC_ADD;  /* Default */
-    
-    emit_tac(create_tac(opcode, result, left, right));
-    return result;
+/* Finish a frame with the operand holding its value */
+static void finish_gen(WorkStack *frames, WorkStack *values, TACOperand value) {
+    stack_pop(frames);
+    *(TACOperand *)stack_push(values) = value;
 }
 
-/* Generate TAC for assignment */
-char *gen_tac_assignment(ASTNode *node) {
-    char *value = gen_tac_expression(node->right);
-    
-    if (node->left->node_type == NODE_ARRAY_ACCESS) {
-        /* Array assignment: a[i] = value */
-        char *array = node->left->value.string_val;
-        char *index = gen_tac_expression(node->left->left);
-        emit_tac(create_tac(TAC_ARRAY_STORE, array, index, value));
-    } else {
-        /* Simple assignment: x = value */
-        char *var = node->left->value.string_val;
-        emit_tac(create_tac(TAC_ASSIGN, var, value, NULL));
-    }
-    
-    return value;
-}
-
-/* Generate TAC for variable access */
-char *gen_tac_var(ASTNode *node) {
-    if (node->node_type == NODE_ARRAY_ACCESS) {
-        /* Array access: t = a[i] */
-        char *array = node->value.string_val;
-        char *index = gen_tac_expression(node->left);
-        char *temp = new_temp();
-        emit_tac(create_tac(TAC_ARRAY_LOAD, temp, array, index));
-        return temp;
-    } else {
-        /* Simple variable */
-        return copy_string(node->value.string_val);
-    }
+/* Map a binary operator to its TAC opcode */
+static TACOpcode binary_opcode(const char *op) {
+    if (strcmp(op, "+") == 0) return TAC_ADD;
+    else if (strcmp(op, "-") == 0) return TAC_SUB;
+    else if (strcmp(op, "*") == 0) return TAC_MUL;
+    else if (strcmp(op, "/") == 0) return TAC_DIV;
+    else if (strcmp(op, "<") == 0) return TAC_LT;
+    else if (strcmp(op, "<=") == 0) return TAC_LTE;
+    else if (strcmp(op, ">") == 0) return TAC_GT;
+    else if (strcmp(op, ">=") == 0) return TAC_GTE;
+    else if (strcmp(op, "==") == 0) return TAC_EQ;
+    else if (strcmp(op, "!=") == 0) return TAC_NEQ;
+    else return TAC_ADD;  /* Default */
 }
 
-/* Generate TAC for function call */
-char *gen_tac_call(ASTNode *node) {
-    char *func_name = node->value.string_val;
+/* Generate TAC for expression
+ *
+ * Uses an explicit work stack instead of recursion: operands of finished
+ * subexpressions are kept on a value stack until their parent consumes
+ * them, so instructions come out in the same order as a recursive walk.
+ */
+TACOperand gen_tac_expression(CompilationContext *ctx, ASTNode *node) {
+    if (node == NULL) return operand_none();
     
-    /* Generate code for arguments */
-    ASTNode *arg = node->left;
-    int arg_count = 0;
-    while (arg) {
-        char *arg_value;
-        if (arg->node_type == NODE_ARG_LIST) {
-            arg_value = gen_tac_expression(arg->right);
-            arg = arg->left;
-        } else {
-            arg_value = gen_tac_expression(arg);
-            arg = NULL;
-        }
-        emit_tac(create_tac(TAC_PARAM, arg_value, NULL, NULL));
-        arg_count++;
-    }
+    WorkStack frames, values;
+    stack_init(&frames, sizeof(GenFrame));
+    stack_init(&values, sizeof(TACOperand));
+    push_gen(&frames, &values, node);
     
-    /* Generate call instruction */
-    char *result = NULL;
-    if (strcmp(func_name, "output") != 0) {
-        result = new_temp();
+    while (frames.count > 0) {
+        GenFrame *frame = (GenFrame *)stack_top(&frames);
+        ASTNode *expr = frame->node;
+        
+        switch (expr->node_type) {
+            case NODE_NUM: {
+                TACOperand temp = new_temp(ctx);
+                TACOperand value = operand_const(expr->value);
+                emit_tac(ctx, create_tac(TAC_LOAD_CONST, temp, value, operand_none()));
+                finish_gen(&frames, &values, temp);
+                break;
+            }
+                
+            case NODE_ID:
+                /* Simple variable */
+                finish_gen(&frames, &values, operand_var(ast_symbol(ctx, expr)));
+                break;
+                
+            case NODE_ARRAY_ACCESS:
+                /* Array access: t = a[i] */
+                if (frame->state == 0) {
+                    frame->state = 1;
+                    push_gen(&frames, &values, AST(ctx, expr->left));
+                } else {
+                    TACOperand index = *(TACOperand *)stack_pop(&values);
+                    TACOperand array = operand_var(ast_symbol(ctx, expr));
+                    TACOperand temp = new_temp(ctx);
+                    emit_tac(ctx, create_tac(TAC_ARRAY_LOAD, temp, array, index));
+                    finish_gen(&frames, &values, temp);
+                }
+                break;
+                
+            case NODE_ASSIGN:
+                if (frame->state == 0) {
+                    frame->state = 1;
+                    push_gen(&frames, &values, AST(ctx, expr->right));
+                } else if (frame->state == 1 && AST(ctx, expr->left)->node_type == NODE_ARRAY_ACCESS) {
+                    /* Array assignment: a[i] = value */
+                    frame->state = 2;
+                    push_gen(&frames, &values, AST(ctx, AST(ctx, expr->left)->left));
+                } else if (frame->state == 1) {
+                    /* Simple assignment: x = value */
+                    TACOperand value = *(TACOperand *)stack_pop(&values);
+                    TACOperand var = operand_var(ast_symbol(ctx, AST(ctx, expr->left)));
+                    emit_tac(ctx, create_tac(TAC_ASSIGN, var, value, operand_none()));
+                    finish_gen(&frames, &values, value);
+                } else {
+                    TACOperand index = *(TACOperand *)stack_pop(&values);
+                    TACOperand value = *(TACOperand *)stack_pop(&values);
+                    TACOperand array = operand_var(ast_symbol(ctx, AST(ctx, expr->left)));
+                    emit_tac(ctx, create_tac(TAC_ARRAY_STORE, array, index, value));
+                    finish_gen(&frames, &values, value);
+                }
+                break;
+                
+            case NODE_BINARY_OP:
+                if (frame->state == 0) {
+                    frame->state = 1;
+                    push_gen(&frames, &values, AST(ctx, expr->left));
+                } else if (frame->state == 1) {
+                    frame->state = 2;
+                    push_gen(&frames, &values, AST(ctx, expr->right));
+                } else {
+                    TACOperand right = *(TACOperand *)stack_pop(&values);
+                    TACOperand left = *(TACOperand *)stack_pop(&values);
+                    TACOperand result = new_temp(ctx);
+                    emit_tac(ctx, create_tac(binary_opcode(AST_NAME(ctx, expr)), result, left, right));
+                    finish_gen(&frames, &values, result);
+                }
+                break;
+                
+            case NODE_CALL: {
+                /* Evaluate every argument before passing any, so calls nested
+                 * in later arguments cannot interleave their params with ours */
+                ASTNode *args = AST(ctx, expr->left);
+                int arg_count = LIST_COUNT(args);
+                if (frame->state < arg_count) {
+                    frame->state++;
+                    push_gen(&frames, &values, LIST_ITEM(ctx, args, frame->state - 1));
+                    break;
+                }
+                
+                /* Pass arguments in source order */
+                values.count -= arg_count;
+                TACOperand *arg_values = (TACOperand *)values.items + values.count;
+                for (int i = 0; i < arg_count; i++) {
+                    emit_tac(ctx, create_tac(TAC_PARAM, arg_values[i], operand_none(), operand_none()));
+                }
+                
+                /* Generate call instruction */
+                SymbolEntry *func = (SymbolEntry *)ast_symbol(ctx, expr);
+                TACOperand result = operand_none();
+                if (func != ctx->symtab.output_func) {
+                    result = new_temp(ctx);
+                }
+                emit_tac(ctx, create_tac(TAC_CALL, result, operand_func(func), operand_const(arg_count)));
+                finish_gen(&frames, &values, result);
+                break;
+            }
+                
+            default:
+                finish_gen(&frames, &values, operand_none());
+                break;
+        }
     }
     
-    char *count_str = make_string("%d", arg_count);
-    emit_tac(create_tac(TAC_CALL, result, func_name, count_str));
-    
+    TACOperand result = *(TACOperand *)stack_pop(&values);
+    stack_free(&frames);
+    stack_free(&values);
     return result;
 }
 
-/* Generate TAC for if statement */
-void gen_tac_if(ASTNode *node) {
-    char *cond = gen_tac_expression(node->left);
-    int false_label = new_label();
-    int end_label = new_label();
+/* Generate TAC for if statement
+ * An else-if is just another if statement on the work stack; the end
+ * labels of a chain come out innermost first.
+ */
+void gen_tac_if(CompilationContext *ctx, ASTNode *node, WorkStack *pending) {
+    TACOperand cond = gen_tac_expression(ctx, AST(ctx, node->left));
+    int false_label = new_label(ctx);
+    int end_label = new_label(ctx);
     
     /* If condition is false, jump to false_label */
-    emit_conditional(cond, false_label, 0);
-    
-    /* Generate code for then branch */
-    gen_tac_node(node->right);
+    emit_conditional(ctx, cond, false_label, 0);
     
     if (node->next) {
-        /* If there's an else branch */
-        emit_goto(end_label);
-        emit_label(false_label);
-        gen_tac_node(node->next);
-        emit_label(end_label);
+        /* Then branch, a jump over the else branch, the else branch */
+        push_stmt(pending, STMT_LABEL, NULL, end_label, -1);
+        push_stmt(pending, STMT_NODE, AST(ctx, node->next), -1, -1);
+        push_stmt(pending, STMT_ELSE, NULL, end_label, false_label);
     } else {
-        emit_label(false_label);
+        push_stmt(pending, STMT_LABEL, NULL, false_label, -1);
     }
+    push_stmt(pending, STMT_NODE, AST(ctx, node->right), -1, -1);
 }
 
 /* Generate TAC for while statement */
-void gen_tac_while(ASTNode *node) {
-    int begin_label = new_label();
-    int end_label = new_label();
+void gen_tac_while(CompilationContext *ctx, ASTNode *node, WorkStack *pending) {
+    int begin_label = new_label(ctx);
+    int end_label = new_label(ctx);
     
     /* Begin of loop */
-    emit_label(begin_label);
+    emit_label(ctx, begin_label);
     
     /* Evaluate condition */
-    char *cond = gen_tac_expression(node->left);
+    TACOperand cond = gen_tac_expression(ctx, AST(ctx, node->left));
     
     /* If condition is false, exit loop */
-    emit_conditional(cond, end_label, 0);
-    
-    /* Generate code for loop body */
-    gen_tac_node(node->right);
-    
-    /* Jump back to beginning */
-    emit_goto(begin_label);
+    emit_conditional(ctx, cond, end_label, 0);
     
-    /* End of loop */
-    emit_label(end_label);
+    /* Loop body, then the jump back and the end of the loop */
+    push_stmt(pending, STMT_LOOP, NULL, begin_label, end_label);
+    push_stmt(pending, STMT_NODE, AST(ctx, node->right), -1, -1);
 }
 
 /* Generate TAC for return statement */
-void gen_tac_return(ASTNode *node) {
+void gen_tac_return(CompilationContext *ctx, ASTNode *node) {
     if (node->left) {
-        char *value = gen_tac_expression(node->left);
-        emit_tac(create_tac(TAC_RETURN, value, NULL, NULL));
+        TACOperand value = gen_tac_expression(ctx, AST(ctx, node->left));
+        emit_tac(ctx, create_tac(TAC_RETURN, value, operand_none(), operand_none()));
     } else {
-        emit_tac(create_tac(TAC_RETURN, NULL, NULL, NULL));
+        emit_tac(ctx, create_tac(TAC_RETURN, operand_none(), operand_none(), operand_none()));
     }
 }
 
-/* Create a TAC instruction */
-TACInstruction *create_tac(TACOpcode op, char *result, char *arg1, char *arg2) {
-    TACInstruction *instr = (TACInstruction *)malloc(sizeof(TACInstruction));
-    instr->opcode = op;
-    instr->result = result ? copy_string(result) : NULL;
-    instr->arg1 = arg1 ? copy_string(arg1) : NULL;
-    instr->arg2 = arg2 ? copy_string(arg2) : NULL;
-    instr->label = -1;
-    instr->next = NULL;
+/* Create a TAC instruction
+ * Operands are stored inline; names are referenced by their intern ID.
+ */
+TACInstruction create_tac(TACOpcode op, TACOperand result, TACOperand arg1, TACOperand arg2) {
+    TACInstruction instr;
+    instr.opcode = op;
+    instr.result = result;
+    instr.arg1 = arg1;
+    instr.arg2 = arg2;
+    instr.label = -1;
     return instr;
 }
 
-/* Emit a TAC instruction */
-void emit_tac(TACInstruction *instr) {
-    if (tac_context->head == NULL) {
-        tac_context->head = instr;
-        tac_context->tail = instr;
-    } else {
-        tac_context->tail->next = instr;
-        tac_context->tail = instr;
+/* Append a TAC instruction to the stream
+ * The returned pointer is valid until the next instruction is emitted.
+ */
+TACInstruction *emit_tac(CompilationContext *ctx, TACInstruction instr) {
+    if (ctx->tac.count == ctx->tac.capacity) {
+        int capacity = ctx->tac.capacity ? ctx->tac.capacity * 2 : 256;
+        ctx->tac.code = (TACInstruction *)arena_grow(REGION(ctx, REGION_TAC), ctx->tac.code,
+                                ctx->tac.capacity * sizeof(TACInstruction),
+                                capacity * sizeof(TACInstruction));
+        ctx->tac.capacity = capacity;
     }
+    
+    TACInstruction *slot = &ctx->tac.code[ctx->tac.count++];
+    *slot = instr;
+    return slot;
 }
 
 /* Emit a label */
-void emit_label(int label) {
-    TACInstruction *instr = create_tac(TAC_LABEL, NULL, NULL, NULL);
-    instr->label = label;
-    emit_tac(instr);
+void emit_label(CompilationContext *ctx, int label) {
+    TACInstruction instr = create_tac(TAC_LABEL, operand_none(), operand_none(), operand_none());
+    instr.label = label;
+    emit_tac(ctx, instr);
 }
 
 /* Emit a goto */
-void emit_goto(int label) {
-    TACInstruction *instr = create_tac(TAC_GOTO, NULL, NULL, NULL);
-    instr->label = label;
-    emit_tac(instr);
+void emit_goto(CompilationContext *ctx, int label) {
+    TACInstruction instr = create_tac(TAC_GOTO, operand_none(), operand_none(), operand_none());
+    instr.label = label;
+    emit_tac(ctx, instr);
 }
 
 /* Emit a conditional jump */
-void emit_conditional(char *cond, int label, int if_true) {
-    TACInstruction *instr = create_tac(
+void emit_conditional(CompilationContext *ctx, TACOperand cond, int label, int if_true) {
+    TACInstruction instr = create_tac(
         if_true ? TAC_IF_TRUE : TAC_IF_FALSE,
-        cond, NULL, NULL
+        cond, operand_none(), operand_none()
     );
-    instr->label = label;
-    emit_tac(instr);
+    instr.label = label;
+    emit_tac(ctx, instr);
 }
 
 /* Generate new temporary variable */
-char *new_temp(void) {
-    return make_string("t%d", tac_context->temp_count++);
+TACOperand new_temp(CompilationContext *ctx) {
+    return operand_temp(ctx->tac.temp_count++);
 }
 
 /* Generate new label */
-int new_label(void) {
-    return tac_context->label_count++;
+int new_label(CompilationContext *ctx) {
+    return ctx->tac.label_count++;
 }
 
-/* Create a formatted string */
-char *make_string(const char *format, ...) {
-    va_list args;
-    char buffer[256];
-    
-    va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
-    va_end(args);
-    
-    return copy_string(buffer);
+/* Operand constructors */
+TACOperand operand_none(void) {
+    TACOperand op = { OPERAND_NONE, 0 };
+    return op;
 }
 
-/* Print TAC instruction */
-void print_tac_instruction(TACInstruction *instr) {
+TACOperand operand_temp(int number) {
+    TACOperand op = { OPERAND_TEMP, number };
+    return op;
+}
+
+TACOperand operand_var(SymbolEntry *symbol) {
+    TACOperand op = { OPERAND_VAR, symbol->id };
+    return op;
+}
+
+TACOperand operand_const(int value) {
+    TACOperand op = { OPERAND_CONST, value };
+    return op;
+}
+
+TACOperand operand_func(SymbolEntry *symbol) {
+    TACOperand op = { OPERAND_FUNC, symbol->id };
+    return op;
+}
+
+/* Get the symbol a variable or function operand is bound to */
+SymbolEntry *operand_symbol(CompilationContext *ctx, TACOperand op) {
+    if (op.kind == OPERAND_VAR || op.kind == OPERAND_FUNC) {
+        return symbol_by_id(ctx, op.value);
+    }
+    return NULL;
+}
+
+/* Check whether two operands denote the same value */
+int operand_equal(TACOperand a, TACOperand b) {
+    return a.kind == b.kind && a.value == b.value;
+}
+
+/* Get the interned name of a variable or function operand */
+char *operand_name(CompilationContext *ctx, TACOperand op) {
+    SymbolEntry *symbol = operand_symbol(ctx, op);
+    return symbol ? symbol->name : NULL;
+}
+
+/* Format an operand as text; buffer must hold OPERAND_BUFFER_SIZE bytes */
+const char *format_operand(CompilationContext *ctx, TACOperand op, char *buffer) {
+    switch (op.kind) {
+        case OPERAND_TEMP:
+            snprintf(buffer, OPERAND_BUFFER_SIZE, "t%d", op.value);
+            return buffer;
+        case OPERAND_CONST:
+            snprintf(buffer, OPERAND_BUFFER_SIZE, "%d", op.value);
+            return buffer;
+        case OPERAND_LABEL:
+            snprintf(buffer, OPERAND_BUFFER_SIZE, "L%d", op.value);
+            return buffer;
+        case OPERAND_VAR:
+        case OPERAND_FUNC:
+            return symbol_by_id(ctx, op.value)->name;
+        default:
+            return "(null)";
+    }
+}
+
+/* Write one TAC instruction in its textual form */
+static void write_tac_instruction(CompilationContext *ctx, FILE *out, TACInstruction *instr) {
+    char rbuf[OPERAND_BUFFER_SIZE], abuf[OPERAND_BUFFER_SIZE], bbuf[OPERAND_BUFFER_SIZE];
+    const char *result = format_operand(ctx, instr->result, rbuf);
+    const char *arg1 = format_operand(ctx, instr->arg1, abuf);
+    const char *arg2 = format_operand(ctx, instr->arg2, bbuf);
+    
     switch (instr->opcode) {
         case TAC_ADD:
-            printf("    %s = %s + %s\n", instr->result, instr->arg1, instr->arg2);
+            fprintf(out, "    %s = %s + %s\n", result, arg1, arg2);
             break;
         case TAC_SUB:
-            printf("    %s = %s - %s\n", instr->result, instr->arg1, instr->arg2);
+            fprintf(out, "    %s = %s - %s\n", result, arg1, arg2);
             break;
         case TAC_MUL:
-            printf("    %s = %s * %s\n", instr->result, instr->arg1, instr->arg2);
+            fprintf(out, "    %s = %s * %s\n", result, arg1, arg2);
             break;
         case TAC_DIV:
-            printf("    %s = %s / %s\n", instr->result, instr->arg1, instr->arg2);
+            fprintf(out, "    %s = %s / %s\n", result, arg1, arg2);
             break;
         case TAC_ASSIGN:
-            printf("    %s = %s\n", instr->result, instr->arg1);
+            fprintf(out, "    %s = %s\n", result, arg1);
             break;
         case TAC_LOAD_CONST:
-            printf("    %s = %s\n", instr->result, instr->arg1);
+            fprintf(out, "    %s = %s\n", result, arg1);
             break;
         case TAC_ARRAY_LOAD:
-            printf("    %s = %s[%s]\n", instr->result, instr->arg1, instr->arg2);
+            fprintf(out, "    %s = %s[%s]\n", result, arg1, arg2);
             break;
         case TAC_ARRAY_STORE:
-            printf("    %s[%s] = %s\n", instr->result, instr->arg1, instr->arg2);
+            fprintf(out, "    %s[%s] = %s\n", result, arg1, arg2);
             break;
         case TAC_LT:
-            printf("    %s = %s < %s\n", instr->result, instr->arg1, instr->arg2);
+            fprintf(out, "    %s = %s < %s\n", result, arg1, arg2);
             break;
         case TAC_LTE:
-            printf("    %s = %s <= %s\n", instr->result, instr->arg1, instr->arg2);
+            fprintf(out, "    %s = %s <= %s\n", result, arg1, arg2);
             break;
         case TAC_GT:
-            printf("    %s = %s > %s\n", instr->result, instr->arg1, instr->arg2);
+            fprintf(out, "    %s = %s > %s\n", result, arg1, arg2);
             break;
         case TAC_GTE:
-            printf("    %s = %s >= %s\n", instr->result, instr->arg1, instr->arg2);
+            fprintf(out, "    %s = %s >= %s\n", result, arg1, arg2);
             break;
         case TAC_EQ:
-            printf("    %s = %s == %s\n", instr->result, instr->arg1, instr->arg2);
+            fprintf(out, "    %s = %s == %s\n", result, arg1, arg2);
             break;
         case TAC_NEQ:
-            printf("    %s = %s != %s\n", instr->result, instr->arg1, instr->arg2);
+            fprintf(out, "    %s = %s != %s\n", result, arg1, arg2);
             break;
         case TAC_GOTO:
-            printf("    goto L%d\n", instr->label);
+            fprintf(out, "    goto L%d\n", instr->label);
             break;
         case TAC_IF_TRUE:
-            printf("    if %s goto L%d\n", instr->result, instr->label);
+            fprintf(out, "    if %s goto L%d\n", result, instr->label);
             break;
         case TAC_IF_FALSE:
-            printf("    if !%s goto L%d\n", instr->result, instr->label);
+            fprintf(out, "    if !%s goto L%d\n", result, instr->label);
             break;
         case TAC_LABEL:
-            printf("L%d:\n", instr->label);
+            fprintf(out, "L%d:\n", instr->label);
             break;
         case TAC_PARAM:
-            printf("    param %s\n", instr->result);
+            fprintf(out, "    param %s\n", result);
             break;
         case TAC_CALL:
-            if (instr->result) {
-                printf("    %s = call %s, %s\n", instr->result, instr->arg1, instr->arg2);
+            if (instr->result.kind != OPERAND_NONE) {
+                fprintf(out, "    %s = call %s, %s\n", result, arg1, arg2);
             } else {
-                printf("    call %s, %s\n", instr->arg1, instr->arg2);
+                fprintf(out, "    call %s, %s\n", arg1, arg2);
             }
             break;
         case TAC_RETURN:
-            if (instr->result) {
-                printf("    return %s\n", instr->result);
+            if (instr->result.kind != OPERAND_NONE) {
+                fprintf(out, "    return %s\n", result);
             } else {
-                printf("    return\n");
+                fprintf(out, "    return\n");
             }
             break;
         case TAC_FUNC_BEGIN:
-            printf("\nBEGIN_FUNC %s\n", instr->result);
+            fprintf(out, "\nBEGIN_FUNC %s\n", result);
             break;
         case TAC_FUNC_END:
-            printf("END_FUNC %s\n\n", instr->result);
+            fprintf(out, "END_FUNC %s\n\n", result);
+            break;
+        case TAC_NOP:
             break;
         default:
-            printf("    UNKNOWN\n");
+            fprintf(out, "    UNKNOWN\n");
     }
 }
 
+/* Print TAC instruction */
+void print_tac_instruction(CompilationContext *ctx, TACInstruction *instr) {
+    write_tac_instruction(ctx, ctx->report, instr);
+}
+
 /* Print all TAC instructions */
-void print_tac(void) {
-    printf("\n=== THREE-ADDRESS CODE ===\n");
-    TACInstruction *instr = tac_context->head;
-    while (instr) {
-        print_tac_instruction(instr);
-        instr = instr->next;
+void print_tac(CompilationContext *ctx) {
+    fprintf(ctx->report, "\n=== THREE-ADDRESS CODE ===\n");
+    for (int i = 0; i < ctx->tac.count; i++) {
+        print_tac_instruction(ctx, &ctx->tac.code[i]);
+    }
+}
+
+/* Write all TAC instructions to a file */
+void write_tac_to_file(CompilationContext *ctx, FILE *file) {
+    for (int i = 0; i < ctx->tac.count; i++) {
+        write_tac_instruction(ctx, file, &ctx->tac.code[i]);
     }
 }
 
 /* Get TAC list (for optimizer) */
-TACInstruction *get_tac_list(void) {
-    return tac_context->head;
+TACInstruction *get_tac_list(CompilationContext *ctx) {
+    return ctx->tac.code;
+}
+
+/* Get number of slots in the TAC list (including tombstones) */
+int get_tac_count(CompilationContext *ctx) {
+    return ctx->tac.count;
+}
+
+/* Set TAC list (after optimization)
+ * The list comes from the TAC region; the one it replaces stays there
+ * until free_tac.
+ */
+void set_tac_list(CompilationContext *ctx, TACInstruction *list, int count) {
+    if (list != ctx->tac.code) {
+        ctx->tac.code = list;
+        ctx->tac.capacity = count;
+    }
+    ctx->tac.count = count;
+    ctx->tac.removed = 0;
+    for (int i = 0; i < count; i++) {
+        if (list[i].opcode == TAC_NOP) ctx->tac.removed++;
+    }
+}
+
+/* Remove an instruction in O(1) by leaving a tombstone */
+void remove_tac(CompilationContext *ctx, int index) {
+    if (ctx->tac.code[index].opcode != TAC_NOP) {
+        ctx->tac.code[index].opcode = TAC_NOP;
+        ctx->tac.removed++;
+    }
+}
+
+/* Index of the next live instruction after index (count if none) */
+int next_tac_index(CompilationContext *ctx, int index) {
+    do {
+        index++;
+    } while (index < ctx->tac.count && ctx->tac.code[index].opcode == TAC_NOP);
+    return index;
 }
 
-/* Set TAC list (after optimization) */
-void set_tac_list(TACInstruction *list) {
-    tac_context->head = list;
+/* Index of the previous live instruction before index (-1 if none) */
+int prev_tac_index(CompilationContext *ctx, int index) {
+    do {
+        index--;
+    } while (index >= 0 && ctx->tac.code[index].opcode == TAC_NOP);
+    return index;
+}
+
+/* Squeeze tombstones out of the stream in one pass */
+void compact_tac(CompilationContext *ctx) {
+    if (ctx->tac.removed == 0) return;
     
-    /* Find new tail */
-    TACInstruction *tail = list;
-    while (tail && tail->next) {
-        tail = tail->next;
+    int out = 0;
+    for (int i = 0; i < ctx->tac.count; i++) {
+        if (ctx->tac.code[i].opcode != TAC_NOP) {
+            ctx->tac.code[out++] = ctx->tac.code[i];
+        }
     }
-    tac_context->tail = tail;
+    ctx->tac.count = out;
+    ctx->tac.removed = 0;
+}
+
+/* Split a stream into one range per function
+ *
+ * A range starts at each TAC_FUNC_BEGIN; anything ahead of the first
+ * function gets a range of its own, so the ranges cover the whole stream
+ * in order. Returns the number of ranges; the caller frees *ranges.
+ */
+int split_tac_functions(TACInstruction *code, int count, TACRange **ranges) {
+    int capacity = 16;
+    int found = 0;
+    *ranges = (TACRange *)safe_malloc(capacity * sizeof(TACRange));
+    
+    for (int i = 0; i < count; i++) {
+        if (i > 0 && code[i].opcode != TAC_FUNC_BEGIN) continue;
+        
+        if (found == capacity) {
+            capacity *= 2;
+            *ranges = (TACRange *)safe_realloc(*ranges, capacity * sizeof(TACRange));
+        }
+        if (found > 0) {
+            (*ranges)[found - 1].count = i - (*ranges)[found - 1].start;
+        }
+        (*ranges)[found].start = i;
+        found++;
+    }
+    if (found > 0) {
+        (*ranges)[found - 1].count = count - (*ranges)[found - 1].start;
+    }
+    return found;
+}
+
+/* Free all TAC instructions */
+void free_tac(CompilationContext *ctx) {
+    ctx->tac.code = NULL;
+    ctx->tac.count = 0;
+    ctx->tac.capacity = 0;
+    ctx->tac.removed = 0;
+    arena_release(REGION(ctx, REGION_TAC));
 }
\ No newline at end of file
@@ -0,0 +1,83 @@
+/*
+ * Compilation Context Implementation
+ * CST-405 Compiler Design
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "context.h"
+
+/* Create an empty context for one source file
+ *
+ * Progress goes to stdout and diagnostics to stderr; a caller that wants
+ * to collect them (batch mode) points the two streams elsewhere.
+ */
+CompilationContext *create_context(const char *filename) {
+    CompilationContext *ctx = (CompilationContext *)safe_calloc(1, sizeof(CompilationContext));
+    ctx->filename = filename;
+    ctx->report = stdout;
+    ctx->diagnostics = stderr;
+    ctx->line = 1;
+    ctx->column = 1;
+    ctx->ast_root = NO_NODE;
+    init_regions(ctx);
+    return ctx;
+}
+
+/* Free a context and everything the compilation left in it */
+void free_context(CompilationContext *ctx) {
+    if (ctx == NULL) return;
+    
+    if (ctx->output) {
+        fclose(ctx->output);
+    }
+    close_source(&ctx->source);
+    free_ast(ctx, AST(ctx, ctx->ast_root));
+    free_tac(ctx);
+    free_symbol_table(ctx);
+    release_all_regions(ctx);
+    free(ctx);
+}
+
+/* Create a context for working on one function of a unit
+ *
+ * The child shares the parent's names and symbol table, which are only
+ * read once code generation starts, and gets its own TAC stream,
+ * optimizer counters, back-end state and scratch regions. Sibling
+ * functions can therefore be optimized and lowered on separate threads.
+ */
+CompilationContext *create_function_context(CompilationContext *parent) {
+    CompilationContext *child = (CompilationContext *)safe_malloc(sizeof(CompilationContext));
+    *child = *parent;
+    
+    memset(&child->source, 0, sizeof(SourceInput));
+    child->scanner = NULL;
+    child->output = NULL;
+    memset(&child->tac, 0, sizeof(TACContext));
+    memset(&child->opt_stats, 0, sizeof(OptimizationStats));
+    memset(&child->mips, 0, sizeof(MIPSContext));
+    memset(&child->timing, 0, sizeof(TimeReport));
+    child->timing.thread_cpu = TRUE;
+    child->error_count = 0;
+    child->warning_count = 0;
+    init_region_set(&child->memory);
+    return child;
+}
+
+/* Fold a function context's counters into its parent and free it */
+void finish_function_context(CompilationContext *parent, CompilationContext *child) {
+    parent->opt_stats.constants_folded += child->opt_stats.constants_folded;
+    parent->opt_stats.dead_code_removed += child->opt_stats.dead_code_removed;
+    parent->opt_stats.copies_propagated += child->opt_stats.copies_propagated;
+    parent->opt_stats.dead_copies_removed += child->opt_stats.dead_copies_removed;
+    parent->opt_stats.expressions_simplified += child->opt_stats.expressions_simplified;
+    parent->opt_stats.subexpressions_eliminated += child->opt_stats.subexpressions_eliminated;
+    parent->error_count += child->error_count;
+    parent->warning_count += child->warning_count;
+    merge_region_usage(&parent->memory, &child->memory);
+    merge_time_report(&parent->timing, &child->timing);
+    
+    release_region_set(&child->memory);
+    free(child);
+}
@@ -16,23 +16,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <getopt.h>
-#include "globals.h"
-#include "ast.h"
-#include "symtab.h"
+#include <pthread.h>
+#include <unistd.h>
+#include "context.h"
 #include "semantic.h"
-#include "codegen.h"
-#include "optimize.h"
-#include "mips.h"
-#include "util.h"
-
-/* External declarations */
-extern FILE *yyin;
-extern int yyparse(void);
-extern ASTNode *ast_root;
+#include "parser.tab.h"
 
 /* Global file handles */
-FILE *source_file = NULL;
-FILE *output_file = NULL;
 FILE *listing_file = NULL;
 
 /* Compilation flags */
@@ -41,24 +31,99 @@ Boolean trace_parse = FALSE;
 Boolean trace_semantic = FALSE;
 Boolean trace_code = FALSE;
 Boolean generate_code = TRUE;
+Boolean report_memory = FALSE;
+Boolean report_registers = FALSE;
+Boolean quiet_mode = FALSE;
+TimeReportFormat time_report = TIME_REPORT_NONE;
 
 /* Optimization level */
 int optimization_level = 1;
+static Boolean optimization_level_set = FALSE;
+
+/* Functions of one file optimized and emitted at once (0 = one per core) */
+int function_jobs = 0;
+static Boolean function_jobs_set = FALSE;
+
+/* Batch mode: compile many files in one process */
+static Boolean batch_mode = FALSE;
+static int job_count = 0;              /* Worker threads, 0 = one per core */
+
+/* One file of a batch and what its compilation printed */
+typedef struct {
+    const char *filename;
+    char *report;              /* Captured progress output */
+    size_t report_size;
+    char *diagnostics;         /* Captured errors and warnings */
+    size_t diagnostics_size;
+    int error_count;
+    int warning_count;
+    Boolean done;
+} BatchUnit;
+
+/* Work shared by the batch workers
+ *
+ * Workers claim units in input order; the main thread prints each unit's
+ * report as soon as it and every unit before it have finished, so the
+ * output does not depend on which worker ran what.
+ */
+typedef struct {
+    BatchUnit *units;
+    int count;
+    int next;                  /* Next unit to claim */
+    pthread_mutex_t lock;
+    pthread_cond_t finished;
+} BatchQueue;
 
 /* Function prototypes */
 void print_usage(const char *program_name);
 void parse_arguments(int argc, char *argv[]);
-void compile_file(const char *filename);
+void print_options(void);
+void compile_file(CompilationContext *ctx);
+int compile_batch(const char **files, int count);
 
-int main(int argc, char *argv[]) {
-    printf("==============================================\n");
-    printf("      C-MINUS COMPILER\n");
-    printf("      CST-405 Compiler Design\n");
-    printf("==============================================\n\n");
+static void add_file(const char ***files, int *count, int *capacity, const char *name) {
+    if (*count == *capacity) {
+        *capacity = (*capacity == 0) ? 16 : *capacity * 2;
+        *files = (const char **)safe_realloc(*files, *capacity * sizeof(const char *));
+    }
+    (*files)[(*count)++] = name;
+}
+
+/* Append the files named in a list file, one per line; '#' starts a comment */
+static void read_list_file(const char *listname, const char ***files, int *count, int *capacity) {
+    FILE *list = fopen(listname, "r");
+    if (list == NULL) {
+        fatal_error("Cannot open list file: %s", listname);
+    }
     
+    char line[4096];
+    while (fgets(line, sizeof(line), list) != NULL) {
+        char *start = line;
+        while (*start == ' ' || *start == '\t') start++;
+        char *end = start + strlen(start);
+        while (end > start && (end[-1] == '\n' || end[-1] == '\r' ||
+                               end[-1] == ' ' || end[-1] == '\t')) {
+            *--end = '\0';
+        }
+        if (*start != '\0' && *start != '#') {
+            add_file(files, count, capacity, copy_string(start));
+        }
+    }
+    fclose(list);
+}
+
+int main(int argc, char *argv[]) {
     /* Parse command line arguments */
     parse_arguments(argc, argv);
     
+    if (!quiet_mode) {
+        printf("==============================================\n");
+        printf("      C-MINUS COMPILER\n");
+        printf("      CST-405 Compiler Design\n");
+        printf("==============================================\n\n");
+        print_options();
+    }
+    
     /* Check if input file was provided */
     if (optind >= argc) {
         fprintf(stderr, "Error: No input file specified\n");
@@ -66,105 +131,314 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
+    /* Any @listfile argument implies batch mode */
+    const char **files = NULL;
+    int file_count = 0, file_capacity = 0;
+    for (int i = optind; i < argc; i++) {
+        if (argv[i][0] == '@') {
+            read_list_file(argv[i] + 1, &files, &file_count, &file_capacity);
+            batch_mode = TRUE;
+        } else {
+            add_file(&files, &file_count, &file_capacity, argv[i]);
+        }
+    }
+    
+    if (batch_mode) {
+        /* Files already run side by side; keep each file on its worker */
+        if (!function_jobs_set) {
+            function_jobs = 1;
+        }
+        int failed = compile_batch(files, file_count);
+        return (failed > 0) ? 1 : 0;
+    }
+    
     /* Compile the input file */
-    compile_file(argv[optind]);
+    CompilationContext *ctx = create_context(files[0]);
+    free(files);
+    compile_file(ctx);
+    
+    if (report_memory) {
+        print_region_report(ctx, stdout);
+    }
+    if (time_report != TIME_REPORT_NONE) {
+        print_time_report(ctx, stdout);
+    }
     
     /* Report final status */
+    int errors = ctx->error_count;
+    if (quiet_mode) {
+        free_context(ctx);
+        return (errors > 0) ? 1 : 0;
+    }
     printf("\n==============================================\n");
     printf("COMPILATION SUMMARY:\n");
-    printf("  Errors:   %d\n", error_count);
-    printf("  Warnings: %d\n", warning_count);
+    printf("  Errors:   %d\n", errors);
+    printf("  Warnings: %d\n", ctx->warning_count);
     
-    if (error_count == 0) {
+    if (errors == 0) {
         printf("  Status:   SUCCESS\n");
     } else {
         printf("  Status:   FAILED\n");
     }
     printf("==============================================\n");
     
-    return (error_count > 0) ? 1 : 0;
+    free_context(ctx);
+    return (errors > 0) ? 1 : 0;
 }
 
 /* Compile a single file */
-void compile_file(const char *filename) {
-    printf("Compiling: %s\n\n", filename);
+void compile_file(CompilationContext *ctx) {
+    const char *filename = ctx->filename;
+    if (!quiet_mode) {
+        fprintf(ctx->report, "Compiling: %s\n\n", filename);
+    }
     
-    /* Open source file */
-    source_file = fopen(filename, "r");
-    if (source_file == NULL) {
-        fatal_error("Cannot open source file: %s", filename);
+    /* Open source file (memory-mapped when it is a regular file) */
+    if (open_source(filename, &ctx->source, TRUE) != 0) {
+        error(ctx, "Cannot open source file: %s", filename);
+        return;
     }
-    yyin = source_file;
     
     /* Create output filename */
-    char output_filename[256];
-    strcpy(output_filename, filename);
+    char output_filename[4096];
+    snprintf(output_filename, sizeof(output_filename) - 2, "%s",
+             strcmp(filename, "-") == 0 ? "stdin" : filename);
     char *ext = strrchr(output_filename, '.');
-    if (ext) *ext = '\0';
+    if (ext && strchr(ext, '/') == NULL) *ext = '\0';
     strcat(output_filename, ".s");
     
     /* Open output file */
-    output_file = fopen(output_filename, "w");
-    if (output_file == NULL) {
-        fatal_error("Cannot create output file: %s", output_filename);
+    ctx->output = fopen(output_filename, "w");
+    if (ctx->output == NULL) {
+        error(ctx, "Cannot create output file: %s", output_filename);
+        return;
     }
+    scan_source(ctx);
     
     /* Phase 1: Lexical and Syntax Analysis */
-    printf("=== PHASE 1: PARSING ===\n");
-    if (yyparse() != 0) {
-        error("Parse failed");
+    if (!quiet_mode) {
+        fprintf(ctx->report, "=== PHASE 1: PARSING ===\n");
+    }
+    PhaseClock clock;
+    begin_phase(ctx, &clock, "parse");
+    int parse_status = yyparse(ctx->scanner, ctx);
+    
+    /* Names are interned, so the source text is not needed past parsing */
+    finish_scan(ctx);
+    close_source(&ctx->source);
+    end_phase(ctx, &clock);
+    if (parse_status != 0) {
+        error(ctx, "Parse failed");
         return;
     }
     
-    if (ast_root == NULL) {
-        error("No AST generated");
+    if (ctx->ast_root == NO_NODE) {
+        error(ctx, "No AST generated");
         return;
     }
     
     /* Display AST if requested */
     if (trace_parse) {
-        printf("\n=== ABSTRACT SYNTAX TREE ===\n");
-        print_ast(ast_root, 0);
+        fprintf(ctx->report, "\n=== ABSTRACT SYNTAX TREE ===\n");
+        print_ast(ctx, AST(ctx, ctx->ast_root), 0);
         
         /* Also show parse tree vs AST comparison */
-        show_parse_tree_vs_ast();
+        show_parse_tree_vs_ast(ctx);
     }
     
     /* Phase 2: Semantic Analysis */
-    printf("\n=== PHASE 2: SEMANTIC ANALYSIS ===\n");
-    semantic_analysis(ast_root);
+    if (!quiet_mode) {
+        fprintf(ctx->report, "\n=== PHASE 2: SEMANTIC ANALYSIS ===\n");
+    }
+    begin_phase(ctx, &clock, "semantic analysis");
+    semantic_analysis(ctx, AST(ctx, ctx->ast_root));
+    end_phase(ctx, &clock);
     
-    if (error_count > 0) {
-        printf("Compilation terminated due to semantic errors.\n");
+    if (ctx->error_count > 0) {
+        if (!quiet_mode) {
+            fprintf(ctx->report, "Compilation terminated due to semantic errors.\n");
+        }
         return;
     }
     
     /* Phase 3: Intermediate Code Generation */
     if (generate_code) {
-        printf("\n=== PHASE 3: INTERMEDIATE CODE GENERATION ===\n");
-        generate_tac(ast_root);
+        if (!quiet_mode) {
+            fprintf(ctx->report, "\n=== PHASE 3: INTERMEDIATE CODE GENERATION ===\n");
+        }
+        begin_phase(ctx, &clock, "tac generation");
+        generate_tac(ctx, AST(ctx, ctx->ast_root));
+        end_phase(ctx, &clock);
+        
+        /* The AST is not needed past this point */
+        free_ast(ctx, AST(ctx, ctx->ast_root));
+        ctx->ast_root = NO_NODE;
         
         /* Phase 4: Optimization */
         if (optimization_level > 0) {
-            printf("\n=== PHASE 4: OPTIMIZATION ===\n");
-            optimize_tac(optimization_level);
+            if (!quiet_mode) {
+                fprintf(ctx->report, "\n=== PHASE 4: OPTIMIZATION ===\n");
+            }
+            begin_phase(ctx, &clock, "optimization");
+            optimize_tac(ctx, optimization_level);
+            end_phase(ctx, &clock);
             
             if (trace_code) {
-                printf("\n=== OPTIMIZED THREE-ADDRESS CODE ===\n");
-                print_tac();
+                fprintf(ctx->report, "\n=== OPTIMIZED THREE-ADDRESS CODE ===\n");
+                print_tac(ctx);
             }
         }
         
         /* Phase 5: Target Code Generation */
-        printf("\n=== PHASE 5: TARGET CODE GENERATION ===\n");
-        generate_mips(get_tac_list(), output_file);
-        printf("Output written to: %s\n", output_filename);
+        if (!quiet_mode) {
+            fprintf(ctx->report, "\n=== PHASE 5: TARGET CODE GENERATION ===\n");
+        }
+        begin_phase(ctx, &clock, "mips emission");
+        generate_mips(ctx, get_tac_list(ctx), get_tac_count(ctx), ctx->output);
+        end_phase(ctx, &clock);
+        if (!quiet_mode) {
+            fprintf(ctx->report, "Output written to: %s\n", output_filename);
+        }
+        free_tac(ctx);
     }
     
     /* Clean up */
-    fclose(source_file);
-    fclose(output_file);
-    free_ast(ast_root);
+    fclose(ctx->output);
+    ctx->output = NULL;
+    free_ast(ctx, AST(ctx, ctx->ast_root));
+    ctx->ast_root = NO_NODE;
+    free_symbol_table(ctx);
+}
+
+/* Compile one batch unit at a time until the queue is empty */
+static void *batch_worker(void *arg) {
+    BatchQueue *queue = (BatchQueue *)arg;
+    
+    for (;;) {
+        pthread_mutex_lock(&queue->lock);
+        int index = queue->next++;
+        pthread_mutex_unlock(&queue->lock);
+        if (index >= queue->count) break;
+        
+        BatchUnit *unit = &queue->units[index];
+        CompilationContext *ctx = create_context(unit->filename);
+        FILE *report = open_memstream(&unit->report, &unit->report_size);
+        FILE *diagnostics = open_memstream(&unit->diagnostics, &unit->diagnostics_size);
+        if (report == NULL || diagnostics == NULL) {
+            fatal_error("Cannot buffer output for %s", unit->filename);
+        }
+        ctx->report = report;
+        ctx->diagnostics = diagnostics;
+        ctx->timing.thread_cpu = TRUE;
+        
+        compile_file(ctx);
+        if (report_memory) {
+            print_region_report(ctx, report);
+        }
+        if (time_report != TIME_REPORT_NONE) {
+            print_time_report(ctx, report);
+        }
+        unit->error_count = ctx->error_count;
+        unit->warning_count = ctx->warning_count;
+        free_context(ctx);
+        fclose(report);
+        fclose(diagnostics);
+        
+        pthread_mutex_lock(&queue->lock);
+        unit->done = TRUE;
+        pthread_cond_broadcast(&queue->finished);
+        pthread_mutex_unlock(&queue->lock);
+    }
+    return NULL;
+}
+
+/* Compile every file on a pool of worker threads
+ *
+ * Each file gets its own context, output file and diagnostics. Reports
+ * are printed in the order the files were given. Returns the number of
+ * files that failed.
+ */
+int compile_batch(const char **files, int count) {
+    int jobs = job_count;
+    if (jobs <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = (cores > 0) ? (int)cores : 1;
+    }
+    if (jobs > count) jobs = count;
+    
+    BatchQueue queue;
+    queue.units = (BatchUnit *)safe_calloc(count, sizeof(BatchUnit));
+    queue.count = count;
+    queue.next = 0;
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.finished, NULL);
+    for (int i = 0; i < count; i++) {
+        queue.units[i].filename = files[i];
+    }
+    
+    if (!quiet_mode) {
+        printf("Batch: %d file(s), %d worker(s)\n", count, jobs);
+        fflush(stdout);
+    }
+    
+    pthread_t *workers = (pthread_t *)safe_malloc(jobs * sizeof(pthread_t));
+    for (int w = 0; w < jobs; w++) {
+        if (pthread_create(&workers[w], NULL, batch_worker, &queue) != 0) {
+            fatal_error("Cannot start batch worker");
+        }
+    }
+    
+    int failed = 0, errors = 0, warnings = 0;
+    for (int i = 0; i < count; i++) {
+        BatchUnit *unit = &queue.units[i];
+        pthread_mutex_lock(&queue.lock);
+        while (!unit->done) {
+            pthread_cond_wait(&queue.finished, &queue.lock);
+        }
+        pthread_mutex_unlock(&queue.lock);
+        
+        /* Quiet batches list only the files that failed */
+        Boolean show = !quiet_mode || unit->error_count > 0;
+        if (show) {
+            printf("\n---------- [%d/%d] %s ----------\n", i + 1, count, unit->filename);
+        }
+        fwrite(unit->report, 1, unit->report_size, stdout);
+        fflush(stdout);
+        fwrite(unit->diagnostics, 1, unit->diagnostics_size, stderr);
+        fflush(stderr);
+        if (show) {
+            printf("Result: %s (%d error(s), %d warning(s))\n",
+                   unit->error_count == 0 ? "SUCCESS" : "FAILED",
+                   unit->error_count, unit->warning_count);
+        }
+        
+        if (unit->error_count > 0) failed++;
+        errors += unit->error_count;
+        warnings += unit->warning_count;
+        free(unit->report);
+        free(unit->diagnostics);
+    }
+    
+    for (int w = 0; w < jobs; w++) {
+        pthread_join(workers[w], NULL);
+    }
+    free(workers);
+    pthread_cond_destroy(&queue.finished);
+    pthread_mutex_destroy(&queue.lock);
+    free(queue.units);
+    
+    /* Quiet mode prints nothing when every file compiles */
+    if (!quiet_mode || failed > 0) {
+        printf("\n==============================================\n");
+        printf("BATCH SUMMARY:\n");
+        printf("  Files:    %d (%d failed)\n", count, failed);
+        printf("  Errors:   %d\n", errors);
+        printf("  Warnings: %d\n", warnings);
+        printf("  Status:   %s\n", failed == 0 ? "SUCCESS" : "FAILED");
+        printf("==============================================\n");
+    }
+    
+    return failed;
 }
 
 /* Parse command line arguments */
@@ -180,10 +454,17 @@ void parse_arguments(int argc, char *argv[]) {
         {"optimize",    required_argument, 0, 'O'},
         {"no-code",     no_argument,       0, 'n'},
         {"output",      required_argument, 0, 'o'},
+        {"mem-report",  no_argument,       0, 'm'},
+        {"reg-report",  no_argument,       0, 'r'},
+        {"batch",       no_argument,       0, 'b'},
+        {"jobs",        required_argument, 0, 'j'},
+        {"threads",     required_argument, 0, 't'},
+        {"quiet",       no_argument,       0, 'q'},
+        {"time-report", optional_argument, 0, 'T'},
         {0, 0, 0, 0}
     };
     
-    while ((opt = getopt_long(argc, argv, "hspacO:no:", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "hspacO:no:mrbj:t:q", long_options, NULL)) != -1) {
         switch (opt) {
             case 'h':
                 print_usage(argv[0]);
@@ -191,38 +472,70 @@ void parse_arguments(int argc, char *argv[]) {
                 
             case 's':
                 trace_scan = TRUE;
-                printf("Scanner tracing enabled\n");
                 break;
                 
             case 'p':
                 trace_parse = TRUE;
-                printf("Parser tracing enabled\n");
                 break;
                 
             case 'a':
                 trace_semantic = TRUE;
-                printf("Semantic analysis tracing enabled\n");
                 break;
                 
             case 'c':
                 trace_code = TRUE;
-                printf("Code generation tracing enabled\n");
                 break;
                 
             case 'O':
                 optimization_level = atoi(optarg);
-                printf("Optimization level: %d\n", optimization_level);
+                optimization_level_set = TRUE;
                 break;
                 
             case 'n':
                 generate_code = FALSE;
-                printf("Code generation disabled\n");
                 break;
                 
             case 'o':
                 /* Output file handling would go here */
                 break;
                 
+            case 'm':
+                report_memory = TRUE;
+                break;
+                
+            case 'r':
+                report_registers = TRUE;
+                break;
+                
+            case 'b':
+                batch_mode = TRUE;
+                break;
+                
+            case 'j':
+                job_count = atoi(optarg);
+                batch_mode = TRUE;
+                break;
+                
+            case 't':
+                function_jobs = atoi(optarg);
+                function_jobs_set = TRUE;
+                break;
+                
+            case 'q':
+                quiet_mode = TRUE;
+                break;
+                
+            case 'T':
+                if (optarg == NULL || strcmp(optarg, "text") == 0) {
+                    time_report = TIME_REPORT_TEXT;
+                } else if (strcmp(optarg, "json") == 0) {
+                    time_report = TIME_REPORT_JSON;
+                } else {
+                    fprintf(stderr, "Error: --time-report takes 'text' or 'json', not '%s'\n", optarg);
+                    exit(1);
+                }
+                break;
+                
             default:
                 print_usage(argv[0]);
                 exit(1);
@@ -230,20 +543,41 @@ void parse_arguments(int argc, char *argv[]) {
     }
 }
 
+/* Echo the options that change what the compiler prints or does */
+void print_options(void) {
+    if (trace_scan) printf("Scanner tracing enabled\n");
+    if (trace_parse) printf("Parser tracing enabled\n");
+    if (trace_semantic) printf("Semantic analysis tracing enabled\n");
+    if (trace_code) printf("Code generation tracing enabled\n");
+    if (optimization_level_set) printf("Optimization level: %d\n", optimization_level);
+    if (!generate_code) printf("Code generation disabled\n");
+}
+
 /* Print usage information */
 void print_usage(const char *program_name) {
-    printf("\nUsage: %s [options] source_file.cm\n", program_name);
+    printf("\nUsage: %s [options] source_file.cm   (\"-\" reads standard input)\n", program_name);
+    printf("       %s --batch [options] file.cm... | @listfile...\n", program_name);
     printf("\nOptions:\n");
     printf("  -h, --help         Show this help message\n");
     printf("  -s, --trace-scan   Enable scanner tracing\n");
     printf("  -p, --trace-parse  Enable parser tracing and show AST\n");
     printf("  -a, --trace-sem    Enable semantic analysis tracing\n");
     printf("  -c, --trace-code   Enable code generation tracing\n");
-    printf("  -O<level>          Set optimization level (0-2)\n");
+    printf("  -O<level>          Set optimization level (0-3)\n");
     printf("  -n, --no-code      Disable code generation\n");
     printf("  -o <file>          Specify output file\n");
+    printf("  -m, --mem-report   Report bytes used per memory region\n");
+    printf("  -r, --reg-report   Report values spilled and reloaded per function\n");
+    printf("  -q, --quiet        No banners, phase reports or TAC listing\n");
+    printf("  --time-report[=json]  Report time and memory used by each phase\n");
+    printf("  -b, --batch        Compile every file given, on one thread per core\n");
+    printf("  -j, --jobs <n>     Use n batch worker threads (implies --batch)\n");
+    printf("  @<listfile>        Read file names from listfile (implies --batch)\n");
+    printf("  -t, --threads <n>  Optimize and emit n functions of a file at once\n");
+    printf("                     (default: one per core, 1 in batch mode)\n");
     printf("\nExample:\n");
     printf("  %s -p -O2 test.cm    # Parse with AST display and optimize\n", program_name);
     printf("  %s -spacO2 test.cm   # Enable all tracing with optimization\n", program_name);
+    printf("  %s --batch -O2 @units.txt  # Compile every listed file\n", program_name);
     printf("\n");
 }
\ No newline at end of file
@@ -10,14 +10,11 @@
 #include <string.h>
 #include <stdarg.h>
 #include <ctype.h>
-#include "mips.h"
-#include "codegen.h"
-#include "symtab.h"
-#include "globals.h"
-#include "optimize.h"
-
-/* Global MIPS context */
-static MIPSContext *mips_ctx = NULL;
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "context.h"
 
 /* Register names */
 static const char *register_names[] = {
@@ -27,56 +24,295 @@ static const char *register_names[] = {
     "$t8", "$t9", "$k0", "$k1", "$gp", "$sp", "$fp", "$ra"
 };
 
-/* Main MIPS generation function */
-void generate_mips(TACInstruction *tac_list, FILE *output) {
-    printf("\n=== MIPS CODE GENERATION ===\n");
+/* Buffers per writev call (POSIX guarantees at least this many) */
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/* Reset the back end to its state at the start of a function */
+static void init_mips_state(CompilationContext *ctx, AsmBuffer *out) {
+    ctx->mips.out = out;
+    ctx->mips.param_offset = 0;
+    ctx->mips.current_func = NULL;
+    ctx->mips.param_area = 0;
+    ctx->mips.next_scratch = REG_T8;
+    ctx->mips.call_index = 0;
+    memset(&ctx->mips.alloc, 0, sizeof(RegAllocation));
+    memset(&ctx->mips.frame, 0, sizeof(FrameLayout));
+}
+
+/* Local array an operand names, or NULL */
+static SymbolEntry *local_array(CompilationContext *ctx, TACOperand operand) {
+    SymbolEntry *symbol = operand_symbol(ctx, operand);
+    if (operand.kind != OPERAND_VAR || symbol == NULL ||
+        symbol->kind != SYMBOL_ARRAY || is_global_symbol(symbol)) {
+        return NULL;
+    }
+    return symbol;
+}
+
+/* Whether a value fits the signed 16-bit immediate of addi, lw and sw */
+static int fits_immediate(int value) {
+    return value >= -32768 && value <= 32767;
+}
+
+/* Build a constant too wide for an immediate in $at */
+static void load_at(CompilationContext *ctx, int value) {
+    emit_mips(ctx, "    lui $at, %d\n", (int)((unsigned)value >> 16));
+    emit_mips(ctx, "    ori $at, $at, %d\n", (int)((unsigned)value & 0xffff));
+}
+
+/* Memory operand for offset(base). An offset past 16 bits, such as a
+ * slot above a large local array, is added to the base in $at. */
+static const char *frame_operand(CompilationContext *ctx, int offset, const char *base, char *buffer) {
+    if (fits_immediate(offset)) {
+        snprintf(buffer, MIPS_OPERAND_SIZE, "%d(%s)", offset, base);
+    } else {
+        load_at(ctx, offset);
+        emit_mips(ctx, "    add $at, $at, %s\n", base);
+        snprintf(buffer, MIPS_OPERAND_SIZE, "0($at)");
+    }
+    return buffer;
+}
+
+/* rd = rs + value, through $at when the value is past 16 bits */
+static void add_immediate(CompilationContext *ctx, const char *rd, const char *rs, int value) {
+    if (fits_immediate(value)) {
+        emit_mips(ctx, "    addi %s, %s, %d\n", rd, rs, value);
+    } else {
+        load_at(ctx, value);
+        emit_mips(ctx, "    add %s, %s, $at\n", rd, rs);
+    }
+}
+
+/* Lay out the frame of code[0..count-1] once its registers are known
+ *
+ * Spill slots come first so scalar loads and stores keep 16-bit offsets
+ * however large the arrays are; linkage, stack arguments and arrays
+ * past 32K are reached through $at. Arrays keep their declaration order
+ * (their symbol-table offsets) but are packed, so arrays the function
+ * never names take no space.
+ *
+ * Only a function that calls needs $ra saved, only the $s registers it
+ * was handed are saved for its caller, and main, which never returns,
+ * saves nothing. Unless a call passes arguments on the stack, $sp stays
+ * put between prologue and epilogue, so the frame is addressed off $sp
+ * and $fp is left alone.
+ */
+static void layout_frame(CompilationContext *ctx, TACInstruction *code, int count) {
+    FrameLayout *frame = &ctx->mips.frame;
+    int calls = 0, pushes = 0, params = 0;
+    int returns = operand_symbol(ctx, code[0].result) != ctx->symtab.main_func;
+    int low = 0, high = -1;
+    for (int i = 0; i < count; i++) {
+        if (code[i].opcode == TAC_PARAM) {
+            params++;
+        } else if (code[i].opcode == TAC_CALL) {
+            calls++;
+            if (params > 4) pushes++;
+            params = 0;
+        }
+
+        TACOperand operands[3] = { code[i].result, code[i].arg1, code[i].arg2 };
+        for (int k = 0; k < 3; k++) {
+            if (local_array(ctx, operands[k]) == NULL) continue;
+            if (high < low) {
+                low = high = operands[k].value;
+            } else if (operands[k].value < low) {
+                low = operands[k].value;
+            } else if (operands[k].value > high) {
+                high = operands[k].value;
+            }
+        }
+    }
+    
+    frame->array_base = low;
+    frame->array_count = high - low + 1;
+    frame->array_offset = (int *)arena_alloc(REGION(ctx, REGION_BACKEND),
+                                             (frame->array_count + 1) * sizeof(int));
+    for (int a = 0; a < frame->array_count; a++) {
+        frame->array_offset[a] = -1;
+    }
+    for (int i = 0; i < count; i++) {
+        TACOperand operands[3] = { code[i].result, code[i].arg1, code[i].arg2 };
+        for (int k = 0; k < 3; k++) {
+            if (local_array(ctx, operands[k])) frame->array_offset[operands[k].value - low] = 0;
+        }
+    }
+    
+    int bytes = ctx->mips.alloc.slot_count * 4;
+    for (int a = 0; a < frame->array_count; a++) {
+        if (frame->array_offset[a] < 0) continue;
+        frame->array_offset[a] = bytes;
+        bytes += symbol_by_id(ctx, low + a)->size * 4;
+    }
+    
+    frame->base = pushes ? REG_FP : REG_SP;
+    frame->returns = returns;
+    frame->saved_mask = 0;
+    frame->saved_offset = bytes;
+    for (int reg = REG_S0; reg <= REG_S7 && returns; reg++) {
+        if (ctx->mips.alloc.used_mask & (1u << reg)) {
+            frame->saved_mask |= 1u << reg;
+            ctx->mips.alloc.callee_saved++;
+            bytes += 4;
+        }
+    }
+    frame->ra_offset = frame->fp_offset = -1;
+    if (returns && calls) {
+        frame->ra_offset = bytes;
+        bytes += 4;
+    }
+    if (returns && pushes) {
+        frame->fp_offset = bytes;
+        bytes += 4;
+    }
+    frame->size = (bytes + 7) & ~7;
+}
+
+/* Functions of one unit being lowered side by side */
+typedef struct {
+    CompilationContext *parent;
+    TACInstruction *code;
+    TACRange *ranges;
+    CompilationContext **functions;
+    AsmBuffer *text;           /* Assembly for each function */
+} FunctionBatch;
+
+/* Lower one function into its own assembly buffer */
+static void lower_function(void *arg, int index) {
+    FunctionBatch *batch = (FunctionBatch *)arg;
+    TACRange range = batch->ranges[index];
+    CompilationContext *fn = create_function_context(batch->parent);
+    
+    init_mips_state(fn, &batch->text[index]);
     
-    /* Initialize context */
-    mips_ctx = (MIPSContext *)malloc(sizeof(MIPSContext));
-    mips_ctx->output = output;
-    mips_ctx->stack_offset = 0;
-    mips_ctx->param_offset = 0;
-    mips_ctx->current_func = NULL;
+    PhaseClock clock;
+    begin_phase(fn, &clock, "register allocation");
+    allocate_registers(fn, batch->code + range.start, range.count, &fn->mips.alloc);
+    end_phase(fn, &clock);
+    begin_phase(fn, &clock, "frame layout");
+    layout_frame(fn, batch->code + range.start, range.count);
+    end_phase(fn, &clock);
     
-    /* Initialize register table */
-    for (int i = 0; i < 32; i++) {
-        mips_ctx->regs[i].var_name = NULL;
-        mips_ctx->regs[i].is_dirty = 0;
-        mips_ctx->regs[i].last_use = 0;
+    for (int i = range.start; i < range.start + range.count; i++) {
+        gen_mips_instruction(fn, &batch->code[i]);
+    }
+    free_allocation(fn, &fn->mips.alloc);
+    fn->mips.frame.array_offset = NULL;
+    batch->functions[index] = fn;
+}
+
+/* Spills and reloads of every function, for --reg-report */
+static void print_allocation_report(CompilationContext *ctx, CompilationContext **functions, int count) {
+    FILE *out = ctx->report;
+    RegAllocation total;
+    memset(&total, 0, sizeof(total));
+    
+    fprintf(out, "\n=== REGISTER ALLOCATION: %s ===\n", ctx->filename);
+    fprintf(out, "%-20s %7s %9s %8s %11s %8s %8s %9s %8s %10s %6s %7s\n", "Function", "Values",
+            "Registers", "Spilled", "Across call", "Reloads", "Stores", "Coalesced", "Saved $s",
+            "Call saves", "Slots", "Frame");
+    fprintf(out, "---------------------------------------------------------------------------------"
+                 "---------------------------------------------\n");
+    for (int f = 0; f < count; f++) {
+        RegAllocation *alloc = &functions[f]->mips.alloc;
+        fprintf(out, "%-20s %7d %9d %8d %11d %8d %8d %9d %8d %10d %6d %7d\n",
+                functions[f]->mips.current_func, alloc->values, alloc->registers_used, alloc->spilled,
+                alloc->spilled_at_calls, alloc->reloads, alloc->spill_stores, alloc->coalesced,
+                alloc->callee_saved, alloc->caller_saves, alloc->slot_count, functions[f]->mips.frame.size);
+        total.values += alloc->values;
+        total.spilled += alloc->spilled;
+        total.spilled_at_calls += alloc->spilled_at_calls;
+        total.reloads += alloc->reloads;
+        total.spill_stores += alloc->spill_stores;
+        total.coalesced += alloc->coalesced;
+        total.callee_saved += alloc->callee_saved;
+        total.caller_saves += alloc->caller_saves;
+        total.slot_count += alloc->slot_count;
+    }
+    fprintf(out, "---------------------------------------------------------------------------------"
+                 "---------------------------------------------\n");
+    fprintf(out, "%-20s %7d %9s %8d %11d %8d %8d %9d %8d %10d %6d\n", "total", total.values, "",
+            total.spilled, total.spilled_at_calls, total.reloads, total.spill_stores, total.coalesced,
+            total.callee_saved, total.caller_saves, total.slot_count);
+}
+
+/* Main MIPS generation function
+ *
+ * Register and frame state starts afresh in every function, so functions
+ * are lowered independently, up to function_jobs at a time, into
+ * separate buffers. The header, the functions in source order and the
+ * runtime routines are then written with one writev, so the output does
+ * not depend on the number of threads.
+ */
+void generate_mips(CompilationContext *ctx, TACInstruction *tac_list, int tac_count, FILE *output) {
+    if (!quiet_mode) {
+        fprintf(ctx->report, "\n=== MIPS CODE GENERATION ===\n");
     }
     
-    /* Generate data section */
-    emit_data_section();
+    FunctionBatch batch;
+    batch.parent = ctx;
+    batch.code = tac_list;
+    int function_count = split_tac_functions(tac_list, tac_count, &batch.ranges);
+    batch.functions = (CompilationContext **)safe_calloc(function_count + 1,
+                                                         sizeof(CompilationContext *));
     
-    /* Generate text section */
-    emit_text_section();
+    /* Buffer 0 holds the header, the last one the runtime routines */
+    AsmBuffer *buffers = (AsmBuffer *)safe_calloc(function_count + 2, sizeof(AsmBuffer));
+    batch.text = buffers + 1;
     
-    /* Generate code for each TAC instruction */
-    TACInstruction *instr = tac_list;
-    while (instr) {
-        gen_mips_instruction(instr);
-        instr = instr->next;
+    /* Generate data and text section headers */
+    init_mips_state(ctx, &buffers[0]);
+    emit_data_section(ctx);
+    emit_text_section(ctx);
+    
+    /* Generate code for each function */
+    run_parallel(function_count, function_jobs, lower_function, &batch);
+    if (report_registers) {
+        print_allocation_report(ctx, batch.functions, function_count);
+    }
+    for (int f = 0; f < function_count; f++) {
+        finish_function_context(ctx, batch.functions[f]);
     }
     
     /* Generate syscall functions */
-    emit_syscall_functions();
+    init_mips_state(ctx, &buffers[function_count + 1]);
+    emit_syscall_functions(ctx);
     
-    printf("MIPS code generation completed.\n");
+    fflush(output);
+    if (write_asm_buffers(fileno(output), buffers, function_count + 2) != 0) {
+        error(ctx, "Cannot write assembly output: %s", strerror(errno));
+    }
+    
+    for (int b = 0; b < function_count + 2; b++) {
+        asm_free(&buffers[b]);
+    }
+    free(buffers);
+    free(batch.functions);
+    free(batch.ranges);
+    ctx->mips.out = NULL;
+    
+    if (!quiet_mode) {
+        fprintf(ctx->report, "MIPS code generation completed.\n");
+    }
 }
 
 /* Generate MIPS for a single TAC instruction */
-void gen_mips_instruction(TACInstruction *instr) {
+void gen_mips_instruction(CompilationContext *ctx, TACInstruction *instr) {
+    ctx->mips.next_scratch = REG_T8;
+    
     switch (instr->opcode) {
         case TAC_ADD:
         case TAC_SUB:
         case TAC_MUL:
         case TAC_DIV:
-            gen_mips_arithmetic(instr);
+            gen_mips_arithmetic(ctx, instr);
             break;
             
         case TAC_ASSIGN:
         case TAC_LOAD_CONST:
-            gen_mips_assignment(instr);
+            gen_mips_assignment(ctx, instr);
             break;
             
         case TAC_LT:
@@ -85,406 +321,615 @@ void gen_mips_instruction(TACInstruction *instr) {
         case TAC_GTE:
         case TAC_EQ:
         case TAC_NEQ:
-            gen_mips_comparison(instr);
+            gen_mips_comparison(ctx, instr);
             break;
             
         case TAC_GOTO:
         case TAC_IF_TRUE:
         case TAC_IF_FALSE:
-            gen_mips_branch(instr);
+            gen_mips_branch(ctx, instr);
             break;
             
         case TAC_LABEL:
-            emit_label_mips(instr->label);
+            emit_label_mips(ctx, instr->label);
             break;
             
         case TAC_FUNC_BEGIN:
         case TAC_FUNC_END:
-            gen_mips_function(instr);
+            gen_mips_function(ctx, instr);
             break;
             
         case TAC_CALL:
         case TAC_PARAM:
-            gen_mips_call(instr);
+            gen_mips_call(ctx, instr);
             break;
             
         case TAC_RETURN:
-            gen_mips_return(instr);
+            gen_mips_return(ctx, instr);
             break;
             
         case TAC_ARRAY_LOAD:
         case TAC_ARRAY_STORE:
-            gen_mips_array(instr);
+            gen_mips_array(ctx, instr);
+            break;
+            
+        case TAC_NOP:
             break;
             
         default:
-            emit_mips("    # Unknown TAC opcode\n");
+            emit_mips(ctx, "    # Unknown TAC opcode\n");
     }
 }
 
 /* Generate MIPS arithmetic operations */
-void gen_mips_arithmetic(TACInstruction *instr) {
-    MIPSRegister rd = allocate_register(instr->result);
-    MIPSRegister rs = get_register(instr->arg1);
-    MIPSRegister rt = get_register(instr->arg2);
+void gen_mips_arithmetic(CompilationContext *ctx, TACInstruction *instr) {
+    MIPSRegister rs = get_register(ctx, instr->arg1);
+    MIPSRegister rt = get_register(ctx, instr->arg2);
+    MIPSRegister rd = allocate_register(ctx, instr->result);
     
     switch (instr->opcode) {
         case TAC_ADD:
-            emit_mips("    add %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
+            emit_mips(ctx, "    add %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
             break;
         case TAC_SUB:
-            emit_mips("    sub %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
+            emit_mips(ctx, "    sub %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
             break;
         case TAC_MUL:
-            emit_mips("    mul %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
+            emit_mips(ctx, "    mul %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
             break;
         case TAC_DIV:
-            emit_mips("    div %s, %s\n", reg_name(rs), reg_name(rt));
-            emit_mips("    mflo %s\n", reg_name(rd));
+            emit_mips(ctx, "    div %s, %s\n", reg_name(rs), reg_name(rt));
+            emit_mips(ctx, "    mflo %s\n", reg_name(rd));
             break;
         default:
             break;
     }
     
-    mips_ctx->regs[rd].is_dirty = 1;
+    store_result(ctx, instr->result, rd);
 }
 
 /* Generate MIPS assignment */
-void gen_mips_assignment(TACInstruction *instr) {
-    if (instr->opcode == TAC_LOAD_CONST) {
-        /* Load constant */
-        MIPSRegister rd = allocate_register(instr->result);
-        int value = atoi(instr->arg1);
-        emit_mips("    li %s, %d\n", reg_name(rd), value);
-        mips_ctx->regs[rd].is_dirty = 1;
+void gen_mips_assignment(CompilationContext *ctx, TACInstruction *instr) {
+    if (is_constant(instr->arg1)) {
+        /* Load constant straight into the destination */
+        MIPSRegister rd = allocate_register(ctx, instr->result);
+        emit_mips(ctx, "    li %s, %d\n", reg_name(rd), instr->arg1.value);
+        store_result(ctx, instr->result, rd);
     } else {
-        /* Copy assignment */
-        MIPSRegister rs = get_register(instr->arg1);
-        MIPSRegister rd = allocate_register(instr->result);
-        
-        if (rd != rs) {
-            emit_mips("    move %s, %s\n", reg_name(rd), reg_name(rs));
-            mips_ctx->regs[rd].is_dirty = 1;
-        }
+        /* Copy assignment; a result kept in memory is stored directly */
+        MIPSRegister rs = get_register(ctx, instr->arg1);
+        store_result(ctx, instr->result, rs);
     }
 }
 
 /* Generate MIPS comparison */
-void gen_mips_comparison(TACInstruction *instr) {
-    MIPSRegister rd = allocate_register(instr->result);
-    MIPSRegister rs = get_register(instr->arg1);
-    MIPSRegister rt = get_register(instr->arg2);
+void gen_mips_comparison(CompilationContext *ctx, TACInstruction *instr) {
+    MIPSRegister rs = get_register(ctx, instr->arg1);
+    MIPSRegister rt = get_register(ctx, instr->arg2);
+    MIPSRegister rd = allocate_register(ctx, instr->result);
     
     switch (instr->opcode) {
         case TAC_LT:
-            emit_mips("    slt %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
+            emit_mips(ctx, "    slt %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
             break;
         case TAC_LTE:
-            emit_mips("    sle %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
+            emit_mips(ctx, "    sle %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
             break;
         case TAC_GT:
-            emit_mips("    sgt %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
+            emit_mips(ctx, "    sgt %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
             break;
         case TAC_GTE:
-            emit_mips("    sge %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
+            emit_mips(ctx, "    sge %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
             break;
         case TAC_EQ:
-            emit_mips("    seq %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
+            emit_mips(ctx, "    seq %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
             break;
         case TAC_NEQ:
-            emit_mips("    sne %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
+            emit_mips(ctx, "    sne %s, %s, %s\n", reg_name(rd), reg_name(rs), reg_name(rt));
             break;
         default:
             break;
     }
     
-    mips_ctx->regs[rd].is_dirty = 1;
+    store_result(ctx, instr->result, rd);
 }
 
 /* Generate MIPS branch */
-void gen_mips_branch(TACInstruction *instr) {
+void gen_mips_branch(CompilationContext *ctx, TACInstruction *instr) {
     if (instr->opcode == TAC_GOTO) {
-        emit_mips("    j L%d\n", instr->label);
+        emit_mips(ctx, "    j L%d\n", instr->label);
     } else {
-        MIPSRegister rs = get_register(instr->result);
+        MIPSRegister rs = get_register(ctx, instr->result);
         
         if (instr->opcode == TAC_IF_TRUE) {
-            emit_mips("    bnez %s, L%d\n", reg_name(rs), instr->label);
+            emit_mips(ctx, "    bnez %s, L%d\n", reg_name(rs), instr->label);
         } else {
-            emit_mips("    beqz %s, L%d\n", reg_name(rs), instr->label);
+            emit_mips(ctx, "    beqz %s, L%d\n", reg_name(rs), instr->label);
         }
     }
 }
 
 /* Generate MIPS function prologue/epilogue */
-void gen_mips_function(TACInstruction *instr) {
+void gen_mips_function(CompilationContext *ctx, TACInstruction *instr) {
     if (instr->opcode == TAC_FUNC_BEGIN) {
-        mips_ctx->current_func = instr->result;
-        mips_ctx->stack_offset = 0;
+        SymbolEntry *func = operand_symbol(ctx, instr->result);
         
-        emit_mips("\n%s:\n", instr->result);
+        FrameLayout *layout = &ctx->mips.frame;
+        int frame = layout->size;
+        char *base = reg_name(layout->base);
+        char address[MIPS_OPERAND_SIZE];
+        ctx->mips.current_func = func->name;
         
-        /* Function prologue */
-        emit_mips("    # Function prologue\n");
-        emit_mips("    addi $sp, $sp, -32\n");  /* Allocate stack frame */
-        emit_mips("    sw $ra, 28($sp)\n");      /* Save return address */
-        emit_mips("    sw $fp, 24($sp)\n");      /* Save frame pointer */
-        emit_mips("    move $fp, $sp\n");        /* Set new frame pointer */
+        emit_mips(ctx, "\n%s:\n", ctx->mips.current_func);
+        
+        /* Function prologue: arrays and spill slots sit at their
+         * layout_frame offsets from the base register, linkage at the top */
+        emit_mips(ctx, "    # Function prologue\n");
+        if (frame > 0) {
+            add_immediate(ctx, "$sp", "$sp", -frame);                 /* Allocate stack frame */
+        }
+        if (layout->ra_offset >= 0) {
+            emit_mips(ctx, "    sw $ra, %s\n",                         /* Save return address */
+                      frame_operand(ctx, layout->ra_offset, "$sp", address));
+        }
+        if (layout->fp_offset >= 0) {
+            emit_mips(ctx, "    sw $fp, %s\n",                         /* Save frame pointer */
+                      frame_operand(ctx, layout->fp_offset, "$sp", address));
+        }
+        int offset = layout->saved_offset;
+        for (int reg = REG_S0; reg <= REG_S7; reg++) {
+            if (layout->saved_mask & (1u << reg)) {
+                emit_mips(ctx, "    sw %s, %s\n", reg_name(reg),      /* Callee-saved */
+                          frame_operand(ctx, offset, "$sp", address));
+                offset += 4;
+            }
+        }
+        if (layout->base == REG_FP) {
+            emit_mips(ctx, "    move $fp, $sp\n");                      /* Set new frame pointer */
+        }
+        
+        /* Move incoming arguments to their registers, or home them in
+         * their parameter slots */
+        int index = 0;
+        for (SymbolEntry *param = func->params; param; param = param->next, index++) {
+            TACOperand operand = operand_var(param);
+            int reg = value_register(ctx, &ctx->mips.alloc, operand);
+            if (index < 4) {
+                if (reg != REG_SPILLED) {
+                    emit_mips(ctx, "    move %s, $a%d\n", reg_name(reg), index);
+                } else {
+                    emit_mips(ctx, "    sw $a%d, %s\n", index,
+                              frame_operand(ctx, get_var_offset(ctx, operand), base, address));
+                    ctx->mips.alloc.spill_stores++;
+                }
+            } else {
+                /* Arguments past the fourth are at the caller's $sp */
+                MIPSRegister rd = (reg != REG_SPILLED) ? (MIPSRegister)reg : REG_T9;
+                emit_mips(ctx, "    lw %s, %s\n", reg_name(rd),
+                          frame_operand(ctx, frame + (index - 4) * 4, base, address));
+                if (reg == REG_SPILLED) {
+                    emit_mips(ctx, "    sw $t9, %s\n",
+                              frame_operand(ctx, get_var_offset(ctx, operand), base, address));
+                    ctx->mips.alloc.spill_stores++;
+                }
+            }
+        }
         
     } else if (instr->opcode == TAC_FUNC_END) {
-        /* Function epilogue */
-        emit_mips("    # Function epilogue\n");
-        emit_mips("    move $sp, $fp\n");        /* Restore stack pointer */
-        emit_mips("    lw $fp, 24($sp)\n");      /* Restore frame pointer */
-        emit_mips("    lw $ra, 28($sp)\n");      /* Restore return address */
-        emit_mips("    addi $sp, $sp, 32\n");    /* Deallocate stack frame */
+        FrameLayout *layout = &ctx->mips.frame;
+        char address[MIPS_OPERAND_SIZE];
         
-        if (strcmp(mips_ctx->current_func, "main") == 0) {
-            /* Exit for main function */
-            emit_mips("    li $v0, 10\n");       /* Exit syscall */
-            emit_mips("    syscall\n");
-        } else {
-            emit_mips("    jr $ra\n");           /* Return */
+        /* Function epilogue; every return jumps here. Arguments pushed
+         * for a call are popped right after it, so $sp is back at the
+         * bottom of the frame. */
+        emit_mips(ctx, "%s_exit:\n", ctx->mips.current_func);
+        emit_mips(ctx, "    # Function epilogue\n");
+        if (!layout->returns) {
+            /* Exit for main function; nothing to restore */
+            emit_mips(ctx, "    li $v0, 10\n");       /* Exit syscall */
+            emit_mips(ctx, "    syscall\n");
+            return;
+        }
+        int offset = layout->saved_offset;
+        for (int reg = REG_S0; reg <= REG_S7; reg++) {
+            if (layout->saved_mask & (1u << reg)) {
+                emit_mips(ctx, "    lw %s, %s\n", reg_name(reg), frame_operand(ctx, offset, "$sp", address));
+                offset += 4;
+            }
+        }
+        if (layout->fp_offset >= 0) {
+            emit_mips(ctx, "    lw $fp, %s\n",                         /* Restore frame pointer */
+                      frame_operand(ctx, layout->fp_offset, "$sp", address));
+        }
+        if (layout->ra_offset >= 0) {
+            emit_mips(ctx, "    lw $ra, %s\n",                         /* Restore return address */
+                      frame_operand(ctx, layout->ra_offset, "$sp", address));
         }
+        if (layout->size > 0) {
+            add_immediate(ctx, "$sp", "$sp", layout->size);           /* Deallocate stack frame */
+        }
+        emit_mips(ctx, "    jr $ra\n");               /* Return */
     }
 }
 
 /* Generate MIPS function call */
-void gen_mips_call(TACInstruction *instr) {
+void gen_mips_call(CompilationContext *ctx, TACInstruction *instr) {
+    char address[MIPS_OPERAND_SIZE];
+    
     if (instr->opcode == TAC_PARAM) {
+        if (ctx->mips.param_offset == 0) {
+            /* The parameters run up to their call; arguments past the
+             * fourth get stack space of their own below the frame */
+            int count = 0;
+            for (TACInstruction *next = instr; next->opcode != TAC_CALL; next++) {
+                if (next->opcode == TAC_PARAM) count++;
+            }
+            ctx->mips.param_area = (count > 4) ? (count - 4) * 4 : 0;
+            if (ctx->mips.param_area > 0) {
+                add_immediate(ctx, "$sp", "$sp", -ctx->mips.param_area);
+            }
+        }
+        
         /* Push parameter */
-        MIPSRegister rs = get_register(instr->result);
+        MIPSRegister rs = get_register(ctx, instr->result);
         
-        if (mips_ctx->param_offset < 4) {
+        if (ctx->mips.param_offset < 4) {
             /* First 4 parameters in $a0-$a3 */
-            emit_mips("    move $a%d, %s\n", mips_ctx->param_offset, reg_name(rs));
+            emit_mips(ctx, "    move $a%d, %s\n", ctx->mips.param_offset, reg_name(rs));
         } else {
             /* Additional parameters on stack */
-            int offset = (mips_ctx->param_offset - 4) * 4;
-            emit_mips("    sw %s, %d($sp)\n", reg_name(rs), offset);
+            int offset = (ctx->mips.param_offset - 4) * 4;
+            emit_mips(ctx, "    sw %s, %s\n", reg_name(rs), frame_operand(ctx, offset, "$sp", address));
         }
-        mips_ctx->param_offset++;
+        ctx->mips.param_offset++;
         
     } else if (instr->opcode == TAC_CALL) {
         /* Make the call */
-        if (strcmp(instr->arg1, "input") == 0) {
-            /* Built-in input function */
-            emit_mips("    jal _input\n");
-            if (instr->result) {
-                MIPSRegister rd = allocate_register(instr->result);
-                emit_mips("    move %s, $v0\n", reg_name(rd));
-                mips_ctx->regs[rd].is_dirty = 1;
-            }
-        } else if (strcmp(instr->arg1, "output") == 0) {
+        SymbolEntry *func = operand_symbol(ctx, instr->arg1);
+        if (func == ctx->symtab.input_func) {
+            /* Built-in input function; it touches only $v0 and $a0 */
+            emit_mips(ctx, "    jal _input\n");
+        } else if (func == ctx->symtab.output_func) {
             /* Built-in output function */
-            emit_mips("    jal _output\n");
+            emit_mips(ctx, "    jal _output\n");
         } else {
-            /* User-defined function */
-            emit_mips("    jal %s\n", instr->arg1);
-            if (instr->result) {
-                MIPSRegister rd = allocate_register(instr->result);
-                emit_mips("    move %s, $v0\n", reg_name(rd));
-                mips_ctx->regs[rd].is_dirty = 1;
+            /* User-defined function; $t registers live across it are
+             * saved in their values' slots */
+            RegAllocation *alloc = &ctx->mips.alloc;
+            char *base = reg_name(ctx->mips.frame.base);
+            int k = ctx->mips.call_index++;
+            for (int s = alloc->save_start[k]; s < alloc->save_start[k + 1]; s++) {
+                LiveInterval *saved = &alloc->intervals[alloc->save_values[s]];
+                emit_mips(ctx, "    sw %s, %s\n", reg_name(saved->reg),
+                          frame_operand(ctx, saved->slot * 4, base, address));
+                alloc->caller_saves++;
+            }
+            emit_mips(ctx, "    jal %s\n", func->name);
+            if (ctx->mips.param_area > 0) {
+                add_immediate(ctx, "$sp", "$sp", ctx->mips.param_area);
             }
+            for (int s = alloc->save_start[k]; s < alloc->save_start[k + 1]; s++) {
+                LiveInterval *saved = &alloc->intervals[alloc->save_values[s]];
+                emit_mips(ctx, "    lw %s, %s\n", reg_name(saved->reg),
+                          frame_operand(ctx, saved->slot * 4, base, address));
+            }
+        }
+        if (instr->result.kind != OPERAND_NONE) {
+            store_result(ctx, instr->result, REG_V0);
         }
-        mips_ctx->param_offset = 0;  /* Reset parameter count */
+        ctx->mips.param_offset = 0;  /* Reset parameter count */
+        ctx->mips.param_area = 0;
     }
 }
 
 /* Generate MIPS return */
-void gen_mips_return(TACInstruction *instr) {
-    if (instr->result) {
-        MIPSRegister rs = get_register(instr->result);
-        emit_mips("    move $v0, %s\n", reg_name(rs));
+void gen_mips_return(CompilationContext *ctx, TACInstruction *instr) {
+    if (instr->result.kind != OPERAND_NONE) {
+        MIPSRegister rs = get_register(ctx, instr->result);
+        emit_mips(ctx, "    move $v0, %s\n", reg_name(rs));
+    }
+    emit_mips(ctx, "    j %s_exit\n", ctx->mips.current_func);
+}
+
+/* Compute the address of array[index] into $t9.
+ * Returns the memory operand naming the element, e.g. "8($t9)".
+ * Local arrays live in the frame, global ones in .data, and array
+ * parameters hold a pointer in their slot.
+ */
+static const char *element_address(CompilationContext *ctx, TACOperand array, MIPSRegister index, char *buffer) {
+    SymbolEntry *symbol = operand_symbol(ctx, array);
+    
+    emit_mips(ctx, "    sll $t9, %s, 2\n", reg_name(index));
+    
+    if (is_global_symbol(symbol)) {
+        snprintf(buffer, MIPS_OPERAND_SIZE, "%s($t9)", symbol->name);
+    } else if (symbol->kind == SYMBOL_PARAM) {
+        MIPSRegister base = get_register(ctx, array);
+        emit_mips(ctx, "    add $t9, $t9, %s\n", reg_name(base));
+        snprintf(buffer, MIPS_OPERAND_SIZE, "0($t9)");
+    } else {
+        int offset = get_var_offset(ctx, array);
+        emit_mips(ctx, "    add $t9, $t9, %s\n", reg_name(ctx->mips.frame.base));
+        if (fits_immediate(offset)) {
+            snprintf(buffer, MIPS_OPERAND_SIZE, "%d($t9)", offset);
+        } else {
+            /* Fold the offset in; $at may be needed for the operand loads that follow */
+            add_immediate(ctx, "$t9", "$t9", offset);
+            snprintf(buffer, MIPS_OPERAND_SIZE, "0($t9)");
+        }
     }
-    emit_mips("    j %s_exit\n", mips_ctx->current_func);
-    emit_mips("%s_exit:\n", mips_ctx->current_func);
+    return buffer;
 }
 
 /* Generate MIPS array operations */
-void gen_mips_array(TACInstruction *instr) {
+void gen_mips_array(CompilationContext *ctx, TACInstruction *instr) {
+    char address[MIPS_OPERAND_SIZE];
+    
     if (instr->opcode == TAC_ARRAY_LOAD) {
         /* t = a[i] */
-        MIPSRegister index = get_register(instr->arg2);
-        MIPSRegister temp = allocate_register("$t8");
-        MIPSRegister result = allocate_register(instr->result);
+        MIPSRegister index = get_register(ctx, instr->arg2);
+        element_address(ctx, instr->arg1, index, address);
+        MIPSRegister result = allocate_register(ctx, instr->result);
         
-        /* Calculate address: base + 4 * index */
-        emit_mips("    sll %s, %s, 2\n", reg_name(temp), reg_name(index));
-        
-        if (is_global_var(instr->arg1)) {
-            emit_mips("    la $t9, %s\n", instr->arg1);
-            emit_mips("    add %s, $t9, %s\n", reg_name(temp), reg_name(temp));
-        } else {
-            int offset = get_var_offset(instr->arg1);
-            emit_mips("    addi %s, $fp, %d\n", reg_name(temp), offset);
-            emit_mips("    add %s, %s, %s\n", reg_name(temp), reg_name(temp), reg_name(index));
-        }
-        
-        emit_mips("    lw %s, 0(%s)\n", reg_name(result), reg_name(temp));
-        mips_ctx->regs[result].is_dirty = 1;
+        emit_mips(ctx, "    lw %s, %s\n", reg_name(result), address);
+        store_result(ctx, instr->result, result);
         
     } else if (instr->opcode == TAC_ARRAY_STORE) {
         /* a[i] = t */
-        MIPSRegister index = get_register(instr->arg1);
-        MIPSRegister value = get_register(instr->arg2);
-        MIPSRegister temp = allocate_register("$t8");
-        
-        /* Calculate address: base + 4 * index */
-        emit_mips("    sll %s, %s, 2\n", reg_name(temp), reg_name(index));
+        MIPSRegister index = get_register(ctx, instr->arg1);
+        element_address(ctx, instr->result, index, address);
+        MIPSRegister value = get_register(ctx, instr->arg2);
         
-        if (is_global_var(instr->result)) {
-            emit_mips("    la $t9, %s\n", instr->result);
-            emit_mips("    add %s, $t9, %s\n", reg_name(temp), reg_name(temp));
-        } else {
-            int offset = get_var_offset(instr->result);
-            emit_mips("    addi %s, $fp, %d\n", reg_name(temp), offset);
-            emit_mips("    add %s, %s, %s\n", reg_name(temp), reg_name(temp), reg_name(index));
-        }
-        
-        emit_mips("    sw %s, 0(%s)\n", reg_name(value), reg_name(temp));
+        emit_mips(ctx, "    sw %s, %s\n", reg_name(value), address);
     }
 }
 
-/* Simple register allocation */
-MIPSRegister allocate_register(char *var) {
-    /* Simple allocation: use $t0-$t7 for temporaries */
-    static int next_temp = 0;
+/* Register holding a source operand
+ *
+ * Values with a register are read in place. Constants, globals and
+ * spilled values are loaded into a scratch register: $t8 for the first
+ * in an instruction, $v1 for the second.
+ */
+MIPSRegister get_register(CompilationContext *ctx, TACOperand var) {
+    if (is_constant(var) && var.value == 0) {
+        return REG_ZERO;
+    }
     
-    if (var && var[0] == 't' && var[1] >= '0' && var[1] <= '9') {
-        /* Temporary variable */
-        int temp_num = atoi(var + 1);
-        MIPSRegister reg = REG_T0 + (temp_num % 8);
-        
-        if (mips_ctx->regs[reg].var_name && 
-            strcmp(mips_ctx->regs[reg].var_name, var) != 0) {
-            /* Spill if necessary */
-            spill_register(reg);
-        }
-        
-        mips_ctx->regs[reg].var_name = copy_string(var);
+    int reg = value_register(ctx, &ctx->mips.alloc, var);
+    if (reg != REG_SPILLED) {
         return reg;
+    }
+    
+    MIPSRegister scratch = ctx->mips.next_scratch;
+    ctx->mips.next_scratch = (scratch == REG_T8) ? REG_V1 : REG_T8;
+    if (is_constant(var)) {
+        emit_mips(ctx, "    li %s, %d\n", reg_name(scratch), var.value);
     } else {
-        /* Regular variable - use saved registers */
-        MIPSRegister reg = REG_S0 + (next_temp++ % 8);
-        
-        if (mips_ctx->regs[reg].var_name) {
-            spill_register(reg);
+        load_variable(ctx, var, scratch);
+        if (value_index(ctx, &ctx->mips.alloc, var) >= 0) {
+            ctx->mips.alloc.reloads++;
         }
-        
-        if (var) {
-            mips_ctx->regs[reg].var_name = copy_string(var);
-            load_variable(var, reg);
-        }
-        
-        return reg;
     }
+    return scratch;
 }
 
-/* Get register containing variable */
-MIPSRegister get_register(char *var) {
-    if (is_constant(var)) {
-        /* Load constant into register */
-        MIPSRegister reg = REG_T8;
-        int value = atoi(var);
-        emit_mips("    li %s, %d\n", reg_name(reg), value);
-        return reg;
-    }
-    
-    /* Check if already in a register */
-    for (int i = REG_T0; i <= REG_S7; i++) {
-        if (mips_ctx->regs[i].var_name && 
-            strcmp(mips_ctx->regs[i].var_name, var) == 0) {
-            return i;
+/* Register to compute a result in: its own, or $t8 when it lives in memory */
+MIPSRegister allocate_register(CompilationContext *ctx, TACOperand var) {
+    int reg = value_register(ctx, &ctx->mips.alloc, var);
+    return (reg != REG_SPILLED) ? (MIPSRegister)reg : REG_T8;
+}
+
+/* Put a result computed in reg where its operand lives */
+void store_result(CompilationContext *ctx, TACOperand var, MIPSRegister reg) {
+    int home = value_register(ctx, &ctx->mips.alloc, var);
+    if (home != REG_SPILLED) {
+        if (home != (int)reg) {
+            emit_mips(ctx, "    move %s, %s\n", reg_name(home), reg_name(reg));
         }
+        return;
     }
     
-    /* Not in register, allocate one */
-    return allocate_register(var);
-}
-
-/* Spill register to memory */
-void spill_register(MIPSRegister reg) {
-    if (mips_ctx->regs[reg].is_dirty) {
-        store_variable(mips_ctx->regs[reg].var_name, reg);
+    store_variable(ctx, var, reg);
+    if (value_index(ctx, &ctx->mips.alloc, var) >= 0) {
+        ctx->mips.alloc.spill_stores++;
     }
-    free(mips_ctx->regs[reg].var_name);
-    mips_ctx->regs[reg].var_name = NULL;
-    mips_ctx->regs[reg].is_dirty = 0;
 }
 
-/* Load variable from memory */
-void load_variable(char *var, MIPSRegister reg) {
-    if (is_global_var(var)) {
-        emit_mips("    lw %s, %s\n", reg_name(reg), var);
+/* Load variable from memory
+ * An array used as a value denotes its address.
+ */
+void load_variable(CompilationContext *ctx, TACOperand var, MIPSRegister reg) {
+    SymbolEntry *symbol = operand_symbol(ctx, var);
+    
+    if (symbol && symbol->kind == SYMBOL_ARRAY) {
+        if (is_global_symbol(symbol)) {
+            emit_mips(ctx, "    la %s, %s\n", reg_name(reg), symbol->name);
+        } else {
+            add_immediate(ctx, reg_name(reg), reg_name(ctx->mips.frame.base), get_var_offset(ctx, var));
+        }
+    } else if (is_global_var(ctx, var)) {
+        emit_mips(ctx, "    lw %s, %s\n", reg_name(reg), operand_name(ctx, var));
     } else {
-        int offset = get_var_offset(var);
-        emit_mips("    lw %s, %d($fp)\n", reg_name(reg), offset);
+        char address[MIPS_OPERAND_SIZE];
+        int offset = get_var_offset(ctx, var);
+        emit_mips(ctx, "    lw %s, %s\n", reg_name(reg),
+                  frame_operand(ctx, offset, reg_name(ctx->mips.frame.base), address));
     }
 }
 
 /* Store variable to memory */
-void store_variable(char *var, MIPSRegister reg) {
-    if (is_global_var(var)) {
-        emit_mips("    sw %s, %s\n", reg_name(reg), var);
+void store_variable(CompilationContext *ctx, TACOperand var, MIPSRegister reg) {
+    if (is_global_var(ctx, var)) {
+        emit_mips(ctx, "    sw %s, %s\n", reg_name(reg), operand_name(ctx, var));
     } else {
-        int offset = get_var_offset(var);
-        emit_mips("    sw %s, %d($fp)\n", reg_name(reg), offset);
+        char address[MIPS_OPERAND_SIZE];
+        int offset = get_var_offset(ctx, var);
+        emit_mips(ctx, "    sw %s, %s\n", reg_name(reg),
+                  frame_operand(ctx, offset, reg_name(ctx->mips.frame.base), address));
+    }
+}
+
+/* Append bytes to an assembly buffer, growing it geometrically */
+void asm_append(AsmBuffer *buffer, const char *text, size_t length) {
+    if (buffer->length + length > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity * 2 : 4096;
+        while (capacity < buffer->length + length) {
+            capacity *= 2;
+        }
+        buffer->data = (char *)safe_realloc(buffer->data, capacity);
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->length, text, length);
+    buffer->length += length;
+}
+
+/* Append a decimal integer */
+void asm_append_int(AsmBuffer *buffer, int value) {
+    char digits[12];
+    char *end = digits + sizeof(digits);
+    char *p = end;
+    unsigned int magnitude = (value < 0) ? 0u - (unsigned int)value : (unsigned int)value;
+    
+    do {
+        *--p = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        *--p = '-';
+    }
+    asm_append(buffer, p, (size_t)(end - p));
+}
+
+/* Release an assembly buffer's storage */
+void asm_free(AsmBuffer *buffer) {
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+}
+
+/* Write buffers to a file descriptor in order, as few writev calls as
+ * the system allows. Returns 0 on success, -1 with errno set on error.
+ */
+int write_asm_buffers(int fd, AsmBuffer *buffers, int count) {
+    struct iovec vectors[IOV_MAX];
+    int next = 0;          /* First buffer not yet queued */
+    size_t skip = 0;       /* Bytes of buffers[next] already written */
+    
+    while (next < count) {
+        int queued = 0;
+        for (int b = next; b < count && queued < IOV_MAX; b++) {
+            size_t offset = (b == next) ? skip : 0;
+            if (buffers[b].length == offset) continue;
+            vectors[queued].iov_base = buffers[b].data + offset;
+            vectors[queued].iov_len = buffers[b].length - offset;
+            queued++;
+        }
+        if (queued == 0) break;
+        
+        ssize_t written = writev(fd, vectors, queued);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        
+        /* Advance past what was written; a short write resumes mid-buffer */
+        size_t left = (size_t)written;
+        while (next < count && left >= buffers[next].length - skip) {
+            left -= buffers[next].length - skip;
+            next++;
+            skip = 0;
+        }
+        skip += left;
     }
+    return 0;
 }
 
-/* Emit MIPS instruction */
-void emit_mips(const char *format, ...) {
+/* Emit MIPS text
+ *
+ * Formatted by hand straight into the current buffer. Only %s, %d and %%
+ * are understood, which is all the generator uses.
+ */
+void emit_mips(CompilationContext *ctx, const char *format, ...) {
+    AsmBuffer *out = ctx->mips.out;
+    const char *run = format;
     va_list args;
     va_start(args, format);
-    vfprintf(mips_ctx->output, format, args);
+    
+    for (const char *p = format; *p; p++) {
+        if (*p != '%') continue;
+        asm_append(out, run, (size_t)(p - run));
+        
+        p++;
+        if (*p == 'd') {
+            asm_append_int(out, va_arg(args, int));
+        } else if (*p == 's') {
+            const char *text = va_arg(args, const char *);
+            asm_append(out, text, strlen(text));
+        } else if (*p == '%') {
+            asm_append(out, "%", 1);
+        } else {
+            p--;           /* Not a conversion; copy it as text */
+            run = p;
+            continue;
+        }
+        run = p + 1;
+    }
+    asm_append(out, run, strlen(run));
+    
     va_end(args);
 }
 
 /* Emit label */
-void emit_label_mips(int label) {
-    emit_mips("L%d:\n", label);
+void emit_label_mips(CompilationContext *ctx, int label) {
+    emit_mips(ctx, "L%d:\n", label);
 }
 
 /* Emit data section */
-void emit_data_section(void) {
-    emit_mips("# C-Minus Compiler Generated MIPS Code\n");
-    emit_mips("# CST-405 Compiler Design\n\n");
-    emit_mips(".data\n");
-    emit_mips("newline: .asciiz \"\\n\"\n");
-    emit_mips("prompt: .asciiz \"Enter a number: \"\n");
+void emit_data_section(CompilationContext *ctx) {
+    emit_mips(ctx, "# C-Minus Compiler Generated MIPS Code\n");
+    emit_mips(ctx, "# CST-405 Compiler Design\n\n");
+    emit_mips(ctx, ".data\n");
     
-    /* Add global variables here */
-    /* This would be populated from the symbol table */
+    /* Global variables, word-aligned ahead of the strings */
+    for (SymbolEntry *entry = ctx->symtab.global_scope->entries; entry; entry = entry->scope_next) {
+        if (entry->kind == SYMBOL_VAR) {
+            emit_mips(ctx, "%s: .word 0\n", entry->name);
+        } else if (entry->kind == SYMBOL_ARRAY) {
+            emit_mips(ctx, "%s: .space %d\n", entry->name, entry->size * 4);
+        }
+    }
     
-    emit_mips("\n");
+    emit_mips(ctx, "newline: .asciiz \"\\n\"\n");
+    emit_mips(ctx, "prompt: .asciiz \"Enter a number: \"\n");
+    emit_mips(ctx, "\n");
 }
 
 /* Emit text section */
-void emit_text_section(void) {
-    emit_mips(".text\n");
-    emit_mips(".globl main\n\n");
+void emit_text_section(CompilationContext *ctx) {
+    emit_mips(ctx, ".text\n");
+    emit_mips(ctx, ".globl main\n\n");
 }
 
 /* Emit syscall functions */
-void emit_syscall_functions(void) {
+void emit_syscall_functions(CompilationContext *ctx) {
     /* Input function */
-    emit_mips("\n_input:\n");
-    emit_mips("    li $v0, 4\n");          /* Print string syscall */
-    emit_mips("    la $a0, prompt\n");
-    emit_mips("    syscall\n");
-    emit_mips("    li $v0, 5\n");          /* Read integer syscall */
-    emit_mips("    syscall\n");
-    emit_mips("    jr $ra\n");
+    emit_mips(ctx, "\n_input:\n");
+    emit_mips(ctx, "    li $v0, 4\n");          /* Print string syscall */
+    emit_mips(ctx, "    la $a0, prompt\n");
+    emit_mips(ctx, "    syscall\n");
+    emit_mips(ctx, "    li $v0, 5\n");          /* Read integer syscall */
+    emit_mips(ctx, "    syscall\n");
+    emit_mips(ctx, "    jr $ra\n");
     
     /* Output function */
-    emit_mips("\n_output:\n");
-    emit_mips("    li $v0, 1\n");          /* Print integer syscall */
-    emit_mips("    syscall\n");
-    emit_mips("    li $v0, 4\n");          /* Print string syscall */
-    emit_mips("    la $a0, newline\n");
-    emit_mips("    syscall\n");
-    emit_mips("    jr $ra\n");
+    emit_mips(ctx, "\n_output:\n");
+    emit_mips(ctx, "    li $v0, 1\n");          /* Print integer syscall */
+    emit_mips(ctx, "    syscall\n");
+    emit_mips(ctx, "    li $v0, 4\n");          /* Print string syscall */
+    emit_mips(ctx, "    la $a0, newline\n");
+    emit_mips(ctx, "    syscall\n");
+    emit_mips(ctx, "    jr $ra\n");
 }
 
 /* Get register name */
@@ -492,16 +937,19 @@ char *reg_name(MIPSRegister reg) {
     return (char *)register_names[reg];
 }
 
-/* Get variable offset (simplified) */
-int get_var_offset(char *var) {
-    /* This would be looked up from the symbol table */
-    /* For now, return a default offset */
-    return -4;
+/* Get the frame offset of a local array or a spilled value's slot */
+int get_var_offset(CompilationContext *ctx, TACOperand var) {
+    FrameLayout *frame = &ctx->mips.frame;
+    if (local_array(ctx, var)) {
+        return frame->array_offset[var.value - frame->array_base];
+    }
+    
+    int v = value_index(ctx, &ctx->mips.alloc, var);
+    return ctx->mips.alloc.intervals[v].slot * 4;
 }
 
 /* Check if variable is global */
-int is_global_var(char *var) {
-    /* This would be checked from the symbol table */
-    /* For now, assume locals start with 't' or are parameters */
-    return !(var[0] == 't' || var[0] == 'p');
-}
\ No newline at end of file
+int is_global_var(CompilationContext *ctx, TACOperand var) {
+    SymbolEntry *symbol = operand_symbol(ctx, var);
+    return symbol && is_global_symbol(symbol);
+}
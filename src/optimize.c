@@ -8,62 +8,135 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
-#include "optimize.h"
-#include "codegen.h"
-#include "globals.h"
+#include "context.h"
 
-OptimizationStats opt_stats = {0};
+/* Run one pass, charging its cost to a --time-report row
+ * A pass's tables are its own, so the optimize region is emptied after it.
+ */
+static void timed_pass(CompilationContext *ctx, const char *name,
+                       void (*pass)(CompilationContext *ctx)) {
+    PhaseClock clock;
+    begin_phase(ctx, &clock, name);
+    pass(ctx);
+    arena_release(REGION(ctx, REGION_OPTIMIZE));
+    end_phase(ctx, &clock);
+}
 
-/* Main optimization function */
-void optimize_tac(OptimizationLevel level) {
+/* Run the passes for one level over the current stream */
+static void run_passes(CompilationContext *ctx, OptimizationLevel level) {
+    /* Basic optimizations; passes that remove instructions leave
+     * tombstones, which are squeezed out before the next pass */
+    timed_pass(ctx, "constant folding", constant_folding);
+    timed_pass(ctx, "constant propagation", constant_propagation);
+    timed_pass(ctx, "dead code elimination", dead_code_elimination);
+    timed_pass(ctx, "compaction", compact_tac);
+    timed_pass(ctx, "copy propagation", copy_propagation);
+    timed_pass(ctx, "dead copies", dead_copy_elimination);
+    timed_pass(ctx, "algebraic simplification", algebraic_simplification);
+    
+    if (level >= OPT_AGGRESSIVE) {
+        /* More aggressive optimizations */
+        timed_pass(ctx, "common subexpressions", common_subexpression_elimination);
+        timed_pass(ctx, "peephole", peephole_optimization);
+    }
+    timed_pass(ctx, "compaction", compact_tac);
+}
+
+/* Functions of one unit being optimized side by side */
+typedef struct {
+    CompilationContext *parent;
+    TACRange *ranges;
+    CompilationContext **functions;
+    OptimizationLevel level;
+} FunctionBatch;
+
+/* Optimize a copy of one function's instructions in its own context */
+static void optimize_function(void *arg, int index) {
+    FunctionBatch *batch = (FunctionBatch *)arg;
+    TACRange range = batch->ranges[index];
+    CompilationContext *fn = create_function_context(batch->parent);
+    
+    fn->tac.code = (TACInstruction *)arena_alloc(REGION(fn, REGION_TAC),
+                                                 range.count * sizeof(TACInstruction));
+    memcpy(fn->tac.code, get_tac_list(batch->parent) + range.start,
+           range.count * sizeof(TACInstruction));
+    fn->tac.count = range.count;
+    fn->tac.capacity = range.count;
+    
+    run_passes(fn, batch->level);
+    batch->functions[index] = fn;
+}
+
+/* Main optimization function
+ *
+ * Every pass forgets what it knows at function boundaries and temporaries
+ * never outlive their function, so each function is optimized on its own,
+ * up to function_jobs at a time. The results are stitched back together
+ * in source order and match a pass over the whole stream.
+ */
+void optimize_tac(CompilationContext *ctx, OptimizationLevel level) {
     if (level == OPT_NONE) return;
     
-    printf("\n=== OPTIMIZATION PHASE ===\n");
-    printf("Optimization level: %d\n", level);
+    if (!quiet_mode) {
+        fprintf(ctx->report, "\n=== OPTIMIZATION PHASE ===\n");
+        fprintf(ctx->report, "Optimization level: %d\n", level);
+    }
     
     /* Count original instructions */
-    TACInstruction *instr = get_tac_list();
-    opt_stats.original_instruction_count = 0;
-    while (instr) {
-        opt_stats.original_instruction_count++;
-        instr = instr->next;
-    }
+    compact_tac(ctx);
+    ctx->opt_stats.original_instruction_count = get_tac_count(ctx);
     
-    /* Basic optimizations */
-    constant_folding();
-    constant_propagation();
-    dead_code_elimination();
-    copy_propagation();
-    algebraic_simplification();
+    FunctionBatch batch;
+    batch.parent = ctx;
+    batch.level = level;
+    int function_count = split_tac_functions(get_tac_list(ctx), get_tac_count(ctx), &batch.ranges);
+    batch.functions = (CompilationContext **)safe_calloc(function_count + 1,
+                                                         sizeof(CompilationContext *));
+    run_parallel(function_count, function_jobs, optimize_function, &batch);
     
-    if (level >= OPT_AGGRESSIVE) {
-        /* More aggressive optimizations */
-        common_subexpression_elimination();
-        peephole_optimization();
+    int total = 0;
+    for (int f = 0; f < function_count; f++) {
+        total += batch.functions[f]->tac.count;
+    }
+    TACInstruction *code = (TACInstruction *)arena_alloc(REGION(ctx, REGION_TAC),
+                                                         (total + 1) * sizeof(TACInstruction));
+    int at = 0;
+    for (int f = 0; f < function_count; f++) {
+        CompilationContext *fn = batch.functions[f];
+        memcpy(code + at, fn->tac.code, fn->tac.count * sizeof(TACInstruction));
+        at += fn->tac.count;
+        finish_function_context(ctx, fn);
     }
+    set_tac_list(ctx, code, total);
+    free(batch.functions);
+    free(batch.ranges);
     
     /* Count optimized instructions */
-    instr = get_tac_list();
-    opt_stats.optimized_instruction_count = 0;
-    while (instr) {
-        opt_stats.optimized_instruction_count++;
-        instr = instr->next;
-    }
+    ctx->opt_stats.optimized_instruction_count = get_tac_count(ctx);
+    
+    /* Optimizer tables are scratch data for this phase only */
+    arena_release(REGION(ctx, REGION_OPTIMIZE));
     
-    print_optimization_stats();
+    if (!quiet_mode) {
+        print_optimization_stats(ctx);
+    }
 }
 
 /* Constant folding - evaluate constant expressions at compile time */
-void constant_folding(void) {
-    TACInstruction *instr = get_tac_list();
+void constant_folding(CompilationContext *ctx) {
+    TACInstruction *code = get_tac_list(ctx);
+    int count = get_tac_count(ctx);
     
-    while (instr) {
+    for (int n = 0; n < count; n++) {
+        TACInstruction *instr = &code[n];
+        if (instr->opcode == TAC_NOP) continue;
+        
         if (instr->opcode >= TAC_ADD && instr->opcode <= TAC_DIV) {
             if (is_constant(instr->arg1) && is_constant(instr->arg2)) {
                 int val1 = get_constant_value(instr->arg1);
                 int val2 = get_constant_value(instr->arg2);
                 int result = 0;
+                int foldable = 1;
                 
                 switch (instr->opcode) {
                     case TAC_ADD: result = val1 + val2; break;
@@ -71,203 +144,469 @@ void constant_folding(void) {
                     case TAC_MUL: result = val1 * val2; break;
                     case TAC_DIV: 
                         if (val2 != 0) result = val1 / val2;
-                        else continue;  /* Skip division by zero */
+                        else foldable = 0;  /* Skip division by zero */
                         break;
-                    default: continue;
+                    default: foldable = 0; break;
                 }
                 
-                /* Replace with constant load */
-                instr->opcode = TAC_LOAD_CONST;
-                free(instr->arg1);
-                instr->arg1 = make_string("%d", result);
-                free(instr->arg2);
-                instr->arg2 = NULL;
-                
-                opt_stats.constants_folded++;
+                if (foldable) {
+                    /* Replace with constant load */
+                    instr->opcode = TAC_LOAD_CONST;
+                    instr->arg1 = operand_const(result);
+                    instr->arg2 = operand_none();
+                    
+                    ctx->opt_stats.constants_folded++;
+                }
             }
         }
-        instr = instr->next;
     }
 }
 
-/* Constant propagation - replace variables with known constant values */
-void constant_propagation(void) {
-    TACInstruction *instr = get_tac_list();
+/* Optimizer tables
+ *
+ * Open-addressing hash map keyed on an opcode and up to two operands
+ * (variable-keyed tables use TAC_NOP and a single operand). A slot is
+ * occupied only if its stamp matches the table's epoch, so clearing the
+ * table at a label is just an epoch bump. Slot arrays are heap allocated,
+ * double when the table is half full, and are freed when the pass ends.
+ */
+typedef struct {
+    unsigned int stamp;     /* Epoch in which the slot was filled */
+    int valid;              /* Entry holds a usable value */
+    TACOpcode op;           /* Key: opcode */
+    TACOperand key1;        /* Key: first operand */
+    TACOperand key2;        /* Key: second operand */
+    TACOperand value;       /* Recorded value */
+    int version1;           /* Versions the entry depends on */
+    int version2;
+    int version3;
+} TableSlot;
+
+typedef struct {
+    TableSlot *slots;
+    int capacity;           /* Power of two */
+    int count;              /* Slots filled in the current epoch */
+    unsigned int epoch;
+} OptTable;
+
+/* Hash an opcode and two operands */
+static unsigned int table_hash(TACOpcode op, TACOperand key1, TACOperand key2) {
+    unsigned int hash = (unsigned int)op * 0x9E3779B1u;
+    hash = (hash ^ ((unsigned int)key1.kind << 24 ^ (unsigned int)key1.value)) * 0x85EBCA6Bu;
+    hash = (hash ^ ((unsigned int)key2.kind << 24 ^ (unsigned int)key2.value)) * 0xC2B2AE35u;
+    return hash ^ (hash >> 16);
+}
+
+/* Create an empty table */
+static void table_init(OptTable *table) {
+    table->capacity = 64;
+    table->count = 0;
+    table->epoch = 1;
+    table->slots = (TableSlot *)safe_calloc(table->capacity, sizeof(TableSlot));
+}
+
+/* Release a table's slots */
+static void table_free(OptTable *table) {
+    free(table->slots);
+    table->slots = NULL;
+    table->capacity = 0;
+}
+
+/* Forget every entry in O(1) */
+static void table_clear(OptTable *table) {
+    table->epoch++;
+    table->count = 0;
+}
+
+/* Find the slot for a key: the occupied slot holding it, or the empty
+ * slot where it would go */
+static TableSlot *table_probe(OptTable *table, TACOpcode op, TACOperand key1, TACOperand key2) {
+    unsigned int mask = (unsigned int)table->capacity - 1;
+    unsigned int index = table_hash(op, key1, key2) & mask;
+    
+    while (table->slots[index].stamp == table->epoch) {
+        TableSlot *slot = &table->slots[index];
+        if (slot->op == op && operand_equal(slot->key1, key1) && operand_equal(slot->key2, key2)) {
+            return slot;
+        }
+        index = (index + 1) & mask;
+    }
+    return &table->slots[index];
+}
+
+/* Double the slot array, keeping entries of the current epoch */
+static void table_grow(OptTable *table) {
+    TableSlot *old_slots = table->slots;
+    int old_capacity = table->capacity;
+    unsigned int epoch = table->epoch;
     
-    /* Simple constant tracking (local to basic blocks) */
-    typedef struct {
-        char *var;
-        char *value;
-    } ConstantEntry;
+    table->capacity *= 2;
+    table->slots = (TableSlot *)safe_calloc(table->capacity, sizeof(TableSlot));
+    for (int i = 0; i < old_capacity; i++) {
+        if (old_slots[i].stamp == epoch) {
+            *table_probe(table, old_slots[i].op, old_slots[i].key1, old_slots[i].key2) = old_slots[i];
+        }
+    }
+    free(old_slots);
+}
+
+/* Look up a key; returns NULL if absent or invalidated */
+static TableSlot *table_find(OptTable *table, TACOpcode op, TACOperand key1, TACOperand key2) {
+    TableSlot *slot = table_probe(table, op, key1, key2);
+    if (slot->stamp != table->epoch || !slot->valid) return NULL;
+    return slot;
+}
+
+/* Get the slot for a key, adding a zeroed entry if absent */
+static TableSlot *table_insert(OptTable *table, TACOpcode op, TACOperand key1, TACOperand key2) {
+    if (2 * (table->count + 1) > table->capacity) {
+        table_grow(table);
+    }
     
-    ConstantEntry constants[100];
-    int const_count = 0;
+    TableSlot *slot = table_probe(table, op, key1, key2);
+    if (slot->stamp != table->epoch) {
+        memset(slot, 0, sizeof(TableSlot));
+        slot->stamp = table->epoch;
+        slot->op = op;
+        slot->key1 = key1;
+        slot->key2 = key2;
+        table->count++;
+    }
+    return slot;
+}
+
+/* Invalidate the entry for a variable, if any */
+static void table_kill(OptTable *table, TACOperand var) {
+    TableSlot *slot = table_probe(table, TAC_NOP, var, operand_none());
+    if (slot->stamp == table->epoch) slot->valid = 0;
+}
+
+/* Current version of a variable; bumped each time it is redefined */
+static int var_version(OptTable *versions, TACOperand var) {
+    if (var.kind != OPERAND_TEMP && var.kind != OPERAND_VAR) return 0;
+    TableSlot *slot = table_probe(versions, TAC_NOP, var, operand_none());
+    return slot->stamp == versions->epoch ? slot->version1 : 0;
+}
+
+/* Record a new definition of a variable */
+static void bump_version(OptTable *versions, TACOperand var) {
+    table_insert(versions, TAC_NOP, var, operand_none())->version1++;
+}
+
+/* Check if an instruction ends the region where recorded facts hold.
+ * Labels are join points; calls may change any global. */
+static int ends_local_region(TACInstruction *instr) {
+    return instr->opcode == TAC_LABEL || instr->opcode == TAC_CALL ||
+           instr->opcode == TAC_FUNC_BEGIN || instr->opcode == TAC_FUNC_END;
+}
+
+/* Constant propagation - replace variables with known constant values */
+void constant_propagation(CompilationContext *ctx) {
+    TACInstruction *code = get_tac_list(ctx);
+    int count = get_tac_count(ctx);
     
-    while (instr) {
+    /* Constant tracking (local to basic blocks) */
+    OptTable constants;
+    table_init(&constants);
+    
+    for (int n = 0; n < count; n++) {
+        TACInstruction *instr = &code[n];
+        if (instr->opcode == TAC_NOP) continue;
+        
         /* Check if this is a constant assignment */
         if (instr->opcode == TAC_LOAD_CONST) {
             /* Record constant */
-            int found = 0;
-            for (int i = 0; i < const_count; i++) {
-                if (strcmp(constants[i].var, instr->result) == 0) {
-                    free(constants[i].value);
-                    constants[i].value = copy_string(instr->arg1);
-                    found = 1;
-                    break;
-                }
-            }
-            if (!found && const_count < 100) {
-                constants[const_count].var = copy_string(instr->result);
-                constants[const_count].value = copy_string(instr->arg1);
-                const_count++;
-            }
+            TableSlot *slot = table_insert(&constants, TAC_NOP, instr->result, operand_none());
+            slot->value = instr->arg1;
+            slot->valid = 1;
         }
         /* Replace uses of constants */
         else if (instr->opcode != TAC_FUNC_BEGIN && instr->opcode != TAC_FUNC_END) {
-            for (int i = 0; i < const_count; i++) {
-                if (instr->arg1 && strcmp(instr->arg1, constants[i].var) == 0) {
-                    free(instr->arg1);
-                    instr->arg1 = copy_string(constants[i].value);
-                    opt_stats.constants_folded++;
-                }
-                if (instr->arg2 && strcmp(instr->arg2, constants[i].var) == 0) {
-                    free(instr->arg2);
-                    instr->arg2 = copy_string(constants[i].value);
-                    opt_stats.constants_folded++;
-                }
+            TableSlot *slot;
+            if ((slot = table_find(&constants, TAC_NOP, instr->arg1, operand_none()))) {
+                instr->arg1 = slot->value;
+                ctx->opt_stats.constants_folded++;
+            }
+            if ((slot = table_find(&constants, TAC_NOP, instr->arg2, operand_none()))) {
+                instr->arg2 = slot->value;
+                ctx->opt_stats.constants_folded++;
+            }
+            
+            /* Any other definition overwrites a recorded constant */
+            if (defines_result(instr)) {
+                table_kill(&constants, instr->result);
             }
         }
         
-        /* Clear constants at labels (conservative) */
-        if (instr->opcode == TAC_LABEL) {
-            const_count = 0;
+        /* Clear constants at labels and calls (conservative) */
+        if (ends_local_region(instr)) {
+            table_clear(&constants);
         }
+    }
+    
+    table_free(&constants);
+}
+
+/* Def-use index for temporaries
+ *
+ * Built in one pass over the stream. Each temporary has a single
+ * definition, so a use count per temporary is enough to tell whether
+ * its defining instruction is dead.
+ */
+typedef struct {
+    int *def;       /* Index of the defining instruction, -1 if none */
+    int *uses;      /* Number of live uses */
+    int base;       /* Lowest temporary covered */
+    int size;       /* Number of temporaries covered */
+} DefUseIndex;
+
+/* Temporary number of an operand, or -1 if it is not a temporary */
+static int temp_number(TACOperand operand) {
+    return is_temporary(operand) ? operand.value : -1;
+}
+
+/* Collect the temporaries an instruction reads (at most three), as
+ * positions in the index */
+static int temp_uses(DefUseIndex *index, TACInstruction *instr, int uses[3]) {
+    int n = 0;
+    if (uses_result(instr) && temp_number(instr->result) >= 0) uses[n++] = instr->result.value - index->base;
+    if (temp_number(instr->arg1) >= 0) uses[n++] = instr->arg1.value - index->base;
+    if (temp_number(instr->arg2) >= 0) uses[n++] = instr->arg2.value - index->base;
+    return n;
+}
+
+/* Widen [*low, *high] to include an operand's temporary */
+static void cover_temp(TACOperand operand, int *low, int *high) {
+    int t = temp_number(operand);
+    if (t < 0) return;
+    if (*high < *low) {
+        *low = *high = t;
+    } else if (t < *low) {
+        *low = t;
+    } else if (t > *high) {
+        *high = t;
+    }
+}
+
+/* Build the def-use index for the current stream
+ *
+ * Temporaries are numbered across the whole unit but a function only
+ * touches its own, so the index covers just the range that appears.
+ */
+static void build_def_use(CompilationContext *ctx, DefUseIndex *index, TACInstruction *code, int count) {
+    int low = 0, high = -1;
+    for (int n = 0; n < count; n++) {
+        if (code[n].opcode == TAC_NOP) continue;
+        cover_temp(code[n].result, &low, &high);
+        cover_temp(code[n].arg1, &low, &high);
+        cover_temp(code[n].arg2, &low, &high);
+    }
+    
+    index->base = low;
+    index->size = high - low + 1;
+    index->def = (int *)arena_alloc(REGION(ctx, REGION_OPTIMIZE), index->size * sizeof(int));
+    index->uses = (int *)arena_calloc(REGION(ctx, REGION_OPTIMIZE), index->size, sizeof(int));
+    for (int t = 0; t < index->size; t++) {
+        index->def[t] = -1;
+    }
+    
+    for (int n = 0; n < count; n++) {
+        TACInstruction *instr = &code[n];
+        if (instr->opcode == TAC_NOP) continue;
         
-        instr = instr->next;
+        int uses[3];
+        int use_count = temp_uses(index, instr, uses);
+        for (int u = 0; u < use_count; u++) {
+            index->uses[uses[u]]++;
+        }
+        if (defines_result(instr) && is_temporary(instr->result)) {
+            index->def[instr->result.value - index->base] = n;
+        }
     }
 }
 
-/* Dead code elimination - remove code that doesn't affect output */
-void dead_code_elimination(void) {
-    TACInstruction *instr = get_tac_list();
-    TACInstruction *prev = NULL;
+/* Dead code elimination - remove code that doesn't affect output
+ *
+ * Instructions whose temporary result has no uses are removed from a
+ * worklist. Removing one drops the use counts of its operands, which
+ * can make their definitions dead in turn.
+ */
+void dead_code_elimination(CompilationContext *ctx) {
+    TACInstruction *code = get_tac_list(ctx);
+    int count = get_tac_count(ctx);
     
-    while (instr) {
-        TACInstruction *next = instr->next;
-        int is_dead = 0;
+    DefUseIndex index;
+    build_def_use(ctx, &index, code, count);
+    
+    int *worklist = (int *)arena_alloc(REGION(ctx, REGION_OPTIMIZE), (count + 1) * sizeof(int));
+    int pending = 0;
+    
+    for (int t = 0; t < index.size; t++) {
+        int def = index.def[t];
+        if (def >= 0 && index.uses[t] == 0 && code[def].opcode != TAC_CALL) {
+            worklist[pending++] = def;
+        }
+    }
+    
+    while (pending > 0) {
+        TACInstruction *instr = &code[worklist[--pending]];
         
-        /* Check if instruction result is never used */
-        if (instr->result && is_temporary(instr->result)) {
-            /* Simple check: is this temp used in any following instruction? */
-            TACInstruction *check = instr->next;
-            int used = 0;
-            
-            while (check && !used) {
-                if ((check->arg1 && strcmp(check->arg1, instr->result) == 0) ||
-                    (check->arg2 && strcmp(check->arg2, instr->result) == 0) ||
-                    (check->opcode == TAC_PARAM && check->result && 
-                     strcmp(check->result, instr->result) == 0)) {
-                    used = 1;
-                }
-                check = check->next;
+        int uses[3];
+        int use_count = temp_uses(&index, instr, uses);
+        remove_tac(ctx, (int)(instr - code));
+        ctx->opt_stats.dead_code_removed++;
+        
+        /* Cascade to definitions that just lost their last use */
+        for (int u = 0; u < use_count; u++) {
+            int t = uses[u];
+            int def = index.def[t];
+            if (--index.uses[t] == 0 && def >= 0 && code[def].opcode != TAC_CALL) {
+                worklist[pending++] = def;
             }
-            
-            if (!used && instr->opcode != TAC_CALL) {
-                is_dead = 1;
+        }
+    }
+}
+
+/* Symbol of a local scalar or parameter operand, or NULL */
+static SymbolEntry *local_scalar(CompilationContext *ctx, TACOperand operand) {
+    SymbolEntry *symbol = operand_symbol(ctx, operand);
+    if (operand.kind != OPERAND_VAR || symbol == NULL ||
+        symbol->kind == SYMBOL_ARRAY || is_global_symbol(symbol)) {
+        return NULL;
+    }
+    return symbol;
+}
+
+/* Dead copy elimination - remove copies into local scalars that nothing reads
+ *
+ * Copy propagation rewrites the reads of a copy's destination to its
+ * source, which can leave the destination unread anywhere in the
+ * function; the copy then costs a move and nothing else. Locals have
+ * consecutive symbol IDs, so the read counts are a dense array.
+ */
+void dead_copy_elimination(CompilationContext *ctx) {
+    TACInstruction *code = get_tac_list(ctx);
+    int count = get_tac_count(ctx);
+    
+    int low = 0, high = -1;
+    for (int n = 0; n < count; n++) {
+        if (code[n].opcode == TAC_ASSIGN && local_scalar(ctx, code[n].result)) {
+            int id = code[n].result.value;
+            if (high < low) {
+                low = high = id;
+            } else if (id < low) {
+                low = id;
+            } else if (id > high) {
+                high = id;
             }
         }
-        
-        if (is_dead) {
-            /* Remove instruction */
-            if (prev) {
-                prev->next = next;
-            } else {
-                set_tac_list(next);
+    }
+    if (high < low) return;
+    
+    int *reads = (int *)arena_calloc(REGION(ctx, REGION_OPTIMIZE), high - low + 1, sizeof(int));
+    for (int n = 0; n < count; n++) {
+        TACInstruction *instr = &code[n];
+        if (instr->opcode == TAC_NOP) continue;
+        TACOperand operands[3] = { instr->arg1, instr->arg2, instr->result };
+        int read_count = uses_result(instr) ? 3 : 2;
+        for (int k = 0; k < read_count; k++) {
+            if (operands[k].kind == OPERAND_VAR && operands[k].value >= low && operands[k].value <= high) {
+                reads[operands[k].value - low]++;
             }
-            free(instr);
-            opt_stats.dead_code_removed++;
-        } else {
-            prev = instr;
         }
-        
-        instr = next;
+    }
+    
+    for (int n = 0; n < count; n++) {
+        if (code[n].opcode == TAC_ASSIGN && local_scalar(ctx, code[n].result) &&
+            reads[code[n].result.value - low] == 0) {
+            remove_tac(ctx, n);
+            ctx->opt_stats.dead_copies_removed++;
+        }
     }
 }
 
-/* Copy propagation - replace copies with original values */
-void copy_propagation(void) {
-    TACInstruction *instr = get_tac_list();
-    
-    typedef struct {
-        char *dest;
-        char *source;
-    } CopyEntry;
+/* Copy propagation - replace copies with original values
+ *
+ * A copy x = y stays usable until x or y is redefined; each entry keeps
+ * the version of its source so a later write to y invalidates it.
+ */
+void copy_propagation(CompilationContext *ctx) {
+    TACInstruction *code = get_tac_list(ctx);
+    int count = get_tac_count(ctx);
     
-    CopyEntry copies[100];
-    int copy_count = 0;
+    OptTable copies;
+    OptTable versions;
+    table_init(&copies);
+    table_init(&versions);
     
-    while (instr) {
+    for (int n = 0; n < count; n++) {
+        TACInstruction *instr = &code[n];
+        if (instr->opcode == TAC_NOP) continue;
+        
         /* Check if this is a copy: x = y */
         if (instr->opcode == TAC_ASSIGN) {
             /* Record copy */
-            int found = 0;
-            for (int i = 0; i < copy_count; i++) {
-                if (strcmp(copies[i].dest, instr->result) == 0) {
-                    free(copies[i].source);
-                    copies[i].source = copy_string(instr->arg1);
-                    found = 1;
-                    break;
-                }
-            }
-            if (!found && copy_count < 100) {
-                copies[copy_count].dest = copy_string(instr->result);
-                copies[copy_count].source = copy_string(instr->arg1);
-                copy_count++;
+            bump_version(&versions, instr->result);
+            if (operand_equal(instr->result, instr->arg1)) {
+                table_kill(&copies, instr->result);
+            } else {
+                TableSlot *slot = table_insert(&copies, TAC_NOP, instr->result, operand_none());
+                slot->value = instr->arg1;
+                slot->version1 = var_version(&versions, instr->arg1);
+                slot->valid = 1;
             }
         }
         /* Replace uses of copies */
         else if (instr->opcode != TAC_FUNC_BEGIN && instr->opcode != TAC_FUNC_END) {
-            for (int i = 0; i < copy_count; i++) {
-                if (instr->arg1 && strcmp(instr->arg1, copies[i].dest) == 0) {
-                    free(instr->arg1);
-                    instr->arg1 = copy_string(copies[i].source);
-                    opt_stats.copies_propagated++;
-                }
-                if (instr->arg2 && strcmp(instr->arg2, copies[i].dest) == 0) {
-                    free(instr->arg2);
-                    instr->arg2 = copy_string(copies[i].source);
-                    opt_stats.copies_propagated++;
-                }
+            TableSlot *slot;
+            if ((slot = table_find(&copies, TAC_NOP, instr->arg1, operand_none())) &&
+                slot->version1 == var_version(&versions, slot->value)) {
+                instr->arg1 = slot->value;
+                ctx->opt_stats.copies_propagated++;
+            }
+            if ((slot = table_find(&copies, TAC_NOP, instr->arg2, operand_none())) &&
+                slot->version1 == var_version(&versions, slot->value)) {
+                instr->arg2 = slot->value;
+                ctx->opt_stats.copies_propagated++;
+            }
+            
+            if (defines_result(instr)) {
+                bump_version(&versions, instr->result);
+                table_kill(&copies, instr->result);
             }
         }
         
-        /* Clear copies at labels (conservative) */
-        if (instr->opcode == TAC_LABEL) {
-            copy_count = 0;
+        /* Clear copies at labels and calls (conservative) */
+        if (ends_local_region(instr)) {
+            table_clear(&copies);
+            table_clear(&versions);
         }
-        
-        instr = instr->next;
     }
+    
+    table_free(&copies);
+    table_free(&versions);
 }
 
 /* Algebraic simplification - simplify algebraic expressions */
-void algebraic_simplification(void) {
-    TACInstruction *instr = get_tac_list();
+void algebraic_simplification(CompilationContext *ctx) {
+    TACInstruction *code = get_tac_list(ctx);
+    int count = get_tac_count(ctx);
     
-    while (instr) {
+    for (int n = 0; n < count; n++) {
+        TACInstruction *instr = &code[n];
+        if (instr->opcode == TAC_NOP) continue;
+        
         /* x = y + 0  =>  x = y */
         if (instr->opcode == TAC_ADD) {
             if (is_constant(instr->arg2) && get_constant_value(instr->arg2) == 0) {
                 instr->opcode = TAC_ASSIGN;
-                free(instr->arg2);
-                instr->arg2 = NULL;
-                opt_stats.expressions_simplified++;
+                instr->arg2 = operand_none();
+                ctx->opt_stats.expressions_simplified++;
             } else if (is_constant(instr->arg1) && get_constant_value(instr->arg1) == 0) {
                 instr->opcode = TAC_ASSIGN;
-                free(instr->arg1);
                 instr->arg1 = instr->arg2;
-                instr->arg2 = NULL;
-                opt_stats.expressions_simplified++;
+                instr->arg2 = operand_none();
+                ctx->opt_stats.expressions_simplified++;
             }
         }
         
@@ -275,15 +614,13 @@ void algebraic_simplification(void) {
         if (instr->opcode == TAC_MUL) {
             if (is_constant(instr->arg2) && get_constant_value(instr->arg2) == 1) {
                 instr->opcode = TAC_ASSIGN;
-                free(instr->arg2);
-                instr->arg2 = NULL;
-                opt_stats.expressions_simplified++;
+                instr->arg2 = operand_none();
+                ctx->opt_stats.expressions_simplified++;
             } else if (is_constant(instr->arg1) && get_constant_value(instr->arg1) == 1) {
                 instr->opcode = TAC_ASSIGN;
-                free(instr->arg1);
                 instr->arg1 = instr->arg2;
-                instr->arg2 = NULL;
-                opt_stats.expressions_simplified++;
+                instr->arg2 = operand_none();
+                ctx->opt_stats.expressions_simplified++;
             }
         }
         
@@ -292,159 +629,179 @@ void algebraic_simplification(void) {
             if ((is_constant(instr->arg1) && get_constant_value(instr->arg1) == 0) ||
                 (is_constant(instr->arg2) && get_constant_value(instr->arg2) == 0)) {
                 instr->opcode = TAC_LOAD_CONST;
-                free(instr->arg1);
-                instr->arg1 = copy_string("0");
-                free(instr->arg2);
-                instr->arg2 = NULL;
-                opt_stats.expressions_simplified++;
+                instr->arg1 = operand_const(0);
+                instr->arg2 = operand_none();
+                ctx->opt_stats.expressions_simplified++;
             }
         }
-        
-        instr = instr->next;
     }
 }
 
-/* Common subexpression elimination */
-void common_subexpression_elimination(void) {
-    TACInstruction *instr = get_tac_list();
-    
-    typedef struct {
-        TACOpcode op;
-        char *arg1;
-        char *arg2;
-        char *result;
-    } ExprEntry;
+/* Check if an opcode computes a value from its operands alone */
+static int is_pure_expression(TACOpcode op) {
+    return (op >= TAC_ADD && op <= TAC_NEG) || (op >= TAC_LT && op <= TAC_NEQ);
+}
+
+/* Common subexpression elimination
+ *
+ * Expressions are keyed on opcode and operands. An entry is reused only
+ * while neither operand nor the variable holding the result has been
+ * redefined since it was recorded.
+ */
+void common_subexpression_elimination(CompilationContext *ctx) {
+    TACInstruction *code = get_tac_list(ctx);
+    int count = get_tac_count(ctx);
     
-    ExprEntry expressions[100];
-    int expr_count = 0;
+    OptTable expressions;
+    OptTable versions;
+    table_init(&expressions);
+    table_init(&versions);
     
-    while (instr) {
-        if (instr->opcode >= TAC_ADD && instr->opcode <= TAC_NEQ) {
+    for (int n = 0; n < count; n++) {
+        TACInstruction *instr = &code[n];
+        if (instr->opcode == TAC_NOP) continue;
+        
+        if (is_pure_expression(instr->opcode)) {
+            int version1 = var_version(&versions, instr->arg1);
+            int version2 = var_version(&versions, instr->arg2);
+            
             /* Check if expression already computed */
-            int found = -1;
-            for (int i = 0; i < expr_count; i++) {
-                if (expressions[i].op == instr->opcode &&
-                    strcmp(expressions[i].arg1, instr->arg1) == 0 &&
-                    strcmp(expressions[i].arg2, instr->arg2) == 0) {
-                    found = i;
-                    break;
-                }
+            TableSlot *slot = table_find(&expressions, instr->opcode, instr->arg1, instr->arg2);
+            if (slot && (slot->version1 != version1 || slot->version2 != version2 ||
+                         slot->version3 != var_version(&versions, slot->value))) {
+                slot = NULL;
             }
             
-            if (found >= 0) {
+            if (slot) {
                 /* Replace with copy of previous result */
                 instr->opcode = TAC_ASSIGN;
-                free(instr->arg1);
-                instr->arg1 = copy_string(expressions[found].result);
-                free(instr->arg2);
-                instr->arg2 = NULL;
-                opt_stats.subexpressions_eliminated++;
-            } else if (expr_count < 100) {
+                instr->arg1 = slot->value;
+                instr->arg2 = operand_none();
+                ctx->opt_stats.subexpressions_eliminated++;
+                bump_version(&versions, instr->result);
+            } else {
                 /* Record new expression */
-                expressions[expr_count].op = instr->opcode;
-                expressions[expr_count].arg1 = copy_string(instr->arg1);
-                expressions[expr_count].arg2 = copy_string(instr->arg2);
-                expressions[expr_count].result = copy_string(instr->result);
-                expr_count++;
+                bump_version(&versions, instr->result);
+                slot = table_insert(&expressions, instr->opcode, instr->arg1, instr->arg2);
+                slot->value = instr->result;
+                slot->version1 = version1;
+                slot->version2 = version2;
+                slot->version3 = var_version(&versions, instr->result);
+                slot->valid = 1;
             }
+        } else if (defines_result(instr)) {
+            bump_version(&versions, instr->result);
         }
         
-        /* Clear expressions at labels (conservative) */
-        if (instr->opcode == TAC_LABEL) {
-            expr_count = 0;
+        /* Clear expressions at labels and calls (conservative) */
+        if (ends_local_region(instr)) {
+            table_clear(&expressions);
+            table_clear(&versions);
         }
-        
-        instr = instr->next;
     }
+    
+    table_free(&expressions);
+    table_free(&versions);
 }
 
 /* Peephole optimization - optimize small instruction sequences */
-void peephole_optimization(void) {
-    remove_redundant_jumps();
-    combine_operations();
+void peephole_optimization(CompilationContext *ctx) {
+    remove_redundant_jumps(ctx);
+    combine_operations(ctx);
 }
 
 /* Remove redundant jumps */
-void remove_redundant_jumps(void) {
-    TACInstruction *instr = get_tac_list();
+void remove_redundant_jumps(CompilationContext *ctx) {
+    TACInstruction *code = get_tac_list(ctx);
+    int count = get_tac_count(ctx);
     
-    while (instr && instr->next) {
+    for (int i = next_tac_index(ctx, -1); i < count; ) {
+        int next = next_tac_index(ctx, i);
+        if (next >= count) break;
+        
         /* Remove jump to next instruction */
-        if (instr->opcode == TAC_GOTO && 
-            instr->next->opcode == TAC_LABEL &&
-            instr->label == instr->next->label) {
-            /* Remove the goto */
-            TACInstruction *to_remove = instr;
-            instr = instr->next;
-            
-            /* Fix linked list */
-            TACInstruction *prev = get_tac_list();
-            if (prev == to_remove) {
-                set_tac_list(instr);
-            } else {
-                while (prev->next != to_remove) {
-                    prev = prev->next;
-                }
-                prev->next = instr;
-            }
-            
-            free(to_remove);
-            opt_stats.dead_code_removed++;
-        } else {
-            instr = instr->next;
+        if (code[i].opcode == TAC_GOTO &&
+            code[next].opcode == TAC_LABEL &&
+            code[i].label == code[next].label) {
+            remove_tac(ctx, i);
+            ctx->opt_stats.dead_code_removed++;
         }
+        i = next;
     }
 }
 
 /* Combine operations */
-void combine_operations(void) {
+void combine_operations(CompilationContext *ctx) {
     /* Example: combine consecutive adds/multiplies */
     /* This is a placeholder for more complex operation combining */
 }
 
 /* Check if operand is a constant */
-int is_constant(char *operand) {
-    if (!operand) return 0;
-    
-    /* Check if it's a number (possibly negative) */
-    char *p = operand;
-    if (*p == '-') p++;
-    
-    while (*p) {
-        if (!isdigit(*p)) return 0;
-        p++;
-    }
-    
-    return 1;
+int is_constant(TACOperand operand) {
+    return operand.kind == OPERAND_CONST;
 }
 
 /* Get constant value */
-int get_constant_value(char *operand) {
-    return atoi(operand);
+int get_constant_value(TACOperand operand) {
+    return operand.value;
 }
 
 /* Check if operand is a temporary */
-int is_temporary(char *operand) {
-    return operand && operand[0] == 't' && isdigit(operand[1]);
+int is_temporary(TACOperand operand) {
+    return operand.kind == OPERAND_TEMP;
+}
+
+/* Check if an instruction writes its result operand */
+int defines_result(TACInstruction *instr) {
+    switch (instr->opcode) {
+        case TAC_ADD: case TAC_SUB: case TAC_MUL: case TAC_DIV: case TAC_NEG:
+        case TAC_ASSIGN: case TAC_LOAD_CONST: case TAC_ARRAY_LOAD:
+        case TAC_LT: case TAC_LTE: case TAC_GT: case TAC_GTE: case TAC_EQ: case TAC_NEQ:
+        case TAC_CALL:
+            return instr->result.kind != OPERAND_NONE;
+        default:
+            return 0;
+    }
+}
+
+/* Check if an instruction reads its result operand */
+int uses_result(TACInstruction *instr) {
+    switch (instr->opcode) {
+        case TAC_ARRAY_STORE:
+        case TAC_IF_TRUE:
+        case TAC_IF_FALSE:
+        case TAC_PARAM:
+        case TAC_RETURN:
+            return instr->result.kind != OPERAND_NONE;
+        default:
+            return 0;
+    }
+}
+
+/* Replace every use of one operand in an instruction with another */
+void replace_operand(TACInstruction *instr, TACOperand old_op, TACOperand new_op) {
+    if (operand_equal(instr->arg1, old_op)) instr->arg1 = new_op;
+    if (operand_equal(instr->arg2, old_op)) instr->arg2 = new_op;
 }
 
 /* Print optimization statistics */
-void print_optimization_stats(void) {
-    printf("\n=== OPTIMIZATION STATISTICS ===\n");
-    printf("Original instructions:     %d\n", opt_stats.original_instruction_count);
-    printf("Optimized instructions:    %d\n", opt_stats.optimized_instruction_count);
-    printf("Instructions removed:      %d\n", 
-           opt_stats.original_instruction_count - opt_stats.optimized_instruction_count);
-    printf("Constants folded:          %d\n", opt_stats.constants_folded);
-    printf("Dead code removed:         %d\n", opt_stats.dead_code_removed);
-    printf("Copies propagated:         %d\n", opt_stats.copies_propagated);
-    printf("Expressions simplified:    %d\n", opt_stats.expressions_simplified);
-    printf("Subexpressions eliminated: %d\n", opt_stats.subexpressions_eliminated);
-    
-    if (opt_stats.original_instruction_count > 0) {
-        float reduction = 100.0 * (opt_stats.original_instruction_count - 
-                                   opt_stats.optimized_instruction_count) /
-                         opt_stats.original_instruction_count;
-        printf("Code size reduction:       %.1f%%\n", reduction);
+void print_optimization_stats(CompilationContext *ctx) {
+    fprintf(ctx->report, "\n=== OPTIMIZATION STATISTICS ===\n");
+    fprintf(ctx->report, "Original instructions:     %d\n", ctx->opt_stats.original_instruction_count);
+    fprintf(ctx->report, "Optimized instructions:    %d\n", ctx->opt_stats.optimized_instruction_count);
+    fprintf(ctx->report, "Instructions removed:      %d\n", 
+            ctx->opt_stats.original_instruction_count - ctx->opt_stats.optimized_instruction_count);
+    fprintf(ctx->report, "Constants folded:          %d\n", ctx->opt_stats.constants_folded);
+    fprintf(ctx->report, "Dead code removed:         %d\n", ctx->opt_stats.dead_code_removed);
+    fprintf(ctx->report, "Copies propagated:         %d\n", ctx->opt_stats.copies_propagated);
+    fprintf(ctx->report, "Dead copies removed:       %d\n", ctx->opt_stats.dead_copies_removed);
+    fprintf(ctx->report, "Expressions simplified:    %d\n", ctx->opt_stats.expressions_simplified);
+    fprintf(ctx->report, "Subexpressions eliminated: %d\n", ctx->opt_stats.subexpressions_eliminated);
+    
+    if (ctx->opt_stats.original_instruction_count > 0) {
+        float reduction = 100.0 * (ctx->opt_stats.original_instruction_count - 
+                                   ctx->opt_stats.optimized_instruction_count) /
+                         ctx->opt_stats.original_instruction_count;
+        fprintf(ctx->report, "Code size reduction:       %.1f%%\n", reduction);
     }
 }
\ No newline at end of file
@@ -55,7 +55,7 @@
 #define YYSKELETON_NAME "yacc.c"
 
 /* Pure parsers.  */
-#define YYPURE 0
+#define YYPURE 2
 
 /* Push parsers.  */
 #define YYPUSH 0
@@ -79,20 +79,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "globals.h"
-#include "ast.h"
-#include "symtab.h"
+#include "context.h"
 
-extern int yylex();
-extern int linenum;
-extern int colnum;
-extern FILE *yyin;
+/* Deeply nested input needs far more than bison's default 10000 states;
+ * the parser stack lives on the heap and doubles as needed. */
+#define YYMAXDEPTH 50000000
 
-void yyerror(const char *s);
-
-ASTNode *ast_root = NULL;
-
-#line 96 "src/parser.tab.c"
+#line 89 "src/parser.tab.c"
 
 # ifndef YY_CAST
 #  ifdef __cplusplus
@@ -568,13 +561,13 @@ static const yytype_int8 yytranslate[] =
 /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_int16 yyrline[] =
 {
-       0,    60,    60,    67,    72,    78,    79,    83,    86,    92,
-      93,    97,   103,   104,   108,   113,   117,   120,   126,   132,
-     137,   141,   146,   150,   151,   152,   153,   154,   158,   159,
-     163,   166,   172,   178,   181,   187,   190,   194,   197,   203,
-     206,   210,   211,   212,   213,   214,   215,   219,   222,   226,
-     227,   231,   234,   238,   239,   243,   244,   245,   246,   252,
-     258,   259,   263,   268
+       0,    73,    73,    82,    85,    91,    92,    96,    99,   105,
+     106,   110,   116,   117,   121,   124,   128,   131,   137,   143,
+     146,   150,   153,   157,   158,   159,   160,   161,   165,   166,
+     170,   173,   179,   185,   188,   194,   197,   201,   204,   210,
+     213,   217,   218,   219,   220,   221,   222,   226,   229,   233,
+     234,   238,   241,   245,   246,   250,   251,   252,   253,   259,
+     265,   266,   270,   273
 };
 #endif
 
@@ -769,7 +762,7 @@ enum { YYENOMEM = -2 };
       }                                                           \
     else                                                          \
       {                                                           \
-        yyerror (YY_("syntax error: cannot back up")); \
+        yyerror (scanner, ctx, YY_("syntax error: cannot back up")); \
         YYERROR;                                                  \
       }                                                           \
   while (0)
@@ -802,7 +795,7 @@ do {                                                                      \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Kind, Value); \
+                  Kind, Value, scanner, ctx); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
@@ -814,10 +807,12 @@ do {                                                                      \
 
 static void
 yy_symbol_value_print (FILE *yyo,
-                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, yyscan_t scanner, CompilationContext *ctx)
 {
   FILE *yyoutput = yyo;
   YY_USE (yyoutput);
+  YY_USE (scanner);
+  YY_USE (ctx);
   if (!yyvaluep)
     return;
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
@@ -832,12 +827,12 @@ yy_symbol_value_print (FILE *yyo,
 
 static void
 yy_symbol_print (FILE *yyo,
-                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, yyscan_t scanner, CompilationContext *ctx)
 {
   YYFPRINTF (yyo, "%s %s (",
              yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  yy_symbol_value_print (yyo, yykind, yyvaluep);
+  yy_symbol_value_print (yyo, yykind, yyvaluep, scanner, ctx);
   YYFPRINTF (yyo, ")");
 }
 
@@ -871,7 +866,7 @@ do {                                                            \
 
 static void
 yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
-                 int yyrule)
+                 int yyrule, yyscan_t scanner, CompilationContext *ctx)
 {
   int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
@@ -884,7 +879,7 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
       YYFPRINTF (stderr, "   $%d = ", yyi + 1);
       yy_symbol_print (stderr,
                        YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
-                       &yyvsp[(yyi + 1) - (yynrhs)]);
+                       &yyvsp[(yyi + 1) - (yynrhs)], scanner, ctx);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -892,7 +887,7 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
 # define YY_REDUCE_PRINT(Rule)          \
 do {                                    \
   if (yydebug)                          \
-    yy_reduce_print (yyssp, yyvsp, Rule); \
+    yy_reduce_print (yyssp, yyvsp, Rule, scanner, ctx); \
 } while (0)
 
 /* Nonzero means print parse trace.  It is left uninitialized so that
@@ -933,9 +928,11 @@ int yydebug;
 
 static void
 yydestruct (const char *yymsg,
-            yysymbol_kind_t yykind, YYSTYPE *yyvaluep)
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, yyscan_t scanner, CompilationContext *ctx)
 {
   YY_USE (yyvaluep);
+  YY_USE (scanner);
+  YY_USE (ctx);
   if (!yymsg)
     yymsg = "Deleting";
   YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
@@ -946,13 +943,6 @@ yydestruct (const char *yymsg,
 }
 
 
-/* Lookahead token kind.  */
-int yychar;
-
-/* The semantic value of the lookahead symbol.  */
-YYSTYPE yylval;
-/* Number of syntax errors so far.  */
-int yynerrs;
 
 
 
@@ -962,8 +952,21 @@ int yynerrs;
 `----------*/
 
 int
-yyparse (void)
+yyparse (yyscan_t scanner, CompilationContext *ctx)
 {
+/* Lookahead token kind.  */
+int yychar;
+
+
+/* The semantic value of the lookahead symbol.  */
+/* Default value used for initialization, for pacifying older GCCs
+   or non-GCC compilers.  */
+YY_INITIAL_VALUE (static YYSTYPE yyval_default;)
+YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
+
+    /* Number of syntax errors so far.  */
+    int yynerrs = 0;
+
     yy_state_fast_t yystate = 0;
     /* Number of tokens to shift before error messages enabled.  */
     int yyerrstatus = 0;
@@ -1116,7 +1119,7 @@ yybackup:
   if (yychar == YYEMPTY)
     {
       YYDPRINTF ((stderr, "Reading a token\n"));
-      yychar = yylex ();
+      yychar = yylex (&yylval, scanner);
     }
 
   if (yychar <= YYEOF)
@@ -1204,442 +1207,434 @@ yyreduce:
   switch (yyn)
     {
   case 2: /* program: declaration_list  */
-#line 60 "src/parser.y"
+#line 73 "src/parser.y"
                      { 
-        ast_root = (yyvsp[0].node); 
-        printf("Parse completed successfully!\n");
+        ctx->ast_root = (yyvsp[0].node); 
+        if (!quiet_mode) {
+            fprintf(ctx->report, "Parse completed successfully!\n");
+        }
     }
-#line 1213 "src/parser.tab.c"
+#line 1218 "src/parser.tab.c"
     break;
 
   case 3: /* declaration_list: declaration_list declaration  */
-#line 67 "src/parser.y"
+#line 82 "src/parser.y"
                                  { 
-        (yyval.node) = create_node(NODE_PROGRAM);
-        (yyval.node)->left = (yyvsp[-1].node);
-        (yyval.node)->right = (yyvsp[0].node);
+        (yyval.node) = append_to_list(ctx, (yyvsp[-1].node), (yyvsp[0].node));
     }
-#line 1223 "src/parser.tab.c"
+#line 1226 "src/parser.tab.c"
     break;
 
   case 4: /* declaration_list: declaration  */
-#line 72 "src/parser.y"
+#line 85 "src/parser.y"
                   { 
-        (yyval.node) = (yyvsp[0].node); 
+        (yyval.node) = append_to_list(ctx, create_list_node(ctx, NODE_PROGRAM), (yyvsp[0].node));
     }
-#line 1231 "src/parser.tab.c"
+#line 1234 "src/parser.tab.c"
     break;
 
   case 5: /* declaration: var_declaration  */
-#line 78 "src/parser.y"
+#line 91 "src/parser.y"
                     { (yyval.node) = (yyvsp[0].node); }
-#line 1237 "src/parser.tab.c"
+#line 1240 "src/parser.tab.c"
     break;
 
   case 6: /* declaration: fun_declaration  */
-#line 79 "src/parser.y"
+#line 92 "src/parser.y"
                       { (yyval.node) = (yyvsp[0].node); }
-#line 1243 "src/parser.tab.c"
+#line 1246 "src/parser.tab.c"
     break;
 
   case 7: /* var_declaration: type_specifier ID SEMI  */
-#line 83 "src/parser.y"
+#line 96 "src/parser.y"
                            { 
-        (yyval.node) = create_var_decl_node((yyvsp[-2].string), (yyvsp[-1].string), 0);
+        (yyval.node) = create_var_decl_node(ctx, (yyvsp[-2].string), (yyvsp[-1].string), 0);
     }
-#line 1251 "src/parser.tab.c"
+#line 1254 "src/parser.tab.c"
     break;
 
   case 8: /* var_declaration: type_specifier ID LBRACKET NUM RBRACKET SEMI  */
-#line 86 "src/parser.y"
+#line 99 "src/parser.y"
                                                    { 
-        (yyval.node) = create_var_decl_node((yyvsp[-5].string), (yyvsp[-4].string), (yyvsp[-2].number));
+        (yyval.node) = create_var_decl_node(ctx, (yyvsp[-5].string), (yyvsp[-4].string), (yyvsp[-2].number));
     }
-#line 1259 "src/parser.tab.c"
+#line 1262 "src/parser.tab.c"
     break;
 
   case 9: /* type_specifier: INT  */
-#line 92 "src/parser.y"
-        { (yyval.string) = strdup("int"); }
-#line 1265 "src/parser.tab.c"
+#line 105 "src/parser.y"
+        { (yyval.string) = arena_strdup(REGION(ctx, REGION_PARSE), "int"); }
+#line 1268 "src/parser.tab.c"
     break;
 
   case 10: /* type_specifier: VOID  */
-#line 93 "src/parser.y"
-           { (yyval.string) = strdup("void"); }
-#line 1271 "src/parser.tab.c"
+#line 106 "src/parser.y"
+           { (yyval.string) = arena_strdup(REGION(ctx, REGION_PARSE), "void"); }
+#line 1274 "src/parser.tab.c"
     break;
 
   case 11: /* fun_declaration: type_specifier ID LPAREN params RPAREN compound_stmt  */
-#line 97 "src/parser.y"
+#line 110 "src/parser.y"
                                                          {
-        (yyval.node) = create_func_decl_node((yyvsp[-5].string), (yyvsp[-4].string), (yyvsp[-2].node), (yyvsp[0].node));
+        (yyval.node) = create_func_decl_node(ctx, (yyvsp[-5].string), (yyvsp[-4].string), (yyvsp[-2].node), (yyvsp[0].node));
     }
-#line 1279 "src/parser.tab.c"
+#line 1282 "src/parser.tab.c"
     break;
 
   case 12: /* params: param_list  */
-#line 103 "src/parser.y"
+#line 116 "src/parser.y"
                { (yyval.node) = (yyvsp[0].node); }
-#line 1285 "src/parser.tab.c"
+#line 1288 "src/parser.tab.c"
     break;
 
   case 13: /* params: VOID  */
-#line 104 "src/parser.y"
-           { (yyval.node) = NULL; }
-#line 1291 "src/parser.tab.c"
+#line 117 "src/parser.y"
+           { (yyval.node) = NO_NODE; }
+#line 1294 "src/parser.tab.c"
     break;
 
   case 14: /* param_list: param_list COMMA param  */
-#line 108 "src/parser.y"
+#line 121 "src/parser.y"
                            {
-        (yyval.node) = create_node(NODE_PARAM_LIST);
-        (yyval.node)->left = (yyvsp[-2].node);
-        (yyval.node)->right = (yyvsp[0].node);
+        (yyval.node) = append_to_list(ctx, (yyvsp[-2].node), (yyvsp[0].node));
     }
-#line 1301 "src/parser.tab.c"
+#line 1302 "src/parser.tab.c"
     break;
 
   case 15: /* param_list: param  */
-#line 113 "src/parser.y"
-            { (yyval.node) = (yyvsp[0].node); }
-#line 1307 "src/parser.tab.c"
+#line 124 "src/parser.y"
+            { (yyval.node) = append_to_list(ctx, create_list_node(ctx, NODE_PARAM_LIST), (yyvsp[0].node)); }
+#line 1308 "src/parser.tab.c"
     break;
 
   case 16: /* param: type_specifier ID  */
-#line 117 "src/parser.y"
+#line 128 "src/parser.y"
                       {
-        (yyval.node) = create_param_node((yyvsp[-1].string), (yyvsp[0].string), 0);
+        (yyval.node) = create_param_node(ctx, (yyvsp[-1].string), (yyvsp[0].string), 0);
     }
-#line 1315 "src/parser.tab.c"
+#line 1316 "src/parser.tab.c"
     break;
 
   case 17: /* param: type_specifier ID LBRACKET RBRACKET  */
-#line 120 "src/parser.y"
+#line 131 "src/parser.y"
                                           {
-        (yyval.node) = create_param_node((yyvsp[-3].string), (yyvsp[-2].string), 1);
+        (yyval.node) = create_param_node(ctx, (yyvsp[-3].string), (yyvsp[-2].string), 1);
     }
-#line 1323 "src/parser.tab.c"
+#line 1324 "src/parser.tab.c"
     break;
 
   case 18: /* compound_stmt: LBRACE local_declarations statement_list RBRACE  */
-#line 126 "src/parser.y"
+#line 137 "src/parser.y"
                                                     {
-        (yyval.node) = create_compound_stmt_node((yyvsp[-2].node), (yyvsp[-1].node));
+        (yyval.node) = create_compound_stmt_node(ctx, (yyvsp[-2].node), (yyvsp[-1].node));
     }
-#line 1331 "src/parser.tab.c"
+#line 1332 "src/parser.tab.c"
     break;
 
   case 19: /* local_declarations: local_declarations var_declaration  */
-#line 132 "src/parser.y"
+#line 143 "src/parser.y"
                                        {
-        (yyval.node) = create_node(NODE_LOCAL_DECLS);
-        (yyval.node)->left = (yyvsp[-1].node);
-        (yyval.node)->right = (yyvsp[0].node);
+        (yyval.node) = append_to_list(ctx, (yyvsp[-1].node), (yyvsp[0].node));
     }
-#line 1341 "src/parser.tab.c"
+#line 1340 "src/parser.tab.c"
     break;
 
   case 20: /* local_declarations: %empty  */
-#line 137 "src/parser.y"
-                  { (yyval.node) = NULL; }
-#line 1347 "src/parser.tab.c"
+#line 146 "src/parser.y"
+                  { (yyval.node) = create_list_node(ctx, NODE_LOCAL_DECLS); }
+#line 1346 "src/parser.tab.c"
     break;
 
   case 21: /* statement_list: statement_list statement  */
-#line 141 "src/parser.y"
+#line 150 "src/parser.y"
                              {
-        (yyval.node) = create_node(NODE_STMT_LIST);
-        (yyval.node)->left = (yyvsp[-1].node);
-        (yyval.node)->right = (yyvsp[0].node);
+        (yyval.node) = append_to_list(ctx, (yyvsp[-1].node), (yyvsp[0].node));
     }
-#line 1357 "src/parser.tab.c"
+#line 1354 "src/parser.tab.c"
     break;
 
   case 22: /* statement_list: %empty  */
-#line 146 "src/parser.y"
-                  { (yyval.node) = NULL; }
-#line 1363 "src/parser.tab.c"
+#line 153 "src/parser.y"
+                  { (yyval.node) = create_list_node(ctx, NODE_STMT_LIST); }
+#line 1360 "src/parser.tab.c"
     break;
 
   case 23: /* statement: expression_stmt  */
-#line 150 "src/parser.y"
+#line 157 "src/parser.y"
                     { (yyval.node) = (yyvsp[0].node); }
-#line 1369 "src/parser.tab.c"
+#line 1366 "src/parser.tab.c"
     break;
 
   case 24: /* statement: compound_stmt  */
-#line 151 "src/parser.y"
+#line 158 "src/parser.y"
                     { (yyval.node) = (yyvsp[0].node); }
-#line 1375 "src/parser.tab.c"
+#line 1372 "src/parser.tab.c"
     break;
 
   case 25: /* statement: selection_stmt  */
-#line 152 "src/parser.y"
+#line 159 "src/parser.y"
                      { (yyval.node) = (yyvsp[0].node); }
-#line 1381 "src/parser.tab.c"
+#line 1378 "src/parser.tab.c"
     break;
 
   case 26: /* statement: iteration_stmt  */
-#line 153 "src/parser.y"
+#line 160 "src/parser.y"
                      { (yyval.node) = (yyvsp[0].node); }
-#line 1387 "src/parser.tab.c"
+#line 1384 "src/parser.tab.c"
     break;
 
   case 27: /* statement: return_stmt  */
-#line 154 "src/parser.y"
+#line 161 "src/parser.y"
                   { (yyval.node) = (yyvsp[0].node); }
-#line 1393 "src/parser.tab.c"
+#line 1390 "src/parser.tab.c"
     break;
 
   case 28: /* expression_stmt: expression SEMI  */
-#line 158 "src/parser.y"
-                    { (yyval.node) = (yyvsp[-1].node); }
-#line 1399 "src/parser.tab.c"
+#line 165 "src/parser.y"
+                    { (yyval.node) = create_expr_stmt_node(ctx, (yyvsp[-1].node)); }
+#line 1396 "src/parser.tab.c"
     break;
 
   case 29: /* expression_stmt: SEMI  */
-#line 159 "src/parser.y"
-           { (yyval.node) = NULL; }
-#line 1405 "src/parser.tab.c"
+#line 166 "src/parser.y"
+           { (yyval.node) = NO_NODE; }
+#line 1402 "src/parser.tab.c"
     break;
 
   case 30: /* selection_stmt: IF LPAREN expression RPAREN statement  */
-#line 163 "src/parser.y"
+#line 170 "src/parser.y"
                                           {
-        (yyval.node) = create_if_node((yyvsp[-2].node), (yyvsp[0].node), NULL);
+        (yyval.node) = create_if_node(ctx, (yyvsp[-2].node), (yyvsp[0].node), NO_NODE);
     }
-#line 1413 "src/parser.tab.c"
+#line 1410 "src/parser.tab.c"
     break;
 
   case 31: /* selection_stmt: IF LPAREN expression RPAREN statement ELSE statement  */
-#line 166 "src/parser.y"
+#line 173 "src/parser.y"
                                                            {
-        (yyval.node) = create_if_node((yyvsp[-4].node), (yyvsp[-2].node), (yyvsp[0].node));
+        (yyval.node) = create_if_node(ctx, (yyvsp[-4].node), (yyvsp[-2].node), (yyvsp[0].node));
     }
-#line 1421 "src/parser.tab.c"
+#line 1418 "src/parser.tab.c"
     break;
 
   case 32: /* iteration_stmt: WHILE LPAREN expression RPAREN statement  */
-#line 172 "src/parser.y"
+#line 179 "src/parser.y"
                                              {
-        (yyval.node) = create_while_node((yyvsp[-2].node), (yyvsp[0].node));
+        (yyval.node) = create_while_node(ctx, (yyvsp[-2].node), (yyvsp[0].node));
     }
-#line 1429 "src/parser.tab.c"
+#line 1426 "src/parser.tab.c"
     break;
 
   case 33: /* return_stmt: RETURN SEMI  */
-#line 178 "src/parser.y"
+#line 185 "src/parser.y"
                 {
-        (yyval.node) = create_return_node(NULL);
+        (yyval.node) = create_return_node(ctx, NO_NODE);
     }
-#line 1437 "src/parser.tab.c"
+#line 1434 "src/parser.tab.c"
     break;
 
   case 34: /* return_stmt: RETURN expression SEMI  */
-#line 181 "src/parser.y"
+#line 188 "src/parser.y"
                              {
-        (yyval.node) = create_return_node((yyvsp[-1].node));
+        (yyval.node) = create_return_node(ctx, (yyvsp[-1].node));
     }
-#line 1445 "src/parser.tab.c"
+#line 1442 "src/parser.tab.c"
     break;
 
   case 35: /* expression: var ASSIGN expression  */
-#line 187 "src/parser.y"
+#line 194 "src/parser.y"
                           {
-        (yyval.node) = create_assign_node((yyvsp[-2].node), (yyvsp[0].node));
+        (yyval.node) = create_assign_node(ctx, (yyvsp[-2].node), (yyvsp[0].node));
     }
-#line 1453 "src/parser.tab.c"
+#line 1450 "src/parser.tab.c"
     break;
 
   case 36: /* expression: simple_expression  */
-#line 190 "src/parser.y"
+#line 197 "src/parser.y"
                         { (yyval.node) = (yyvsp[0].node); }
-#line 1459 "src/parser.tab.c"
+#line 1456 "src/parser.tab.c"
     break;
 
   case 37: /* var: ID  */
-#line 194 "src/parser.y"
+#line 201 "src/parser.y"
        {
-        (yyval.node) = create_id_node((yyvsp[0].string));
+        (yyval.node) = create_id_node(ctx, (yyvsp[0].string));
     }
-#line 1467 "src/parser.tab.c"
+#line 1464 "src/parser.tab.c"
     break;
 
   case 38: /* var: ID LBRACKET expression RBRACKET  */
-#line 197 "src/parser.y"
+#line 204 "src/parser.y"
                                       {
-        (yyval.node) = create_array_access_node((yyvsp[-3].string), (yyvsp[-1].node));
+        (yyval.node) = create_array_access_node(ctx, (yyvsp[-3].string), (yyvsp[-1].node));
     }
-#line 1475 "src/parser.tab.c"
+#line 1472 "src/parser.tab.c"
     break;
 
   case 39: /* simple_expression: additive_expression relop additive_expression  */
-#line 203 "src/parser.y"
+#line 210 "src/parser.y"
                                                   {
-        (yyval.node) = create_binary_op_node((yyvsp[-1].string), (yyvsp[-2].node), (yyvsp[0].node));
+        (yyval.node) = create_binary_op_node(ctx, (yyvsp[-1].string), (yyvsp[-2].node), (yyvsp[0].node));
     }
-#line 1483 "src/parser.tab.c"
+#line 1480 "src/parser.tab.c"
     break;
 
   case 40: /* simple_expression: additive_expression  */
-#line 206 "src/parser.y"
+#line 213 "src/parser.y"
                           { (yyval.node) = (yyvsp[0].node); }
-#line 1489 "src/parser.tab.c"
+#line 1486 "src/parser.tab.c"
     break;
 
   case 41: /* relop: LTE  */
-#line 210 "src/parser.y"
-        { (yyval.string) = strdup("<="); }
-#line 1495 "src/parser.tab.c"
+#line 217 "src/parser.y"
+        { (yyval.string) = intern_string(ctx, "<="); }
+#line 1492 "src/parser.tab.c"
     break;
 
   case 42: /* relop: LT  */
-#line 211 "src/parser.y"
-         { (yyval.string) = strdup("<"); }
-#line 1501 "src/parser.tab.c"
+#line 218 "src/parser.y"
+         { (yyval.string) = intern_string(ctx, "<"); }
+#line 1498 "src/parser.tab.c"
     break;
 
   case 43: /* relop: GT  */
-#line 212 "src/parser.y"
-         { (yyval.string) = strdup(">"); }
-#line 1507 "src/parser.tab.c"
+#line 219 "src/parser.y"
+         { (yyval.string) = intern_string(ctx, ">"); }
+#line 1504 "src/parser.tab.c"
     break;
 
   case 44: /* relop: GTE  */
-#line 213 "src/parser.y"
-          { (yyval.string) = strdup(">="); }
-#line 1513 "src/parser.tab.c"
+#line 220 "src/parser.y"
+          { (yyval.string) = intern_string(ctx, ">="); }
+#line 1510 "src/parser.tab.c"
     break;
 
   case 45: /* relop: EQ  */
-#line 214 "src/parser.y"
-         { (yyval.string) = strdup("=="); }
-#line 1519 "src/parser.tab.c"
+#line 221 "src/parser.y"
+         { (yyval.string) = intern_string(ctx, "=="); }
+#line 1516 "src/parser.tab.c"
     break;
 
   case 46: /* relop: NEQ  */
-#line 215 "src/parser.y"
-          { (yyval.string) = strdup("!="); }
-#line 1525 "src/parser.tab.c"
+#line 222 "src/parser.y"
+          { (yyval.string) = intern_string(ctx, "!="); }
+#line 1522 "src/parser.tab.c"
     break;
 
   case 47: /* additive_expression: additive_expression addop term  */
-#line 219 "src/parser.y"
+#line 226 "src/parser.y"
                                    {
-        (yyval.node) = create_binary_op_node((yyvsp[-1].string), (yyvsp[-2].node), (yyvsp[0].node));
+        (yyval.node) = create_binary_op_node(ctx, (yyvsp[-1].string), (yyvsp[-2].node), (yyvsp[0].node));
     }
-#line 1533 "src/parser.tab.c"
+#line 1530 "src/parser.tab.c"
     break;
 
   case 48: /* additive_expression: term  */
-#line 222 "src/parser.y"
+#line 229 "src/parser.y"
            { (yyval.node) = (yyvsp[0].node); }
-#line 1539 "src/parser.tab.c"
+#line 1536 "src/parser.tab.c"
     break;
 
   case 49: /* addop: PLUS  */
-#line 226 "src/parser.y"
-         { (yyval.string) = strdup("+"); }
-#line 1545 "src/parser.tab.c"
+#line 233 "src/parser.y"
+         { (yyval.string) = intern_string(ctx, "+"); }
+#line 1542 "src/parser.tab.c"
     break;
 
   case 50: /* addop: MINUS  */
-#line 227 "src/parser.y"
-            { (yyval.string) = strdup("-"); }
-#line 1551 "src/parser.tab.c"
+#line 234 "src/parser.y"
+            { (yyval.string) = intern_string(ctx, "-"); }
+#line 1548 "src/parser.tab.c"
     break;
 
   case 51: /* term: term mulop factor  */
-#line 231 "src/parser.y"
+#line 238 "src/parser.y"
                       {
-        (yyval.node) = create_binary_op_node((yyvsp[-1].string), (yyvsp[-2].node), (yyvsp[0].node));
+        (yyval.node) = create_binary_op_node(ctx, (yyvsp[-1].string), (yyvsp[-2].node), (yyvsp[0].node));
     }
-#line 1559 "src/parser.tab.c"
+#line 1556 "src/parser.tab.c"
     break;
 
   case 52: /* term: factor  */
-#line 234 "src/parser.y"
+#line 241 "src/parser.y"
              { (yyval.node) = (yyvsp[0].node); }
-#line 1565 "src/parser.tab.c"
+#line 1562 "src/parser.tab.c"
     break;
 
   case 53: /* mulop: TIMES  */
-#line 238 "src/parser.y"
-          { (yyval.string) = strdup("*"); }
-#line 1571 "src/parser.tab.c"
+#line 245 "src/parser.y"
+          { (yyval.string) = intern_string(ctx, "*"); }
+#line 1568 "src/parser.tab.c"
     break;
 
   case 54: /* mulop: DIVIDE  */
-#line 239 "src/parser.y"
-             { (yyval.string) = strdup("/"); }
-#line 1577 "src/parser.tab.c"
+#line 246 "src/parser.y"
+             { (yyval.string) = intern_string(ctx, "/"); }
+#line 1574 "src/parser.tab.c"
     break;
 
   case 55: /* factor: LPAREN expression RPAREN  */
-#line 243 "src/parser.y"
+#line 250 "src/parser.y"
                              { (yyval.node) = (yyvsp[-1].node); }
-#line 1583 "src/parser.tab.c"
+#line 1580 "src/parser.tab.c"
     break;
 
   case 56: /* factor: var  */
-#line 244 "src/parser.y"
+#line 251 "src/parser.y"
           { (yyval.node) = (yyvsp[0].node); }
-#line 1589 "src/parser.tab.c"
+#line 1586 "src/parser.tab.c"
     break;
 
   case 57: /* factor: call  */
-#line 245 "src/parser.y"
+#line 252 "src/parser.y"
            { (yyval.node) = (yyvsp[0].node); }
-#line 1595 "src/parser.tab.c"
+#line 1592 "src/parser.tab.c"
     break;
 
   case 58: /* factor: NUM  */
-#line 246 "src/parser.y"
+#line 253 "src/parser.y"
           { 
-        (yyval.node) = create_num_node((yyvsp[0].number)); 
+        (yyval.node) = create_num_node(ctx, (yyvsp[0].number)); 
     }
-#line 1603 "src/parser.tab.c"
+#line 1600 "src/parser.tab.c"
     break;
 
   case 59: /* call: ID LPAREN args RPAREN  */
-#line 252 "src/parser.y"
+#line 259 "src/parser.y"
                           {
-        (yyval.node) = create_call_node((yyvsp[-3].string), (yyvsp[-1].node));
+        (yyval.node) = create_call_node(ctx, (yyvsp[-3].string), (yyvsp[-1].node));
     }
-#line 1611 "src/parser.tab.c"
+#line 1608 "src/parser.tab.c"
     break;
 
   case 60: /* args: arg_list  */
-#line 258 "src/parser.y"
+#line 265 "src/parser.y"
              { (yyval.node) = (yyvsp[0].node); }
-#line 1617 "src/parser.tab.c"
+#line 1614 "src/parser.tab.c"
     break;
 
   case 61: /* args: %empty  */
-#line 259 "src/parser.y"
-                  { (yyval.node) = NULL; }
-#line 1623 "src/parser.tab.c"
+#line 266 "src/parser.y"
+                  { (yyval.node) = NO_NODE; }
+#line 1620 "src/parser.tab.c"
     break;
 
   case 62: /* arg_list: arg_list COMMA expression  */
-#line 263 "src/parser.y"
+#line 270 "src/parser.y"
                               {
-        (yyval.node) = create_node(NODE_ARG_LIST);
-        (yyval.node)->left = (yyvsp[-2].node);
-        (yyval.node)->right = (yyvsp[0].node);
+        (yyval.node) = append_to_list(ctx, (yyvsp[-2].node), (yyvsp[0].node));
     }
-#line 1633 "src/parser.tab.c"
+#line 1628 "src/parser.tab.c"
     break;
 
   case 63: /* arg_list: expression  */
-#line 268 "src/parser.y"
-                 { (yyval.node) = (yyvsp[0].node); }
-#line 1639 "src/parser.tab.c"
+#line 273 "src/parser.y"
+                 { (yyval.node) = append_to_list(ctx, create_list_node(ctx, NODE_ARG_LIST), (yyvsp[0].node)); }
+#line 1634 "src/parser.tab.c"
     break;
 
 
-#line 1643 "src/parser.tab.c"
+#line 1638 "src/parser.tab.c"
 
       default: break;
     }
@@ -1686,7 +1681,7 @@ yyerrlab:
   if (!yyerrstatus)
     {
       ++yynerrs;
-      yyerror (YY_("syntax error"));
+      yyerror (scanner, ctx, YY_("syntax error"));
     }
 
   if (yyerrstatus == 3)
@@ -1703,7 +1698,7 @@ yyerrlab:
       else
         {
           yydestruct ("Error: discarding",
-                      yytoken, &yylval);
+                      yytoken, &yylval, scanner, ctx);
           yychar = YYEMPTY;
         }
     }
@@ -1759,7 +1754,7 @@ yyerrlab1:
 
 
       yydestruct ("Error: popping",
-                  YY_ACCESSING_SYMBOL (yystate), yyvsp);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, scanner, ctx);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -1797,7 +1792,7 @@ yyabortlab:
 | yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
 `-----------------------------------------------------------*/
 yyexhaustedlab:
-  yyerror (YY_("memory exhausted"));
+  yyerror (scanner, ctx, YY_("memory exhausted"));
   yyresult = 2;
   goto yyreturnlab;
 
@@ -1812,7 +1807,7 @@ yyreturnlab:
          user semantic actions for why this is necessary.  */
       yytoken = YYTRANSLATE (yychar);
       yydestruct ("Cleanup: discarding lookahead",
-                  yytoken, &yylval);
+                  yytoken, &yylval, scanner, ctx);
     }
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYABORT or YYACCEPT.  */
@@ -1821,7 +1816,7 @@ yyreturnlab:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, scanner, ctx);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
@@ -1832,9 +1827,10 @@ yyreturnlab:
   return yyresult;
 }
 
-#line 271 "src/parser.y"
+#line 276 "src/parser.y"
 
 
-void yyerror(const char *s) {
-    fprintf(stderr, "Parse error at line %d, column %d: %s\n", linenum, colnum, s);
+void yyerror(yyscan_t scanner, CompilationContext *ctx, const char *s) {
+    (void)scanner;
+    fprintf(ctx->diagnostics, "Parse error at line %d, column %d: %s\n", ctx->line, ctx->column, s);
 }
@@ -44,6 +44,17 @@
 #if YYDEBUG
 extern int yydebug;
 #endif
+/* "%code requires" blocks.  */
+#line 19 "src/parser.y"
+
+#include "ast.h"
+
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+
+#line 58 "src/parser.tab.h"
 
 /* Token kinds.  */
 #ifndef YYTOKENTYPE
@@ -89,13 +100,13 @@ extern int yydebug;
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
 union YYSTYPE
 {
-#line 26 "src/parser.y"
+#line 39 "src/parser.y"
 
     int number;
     char *string;
-    struct ASTNode *node;
+    NodeId node;
 
-#line 99 "src/parser.tab.h"
+#line 110 "src/parser.tab.h"
 
 };
 typedef union YYSTYPE YYSTYPE;
@@ -104,10 +115,16 @@ typedef union YYSTYPE YYSTYPE;
 #endif
 
 
-extern YYSTYPE yylval;
 
 
-int yyparse (void);
+int yyparse (yyscan_t scanner, CompilationContext *ctx);
+
+/* "%code provides" blocks.  */
+#line 28 "src/parser.y"
+
+int yylex(YYSTYPE *yylval_param, yyscan_t yyscanner);
+void yyerror(yyscan_t scanner, CompilationContext *ctx, const char *s);
 
+#line 129 "src/parser.tab.h"
 
 #endif /* !YY_YY_SRC_PARSER_TAB_H_INCLUDED  */
@@ -9,24 +9,37 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "globals.h"
+#include "context.h"
+
+/* Deeply nested input needs far more than bison's default 10000 states;
+ * the parser stack lives on the heap and doubles as needed. */
+#define YYMAXDEPTH 50000000
+%}
+
+%code requires {
 #include "ast.h"
-#include "symtab.h"
 
-extern int yylex();
-extern int linenum;
-extern int colnum;
-extern FILE *yyin;
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+}
 
-void yyerror(const char *s);
+%code provides {
+int yylex(YYSTYPE *yylval_param, yyscan_t yyscanner);
+void yyerror(yyscan_t scanner, CompilationContext *ctx, const char *s);
+}
 
-ASTNode *ast_root = NULL;
-%}
+/* The parser keeps no globals: the scanner and the compilation it builds
+ * into are passed through every call */
+%define api.pure full
+%lex-param {yyscan_t scanner}
+%parse-param {yyscan_t scanner} {CompilationContext *ctx}
 
 %union {
     int number;
     char *string;
-    struct ASTNode *node;
+    NodeId node;
 }
 
 /* Token declarations */
@@ -58,19 +71,19 @@ ASTNode *ast_root = NULL;
 
 program:
     declaration_list { 
-        ast_root = $1; 
-        printf("Parse completed successfully!\n");
+        ctx->ast_root = $1; 
+        if (!quiet_mode) {
+            fprintf(ctx->report, "Parse completed successfully!\n");
+        }
     }
     ;
 
 declaration_list:
     declaration_list declaration { 
-        $$ = create_node(NODE_PROGRAM);
-        $$->left = $1;
-        $$->right = $2;
+        $$ = append_to_list(ctx, $1, $2);
     }
     | declaration { 
-        $$ = $1; 
+        $$ = append_to_list(ctx, create_list_node(ctx, NODE_PROGRAM), $1);
     }
     ;
 
@@ -81,69 +94,63 @@ declaration:
 
 var_declaration:
     type_specifier ID SEMI { 
-        $$ = create_var_decl_node($1, $2, 0);
+        $$ = create_var_decl_node(ctx, $1, $2, 0);
     }
     | type_specifier ID LBRACKET NUM RBRACKET SEMI { 
-        $$ = create_var_decl_node($1, $2, $4);
+        $$ = create_var_decl_node(ctx, $1, $2, $4);
     }
     ;
 
 type_specifier:
-    INT { $$ = strdup("int"); }
-    | VOID { $$ = strdup("void"); }
+    INT { $$ = arena_strdup(REGION(ctx, REGION_PARSE), "int"); }
+    | VOID { $$ = arena_strdup(REGION(ctx, REGION_PARSE), "void"); }
     ;
 
 fun_declaration:
     type_specifier ID LPAREN params RPAREN compound_stmt {
-        $$ = create_func_decl_node($1, $2, $4, $6);
+        $$ = create_func_decl_node(ctx, $1, $2, $4, $6);
     }
     ;
 
 params:
     param_list { $$ = $1; }
-    | VOID { $$ = NULL; }
+    | VOID { $$ = NO_NODE; }
     ;
 
 param_list:
     param_list COMMA param {
-        $$ = create_node(NODE_PARAM_LIST);
-        $$->left = $1;
-        $$->right = $3;
+        $$ = append_to_list(ctx, $1, $3);
     }
-    | param { $$ = $1; }
+    | param { $$ = append_to_list(ctx, create_list_node(ctx, NODE_PARAM_LIST), $1); }
     ;
 
 param:
     type_specifier ID {
-        $$ = create_param_node($1, $2, 0);
+        $$ = create_param_node(ctx, $1, $2, 0);
     }
     | type_specifier ID LBRACKET RBRACKET {
-        $$ = create_param_node($1, $2, 1);
+        $$ = create_param_node(ctx, $1, $2, 1);
     }
     ;
 
 compound_stmt:
     LBRACE local_declarations statement_list RBRACE {
-        $$ = create_compound_stmt_node($2, $3);
+        $$ = create_compound_stmt_node(ctx, $2, $3);
     }
     ;
 
 local_declarations:
     local_declarations var_declaration {
-        $$ = create_node(NODE_LOCAL_DECLS);
-        $$->left = $1;
-        $$->right = $2;
+        $$ = append_to_list(ctx, $1, $2);
     }
-    | /* empty */ { $$ = NULL; }
+    | /* empty */ { $$ = create_list_node(ctx, NODE_LOCAL_DECLS); }
     ;
 
 statement_list:
     statement_list statement {
-        $$ = create_node(NODE_STMT_LIST);
-        $$->left = $1;
-        $$->right = $2;
+        $$ = append_to_list(ctx, $1, $2);
     }
-    | /* empty */ { $$ = NULL; }
+    | /* empty */ { $$ = create_list_node(ctx, NODE_STMT_LIST); }
     ;
 
 statement:
@@ -155,88 +162,88 @@ statement:
     ;
 
 expression_stmt:
-    expression SEMI { $$ = $1; }
-    | SEMI { $$ = NULL; }
+    expression SEMI { $$ = create_expr_stmt_node(ctx, $1); }
+    | SEMI { $$ = NO_NODE; }
     ;
 
 selection_stmt:
     IF LPAREN expression RPAREN statement {
-        $$ = create_if_node($3, $5, NULL);
+        $$ = create_if_node(ctx, $3, $5, NO_NODE);
     }
     | IF LPAREN expression RPAREN statement ELSE statement {
-        $$ = create_if_node($3, $5, $7);
+        $$ = create_if_node(ctx, $3, $5, $7);
     }
     ;
 
 iteration_stmt:
     WHILE LPAREN expression RPAREN statement {
-        $$ = create_while_node($3, $5);
+        $$ = create_while_node(ctx, $3, $5);
     }
     ;
 
 return_stmt:
     RETURN SEMI {
-        $$ = create_return_node(NULL);
+        $$ = create_return_node(ctx, NO_NODE);
     }
     | RETURN expression SEMI {
-        $$ = create_return_node($2);
+        $$ = create_return_node(ctx, $2);
     }
     ;
 
 expression:
     var ASSIGN expression {
-        $$ = create_assign_node($1, $3);
+        $$ = create_assign_node(ctx, $1, $3);
     }
     | simple_expression { $$ = $1; }
     ;
 
 var:
     ID {
-        $$ = create_id_node($1);
+        $$ = create_id_node(ctx, $1);
     }
     | ID LBRACKET expression RBRACKET {
-        $$ = create_array_access_node($1, $3);
+        $$ = create_array_access_node(ctx, $1, $3);
     }
     ;
 
 simple_expression:
     additive_expression relop additive_expression {
-        $$ = create_binary_op_node($2, $1, $3);
+        $$ = create_binary_op_node(ctx, $2, $1, $3);
     }
     | additive_expression { $$ = $1; }
     ;
 
 relop:
-    LTE { $$ = strdup("<="); }
-    | LT { $$ = strdup("<"); }
-    | GT { $$ = strdup(">"); }
-    | GTE { $$ = strdup(">="); }
-    | EQ { $$ = strdup("=="); }
-    | NEQ { $$ = strdup("!="); }
+    LTE { $$ = intern_string(ctx, "<="); }
+    | LT { $$ = intern_string(ctx, "<"); }
+    | GT { $$ = intern_string(ctx, ">"); }
+    | GTE { $$ = intern_string(ctx, ">="); }
+    | EQ { $$ = intern_string(ctx, "=="); }
+    | NEQ { $$ = intern_string(ctx, "!="); }
     ;
 
 additive_expression:
     additive_expression addop term {
-        $$ = create_binary_op_node($2, $1, $3);
+        $$ = create_binary_op_node(ctx, $2, $1, $3);
     }
     | term { $$ = $1; }
     ;
 
 addop:
-    PLUS { $$ = strdup("+"); }
-    | MINUS { $$ = strdup("-"); }
+    PLUS { $$ = intern_string(ctx, "+"); }
+    | MINUS { $$ = intern_string(ctx, "-"); }
     ;
 
 term:
     term mulop factor {
-        $$ = create_binary_op_node($2, $1, $3);
+        $$ = create_binary_op_node(ctx, $2, $1, $3);
     }
     | factor { $$ = $1; }
     ;
 
 mulop:
-    TIMES { $$ = strdup("*"); }
-    | DIVIDE { $$ = strdup("/"); }
+    TIMES { $$ = intern_string(ctx, "*"); }
+    | DIVIDE { $$ = intern_string(ctx, "/"); }
     ;
 
 factor:
@@ -244,32 +251,31 @@ factor:
     | var { $$ = $1; }
     | call { $$ = $1; }
     | NUM { 
-        $$ = create_num_node($1); 
+        $$ = create_num_node(ctx, $1); 
     }
     ;
 
 call:
     ID LPAREN args RPAREN {
-        $$ = create_call_node($1, $3);
+        $$ = create_call_node(ctx, $1, $3);
     }
     ;
 
 args:
     arg_list { $$ = $1; }
-    | /* empty */ { $$ = NULL; }
+    | /* empty */ { $$ = NO_NODE; }
     ;
 
 arg_list:
     arg_list COMMA expression {
-        $$ = create_node(NODE_ARG_LIST);
-        $$->left = $1;
-        $$->right = $3;
+        $$ = append_to_list(ctx, $1, $3);
     }
-    | expression { $$ = $1; }
+    | expression { $$ = append_to_list(ctx, create_list_node(ctx, NODE_ARG_LIST), $1); }
     ;
 
 %%
 
-void yyerror(const char *s) {
-    fprintf(stderr, "Parse error at line %d, column %d: %s\n", linenum, colnum, s);
+void yyerror(yyscan_t scanner, CompilationContext *ctx, const char *s) {
+    (void)scanner;
+    fprintf(ctx->diagnostics, "Parse error at line %d, column %d: %s\n", ctx->line, ctx->column, s);
 }
\ No newline at end of file
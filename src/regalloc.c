@@ -0,0 +1,1186 @@
+/*
+ * Register Allocator Implementation
+ * CST-405 Compiler Design
+ *
+ * Linear scan over live intervals (Poletto and Sarkar). Liveness is
+ * solved over the function's basic blocks, every temporary and local
+ * scalar gets one interval covering each position where it may be live,
+ * and the intervals are handed registers in order of their start. A
+ * copy's destination takes its source's register when the two cannot
+ * hold different values at once, so the move disappears. When no
+ * register is free, the value with the lowest loop-weighted use
+ * count per position spends its whole lifetime in its stack slot instead.
+ *
+ * Values live across a call prefer the callee-saved $s registers, which
+ * the prologue saves only if handed out; others prefer $t registers. A
+ * value that crosses a call in a $t register is saved around just the
+ * calls it is live across.
+ *
+ * At -O3 the same liveness feeds a graph-coloring allocator that also
+ * removes copies by coalescing (see color_graph).
+ *
+ * Every table, the allocation itself included, comes from the backend
+ * region and is released with it once the function is emitted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "context.h"
+
+/* Registers handed out, in order of preference; $t8, $t9 and $v1 are
+ * left to the code generator as scratch */
+static const MIPSRegister allocatable[] = {
+    REG_T0, REG_T1, REG_T2, REG_T3, REG_T4, REG_T5, REG_T6, REG_T7,
+    REG_S0, REG_S1, REG_S2, REG_S3, REG_S4, REG_S5, REG_S6, REG_S7
+};
+#define ALLOCATABLE_COUNT (int)(sizeof(allocatable) / sizeof(allocatable[0]))
+
+/* A use inside a loop counts ten times one outside it, up to this depth */
+#define MAX_WEIGHTED_DEPTH 6
+
+/* Control flow of one function */
+typedef struct {
+    int block_count;
+    int *block_start;          /* First instruction of each block, then the count */
+    int (*successors)[2];      /* Up to two per block, -1 when absent */
+    int *loop_depth;           /* Loops enclosing each instruction */
+} FlowGraph;
+
+/* Widen [*low, *high] to include n */
+static void cover(int n, int *low, int *high) {
+    if (*high < *low) {
+        *low = *high = n;
+    } else if (n < *low) {
+        *low = n;
+    } else if (n > *high) {
+        *high = n;
+    }
+}
+
+/* Local scalar or parameter symbol an operand names, or NULL */
+static SymbolEntry *local_scalar(CompilationContext *ctx, TACOperand operand) {
+    SymbolEntry *symbol = operand_symbol(ctx, operand);
+    if (operand.kind != OPERAND_VAR || symbol == NULL ||
+        symbol->kind == SYMBOL_ARRAY || is_global_symbol(symbol)) {
+        return NULL;
+    }
+    return symbol;
+}
+
+/* Number the temporaries and local scalars the function touches
+ *
+ * Temporaries are numbered across the unit and a function's locals have
+ * consecutive symbol IDs, so each is a dense span.
+ */
+static void number_values(CompilationContext *ctx, TACInstruction *code, int count, RegAllocation *alloc) {
+    int temp_low = 0, temp_high = -1;
+    int var_low = 0, var_high = -1;
+
+    for (int i = 0; i < count; i++) {
+        TACOperand operands[3] = { code[i].result, code[i].arg1, code[i].arg2 };
+        for (int k = 0; k < 3; k++) {
+            if (is_temporary(operands[k])) {
+                cover(operands[k].value, &temp_low, &temp_high);
+            } else if (local_scalar(ctx, operands[k])) {
+                cover(operands[k].value, &var_low, &var_high);
+            }
+        }
+        if (code[i].opcode == TAC_FUNC_BEGIN) {
+            SymbolEntry *func = operand_symbol(ctx, code[i].result);
+            for (SymbolEntry *param = func->params; param; param = param->next) {
+                cover(param->id, &var_low, &var_high);
+            }
+        }
+    }
+
+    alloc->temp_base = temp_low;
+    alloc->temp_count = temp_high - temp_low + 1;
+    alloc->var_base = var_low;
+    alloc->var_count = var_high - var_low + 1;
+    alloc->value_count = alloc->temp_count + alloc->var_count;
+}
+
+/* Value an operand names, or -1 for constants, globals, arrays and functions */
+int value_index(CompilationContext *ctx, RegAllocation *alloc, TACOperand operand) {
+    if (operand.kind == OPERAND_TEMP) {
+        int t = operand.value - alloc->temp_base;
+        return (t >= 0 && t < alloc->temp_count) ? t : -1;
+    }
+    if (operand.kind == OPERAND_VAR) {
+        int v = operand.value - alloc->var_base;
+        if (v >= 0 && v < alloc->var_count && local_scalar(ctx, operand)) {
+            return alloc->temp_count + v;
+        }
+    }
+    return -1;
+}
+
+/* Register holding an operand for its lifetime, or REG_SPILLED */
+int value_register(CompilationContext *ctx, RegAllocation *alloc, TACOperand operand) {
+    int v = value_index(ctx, alloc, operand);
+    return (v >= 0) ? alloc->intervals[v].reg : REG_SPILLED;
+}
+
+/* Values an instruction reads, at most three */
+static int instruction_uses(CompilationContext *ctx, RegAllocation *alloc, TACInstruction *instr, int uses[3]) {
+    int n = 0;
+    int v;
+    if (uses_result(instr) && (v = value_index(ctx, alloc, instr->result)) >= 0) uses[n++] = v;
+    if ((v = value_index(ctx, alloc, instr->arg1)) >= 0) uses[n++] = v;
+    if ((v = value_index(ctx, alloc, instr->arg2)) >= 0) uses[n++] = v;
+    return n;
+}
+
+/* Value an instruction writes, or -1 */
+static int instruction_def(CompilationContext *ctx, RegAllocation *alloc, TACInstruction *instr) {
+    return defines_result(instr) ? value_index(ctx, alloc, instr->result) : -1;
+}
+
+static int ends_block(TACInstruction *instr) {
+    return instr->opcode == TAC_GOTO || instr->opcode == TAC_IF_TRUE ||
+           instr->opcode == TAC_IF_FALSE || instr->opcode == TAC_RETURN;
+}
+
+/* Split the function into basic blocks and find its loops
+ *
+ * A jump back to an earlier label closes a loop around everything in
+ * between; the depths are summed with a difference array.
+ */
+static void build_flow_graph(CompilationContext *ctx, TACInstruction *code, int count, FlowGraph *flow) {
+    Arena *arena = REGION(ctx, REGION_BACKEND);
+    int label_low = 0, label_high = -1;
+    flow->block_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (i == 0 || code[i].opcode == TAC_LABEL || ends_block(&code[i - 1])) {
+            flow->block_count++;
+        }
+        if (code[i].opcode == TAC_LABEL) {
+            cover(code[i].label, &label_low, &label_high);
+        }
+    }
+
+    flow->block_start = (int *)arena_alloc(arena, (flow->block_count + 1) * sizeof(int));
+    flow->successors = (int (*)[2])arena_alloc(arena, (flow->block_count + 1) * sizeof(int[2]));
+    int *label_block = (int *)arena_alloc(arena, (label_high - label_low + 2) * sizeof(int));
+    int *label_position = (int *)arena_alloc(arena, (label_high - label_low + 2) * sizeof(int));
+    int b = 0;
+    for (int i = 0; i < count; i++) {
+        if (i == 0 || code[i].opcode == TAC_LABEL || ends_block(&code[i - 1])) {
+            flow->block_start[b++] = i;
+        }
+        if (code[i].opcode == TAC_LABEL) {
+            label_block[code[i].label - label_low] = b - 1;
+            label_position[code[i].label - label_low] = i;
+        }
+    }
+    flow->block_start[flow->block_count] = count;
+
+    int *depth_change = (int *)arena_calloc(arena, count + 1, sizeof(int));
+    for (b = 0; b < flow->block_count; b++) {
+        int last = flow->block_start[b + 1] - 1;
+        int next = (b + 1 < flow->block_count) ? b + 1 : -1;
+        TACInstruction *instr = &code[last];
+
+        flow->successors[b][0] = next;
+        flow->successors[b][1] = -1;
+        if (instr->opcode == TAC_GOTO || instr->opcode == TAC_IF_TRUE || instr->opcode == TAC_IF_FALSE) {
+            int target = instr->label - label_low;
+            flow->successors[b][instr->opcode == TAC_GOTO ? 0 : 1] = label_block[target];
+            if (label_position[target] <= last) {
+                depth_change[label_position[target]]++;
+                depth_change[last + 1]--;
+            }
+        } else if (instr->opcode == TAC_RETURN) {
+            flow->successors[b][0] = -1;
+        }
+    }
+
+    flow->loop_depth = (int *)arena_alloc(arena, (count + 1) * sizeof(int));
+    int depth = 0;
+    for (int i = 0; i < count; i++) {
+        depth += depth_change[i];
+        flow->loop_depth[i] = depth;
+    }
+}
+
+/* Stretch an interval over a position */
+static void extend(LiveInterval *interval, int position) {
+    if (interval->start > interval->end) {
+        interval->start = interval->end = position;
+    } else if (position < interval->start) {
+        interval->start = position;
+    } else if (position > interval->end) {
+        interval->end = position;
+    }
+}
+
+/* Values live into or out of each block
+ *
+ * Most values are temporaries read in the block that writes them, so
+ * only values read before being written in some block take part in the
+ * dataflow; the bit sets stay small even for very long functions.
+ */
+typedef struct {
+    int count;                 /* Values taking part */
+    int words;                 /* Words in each block's set */
+    int *values;               /* Value of each bit */
+    unsigned int *live_in;     /* Per block, words apiece */
+    unsigned int *live_out;
+} Liveness;
+
+/* Positions and loop-weighted counts of every use and def */
+static void record_uses(CompilationContext *ctx, TACInstruction *code, int count,
+                        FlowGraph *flow, RegAllocation *alloc) {
+    LiveInterval *intervals = alloc->intervals;
+    double weights[MAX_WEIGHTED_DEPTH + 1];
+    weights[0] = 1;
+    for (int d = 1; d <= MAX_WEIGHTED_DEPTH; d++) {
+        weights[d] = weights[d - 1] * 10;
+    }
+
+    for (int i = 0; i < count; i++) {
+        int depth = flow->loop_depth[i] < MAX_WEIGHTED_DEPTH ? flow->loop_depth[i] : MAX_WEIGHTED_DEPTH;
+        int uses[3];
+        int use_count = instruction_uses(ctx, alloc, &code[i], uses);
+        for (int u = 0; u < use_count; u++) {
+            extend(&intervals[uses[u]], 2 * i);
+            intervals[uses[u]].weight += weights[depth];
+        }
+        int def = instruction_def(ctx, alloc, &code[i]);
+        if (def >= 0) {
+            extend(&intervals[def], 2 * i + 1);
+            intervals[def].weight += weights[depth];
+            intervals[def].defs++;
+            if (code[i].opcode == TAC_ASSIGN && use_count == 1 && intervals[def].hint < 0) {
+                intervals[def].hint = uses[0];
+            }
+        }
+        if (code[i].opcode == TAC_FUNC_BEGIN) {
+            SymbolEntry *func = operand_symbol(ctx, code[i].result);
+            for (SymbolEntry *param = func->params; param; param = param->next) {
+                extend(&intervals[alloc->temp_count + param->id - alloc->var_base], 2 * i + 1);
+                intervals[alloc->temp_count + param->id - alloc->var_base].defs++;
+            }
+        }
+    }
+}
+
+static void solve_liveness(CompilationContext *ctx, TACInstruction *code,
+                           FlowGraph *flow, RegAllocation *alloc, Liveness *live) {
+    Arena *arena = REGION(ctx, REGION_BACKEND);
+    int values = alloc->value_count;
+
+    /* Values live into some block */
+    int *defined_in = (int *)arena_alloc(arena, (values + 1) * sizeof(int));
+    int *global_id = (int *)arena_alloc(arena, (values + 1) * sizeof(int));
+    for (int v = 0; v < values; v++) {
+        defined_in[v] = -1;
+        global_id[v] = -1;
+    }
+    int global_count = 0;
+    for (int b = 0; b < flow->block_count; b++) {
+        for (int i = flow->block_start[b]; i < flow->block_start[b + 1]; i++) {
+            int uses[3];
+            int use_count = instruction_uses(ctx, alloc, &code[i], uses);
+            for (int u = 0; u < use_count; u++) {
+                if (defined_in[uses[u]] != b && global_id[uses[u]] < 0) {
+                    global_id[uses[u]] = global_count++;
+                }
+            }
+            int def = instruction_def(ctx, alloc, &code[i]);
+            if (def >= 0) defined_in[def] = b;
+        }
+    }
+
+    int words = (global_count + 31) / 32;
+    size_t set_bytes = (size_t)flow->block_count * words * sizeof(unsigned int) + 1;
+    unsigned int *use = (unsigned int *)arena_calloc(arena, 1, set_bytes);
+    unsigned int *def = (unsigned int *)arena_calloc(arena, 1, set_bytes);
+    live->count = global_count;
+    live->words = words;
+    live->values = (int *)arena_alloc(arena, (global_count + 1) * sizeof(int));
+    live->live_in = (unsigned int *)arena_calloc(arena, 1, set_bytes);
+    live->live_out = (unsigned int *)arena_calloc(arena, 1, set_bytes);
+    for (int v = 0; v < values; v++) {
+        if (global_id[v] >= 0) live->values[global_id[v]] = v;
+    }
+
+    /* Read before written (use) and written (def) in each block */
+    for (int b = 0; b < flow->block_count && global_count > 0; b++) {
+        unsigned int *block_use = use + (size_t)b * words;
+        unsigned int *block_def = def + (size_t)b * words;
+        for (int i = flow->block_start[b]; i < flow->block_start[b + 1]; i++) {
+            int uses[3];
+            int use_count = instruction_uses(ctx, alloc, &code[i], uses);
+            for (int u = 0; u < use_count; u++) {
+                int g = global_id[uses[u]];
+                if (g >= 0 && !(block_def[g / 32] & (1u << (g % 32)))) {
+                    block_use[g / 32] |= 1u << (g % 32);
+                }
+            }
+            int d = instruction_def(ctx, alloc, &code[i]);
+            if (d >= 0 && global_id[d] >= 0) {
+                block_def[global_id[d] / 32] |= 1u << (global_id[d] % 32);
+            }
+            if (code[i].opcode == TAC_FUNC_BEGIN) {
+                SymbolEntry *func = operand_symbol(ctx, code[i].result);
+                for (SymbolEntry *param = func->params; param; param = param->next) {
+                    int g = global_id[alloc->temp_count + param->id - alloc->var_base];
+                    if (g >= 0) block_def[g / 32] |= 1u << (g % 32);
+                }
+            }
+        }
+    }
+
+    /* live_out = union of successors' live_in; live_in = use | (live_out & ~def) */
+    int changed = global_count > 0;
+    while (changed) {
+        changed = 0;
+        for (int b = flow->block_count - 1; b >= 0; b--) {
+            unsigned int *out = live->live_out + (size_t)b * words;
+            unsigned int *in = live->live_in + (size_t)b * words;
+            for (int w = 0; w < words; w++) {
+                unsigned int bits = 0;
+                for (int s = 0; s < 2; s++) {
+                    int succ = flow->successors[b][s];
+                    if (succ >= 0) bits |= live->live_in[(size_t)succ * words + w];
+                }
+                out[w] = bits;
+                unsigned int new_in = use[(size_t)b * words + w] | (bits & ~def[(size_t)b * words + w]);
+                if (new_in != in[w]) {
+                    in[w] = new_in;
+                    changed = 1;
+                }
+            }
+        }
+    }
+}
+
+/* Stretch the intervals of values live into a block back to its first
+ * read, and of values live out of it on to its last write */
+static void extend_over_blocks(FlowGraph *flow, Liveness *live, RegAllocation *alloc) {
+    LiveInterval *intervals = alloc->intervals;
+    for (int b = 0; b < flow->block_count; b++) {
+        for (int w = 0; w < live->words; w++) {
+            unsigned int in = live->live_in[(size_t)b * live->words + w];
+            unsigned int out = live->live_out[(size_t)b * live->words + w];
+            for (int bit = 0; bit < 32 && (in | out); bit++) {
+                int v = live->values[w * 32 + bit];
+                if (in & (1u << bit)) extend(&intervals[v], 2 * flow->block_start[b]);
+                if (out & (1u << bit)) extend(&intervals[v], 2 * flow->block_start[b + 1] - 1);
+                in &= ~(1u << bit);
+                out &= ~(1u << bit);
+            }
+        }
+    }
+}
+
+/* Calls to user functions; the input and output routines leave every
+ * allocatable register alone */
+static int is_user_call(CompilationContext *ctx, TACInstruction *instr) {
+    return instr->opcode == TAC_CALL && !is_builtin_function(ctx, operand_symbol(ctx, instr->arg1));
+}
+
+/* A value live across a call, before registers are known */
+typedef struct {
+    int call;                  /* Index of the call in instruction order */
+    int value;
+} CallCrossing;
+
+/* Positions of the calls to user functions, in order */
+static int *find_user_calls(CompilationContext *ctx, TACInstruction *code, int count, RegAllocation *alloc) {
+    int *calls = (int *)arena_alloc(REGION(ctx, REGION_BACKEND), (count + 1) * sizeof(int));
+    alloc->call_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (is_user_call(ctx, &code[i])) {
+            calls[alloc->call_count++] = 2 * i;
+        }
+    }
+    return calls;
+}
+
+/* Mark the intervals that stay live across a call to a user function and
+ * note every call each one crosses */
+static void mark_call_crossings(RegAllocation *alloc, int *calls, WorkStack *crossings) {
+    int call_count = alloc->call_count;
+    for (int v = 0; v < alloc->value_count && call_count > 0; v++) {
+        LiveInterval *interval = &alloc->intervals[v];
+        if (interval->start > interval->end) continue;
+
+        /* First call at or after the start; the value crosses it if it
+         * is still live once the call has written its result */
+        int low = 0, high = call_count;
+        while (low < high) {
+            int mid = (low + high) / 2;
+            if (calls[mid] < interval->start) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        interval->crosses_call = low < call_count && calls[low] + 1 <= interval->end;
+        for (int k = low; k < call_count && calls[k] + 1 <= interval->end; k++) {
+            CallCrossing *crossing = (CallCrossing *)stack_push(crossings);
+            crossing->call = k;
+            crossing->value = v;
+        }
+    }
+}
+
+/* Interval order for the scan */
+typedef struct {
+    int start;
+    int value;
+} ScanEntry;
+
+static int compare_scan_entries(const void *a, const void *b) {
+    const ScanEntry *ea = (const ScanEntry *)a;
+    const ScanEntry *eb = (const ScanEntry *)b;
+    if (ea->start != eb->start) return (ea->start < eb->start) ? -1 : 1;
+    return ea->value - eb->value;
+}
+
+/* Cost of keeping an interval in memory, per position it covers */
+static double spill_weight(LiveInterval *interval) {
+    return interval->weight / (interval->end - interval->start + 1);
+}
+
+/* Whether a should be spilled rather than b */
+static int cheaper_to_spill(LiveInterval *a, LiveInterval *b) {
+    double wa = spill_weight(a), wb = spill_weight(b);
+    if (wa != wb) return wa < wb;
+    return a->end > b->end;
+}
+
+/* Free register for an interval, or -1: $s first for a value live
+ * across a call, so nothing need be saved around it, $t first otherwise,
+ * so the prologue need save nothing */
+static int preferred_register(int owner[], int crosses_call) {
+    for (int pass = 0; pass < 2; pass++) {
+        int want_callee_saved = (pass == 0) == (crosses_call != 0);
+        for (int r = 0; r < ALLOCATABLE_COUNT; r++) {
+            if (owner[r] < 0 && CALLEE_SAVED(allocatable[r]) == want_callee_saved) return r;
+        }
+    }
+    return -1;
+}
+
+/* Register to share with the value copied into an interval, or -1
+ *
+ * The source was scanned first. Its register is free once its interval
+ * has ended. While it is still live the two may share it only if each
+ * is written once and the destination is not live before the copy; then
+ * they hold the same value wherever both are live. A value live across a
+ * call takes an $t register only from a source that has ended; a move is
+ * cheaper than saves around calls.
+ */
+static int hinted_register(RegAllocation *alloc, int owner[], LiveInterval *current, int *shares) {
+    *shares = 0;
+    if (current->hint < 0) return -1;
+    LiveInterval *source = &alloc->intervals[current->hint];
+    for (int r = 0; r < ALLOCATABLE_COUNT; r++) {
+        if (allocatable[r] != source->reg) continue;
+        if (current->crosses_call && !CALLEE_SAVED(source->reg)) return -1;
+        if (owner[r] < 0) return r;
+        *shares = owner[r] == current->hint && source->defs == 1 && current->defs == 1 &&
+                  current->start % 2 == 1;
+        return *shares ? r : -1;
+    }
+    return -1;
+}
+
+/* Assign registers in order of interval start */
+static void linear_scan(CompilationContext *ctx, RegAllocation *alloc) {
+    LiveInterval *intervals = alloc->intervals;
+    ScanEntry *order = (ScanEntry *)arena_alloc(REGION(ctx, REGION_BACKEND),
+                                                (alloc->value_count + 1) * sizeof(ScanEntry));
+    int order_count = 0;
+    for (int v = 0; v < alloc->value_count; v++) {
+        if (intervals[v].start <= intervals[v].end) {
+            order[order_count].start = intervals[v].start;
+            order[order_count].value = v;
+            order_count++;
+        }
+    }
+    qsort(order, order_count, sizeof(ScanEntry), compare_scan_entries);
+
+    int owner[ALLOCATABLE_COUNT];              /* Value in each register, -1 if free */
+    int shared[ALLOCATABLE_COUNT];             /* Held by a copy and its source */
+    unsigned int used = 0;
+    for (int r = 0; r < ALLOCATABLE_COUNT; r++) {
+        owner[r] = -1;
+        shared[r] = 0;
+    }
+
+    for (int n = 0; n < order_count; n++) {
+        int v = order[n].value;
+        LiveInterval *current = &intervals[v];
+        alloc->values++;
+
+        /* Free the registers of intervals that have ended */
+        for (int r = 0; r < ALLOCATABLE_COUNT; r++) {
+            if (owner[r] >= 0 && intervals[owner[r]].end < current->start) {
+                owner[r] = -1;
+                shared[r] = 0;
+            }
+        }
+        int shares;
+        int chosen = hinted_register(alloc, owner, current, &shares);
+        if (chosen >= 0) {
+            alloc->coalesced++;
+            if (shares) {
+                /* The register is free again once both have ended */
+                if (current->end > intervals[owner[chosen]].end) owner[chosen] = v;
+                shared[chosen] = 1;
+                current->reg = allocatable[chosen];
+                continue;
+            }
+        } else {
+            chosen = preferred_register(owner, current->crosses_call);
+        }
+
+        if (chosen < 0) {
+            /* Spill whichever of the live intervals costs least */
+            int victim = -1;
+            for (int r = 0; r < ALLOCATABLE_COUNT; r++) {
+                if (shared[r]) continue;
+                if (cheaper_to_spill(&intervals[owner[r]], victim < 0 ? current : &intervals[owner[victim]])) {
+                    victim = r;
+                }
+            }
+            alloc->spilled++;
+            if (victim < 0) {
+                current->reg = REG_SPILLED;
+                if (current->crosses_call) alloc->spilled_at_calls++;
+                continue;
+            }
+            intervals[owner[victim]].reg = REG_SPILLED;
+            if (intervals[owner[victim]].crosses_call) alloc->spilled_at_calls++;
+            chosen = victim;
+        }
+
+        owner[chosen] = v;
+        current->reg = allocatable[chosen];
+        used |= 1u << chosen;
+    }
+
+    for (int r = 0; r < ALLOCATABLE_COUNT; r++) {
+        if (used & (1u << r)) alloc->used_mask |= 1u << allocatable[r];
+    }
+}
+
+/*
+ * Graph coloring with iterated coalescing (George and Appel)
+ *
+ * Two values interfere when one is written while the other is live; a
+ * copy's source does not interfere with its destination, so the two can
+ * share a register and the move disappears. Nodes of fewer than K
+ * neighbours are simplified away, copies are coalesced when Briggs' or
+ * George's test shows the merged node stays colorable, and a copy is
+ * frozen when nothing else can proceed. Failing all of those, the node
+ * with the lowest loop-weighted cost per neighbour is pushed as a
+ * potential spill. Spilled values are reloaded into scratch registers
+ * outside the pool, so one round of coloring is final. Nodes live across
+ * a call are colored from the $s registers first.
+ */
+
+/* Past this many values the interference matrix grows too large and the
+ * function falls back to linear scan */
+#define MAX_COLORED_VALUES 8192
+
+typedef enum {
+    NODE_ABSENT,               /* Never live */
+    NODE_SIMPLIFY,             /* Low degree, no copies pending */
+    NODE_FREEZE,               /* Low degree, copy related */
+    NODE_SPILL,                /* High degree */
+    NODE_SELECTED,             /* On the select stack */
+    NODE_COALESCED,            /* Merged into its alias */
+    NODE_COLORED,
+    NODE_SPILLED
+} NodeState;
+
+typedef enum {
+    MOVE_WORKLIST,             /* May be coalescable */
+    MOVE_ACTIVE,               /* Not coalescable yet */
+    MOVE_COALESCED,
+    MOVE_CONSTRAINED,          /* Source and destination interfere */
+    MOVE_FROZEN                /* Given up on */
+} MoveState;
+
+typedef struct {
+    int source;
+    int dest;
+    MoveState state;
+} Move;
+
+typedef struct {
+    int nodes;
+    unsigned char *matrix;     /* Interference bits, nodes * nodes */
+    WorkStack *adjacent;       /* Interfering nodes of each node */
+    int *degree;
+    NodeState *state;
+    int *alias;                /* Node a coalesced node was merged into */
+    double *cost;              /* Loop-weighted uses and defs */
+    WorkStack moves;           /* Every copy between two values */
+    WorkStack *node_moves;     /* Indices of the copies touching each node */
+    WorkStack simplify;        /* Nodes to simplify; stale entries are skipped */
+    WorkStack move_worklist;   /* Copies to try; stale entries are skipped */
+    WorkStack select;          /* Simplified nodes, colored in reverse */
+} ColorGraph;
+
+#define STACK_INT(stack, k) (((int *)(stack).items)[k])
+
+static void push_int(WorkStack *stack, int value) {
+    *(int *)stack_push(stack) = value;
+}
+
+static int interferes(ColorGraph *g, int u, int v) {
+    size_t bit = (size_t)u * g->nodes + v;
+    return (g->matrix[bit / 8] >> (bit % 8)) & 1;
+}
+
+static void add_edge(ColorGraph *g, int u, int v) {
+    if (u == v || interferes(g, u, v)) return;
+    size_t uv = (size_t)u * g->nodes + v;
+    size_t vu = (size_t)v * g->nodes + u;
+    g->matrix[uv / 8] |= 1 << (uv % 8);
+    g->matrix[vu / 8] |= 1 << (vu % 8);
+    push_int(&g->adjacent[u], v);
+    push_int(&g->adjacent[v], u);
+    g->degree[u]++;
+    g->degree[v]++;
+}
+
+/* Live set for the backward walk through a block */
+typedef struct {
+    int *members;
+    int *slot;                 /* Position in members, -1 if absent */
+    int count;
+} LiveSet;
+
+static void live_add(LiveSet *set, int v) {
+    if (set->slot[v] >= 0) return;
+    set->slot[v] = set->count;
+    set->members[set->count++] = v;
+}
+
+static void live_remove(LiveSet *set, int v) {
+    int at = set->slot[v];
+    if (at < 0) return;
+    int last = set->members[--set->count];
+    set->members[at] = last;
+    set->slot[last] = at;
+    set->slot[v] = -1;
+}
+
+/* Interference edges, copies and call crossings, block by block */
+static void build_graph(CompilationContext *ctx, TACInstruction *code, FlowGraph *flow, Liveness *live,
+                        int *calls, WorkStack *crossings, RegAllocation *alloc, ColorGraph *g) {
+    Arena *arena = REGION(ctx, REGION_BACKEND);
+    LiveSet set;
+    set.members = (int *)arena_alloc(arena, (g->nodes + 1) * sizeof(int));
+    set.slot = (int *)arena_alloc(arena, (g->nodes + 1) * sizeof(int));
+    set.count = 0;
+    for (int v = 0; v < g->nodes; v++) {
+        set.slot[v] = -1;
+    }
+    int *defs = (int *)arena_alloc(arena, (g->nodes + 1) * sizeof(int));
+
+    for (int b = 0; b < flow->block_count; b++) {
+        while (set.count > 0) {
+            live_remove(&set, set.members[0]);
+        }
+        unsigned int *out = live->live_out + (size_t)b * live->words;
+        for (int k = 0; k < live->count; k++) {
+            if (out[k / 32] & (1u << (k % 32))) live_add(&set, live->values[k]);
+        }
+
+        for (int i = flow->block_start[b + 1] - 1; i >= flow->block_start[b]; i--) {
+            TACInstruction *instr = &code[i];
+            int def_count = 0;
+            int def = instruction_def(ctx, alloc, instr);
+            if (def >= 0) defs[def_count++] = def;
+            if (instr->opcode == TAC_FUNC_BEGIN) {
+                /* Parameters arrive together, so each needs its own register */
+                SymbolEntry *func = operand_symbol(ctx, instr->result);
+                for (SymbolEntry *param = func->params; param; param = param->next) {
+                    defs[def_count++] = alloc->temp_count + param->id - alloc->var_base;
+                }
+                for (int d = 0; d < def_count; d++) {
+                    for (int e = d + 1; e < def_count; e++) add_edge(g, defs[d], defs[e]);
+                }
+            }
+
+            int source = -1;
+            if (instr->opcode == TAC_ASSIGN && def >= 0) {
+                source = value_index(ctx, alloc, instr->arg1);
+                if (source >= 0 && source != def) {
+                    Move *move = (Move *)stack_push(&g->moves);
+                    move->source = source;
+                    move->dest = def;
+                    move->state = MOVE_WORKLIST;
+                    push_int(&g->node_moves[source], g->moves.count - 1);
+                    push_int(&g->node_moves[def], g->moves.count - 1);
+                }
+            }
+
+            if (is_user_call(ctx, instr)) {
+                int call = 0;
+                while (calls[call] != 2 * i) {
+                    call++;
+                }
+                for (int k = 0; k < set.count; k++) {
+                    if (set.members[k] == def) continue;
+                    alloc->intervals[set.members[k]].crosses_call = 1;
+                    CallCrossing *crossing = (CallCrossing *)stack_push(crossings);
+                    crossing->call = call;
+                    crossing->value = set.members[k];
+                }
+            }
+
+            for (int d = 0; d < def_count; d++) {
+                for (int k = 0; k < set.count; k++) {
+                    if (set.members[k] != source) add_edge(g, defs[d], set.members[k]);
+                }
+            }
+            for (int d = 0; d < def_count; d++) {
+                live_remove(&set, defs[d]);
+            }
+            int uses[3];
+            int use_count = instruction_uses(ctx, alloc, instr, uses);
+            for (int u = 0; u < use_count; u++) {
+                live_add(&set, uses[u]);
+            }
+        }
+    }
+}
+
+static Move *move_at(ColorGraph *g, int m) {
+    return (Move *)g->moves.items + m;
+}
+
+static int get_alias(ColorGraph *g, int n) {
+    while (g->state[n] == NODE_COALESCED) {
+        n = g->alias[n];
+    }
+    return n;
+}
+
+/* Whether a node still has a copy that might be coalesced */
+static int move_related(ColorGraph *g, int n) {
+    for (int k = 0; k < g->node_moves[n].count; k++) {
+        MoveState state = move_at(g, STACK_INT(g->node_moves[n], k))->state;
+        if (state == MOVE_WORKLIST || state == MOVE_ACTIVE) return 1;
+    }
+    return 0;
+}
+
+/* Neighbours still in the graph */
+static int in_graph(ColorGraph *g, int n) {
+    return g->state[n] != NODE_ABSENT && g->state[n] != NODE_SELECTED && g->state[n] != NODE_COALESCED;
+}
+
+static void push_simplify(ColorGraph *g, int n) {
+    g->state[n] = NODE_SIMPLIFY;
+    push_int(&g->simplify, n);
+}
+
+static void enable_moves(ColorGraph *g, int n) {
+    for (int k = 0; k < g->node_moves[n].count; k++) {
+        int m = STACK_INT(g->node_moves[n], k);
+        if (move_at(g, m)->state == MOVE_ACTIVE) {
+            move_at(g, m)->state = MOVE_WORKLIST;
+            push_int(&g->move_worklist, m);
+        }
+    }
+}
+
+static void decrement_degree(ColorGraph *g, int n) {
+    if (g->degree[n]-- != ALLOCATABLE_COUNT) return;
+    enable_moves(g, n);
+    for (int k = 0; k < g->adjacent[n].count; k++) {
+        int t = STACK_INT(g->adjacent[n], k);
+        if (in_graph(g, t)) enable_moves(g, t);
+    }
+    if (g->state[n] == NODE_SPILL) {
+        if (move_related(g, n)) {
+            g->state[n] = NODE_FREEZE;
+        } else {
+            push_simplify(g, n);
+        }
+    }
+}
+
+static void simplify(ColorGraph *g, int n) {
+    g->state[n] = NODE_SELECTED;
+    push_int(&g->select, n);
+    for (int k = 0; k < g->adjacent[n].count; k++) {
+        int t = STACK_INT(g->adjacent[n], k);
+        if (in_graph(g, t)) decrement_degree(g, t);
+    }
+}
+
+/* Move a low-degree node with no copies left onto the simplify list */
+static void add_worklist(ColorGraph *g, int n) {
+    if (g->state[n] == NODE_FREEZE && !move_related(g, n) && g->degree[n] < ALLOCATABLE_COUNT) {
+        push_simplify(g, n);
+    }
+}
+
+/* Briggs: the merged node has fewer than K neighbours of significant degree */
+static int briggs_safe(ColorGraph *g, int u, int v) {
+    int significant = 0;
+    for (int side = 0; side < 2; side++) {
+        int n = side ? v : u;
+        for (int k = 0; k < g->adjacent[n].count; k++) {
+            int t = STACK_INT(g->adjacent[n], k);
+            if (!in_graph(g, t) || g->degree[t] < ALLOCATABLE_COUNT) continue;
+            if (side == 1 && interferes(g, t, u)) continue;     /* Counted from u */
+            significant++;
+        }
+    }
+    return significant < ALLOCATABLE_COUNT;
+}
+
+/* George: every significant neighbour of v already interferes with u */
+static int george_safe(ColorGraph *g, int u, int v) {
+    for (int k = 0; k < g->adjacent[v].count; k++) {
+        int t = STACK_INT(g->adjacent[v], k);
+        if (in_graph(g, t) && g->degree[t] >= ALLOCATABLE_COUNT && !interferes(g, t, u)) return 0;
+    }
+    return 1;
+}
+
+static void combine(ColorGraph *g, int u, int v, RegAllocation *alloc) {
+    g->state[v] = NODE_COALESCED;
+    g->alias[v] = u;
+    g->cost[u] += g->cost[v];
+    if (alloc->intervals[v].crosses_call) alloc->intervals[u].crosses_call = 1;
+    for (int k = 0; k < g->node_moves[v].count; k++) {
+        push_int(&g->node_moves[u], STACK_INT(g->node_moves[v], k));
+    }
+    enable_moves(g, v);
+    for (int k = 0; k < g->adjacent[v].count; k++) {
+        int t = STACK_INT(g->adjacent[v], k);
+        if (!in_graph(g, t)) continue;
+        add_edge(g, t, u);
+        decrement_degree(g, t);
+    }
+    if (g->degree[u] >= ALLOCATABLE_COUNT && g->state[u] == NODE_FREEZE) {
+        g->state[u] = NODE_SPILL;
+    }
+}
+
+static void coalesce(ColorGraph *g, int m, RegAllocation *alloc) {
+    Move *move = move_at(g, m);
+    int u = get_alias(g, move->dest);
+    int v = get_alias(g, move->source);
+
+    if (u == v) {
+        move->state = MOVE_COALESCED;
+        alloc->coalesced++;
+        add_worklist(g, u);
+    } else if (interferes(g, u, v)) {
+        move->state = MOVE_CONSTRAINED;
+        add_worklist(g, u);
+        add_worklist(g, v);
+    } else if (briggs_safe(g, u, v) || george_safe(g, u, v)) {
+        move->state = MOVE_COALESCED;
+        alloc->coalesced++;
+        combine(g, u, v, alloc);
+        add_worklist(g, u);
+    } else {
+        move->state = MOVE_ACTIVE;
+    }
+}
+
+/* Give up on coalescing the copies of a node */
+static void freeze_moves(ColorGraph *g, int u) {
+    for (int k = 0; k < g->node_moves[u].count; k++) {
+        Move *move = move_at(g, STACK_INT(g->node_moves[u], k));
+        if (move->state != MOVE_WORKLIST && move->state != MOVE_ACTIVE) continue;
+        move->state = MOVE_FROZEN;
+        int v = (get_alias(g, move->source) == get_alias(g, u))
+                    ? get_alias(g, move->dest) : get_alias(g, move->source);
+        if (g->state[v] == NODE_FREEZE && !move_related(g, v) && g->degree[v] < ALLOCATABLE_COUNT) {
+            push_simplify(g, v);
+        }
+    }
+}
+
+/* Lowest-cost node of a state per neighbour, or -1 */
+static int cheapest_node(ColorGraph *g, NodeState state) {
+    int best = -1;
+    for (int n = 0; n < g->nodes; n++) {
+        if (g->state[n] != state) continue;
+        if (best < 0 || g->cost[n] * g->degree[best] < g->cost[best] * g->degree[n]) {
+            best = n;
+        }
+    }
+    return best;
+}
+
+/* Pop the select stack, giving each node a register its colored
+ * neighbours do not hold */
+static void assign_colors(CompilationContext *ctx, ColorGraph *g, RegAllocation *alloc) {
+    int *color = (int *)arena_alloc(REGION(ctx, REGION_BACKEND), (g->nodes + 1) * sizeof(int));
+    while (g->select.count > 0) {
+        int n = *(int *)stack_pop(&g->select);
+        int owner[ALLOCATABLE_COUNT];          /* -1 where the color is free */
+        for (int r = 0; r < ALLOCATABLE_COUNT; r++) {
+            owner[r] = -1;
+        }
+        for (int k = 0; k < g->adjacent[n].count; k++) {
+            int t = get_alias(g, STACK_INT(g->adjacent[n], k));
+            if (g->state[t] == NODE_COLORED) owner[color[t]] = t;
+        }
+        int chosen = preferred_register(owner, alloc->intervals[n].crosses_call);
+        if (chosen < 0) {
+            g->state[n] = NODE_SPILLED;
+        } else {
+            g->state[n] = NODE_COLORED;
+            color[n] = chosen;
+            alloc->used_mask |= 1u << allocatable[chosen];
+        }
+    }
+
+    for (int n = 0; n < g->nodes; n++) {
+        LiveInterval *interval = &alloc->intervals[n];
+        if (interval->start > interval->end) continue;
+        alloc->values++;
+        int a = get_alias(g, n);
+        if (g->state[a] == NODE_COLORED) {
+            interval->reg = allocatable[color[a]];
+        } else {
+            interval->reg = REG_SPILLED;
+            alloc->spilled++;
+            if (interval->crosses_call) alloc->spilled_at_calls++;
+        }
+    }
+}
+
+static void color_graph(CompilationContext *ctx, TACInstruction *code, FlowGraph *flow, Liveness *live,
+                        int *calls, WorkStack *crossings, RegAllocation *alloc) {
+    Arena *arena = REGION(ctx, REGION_BACKEND);
+    ColorGraph g;
+    int n = alloc->value_count;
+    g.nodes = n;
+    g.matrix = (unsigned char *)arena_calloc(arena, (size_t)n * n / 8 + 1, 1);
+    g.adjacent = (WorkStack *)arena_alloc(arena, (n + 1) * sizeof(WorkStack));
+    g.node_moves = (WorkStack *)arena_alloc(arena, (n + 1) * sizeof(WorkStack));
+    g.degree = (int *)arena_calloc(arena, n + 1, sizeof(int));
+    g.state = (NodeState *)arena_alloc(arena, (n + 1) * sizeof(NodeState));
+    g.alias = (int *)arena_alloc(arena, (n + 1) * sizeof(int));
+    g.cost = (double *)arena_alloc(arena, (n + 1) * sizeof(double));
+    for (int v = 0; v < n; v++) {
+        stack_init_in(&g.adjacent[v], sizeof(int), arena);
+        stack_init_in(&g.node_moves[v], sizeof(int), arena);
+        g.alias[v] = v;
+        g.cost[v] = alloc->intervals[v].weight;
+    }
+    stack_init_in(&g.moves, sizeof(Move), arena);
+    stack_init_in(&g.simplify, sizeof(int), arena);
+    stack_init_in(&g.move_worklist, sizeof(int), arena);
+    stack_init_in(&g.select, sizeof(int), arena);
+
+    build_graph(ctx, code, flow, live, calls, crossings, alloc, &g);
+
+    for (int v = 0; v < n; v++) {
+        LiveInterval *interval = &alloc->intervals[v];
+        if (interval->start > interval->end) {
+            g.state[v] = NODE_ABSENT;
+        } else if (g.degree[v] >= ALLOCATABLE_COUNT) {
+            g.state[v] = NODE_SPILL;
+        } else {
+            g.state[v] = NODE_FREEZE;
+        }
+    }
+    for (int m = 0; m < g.moves.count; m++) {
+        push_int(&g.move_worklist, m);
+    }
+    for (int v = 0; v < n; v++) {
+        if (g.state[v] == NODE_FREEZE && !move_related(&g, v)) push_simplify(&g, v);
+    }
+
+    for (;;) {
+        if (g.simplify.count > 0) {
+            int v = *(int *)stack_pop(&g.simplify);
+            if (g.state[v] == NODE_SIMPLIFY) simplify(&g, v);
+        } else if (g.move_worklist.count > 0) {
+            int m = *(int *)stack_pop(&g.move_worklist);
+            if (move_at(&g, m)->state == MOVE_WORKLIST) coalesce(&g, m, alloc);
+        } else {
+            int v = cheapest_node(&g, NODE_FREEZE);
+            if (v >= 0) {
+                push_simplify(&g, v);
+                freeze_moves(&g, v);
+                continue;
+            }
+            v = cheapest_node(&g, NODE_SPILL);
+            if (v < 0) break;
+            /* Potential spill: it may still find a color when selected */
+            push_simplify(&g, v);
+            freeze_moves(&g, v);
+        }
+    }
+
+    assign_colors(ctx, &g, alloc);
+}
+
+/* A register to save around a call */
+typedef struct {
+    int call;
+    int reg;
+    int value;                 /* Value live in it, whose slot it goes to */
+} CallSave;
+
+static int compare_call_saves(const void *a, const void *b) {
+    const CallSave *sa = (const CallSave *)a;
+    const CallSave *sb = (const CallSave *)b;
+    if (sa->call != sb->call) return sa->call - sb->call;
+    if (sa->reg != sb->reg) return sa->reg - sb->reg;
+    return sa->value - sb->value;
+}
+
+/* Turn the call crossings into the caller-saved registers to save around
+ * each call, once per register; marks the values whose slots receive them */
+static void collect_call_saves(CompilationContext *ctx, RegAllocation *alloc, WorkStack *crossings, char *saved) {
+    Arena *arena = REGION(ctx, REGION_BACKEND);
+    CallSave *saves = (CallSave *)arena_alloc(arena, (crossings->count + 1) * sizeof(CallSave));
+    int save_count = 0;
+    for (int c = 0; c < crossings->count; c++) {
+        CallCrossing *crossing = (CallCrossing *)crossings->items + c;
+        int reg = alloc->intervals[crossing->value].reg;
+        if (reg != REG_SPILLED && CALLER_SAVED(reg)) {
+            saves[save_count].call = crossing->call;
+            saves[save_count].reg = reg;
+            saves[save_count].value = crossing->value;
+            save_count++;
+        }
+    }
+    qsort(saves, save_count, sizeof(CallSave), compare_call_saves);
+
+    alloc->save_start = (int *)arena_calloc(arena, alloc->call_count + 1, sizeof(int));
+    alloc->save_values = (int *)arena_alloc(arena, (save_count + 1) * sizeof(int));
+    int kept = 0;
+    for (int s = 0; s < save_count; s++) {
+        if (s > 0 && saves[s].call == saves[s - 1].call && saves[s].reg == saves[s - 1].reg) continue;
+        alloc->save_values[kept++] = saves[s].value;
+        alloc->save_start[saves[s].call + 1] = kept;
+        saved[saves[s].value] = 1;
+    }
+    for (int k = 1; k <= alloc->call_count; k++) {
+        if (alloc->save_start[k] < alloc->save_start[k - 1]) alloc->save_start[k] = alloc->save_start[k - 1];
+    }
+}
+
+/* Give each spilled value, and each value saved around a call, a stack
+ * slot, sharing slots between values whose intervals do not overlap
+ *
+ * Intervals are taken in order of start; a min-heap of the slots in use,
+ * keyed by the end of their current interval, hands back the slots that
+ * have come free. Packing intervals this way needs no more slots than
+ * values are ever live at once.
+ */
+static void assign_spill_slots(CompilationContext *ctx, RegAllocation *alloc, char *saved) {
+    Arena *arena = REGION(ctx, REGION_BACKEND);
+    LiveInterval *intervals = alloc->intervals;
+    ScanEntry *order = (ScanEntry *)arena_alloc(arena, (alloc->value_count + 1) * sizeof(ScanEntry));
+    int order_count = 0;
+    for (int v = 0; v < alloc->value_count; v++) {
+        if (intervals[v].start <= intervals[v].end && (intervals[v].reg == REG_SPILLED || saved[v])) {
+            order[order_count].start = intervals[v].start;
+            order[order_count].value = v;
+            order_count++;
+        }
+    }
+    qsort(order, order_count, sizeof(ScanEntry), compare_scan_entries);
+
+    int *heap = (int *)arena_alloc(arena, (order_count + 1) * sizeof(int));     /* Values holding slots */
+    int heap_count = 0;
+    int *free_slots = (int *)arena_alloc(arena, (order_count + 1) * sizeof(int));
+    int free_count = 0;
+
+    for (int n = 0; n < order_count; n++) {
+        LiveInterval *current = &intervals[order[n].value];
+
+        /* Release the slots of intervals that have ended */
+        while (heap_count > 0 && intervals[heap[0]].end < current->start) {
+            free_slots[free_count++] = intervals[heap[0]].slot;
+            heap[0] = heap[--heap_count];
+            for (int i = 0;;) {
+                int child = 2 * i + 1;
+                if (child >= heap_count) break;
+                if (child + 1 < heap_count && intervals[heap[child + 1]].end < intervals[heap[child]].end) {
+                    child++;
+                }
+                if (intervals[heap[i]].end <= intervals[heap[child]].end) break;
+                int swap = heap[i];
+                heap[i] = heap[child];
+                heap[child] = swap;
+                i = child;
+            }
+        }
+
+        current->slot = (free_count > 0) ? free_slots[--free_count] : alloc->slot_count++;
+        int i = heap_count++;
+        heap[i] = order[n].value;
+        while (i > 0 && intervals[heap[(i - 1) / 2]].end > intervals[heap[i]].end) {
+            int swap = heap[i];
+            heap[i] = heap[(i - 1) / 2];
+            heap[(i - 1) / 2] = swap;
+            i = (i - 1) / 2;
+        }
+    }
+}
+
+/* Allocate registers for code[0..count-1], one whole function */
+void allocate_registers(CompilationContext *ctx, TACInstruction *code, int count, RegAllocation *alloc) {
+    memset(alloc, 0, sizeof(RegAllocation));
+    number_values(ctx, code, count, alloc);
+    alloc->intervals = (LiveInterval *)arena_alloc(REGION(ctx, REGION_BACKEND),
+                                                   (alloc->value_count + 1) * sizeof(LiveInterval));
+    for (int v = 0; v < alloc->value_count; v++) {
+        alloc->intervals[v].start = INT_MAX;
+        alloc->intervals[v].end = -1;
+        alloc->intervals[v].weight = 0;
+        alloc->intervals[v].reg = REG_SPILLED;
+        alloc->intervals[v].crosses_call = 0;
+        alloc->intervals[v].slot = -1;
+        alloc->intervals[v].hint = -1;
+        alloc->intervals[v].defs = 0;
+    }
+
+    FlowGraph flow;
+    Liveness live;
+    build_flow_graph(ctx, code, count, &flow);
+    record_uses(ctx, code, count, &flow, alloc);
+    solve_liveness(ctx, code, &flow, alloc, &live);
+    extend_over_blocks(&flow, &live, alloc);
+    int *calls = find_user_calls(ctx, code, count, alloc);
+    WorkStack crossings;
+    stack_init_in(&crossings, sizeof(CallCrossing), REGION(ctx, REGION_BACKEND));
+    if (optimization_level >= OPT_GRAPH_COLORING && alloc->value_count <= MAX_COLORED_VALUES) {
+        color_graph(ctx, code, &flow, &live, calls, &crossings, alloc);
+    } else {
+        mark_call_crossings(alloc, calls, &crossings);
+        linear_scan(ctx, alloc);
+    }
+    for (int r = 0; r < 32; r++) {
+        if (alloc->used_mask & (1u << r)) alloc->registers_used++;
+    }
+
+    char *saved = (char *)arena_calloc(REGION(ctx, REGION_BACKEND), alloc->value_count + 1, 1);
+    collect_call_saves(ctx, alloc, &crossings, saved);
+    assign_spill_slots(ctx, alloc, saved);
+}
+
+/* Drop an allocation along with the rest of the backend region */
+void free_allocation(CompilationContext *ctx, RegAllocation *alloc) {
+    arena_release(REGION(ctx, REGION_BACKEND));
+    alloc->intervals = NULL;
+    alloc->save_start = NULL;
+    alloc->save_values = NULL;
+}
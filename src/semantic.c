@@ -7,315 +7,318 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
+#include "context.h"
 #include "semantic.h"
-#include "ast.h"
-#include "symtab.h"
-#include "globals.h"
-
-/* Current function being analyzed */
-SymbolEntry *current_function = NULL;
 
 /* Main semantic analysis function */
-void semantic_analysis(ASTNode *tree) {
+void semantic_analysis(CompilationContext *ctx, ASTNode *tree) {
     if (tree == NULL) return;
     
-    printf("\n=== SEMANTIC ANALYSIS ===\n");
+    if (!quiet_mode) {
+        fprintf(ctx->report, "\n=== SEMANTIC ANALYSIS ===\n");
+    }
     
     /* Initialize symbol table */
-    init_symbol_table();
+    init_symbol_table(ctx);
     
     /* Analyze the AST */
-    analyze_node(tree);
+    analyze_node(ctx, tree);
     
     /* Perform final checks */
-    check_main_function();
-    check_unused_symbols();
+    check_main_function(ctx);
+    check_unused_symbols(ctx);
     
     /* Print symbol table if in trace mode */
     if (trace_semantic) {
-        print_symbol_table();
+        print_symbol_table(ctx);
     }
     
-    printf("Semantic analysis completed. ");
-    if (error_count == 0) {
-        printf("No errors found.\n");
+    if (quiet_mode) return;
+    fprintf(ctx->report, "Semantic analysis completed. ");
+    if (ctx->error_count == 0) {
+        fprintf(ctx->report, "No errors found.\n");
     } else {
-        printf("%d error(s) found.\n", error_count);
+        fprintf(ctx->report, "%d error(s) found.\n", ctx->error_count);
+    }
+}
+
+/* Schedule a node for analyze_node; a missing one is skipped */
+static void push_node(WorkStack *pending, ASTNode *node) {
+    if (node != NULL) {
+        *(ASTNode **)stack_push(pending) = node;
     }
 }
 
-/* Analyze a single node */
-void analyze_node(ASTNode *node) {
+/* Analyze a subtree
+ *
+ * Statements are walked with an explicit work stack: a node's own checks
+ * run when it is popped and its children are pushed in reverse, so they
+ * are analyzed in source order and nesting depth is limited only by
+ * memory. A function body gets a walk of its own inside its scope.
+ */
+void analyze_node(CompilationContext *ctx, ASTNode *node) {
     if (node == NULL) return;
     
-    switch (node->node_type) {
-        case NODE_PROGRAM:
-            analyze_node(node->left);
-            analyze_node(node->right);
-            break;
-            
-        case NODE_VAR_DECL:
-            analyze_var_decl(node);
-            break;
-            
-        case NODE_FUNC_DECL:
-            analyze_func_decl(node);
-            break;
-            
-        case NODE_COMPOUND_STMT:
-            analyze_compound_stmt(node);
-            break;
-            
-        case NODE_IF_STMT:
-            analyze_if_stmt(node);
-            break;
-            
-        case NODE_WHILE_STMT:
-            analyze_while_stmt(node);
-            break;
-            
-        case NODE_RETURN_STMT:
-            analyze_return_stmt(node);
-            break;
-            
-        case NODE_EXPR_STMT:
-            if (node->left) {
-                analyze_expression(node->left);
-            }
-            break;
-            
-        default:
-            analyze_node(node->left);
-            analyze_node(node->right);
-            analyze_node(node->next);
-            break;
+    WorkStack pending;
+    stack_init(&pending, sizeof(ASTNode *));
+    push_node(&pending, node);
+    
+    while (pending.count > 0) {
+        node = *(ASTNode **)stack_pop(&pending);
+        
+        switch (node->node_type) {
+            case NODE_PROGRAM:
+            case NODE_PARAM_LIST:
+            case NODE_LOCAL_DECLS:
+            case NODE_STMT_LIST:
+            case NODE_ARG_LIST:
+                for (int i = node->list.count - 1; i >= 0; i--) {
+                    push_node(&pending, LIST_ITEM(ctx, node, i));
+                }
+                break;
+                
+            case NODE_VAR_DECL:
+                analyze_var_decl(ctx, node);
+                break;
+                
+            case NODE_FUNC_DECL:
+                analyze_func_decl(ctx, node);
+                break;
+                
+            case NODE_COMPOUND_STMT:
+                analyze_compound_stmt(ctx, node, &pending);
+                break;
+                
+            case NODE_IF_STMT:
+                analyze_if_stmt(ctx, node, &pending);
+                break;
+                
+            case NODE_WHILE_STMT:
+                analyze_while_stmt(ctx, node, &pending);
+                break;
+                
+            case NODE_RETURN_STMT:
+                analyze_return_stmt(ctx, node);
+                break;
+                
+            case NODE_EXPR_STMT:
+                if (node->left) {
+                    analyze_expression(ctx, AST(ctx, node->left));
+                }
+                break;
+                
+            default:
+                push_node(&pending, AST(ctx, node->next));
+                push_node(&pending, AST(ctx, node->right));
+                push_node(&pending, AST(ctx, node->left));
+                break;
+        }
     }
+    
+    stack_free(&pending);
 }
 
 /* Analyze variable declaration */
-void analyze_var_decl(ASTNode *node) {
-    char *name = node->value.var_decl.name;
-    int size = node->value.var_decl.size;
+void analyze_var_decl(CompilationContext *ctx, ASTNode *node) {
+    char *name = AST_NAME(ctx, node);
+    int size = node->array_size;
     
     /* Check for void variables */
     if (node->data_type == TYPE_VOID) {
-        semantic_error(node, "Variable '%s' cannot have void type", name);
+        semantic_error(ctx, node, "Variable '%s' cannot have void type", name);
         return;
     }
     
     /* Insert into symbol table */
     SymbolKind kind = (size > 0) ? SYMBOL_ARRAY : SYMBOL_VAR;
-    SymbolEntry *symbol = insert_symbol(name, kind, node->data_type);
+    SymbolEntry *symbol = insert_symbol(ctx, name, kind, node->data_type);
     
     if (symbol && kind == SYMBOL_ARRAY) {
         symbol->size = size;
-        allocate_memory(size * 4);  /* 4 bytes per int */
+        allocate_memory(ctx, size * 4);  /* 4 bytes per int */
     }
     
     /* Link AST node to symbol table entry */
-    node->symbol = symbol;
+    ast_set_symbol(ctx, node, symbol);
 }
 
 /* Analyze function declaration */
-void analyze_func_decl(ASTNode *node) {
-    char *name = node->value.func_decl.name;
-    DataType return_type = node->value.func_decl.return_type;
+void analyze_func_decl(CompilationContext *ctx, ASTNode *node) {
+    char *name = AST_NAME(ctx, node);
+    DataType return_type = node->return_type;
     
     /* Insert function into global scope */
-    SymbolEntry *func = insert_symbol(name, SYMBOL_FUNCTION, TYPE_FUNCTION);
+    SymbolEntry *func = insert_symbol(ctx, name, SYMBOL_FUNCTION, TYPE_FUNCTION);
     if (func == NULL) return;  /* Already declared */
     
     func->type = return_type;
-    node->symbol = func;
+    ast_set_symbol(ctx, node, func);
     
     /* Set current function context */
-    current_function = func;
+    ctx->current_function = func;
     
     /* Enter new scope for function */
-    enter_scope();
+    enter_scope(ctx);
     
     /* Process parameters */
-    analyze_params(node->left, func);
+    analyze_params(ctx, AST(ctx, node->left), func);
     
     /* Analyze function body */
-    analyze_node(node->right);
+    analyze_node(ctx, AST(ctx, node->right));
     
     /* Check return paths */
     if (return_type != TYPE_VOID) {
-        check_return_paths(node->right, return_type);
+        check_return_paths(ctx, AST(ctx, node->right), return_type);
     }
     
+    /* Record the frame space taken by parameters and locals */
+    func->frame_size = get_current_offset(ctx);
+    
     /* Exit function scope */
-    exit_scope();
-    current_function = NULL;
+    exit_scope(ctx);
+    ctx->current_function = NULL;
 }
 
 /* Analyze function parameters */
-void analyze_params(ASTNode *params, SymbolEntry *func) {
-    ASTNode *param = params;
-    
-    while (param) {
+void analyze_params(CompilationContext *ctx, ASTNode *params, SymbolEntry *func) {
+    for (int i = 0; i < LIST_COUNT(params); i++) {
+        ASTNode *param = LIST_ITEM(ctx, params, i);
+        
         if (param->node_type == NODE_PARAM) {
-            char *param_name = param->value.string_val;
+            char *param_name = AST_NAME(ctx, param);
             DataType param_type = param->data_type;
             
             /* Insert parameter into symbol table */
-            SymbolEntry *param_symbol = insert_symbol(param_name, SYMBOL_PARAM, param_type);
+            SymbolEntry *param_symbol = insert_symbol(ctx, param_name, SYMBOL_PARAM, param_type);
             
             /* Add to function's parameter list */
             if (param_symbol) {
-                SymbolEntry *param_copy = (SymbolEntry *)malloc(sizeof(SymbolEntry));
+                SymbolEntry *param_copy = (SymbolEntry *)arena_alloc(REGION(ctx, REGION_SEMANTIC),
+                                                                     sizeof(SymbolEntry));
                 *param_copy = *param_symbol;
                 param_copy->next = NULL;
                 add_param_to_function(func, param_copy);
             }
             
-            param->symbol = param_symbol;
+            ast_set_symbol(ctx, param, param_symbol);
         }
-        
-        param = (param->node_type == NODE_PARAM_LIST) ? param->right : param->next;
     }
 }
 
 /* Analyze compound statement */
-void analyze_compound_stmt(ASTNode *node) {
+void analyze_compound_stmt(CompilationContext *ctx, ASTNode *node, WorkStack *pending) {
     /* Note: We already entered scope in function declaration */
     /* For nested compound statements, we would enter a new scope here */
     
-    /* Analyze local declarations */
-    analyze_node(node->left);
-    
-    /* Analyze statement list */
-    analyze_node(node->right);
+    /* Local declarations, then the statement list */
+    push_node(pending, AST(ctx, node->right));
+    push_node(pending, AST(ctx, node->left));
 }
 
-/* Analyze if statement */
-void analyze_if_stmt(ASTNode *node) {
+/* Analyze if statement
+ * An else-if is just another if statement on the work stack.
+ */
+void analyze_if_stmt(CompilationContext *ctx, ASTNode *node, WorkStack *pending) {
     /* Check condition */
-    DataType cond_type = analyze_expression(node->left);
+    DataType cond_type = analyze_expression(ctx, AST(ctx, node->left));
     if (cond_type == TYPE_VOID) {
-        semantic_error(node, "If condition cannot be void");
+        semantic_error(ctx, node, "If condition cannot be void");
     }
     
-    /* Analyze then branch */
-    analyze_node(node->right);
-    
-    /* Analyze else branch if present */
-    analyze_node(node->next);
+    /* Then branch, then the else branch if present */
+    push_node(pending, AST(ctx, node->next));
+    push_node(pending, AST(ctx, node->right));
 }
 
 /* Analyze while statement */
-void analyze_while_stmt(ASTNode *node) {
+void analyze_while_stmt(CompilationContext *ctx, ASTNode *node, WorkStack *pending) {
     /* Check condition */
-    DataType cond_type = analyze_expression(node->left);
+    DataType cond_type = analyze_expression(ctx, AST(ctx, node->left));
     if (cond_type == TYPE_VOID) {
-        semantic_error(node, "While condition cannot be void");
+        semantic_error(ctx, node, "While condition cannot be void");
     }
     
-    /* Analyze body */
-    analyze_node(node->right);
+    /* Body */
+    push_node(pending, AST(ctx, node->right));
 }
 
 /* Analyze return statement */
-void analyze_return_stmt(ASTNode *node) {
-    if (current_function == NULL) {
-        semantic_error(node, "Return statement outside function");
+void analyze_return_stmt(CompilationContext *ctx, ASTNode *node) {
+    if (ctx->current_function == NULL) {
+        semantic_error(ctx, node, "Return statement outside function");
         return;
     }
     
-    DataType func_return_type = current_function->type;
+    DataType func_return_type = ctx->current_function->type;
     
-    if (node->left == NULL) {
+    if (node->left == NO_NODE) {
         /* Return without value */
         if (func_return_type != TYPE_VOID) {
-            semantic_error(node, "Function '%s' must return a value", 
-                          current_function->name);
+            semantic_error(ctx, node, "Function '%s' must return a value", 
+                          ctx->current_function->name);
         }
     } else {
         /* Return with value */
         if (func_return_type == TYPE_VOID) {
-            semantic_error(node, "Void function '%s' cannot return a value",
-                          current_function->name);
+            semantic_error(ctx, node, "Void function '%s' cannot return a value",
+                          ctx->current_function->name);
         } else {
-            DataType expr_type = analyze_expression(node->left);
+            DataType expr_type = analyze_expression(ctx, AST(ctx, node->left));
             if (!types_compatible(func_return_type, expr_type)) {
-                semantic_error(node, "Return type mismatch in function '%s'",
-                              current_function->name);
+                semantic_error(ctx, node, "Return type mismatch in function '%s'",
+                              ctx->current_function->name);
             }
         }
     }
 }
 
-/* Analyze expression and return its type */
-DataType analyze_expression(ASTNode *node) {
-    if (node == NULL) return TYPE_ERROR;
-    
-    switch (node->node_type) {
-        case NODE_NUM:
-            node->data_type = TYPE_INT;
-            return TYPE_INT;
-            
-        case NODE_ID:
-            return analyze_var(node);
-            
-        case NODE_ARRAY_ACCESS:
-            return analyze_var(node);
-            
-        case NODE_ASSIGN:
-            return analyze_assignment(node);
-            
-        case NODE_BINARY_OP:
-            return analyze_binary_op(node);
-            
-        case NODE_CALL:
-            return analyze_call(node);
-            
-        default:
-            return TYPE_ERROR;
+/* Work item for the iterative expression walker */
+typedef struct {
+    ASTNode *node;
+    int state;              /* Children analyzed so far */
+    SymbolEntry *param;     /* Next parameter to match (calls) */
+} ExprFrame;
+
+/* Schedule a subexpression; a missing one has type TYPE_ERROR */
+static void push_expression(WorkStack *frames, WorkStack *types, ASTNode *node) {
+    if (node == NULL) {
+        *(DataType *)stack_push(types) = TYPE_ERROR;
+        return;
     }
+    ExprFrame *frame = (ExprFrame *)stack_push(frames);
+    frame->node = node;
+    frame->state = 0;
+    frame->param = NULL;
 }
 
-/* Analyze variable reference */
-DataType analyze_var(ASTNode *node) {
-    char *name = node->value.string_val;
-    SymbolEntry *symbol = lookup_symbol(name);
+/* Finish a frame with the type of its expression */
+static void finish_expression(WorkStack *frames, WorkStack *types, DataType type) {
+    stack_pop(frames);
+    *(DataType *)stack_push(types) = type;
+}
+
+/* Look up the symbol for a variable reference */
+static SymbolEntry *resolve_var(CompilationContext *ctx, ASTNode *node) {
+    char *name = AST_NAME(ctx, node);
+    SymbolEntry *symbol = lookup_symbol(ctx, name);
     
     if (symbol == NULL) {
-        semantic_error(node, "Undefined variable '%s'", name);
-        return TYPE_ERROR;
+        semantic_error(ctx, node, "Undefined variable '%s'", name);
+        return NULL;
     }
     
-    node->symbol = symbol;
-    
-    if (node->node_type == NODE_ARRAY_ACCESS) {
-        if (symbol->kind != SYMBOL_ARRAY && symbol->kind != SYMBOL_PARAM) {
-            semantic_error(node, "'%s' is not an array", name);
-            return TYPE_ERROR;
-        }
-        
-        /* Check index type */
-        DataType index_type = analyze_expression(node->left);
-        if (index_type != TYPE_INT) {
-            semantic_error(node, "Array index must be integer");
-        }
-        
-        return TYPE_INT;
-    }
-    
-    return symbol->type;
+    ast_set_symbol(ctx, node, symbol);
+    return symbol;
 }
 
-/* Analyze assignment */
-DataType analyze_assignment(ASTNode *node) {
-    DataType var_type = analyze_expression(node->left);
-    DataType expr_type = analyze_expression(node->right);
-    
+/* Type of an assignment whose sides have been analyzed */
+static DataType finish_assignment(CompilationContext *ctx, ASTNode *node, DataType var_type, DataType expr_type) {
     if (var_type == TYPE_ERROR || expr_type == TYPE_ERROR) {
         return TYPE_ERROR;
     }
     
     if (!types_compatible(var_type, expr_type)) {
-        semantic_error(node, "Type mismatch in assignment");
+        semantic_error(ctx, node, "Type mismatch in assignment");
         return TYPE_ERROR;
     }
     
@@ -323,23 +326,21 @@ DataType analyze_assignment(ASTNode *node) {
     return var_type;
 }
 
-/* Analyze binary operation */
-DataType analyze_binary_op(ASTNode *node) {
-    DataType left_type = analyze_expression(node->left);
-    DataType right_type = analyze_expression(node->right);
-    char *op = node->value.string_val;
+/* Type of a binary operation whose operands have been analyzed */
+static DataType finish_binary_op(CompilationContext *ctx, ASTNode *node, DataType left_type, DataType right_type) {
+    char *op = AST_NAME(ctx, node);
     
     if (left_type == TYPE_ERROR || right_type == TYPE_ERROR) {
         return TYPE_ERROR;
     }
     
     if (left_type == TYPE_VOID || right_type == TYPE_VOID) {
-        semantic_error(node, "Void type cannot be used in expression");
+        semantic_error(ctx, node, "Void type cannot be used in expression");
         return TYPE_ERROR;
     }
     
     if (!types_compatible(left_type, right_type)) {
-        semantic_error(node, "Type mismatch in binary operation '%s'", op);
+        semantic_error(ctx, node, "Type mismatch in binary operation '%s'", op);
         return TYPE_ERROR;
     }
     
@@ -347,58 +348,161 @@ DataType analyze_binary_op(ASTNode *node) {
     return TYPE_INT;
 }
 
-/* Analyze function call */
-DataType analyze_call(ASTNode *node) {
-    char *name = node->value.string_val;
-    SymbolEntry *func = lookup_symbol(name);
-    
-    if (func == NULL) {
-        semantic_error(node, "Undefined function '%s'", name);
-        return TYPE_ERROR;
-    }
-    
-    if (func->kind != SYMBOL_FUNCTION) {
-        semantic_error(node, "'%s' is not a function", name);
-        return TYPE_ERROR;
-    }
-    
-    node->symbol = func;
-    
-    /* Check arguments */
-    check_function_args(func, node->left);
+/* Analyze expression and return its type
+ *
+ * Walks the expression tree with an explicit work stack: each frame
+ * schedules its children one at a time and combines their types from
+ * the type stack once they are done, so nesting depth is limited only
+ * by memory.
+ */
+DataType analyze_expression(CompilationContext *ctx, ASTNode *node) {
+    if (node == NULL) return TYPE_ERROR;
     
-    /* Handle built-in functions */
-    if (strcmp(name, "input") == 0) {
-        return TYPE_INT;
-    } else if (strcmp(name, "output") == 0) {
-        return TYPE_VOID;
-    }
+    WorkStack frames, types;
+    stack_init(&frames, sizeof(ExprFrame));
+    stack_init(&types, sizeof(DataType));
+    push_expression(&frames, &types, node);
     
-    return func->type;
-}
-
-/* Check function arguments */
-void check_function_args(SymbolEntry *func, ASTNode *args) {
-    SymbolEntry *param = func->params;
-    ASTNode *arg = args;
-    
-    while (arg && param) {
-        DataType arg_type = analyze_expression(
-            (arg->node_type == NODE_ARG_LIST) ? arg->right : arg);
+    while (frames.count > 0) {
+        ExprFrame *frame = (ExprFrame *)stack_top(&frames);
+        ASTNode *expr = frame->node;
         
-        if (!types_compatible(param->type, arg_type)) {
-            semantic_error(arg, "Argument type mismatch in call to '%s'", func->name);
+        switch (expr->node_type) {
+            case NODE_NUM:
+                expr->data_type = TYPE_INT;
+                finish_expression(&frames, &types, TYPE_INT);
+                break;
+                
+            case NODE_ID: {
+                SymbolEntry *symbol = resolve_var(ctx, expr);
+                finish_expression(&frames, &types, symbol ? symbol->type : TYPE_ERROR);
+                break;
+            }
+                
+            case NODE_ARRAY_ACCESS:
+                if (frame->state == 0) {
+                    SymbolEntry *symbol = resolve_var(ctx, expr);
+                    if (symbol == NULL) {
+                        finish_expression(&frames, &types, TYPE_ERROR);
+                    } else if (symbol->kind != SYMBOL_ARRAY && symbol->kind != SYMBOL_PARAM) {
+                        semantic_error(ctx, expr, "'%s' is not an array", AST_NAME(ctx, expr));
+                        finish_expression(&frames, &types, TYPE_ERROR);
+                    } else {
+                        /* Check index type */
+                        frame->state = 1;
+                        push_expression(&frames, &types, AST(ctx, expr->left));
+                    }
+                } else {
+                    DataType index_type = *(DataType *)stack_pop(&types);
+                    if (index_type != TYPE_INT) {
+                        semantic_error(ctx, expr, "Array index must be integer");
+                    }
+                    finish_expression(&frames, &types, TYPE_INT);
+                }
+                break;
+                
+            case NODE_ASSIGN:
+            case NODE_BINARY_OP:
+                if (frame->state == 0) {
+                    frame->state = 1;
+                    push_expression(&frames, &types, AST(ctx, expr->left));
+                } else if (frame->state == 1) {
+                    frame->state = 2;
+                    push_expression(&frames, &types, AST(ctx, expr->right));
+                } else {
+                    DataType right_type = *(DataType *)stack_pop(&types);
+                    DataType left_type = *(DataType *)stack_pop(&types);
+                    finish_expression(&frames, &types,
+                        expr->node_type == NODE_ASSIGN
+                            ? finish_assignment(ctx, expr, left_type, right_type)
+                            : finish_binary_op(ctx, expr, left_type, right_type));
+                }
+                break;
+                
+            case NODE_CALL: {
+                char *name = AST_NAME(ctx, expr);
+                ASTNode *args = AST(ctx, expr->left);
+                
+                if (frame->state == 0) {
+                    SymbolEntry *func = lookup_symbol(ctx, name);
+                    if (func == NULL) {
+                        semantic_error(ctx, expr, "Undefined function '%s'", name);
+                        finish_expression(&frames, &types, TYPE_ERROR);
+                        break;
+                    }
+                    if (func->kind != SYMBOL_FUNCTION) {
+                        semantic_error(ctx, expr, "'%s' is not a function", name);
+                        finish_expression(&frames, &types, TYPE_ERROR);
+                        break;
+                    }
+                    ast_set_symbol(ctx, expr, func);
+                    frame->param = func->params;
+                } else {
+                    /* Check the argument just analyzed */
+                    SymbolEntry *func = (SymbolEntry *)ast_symbol(ctx, expr);
+                    DataType arg_type = *(DataType *)stack_pop(&types);
+                    if (!types_compatible(frame->param->type, arg_type)) {
+                        semantic_error(ctx, LIST_ITEM(ctx, args, frame->state - 1),
+                                       "Argument type mismatch in call to '%s'", func->name);
+                    }
+                    frame->param = frame->param->next;
+                }
+                
+                /* Analyze the next argument while parameters remain */
+                if (frame->state < LIST_COUNT(args) && frame->param) {
+                    frame->state++;
+                    push_expression(&frames, &types, LIST_ITEM(ctx, args, frame->state - 1));
+                    break;
+                }
+                
+                SymbolEntry *func = (SymbolEntry *)ast_symbol(ctx, expr);
+                if (frame->param) {
+                    semantic_error(ctx, args, "Too few arguments in call to '%s'", func->name);
+                } else if (frame->state < LIST_COUNT(args)) {
+                    semantic_error(ctx, args, "Too many arguments in call to '%s'", func->name);
+                }
+                
+                /* Handle built-in functions */
+                DataType type = func->type;
+                if (func == ctx->symtab.input_func) {
+                    type = TYPE_INT;
+                } else if (func == ctx->symtab.output_func) {
+                    type = TYPE_VOID;
+                }
+                finish_expression(&frames, &types, type);
+                break;
+            }
+                
+            default:
+                finish_expression(&frames, &types, TYPE_ERROR);
+                break;
         }
-        
-        param = param->next;
-        arg = (arg->node_type == NODE_ARG_LIST) ? arg->left : NULL;
     }
     
-    if (param) {
-        semantic_error(args, "Too few arguments in call to '%s'", func->name);
-    } else if (arg) {
-        semantic_error(args, "Too many arguments in call to '%s'", func->name);
-    }
+    DataType result = *(DataType *)stack_pop(&types);
+    stack_free(&frames);
+    stack_free(&types);
+    return result;
+}
+
+/* Analyze variable reference */
+DataType analyze_var(CompilationContext *ctx, ASTNode *node) {
+    return analyze_expression(ctx, node);
+}
+
+/* Analyze assignment */
+DataType analyze_assignment(CompilationContext *ctx, ASTNode *node) {
+    return analyze_expression(ctx, node);
+}
+
+/* Analyze binary operation */
+DataType analyze_binary_op(CompilationContext *ctx, ASTNode *node) {
+    return analyze_expression(ctx, node);
+}
+
+/* Analyze function call */
+DataType analyze_call(CompilationContext *ctx, ASTNode *node) {
+    return analyze_expression(ctx, node);
 }
 
 /* Check type compatibility */
@@ -409,22 +513,29 @@ int types_compatible(DataType t1, DataType t2) {
 }
 
 /* Check for main function */
-void check_main_function(void) {
-    SymbolEntry *main_func = lookup_symbol("main");
+void check_main_function(CompilationContext *ctx) {
+    SymbolEntry *main_func = lookup_symbol(ctx, intern_string(ctx, "main"));
     
     if (main_func == NULL) {
-        error("No 'main' function defined");
-    } else if (main_func->kind != SYMBOL_FUNCTION) {
-        error("'main' must be a function");
-    } else if (main_func->type != TYPE_VOID) {
-        warning("'main' function should return void");
+        error(ctx, "No 'main' function defined");
+        return;
+    }
+    if (main_func->kind != SYMBOL_FUNCTION) {
+        error(ctx, "'main' must be a function");
+        return;
+    }
+    
+    /* The back end tells main apart by this entry */
+    ctx->symtab.main_func = main_func;
+    if (main_func->type != TYPE_VOID) {
+        warning(ctx, "'main' function should return void");
     } else if (main_func->param_count != 0) {
-        warning("'main' function should have no parameters");
+        warning(ctx, "'main' function should have no parameters");
     }
 }
 
 /* Check return paths (simplified) */
-void check_return_paths(ASTNode *func_body, DataType return_type) {
+void check_return_paths(CompilationContext *ctx, ASTNode *func_body, DataType return_type) {
     /* This is a simplified check - a full implementation would
        ensure all paths through the function have appropriate returns */
     /* For now, we just warn if no return statement is found */
@@ -447,29 +558,29 @@ char *type_to_string(DataType type) {
 }
 
 /* Semantic error reporting */
-void semantic_error(ASTNode *node, const char *format, ...) {
+void semantic_error(CompilationContext *ctx, ASTNode *node, const char *format, ...) {
     va_list args;
     va_start(args, format);
     
-    fprintf(stderr, "Semantic error at line %d: ", 
-            node ? node->line_number : linenum);
-    vfprintf(stderr, format, args);
-    fprintf(stderr, "\n");
+    fprintf(ctx->diagnostics, "Semantic error at line %d: ", 
+            node ? ast_line(ctx, node) : ctx->line);
+    vfprintf(ctx->diagnostics, format, args);
+    fprintf(ctx->diagnostics, "\n");
     
     va_end(args);
-    error_count++;
+    ctx->error_count++;
 }
 
 /* Semantic warning reporting */
-void semantic_warning(ASTNode *node, const char *format, ...) {
+void semantic_warning(CompilationContext *ctx, ASTNode *node, const char *format, ...) {
     va_list args;
     va_start(args, format);
     
-    fprintf(stderr, "Warning at line %d: ",
-            node ? node->line_number : linenum);
-    vfprintf(stderr, format, args);
-    fprintf(stderr, "\n");
+    fprintf(ctx->diagnostics, "Warning at line %d: ",
+            node ? ast_line(ctx, node) : ctx->line);
+    vfprintf(ctx->diagnostics, format, args);
+    fprintf(ctx->diagnostics, "\n");
     
     va_end(args);
-    warning_count++;
+    ctx->warning_count++;
 }
\ No newline at end of file
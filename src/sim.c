@@ -0,0 +1,1201 @@
+/*
+ * MIPS32 Simulator Implementation
+ * CST-405 Compiler Design
+ *
+ * Assembles the subset of MIPS assembly used by the back end and the
+ * examples into a decoded instruction array, then interprets it.
+ * Pseudo-instructions (li, la, move, sle, sgt, seq, blt, ...) are kept as
+ * single operations; each records how many machine instructions the
+ * usual expansion takes, so both counts can be reported. Arithmetic
+ * wraps rather than trapping on overflow.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include "sim.h"
+#include "util.h"
+
+/* Address jr returns to when main returns instead of exiting */
+#define RETURN_TO_SYSTEM 0u
+
+/* Lowest stack address */
+#define SIM_STACK_BASE (SIM_STACK_TOP + 4 - SIM_STACK_SIZE)
+
+/* How an instruction's operands are written */
+typedef enum {
+    FORM_ALU,                  /* rd, rs, rt|imm */
+    FORM_ALU_IMM,              /* rt, rs, imm */
+    FORM_UNARY,                /* rd, rs */
+    FORM_LI,                   /* rd, imm */
+    FORM_LUI,                  /* rt, imm */
+    FORM_LA,                   /* rd, label or address */
+    FORM_HILO,                 /* rs, rt (div and divu also take rd, rs, rt) */
+    FORM_MOVE_FROM,            /* rd */
+    FORM_MOVE_TO,              /* rs */
+    FORM_MEMORY,               /* rt, offset(base) */
+    FORM_BRANCH,               /* rs, rt|imm, label */
+    FORM_BRANCH_ZERO,          /* rs, label */
+    FORM_JUMP,                 /* label */
+    FORM_JUMP_REG,             /* rs */
+    FORM_JALR,                 /* [rd,] rs */
+    FORM_NONE
+} OperandForm;
+
+typedef struct {
+    const char *name;
+    SimOpcode op;
+    OperandForm form;
+    int native;                /* Machine instructions in the usual expansion */
+} Mnemonic;
+
+static const Mnemonic mnemonics[] = {
+    { "add",     SIM_ADD,     FORM_ALU, 1 },
+    { "addu",    SIM_ADD,     FORM_ALU, 1 },
+    { "sub",     SIM_SUB,     FORM_ALU, 1 },
+    { "subu",    SIM_SUB,     FORM_ALU, 1 },
+    { "and",     SIM_AND,     FORM_ALU, 1 },
+    { "or",      SIM_OR,      FORM_ALU, 1 },
+    { "xor",     SIM_XOR,     FORM_ALU, 1 },
+    { "nor",     SIM_NOR,     FORM_ALU, 1 },
+    { "slt",     SIM_SLT,     FORM_ALU, 1 },
+    { "sltu",    SIM_SLTU,    FORM_ALU, 1 },
+    { "mul",     SIM_MUL,     FORM_ALU, 1 },
+    { "sle",     SIM_SLE,     FORM_ALU, 2 },
+    { "sleu",    SIM_SLEU,    FORM_ALU, 2 },
+    { "sgt",     SIM_SGT,     FORM_ALU, 1 },
+    { "sgtu",    SIM_SGTU,    FORM_ALU, 1 },
+    { "sge",     SIM_SGE,     FORM_ALU, 2 },
+    { "sgeu",    SIM_SGEU,    FORM_ALU, 2 },
+    { "seq",     SIM_SEQ,     FORM_ALU, 2 },
+    { "sne",     SIM_SNE,     FORM_ALU, 2 },
+    { "rem",     SIM_REM,     FORM_ALU, 2 },
+    { "remu",    SIM_REMU,    FORM_ALU, 2 },
+    { "sll",     SIM_SLL,     FORM_ALU, 1 },
+    { "srl",     SIM_SRL,     FORM_ALU, 1 },
+    { "sra",     SIM_SRA,     FORM_ALU, 1 },
+    { "sllv",    SIM_SLL,     FORM_ALU, 1 },
+    { "srlv",    SIM_SRL,     FORM_ALU, 1 },
+    { "srav",    SIM_SRA,     FORM_ALU, 1 },
+    { "addi",    SIM_ADD,     FORM_ALU_IMM, 1 },
+    { "addiu",   SIM_ADD,     FORM_ALU_IMM, 1 },
+    { "subi",    SIM_SUB,     FORM_ALU_IMM, 1 },
+    { "andi",    SIM_AND,     FORM_ALU_IMM, 1 },
+    { "ori",     SIM_OR,      FORM_ALU_IMM, 1 },
+    { "xori",    SIM_XOR,     FORM_ALU_IMM, 1 },
+    { "slti",    SIM_SLT,     FORM_ALU_IMM, 1 },
+    { "sltiu",   SIM_SLTU,    FORM_ALU_IMM, 1 },
+    { "move",    SIM_MOVE,    FORM_UNARY, 1 },
+    { "neg",     SIM_NEG,     FORM_UNARY, 1 },
+    { "negu",    SIM_NEG,     FORM_UNARY, 1 },
+    { "not",     SIM_NOT,     FORM_UNARY, 1 },
+    { "li",      SIM_LI,      FORM_LI, 1 },
+    { "lui",     SIM_LI,      FORM_LUI, 1 },
+    { "la",      SIM_LI,      FORM_LA, 2 },
+    { "mult",    SIM_MULT,    FORM_HILO, 1 },
+    { "multu",   SIM_MULTU,   FORM_HILO, 1 },
+    { "div",     SIM_DIV,     FORM_HILO, 1 },
+    { "divu",    SIM_DIVU,    FORM_HILO, 1 },
+    { "mfhi",    SIM_MFHI,    FORM_MOVE_FROM, 1 },
+    { "mflo",    SIM_MFLO,    FORM_MOVE_FROM, 1 },
+    { "mthi",    SIM_MTHI,    FORM_MOVE_TO, 1 },
+    { "mtlo",    SIM_MTLO,    FORM_MOVE_TO, 1 },
+    { "lw",      SIM_LW,      FORM_MEMORY, 1 },
+    { "lh",      SIM_LH,      FORM_MEMORY, 1 },
+    { "lhu",     SIM_LHU,     FORM_MEMORY, 1 },
+    { "lb",      SIM_LB,      FORM_MEMORY, 1 },
+    { "lbu",     SIM_LBU,     FORM_MEMORY, 1 },
+    { "sw",      SIM_SW,      FORM_MEMORY, 1 },
+    { "sh",      SIM_SH,      FORM_MEMORY, 1 },
+    { "sb",      SIM_SB,      FORM_MEMORY, 1 },
+    { "beq",     SIM_BEQ,     FORM_BRANCH, 1 },
+    { "bne",     SIM_BNE,     FORM_BRANCH, 1 },
+    { "blt",     SIM_BLT,     FORM_BRANCH, 2 },
+    { "ble",     SIM_BLE,     FORM_BRANCH, 2 },
+    { "bgt",     SIM_BGT,     FORM_BRANCH, 2 },
+    { "bge",     SIM_BGE,     FORM_BRANCH, 2 },
+    { "bltu",    SIM_BLTU,    FORM_BRANCH, 2 },
+    { "bleu",    SIM_BLEU,    FORM_BRANCH, 2 },
+    { "bgtu",    SIM_BGTU,    FORM_BRANCH, 2 },
+    { "bgeu",    SIM_BGEU,    FORM_BRANCH, 2 },
+    { "beqz",    SIM_BEQ,     FORM_BRANCH_ZERO, 1 },
+    { "bnez",    SIM_BNE,     FORM_BRANCH_ZERO, 1 },
+    { "bltz",    SIM_BLT,     FORM_BRANCH_ZERO, 1 },
+    { "blez",    SIM_BLE,     FORM_BRANCH_ZERO, 1 },
+    { "bgtz",    SIM_BGT,     FORM_BRANCH_ZERO, 1 },
+    { "bgez",    SIM_BGE,     FORM_BRANCH_ZERO, 1 },
+    { "b",       SIM_J,       FORM_JUMP, 1 },
+    { "j",       SIM_J,       FORM_JUMP, 1 },
+    { "jal",     SIM_JAL,     FORM_JUMP, 1 },
+    { "jr",      SIM_JR,      FORM_JUMP_REG, 1 },
+    { "jalr",    SIM_JALR,    FORM_JALR, 1 },
+    { "syscall", SIM_SYSCALL, FORM_NONE, 1 },
+    { "nop",     SIM_NOP,     FORM_NONE, 1 },
+    { NULL,      SIM_NOP,     FORM_NONE, 0 }
+};
+
+static const char *register_names[32] = {
+    "zero", "at", "v0", "v1", "a0", "a1", "a2", "a3",
+    "t0", "t1", "t2", "t3", "t4", "t5", "t6", "t7",
+    "s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7",
+    "t8", "t9", "k0", "k1", "gp", "sp", "fp", "ra"
+};
+
+/* A label use resolved once the whole file has been read */
+typedef enum {
+    FIXUP_TARGET,              /* Branch or jump target */
+    FIXUP_ADDRESS,             /* Instruction immediate gets the address */
+    FIXUP_WORD                 /* Data word gets the address */
+} FixupKind;
+
+typedef struct {
+    FixupKind kind;
+    int index;                 /* Instruction index or data offset */
+    char *name;
+    int32_t addend;
+    int line;
+} Fixup;
+
+/* Assembler state while a file is read */
+typedef struct {
+    MIPSMachine *machine;
+    const char *filename;
+    int line;
+    int in_text;
+    Fixup *fixups;
+    int fixup_count;
+    int fixup_capacity;
+    int *pending;              /* Data labels waiting for the next item */
+    int pending_count;
+    int pending_capacity;
+} Assembler;
+
+/* Record a load error; always returns -1 */
+static int load_error(Assembler *as, const char *format, ...) {
+    char message[200];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    snprintf(as->machine->error, sizeof(as->machine->error), "%s:%d: %s",
+             as->filename, as->line, message);
+    return -1;
+}
+
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) s++;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return s;
+}
+
+static int fits_signed16(int32_t value) {
+    return value >= -32768 && value <= 32767;
+}
+
+static int parse_register(const char *text, unsigned char *reg) {
+    if (text[0] != '$') return 0;
+    text++;
+    if (isdigit((unsigned char)text[0])) {
+        char *end;
+        long number = strtol(text, &end, 10);
+        if (*end != '\0' || number < 0 || number > 31) return 0;
+        *reg = (unsigned char)number;
+        return 1;
+    }
+    for (int r = 0; r < 32; r++) {
+        if (strcmp(text, register_names[r]) == 0) {
+            *reg = (unsigned char)r;
+            return 1;
+        }
+    }
+    if (strcmp(text, "s8") == 0) {
+        *reg = 30;
+        return 1;
+    }
+    return 0;
+}
+
+/* A number: decimal, hex, octal or a quoted character */
+static int parse_immediate(const char *text, int32_t *value) {
+    if (text[0] == '\'' && text[1] != '\0') {
+        if (text[1] == '\\' && text[2] != '\0' && text[3] == '\'' && text[4] == '\0') {
+            switch (text[2]) {
+                case 'n': *value = '\n'; break;
+                case 't': *value = '\t'; break;
+                case '0': *value = 0; break;
+                default: *value = (unsigned char)text[2]; break;
+            }
+            return 1;
+        }
+        if (text[2] == '\'' && text[3] == '\0') {
+            *value = (unsigned char)text[1];
+            return 1;
+        }
+        return 0;
+    }
+    if (text[0] == '\0') return 0;
+    char *end;
+    long long number = strtoll(text, &end, 0);
+    if (*end != '\0' || number < INT32_MIN || number > UINT32_MAX) return 0;
+    *value = (int32_t)(uint32_t)number;
+    return 1;
+}
+
+static int is_label_name(const char *text) {
+    if (!(isalpha((unsigned char)*text) || *text == '_' || *text == '.')) return 0;
+    for (; *text; text++) {
+        if (!(isalnum((unsigned char)*text) || *text == '_' || *text == '.' || *text == '$')) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void add_fixup(Assembler *as, FixupKind kind, int index, const char *name, int32_t addend) {
+    if (as->fixup_count == as->fixup_capacity) {
+        as->fixup_capacity = as->fixup_capacity ? as->fixup_capacity * 2 : 64;
+        as->fixups = (Fixup *)safe_realloc(as->fixups, as->fixup_capacity * sizeof(Fixup));
+    }
+    Fixup *fixup = &as->fixups[as->fixup_count++];
+    fixup->kind = kind;
+    fixup->index = index;
+    fixup->name = copy_string(name);
+    fixup->addend = addend;
+    fixup->line = as->line;
+}
+
+/* A label, optionally plus or minus a number: "name", "name+8" */
+static int parse_symbol(char *text, char **name, int32_t *addend) {
+    *addend = 0;
+    char *sign = strpbrk(text, "+-");
+    if (sign != NULL) {
+        int32_t offset;
+        char saved = *sign;
+        if (!parse_immediate(trim(sign + 1), &offset)) return 0;
+        *addend = (saved == '-') ? -offset : offset;
+        *sign = '\0';
+        text = trim(text);
+    }
+    if (!is_label_name(text)) return 0;
+    *name = text;
+    return 1;
+}
+
+/* An address operand: "off($r)", "($r)", "label", "label($r)", "label+4" */
+static int parse_address(Assembler *as, char *text, SimInstruction *instr, int *extra) {
+    char *open = strchr(text, '(');
+    char *offset = text;
+    instr->rs = 0;
+    *extra = 0;
+
+    if (open != NULL) {
+        char *close = strchr(open, ')');
+        if (close == NULL || trim(close + 1)[0] != '\0') {
+            return load_error(as, "bad address '%s'", text);
+        }
+        *close = '\0';
+        if (!parse_register(trim(open + 1), &instr->rs)) {
+            return load_error(as, "bad base register in '%s'", text);
+        }
+        *open = '\0';
+        offset = trim(text);
+    }
+
+    if (offset[0] == '\0') {
+        instr->imm = 0;
+        return 0;
+    }
+    if (parse_immediate(offset, &instr->imm)) {
+        /* Offsets beyond 16 bits go through $at */
+        if (!fits_signed16(instr->imm)) *extra = 2;
+        return 0;
+    }
+
+    char *name;
+    int32_t addend;
+    if (!parse_symbol(offset, &name, &addend)) {
+        return load_error(as, "bad address '%s'", offset);
+    }
+    add_fixup(as, FIXUP_ADDRESS, as->machine->count, name, addend);
+    instr->imm = 0;
+    *extra = (instr->rs == 0) ? 1 : 2;     /* lui $at, then addu with the base */
+    return 0;
+}
+
+/* Split an operand list at commas; returns max + 1 if there are more */
+static int split_operands(char *text, char **operands, int max) {
+    int count = 0;
+    text = trim(text);
+    if (*text == '\0') return 0;
+    for (;;) {
+        if (count == max) return max + 1;
+        operands[count++] = text;
+        char *comma = strchr(text, ',');
+        if (comma == NULL) break;
+        *comma = '\0';
+        text = comma + 1;
+    }
+    for (int i = 0; i < count; i++) {
+        operands[i] = trim(operands[i]);
+    }
+    return count;
+}
+
+static const Mnemonic *find_mnemonic(const char *name) {
+    for (const Mnemonic *m = mnemonics; m->name; m++) {
+        if (strcmp(m->name, name) == 0) return m;
+    }
+    return NULL;
+}
+
+static int define_label(Assembler *as, const char *name) {
+    MIPSMachine *machine = as->machine;
+    for (int i = 0; i < machine->label_count; i++) {
+        if (strcmp(machine->labels[i].name, name) == 0) {
+            return load_error(as, "label '%s' defined twice", name);
+        }
+    }
+    if (machine->label_count == machine->label_capacity) {
+        machine->label_capacity = machine->label_capacity ? machine->label_capacity * 2 : 64;
+        machine->labels = (SimLabel *)safe_realloc(machine->labels,
+                                                    machine->label_capacity * sizeof(SimLabel));
+    }
+    SimLabel *label = &machine->labels[machine->label_count];
+    label->name = copy_string(name);
+    label->in_text = as->in_text;
+    label->value = as->in_text ? (uint32_t)machine->count : 0;
+    if (!as->in_text) {
+        /* Bound when the next data item fixes its alignment */
+        if (as->pending_count == as->pending_capacity) {
+            as->pending_capacity = as->pending_capacity ? as->pending_capacity * 2 : 8;
+            as->pending = (int *)safe_realloc(as->pending, as->pending_capacity * sizeof(int));
+        }
+        as->pending[as->pending_count++] = machine->label_count;
+    }
+    machine->label_count++;
+    return 0;
+}
+
+/* Align the data segment and bind waiting labels to the result */
+static void align_data(Assembler *as, uint32_t alignment) {
+    MIPSMachine *machine = as->machine;
+    while (machine->data_size % alignment != 0) {
+        machine->data_size++;
+    }
+    for (int i = 0; i < as->pending_count; i++) {
+        machine->labels[as->pending[i]].value = SIM_DATA_BASE + machine->data_size;
+    }
+    as->pending_count = 0;
+}
+
+/* Reserve zeroed bytes at the end of the data segment */
+static unsigned char *grow_data(MIPSMachine *machine, uint32_t size) {
+    if (machine->data_size + size > machine->data_capacity) {
+        uint32_t capacity = machine->data_capacity ? machine->data_capacity * 2 : 4096;
+        while (capacity < machine->data_size + size) {
+            capacity *= 2;
+        }
+        machine->data = (unsigned char *)safe_realloc(machine->data, capacity);
+        memset(machine->data + machine->data_capacity, 0, capacity - machine->data_capacity);
+        machine->data_capacity = capacity;
+    }
+    unsigned char *at = machine->data + machine->data_size;
+    machine->data_size += size;
+    return at;
+}
+
+static void store_bytes(unsigned char *at, uint32_t value, int size) {
+    for (int b = 0; b < size; b++) {
+        at[b] = (unsigned char)(value >> (8 * b));
+    }
+}
+
+/* Copy a quoted string literal, handling escapes */
+static int assemble_string(Assembler *as, char *text, int terminate) {
+    text = trim(text);
+    size_t length = strlen(text);
+    if (length < 2 || text[0] != '"' || text[length - 1] != '"') {
+        return load_error(as, "expected a string literal");
+    }
+    align_data(as, 1);
+    for (size_t i = 1; i < length - 1; i++) {
+        char c = text[i];
+        if (c == '\\' && i + 1 < length - 1) {
+            switch (text[++i]) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case '0': c = '\0'; break;
+                case 'r': c = '\r'; break;
+                default: c = text[i]; break;
+            }
+        }
+        *grow_data(as->machine, 1) = (unsigned char)c;
+    }
+    if (terminate) {
+        *grow_data(as->machine, 1) = 0;
+    }
+    return 0;
+}
+
+/* Values for .word, .half and .byte; words may name labels */
+static int assemble_values(Assembler *as, char *text, int size) {
+    char *operands[256];
+    int count = split_operands(text, operands, 256);
+    if (count == 0 || count > 256) {
+        return load_error(as, "expected 1 to 256 values");
+    }
+    align_data(as, (uint32_t)size);
+    for (int i = 0; i < count; i++) {
+        int32_t value = 0;
+        char *name;
+        if (!parse_immediate(operands[i], &value)) {
+            if (size != 4 || !parse_symbol(operands[i], &name, &value)) {
+                return load_error(as, "bad value '%s'", operands[i]);
+            }
+            add_fixup(as, FIXUP_WORD, (int)as->machine->data_size, name, value);
+        }
+        store_bytes(grow_data(as->machine, (uint32_t)size), (uint32_t)value, size);
+    }
+    return 0;
+}
+
+static int assemble_directive(Assembler *as, char *name, char *rest) {
+    if (strcmp(name, ".data") == 0) {
+        as->in_text = 0;
+    } else if (strcmp(name, ".text") == 0) {
+        align_data(as, 1);
+        as->in_text = 1;
+    } else if (strcmp(name, ".globl") == 0 || strcmp(name, ".global") == 0 ||
+               strcmp(name, ".extern") == 0 || strcmp(name, ".ent") == 0 ||
+               strcmp(name, ".end") == 0) {
+        /* Linkage hints: nothing to do in a single-file program */
+    } else if (as->in_text) {
+        return load_error(as, "%s is only allowed in .data", name);
+    } else if (strcmp(name, ".word") == 0) {
+        return assemble_values(as, rest, 4);
+    } else if (strcmp(name, ".half") == 0) {
+        return assemble_values(as, rest, 2);
+    } else if (strcmp(name, ".byte") == 0) {
+        return assemble_values(as, rest, 1);
+    } else if (strcmp(name, ".space") == 0) {
+        int32_t size;
+        if (!parse_immediate(trim(rest), &size) || size < 0) {
+            return load_error(as, "bad .space size");
+        }
+        align_data(as, 1);
+        grow_data(as->machine, (uint32_t)size);
+    } else if (strcmp(name, ".align") == 0) {
+        int32_t power;
+        if (!parse_immediate(trim(rest), &power) || power < 0 || power > 12) {
+            return load_error(as, "bad .align");
+        }
+        align_data(as, 1u << power);
+    } else if (strcmp(name, ".asciiz") == 0) {
+        return assemble_string(as, rest, 1);
+    } else if (strcmp(name, ".ascii") == 0) {
+        return assemble_string(as, rest, 0);
+    } else {
+        return load_error(as, "unknown directive %s", name);
+    }
+    return 0;
+}
+
+/* Parse a register operand, or fail with a message naming the instruction */
+static int need_register(Assembler *as, const char *text, unsigned char *reg, const char *mnemonic) {
+    if (!parse_register(text, reg)) {
+        return load_error(as, "%s: expected a register, got '%s'", mnemonic, text);
+    }
+    return 0;
+}
+
+static int need_target(Assembler *as, char *text, const char *mnemonic) {
+    if (!is_label_name(text)) {
+        return load_error(as, "%s: expected a label, got '%s'", mnemonic, text);
+    }
+    add_fixup(as, FIXUP_TARGET, as->machine->count, text, 0);
+    return 0;
+}
+
+/* Second source operand: a register, or an immediate for the pseudo form */
+static int second_operand(Assembler *as, const char *text, SimInstruction *instr, int has_imm_form,
+                          const char *mnemonic) {
+    if (parse_register(text, &instr->rt)) return 0;
+    if (!parse_immediate(text, &instr->imm)) {
+        return load_error(as, "%s: expected a register or number, got '%s'", mnemonic, text);
+    }
+    instr->use_imm = 1;
+    if (!has_imm_form) {
+        instr->native += fits_signed16(instr->imm) ? 1 : 2;   /* Materialize in $at */
+    } else if (!fits_signed16(instr->imm)) {
+        instr->native += 2;
+    }
+    return 0;
+}
+
+static int assemble_instruction(Assembler *as, char *name, char *rest) {
+    if (!as->in_text) {
+        return load_error(as, "instruction '%s' outside .text", name);
+    }
+    const Mnemonic *m = find_mnemonic(name);
+    if (m == NULL) {
+        return load_error(as, "unknown instruction '%s'", name);
+    }
+
+    SimInstruction instr;
+    memset(&instr, 0, sizeof(instr));
+    instr.op = m->op;
+    instr.native = (unsigned char)m->native;
+    instr.line = as->line;
+    instr.function = -1;
+
+    char *ops[4];
+    int count = split_operands(rest, ops, 4);
+    int expected[] = {
+        [FORM_ALU] = 3, [FORM_ALU_IMM] = 3, [FORM_UNARY] = 2, [FORM_LI] = 2,
+        [FORM_LUI] = 2, [FORM_LA] = 2, [FORM_HILO] = 2, [FORM_MOVE_FROM] = 1,
+        [FORM_MOVE_TO] = 1, [FORM_MEMORY] = 2, [FORM_BRANCH] = 3,
+        [FORM_BRANCH_ZERO] = 2, [FORM_JUMP] = 1, [FORM_JUMP_REG] = 1,
+        [FORM_JALR] = 1, [FORM_NONE] = 0
+    };
+    int ok = (count == expected[m->form]) ||
+             (m->form == FORM_HILO && count == 3) ||
+             (m->form == FORM_JALR && count == 2);
+    if (!ok) {
+        return load_error(as, "%s takes %d operand(s)", name, expected[m->form]);
+    }
+
+    int extra = 0;
+    switch (m->form) {
+        case FORM_ALU: {
+            /* Shifts by a constant and the immediate pseudo forms */
+            int has_imm_form = (m->op == SIM_ADD || m->op == SIM_AND || m->op == SIM_OR ||
+                                m->op == SIM_XOR || m->op == SIM_SLT || m->op == SIM_SLTU ||
+                                m->op == SIM_SLL || m->op == SIM_SRL || m->op == SIM_SRA);
+            if (need_register(as, ops[0], &instr.rd, name) ||
+                need_register(as, ops[1], &instr.rs, name) ||
+                second_operand(as, ops[2], &instr, has_imm_form, name)) {
+                return -1;
+            }
+            break;
+        }
+        case FORM_ALU_IMM:
+            if (need_register(as, ops[0], &instr.rd, name) ||
+                need_register(as, ops[1], &instr.rs, name)) {
+                return -1;
+            }
+            if (!parse_immediate(ops[2], &instr.imm)) {
+                return load_error(as, "%s: expected a number, got '%s'", name, ops[2]);
+            }
+            if (m->op == SIM_AND || m->op == SIM_OR || m->op == SIM_XOR) {
+                instr.imm &= 0xffff;              /* Logical immediates zero-extend */
+            }
+            if (m->op == SIM_SUB) {
+                instr.op = SIM_ADD;
+                instr.imm = -instr.imm;
+            }
+            instr.use_imm = 1;
+            break;
+        case FORM_UNARY:
+            if (need_register(as, ops[0], &instr.rd, name) ||
+                need_register(as, ops[1], &instr.rs, name)) {
+                return -1;
+            }
+            break;
+        case FORM_LI:
+        case FORM_LUI:
+            if (need_register(as, ops[0], &instr.rd, name)) return -1;
+            if (!parse_immediate(ops[1], &instr.imm)) {
+                return load_error(as, "%s: expected a number, got '%s'", name, ops[1]);
+            }
+            if (m->form == FORM_LUI) {
+                instr.imm = (int32_t)((uint32_t)instr.imm << 16);
+            } else if (!fits_signed16(instr.imm) && (instr.imm < 0 || instr.imm > 0xffff)) {
+                instr.native = 2;                 /* lui and ori */
+            }
+            break;
+        case FORM_LA:
+            if (need_register(as, ops[0], &instr.rd, name)) return -1;
+            if (parse_address(as, ops[1], &instr, &extra) != 0) return -1;
+            if (instr.rs != 0) {
+                /* la $r, off($base) is an add */
+                instr.op = SIM_ADD;
+                instr.use_imm = 1;
+                instr.native = (unsigned char)(1 + extra);
+            }
+            break;
+        case FORM_HILO:
+            if (count == 3) {
+                /* div rd, rs, rt: quotient straight into rd */
+                if (m->op != SIM_DIV && m->op != SIM_DIVU) {
+                    return load_error(as, "%s takes 2 operands", name);
+                }
+                instr.op = (m->op == SIM_DIV) ? SIM_QUOT : SIM_QUOTU;
+                instr.native = 2;
+                if (need_register(as, ops[0], &instr.rd, name) ||
+                    need_register(as, ops[1], &instr.rs, name) ||
+                    second_operand(as, ops[2], &instr, 0, name)) {
+                    return -1;
+                }
+            } else if (need_register(as, ops[0], &instr.rs, name) ||
+                       need_register(as, ops[1], &instr.rt, name)) {
+                return -1;
+            }
+            break;
+        case FORM_MOVE_FROM:
+            if (need_register(as, ops[0], &instr.rd, name)) return -1;
+            break;
+        case FORM_MOVE_TO:
+        case FORM_JUMP_REG:
+            if (need_register(as, ops[0], &instr.rs, name)) return -1;
+            break;
+        case FORM_JALR:
+            instr.rd = 31;
+            if (count == 2 && need_register(as, ops[0], &instr.rd, name)) return -1;
+            if (need_register(as, ops[count - 1], &instr.rs, name)) return -1;
+            break;
+        case FORM_MEMORY:
+            if (need_register(as, ops[0], &instr.rt, name)) return -1;
+            if (parse_address(as, ops[1], &instr, &extra) != 0) return -1;
+            instr.native = (unsigned char)(instr.native + extra);
+            break;
+        case FORM_BRANCH:
+            if (need_register(as, ops[0], &instr.rs, name) ||
+                second_operand(as, ops[1], &instr, 0, name) ||
+                need_target(as, ops[2], name)) {
+                return -1;
+            }
+            break;
+        case FORM_BRANCH_ZERO:
+            instr.rt = 0;
+            if (need_register(as, ops[0], &instr.rs, name) ||
+                need_target(as, ops[1], name)) {
+                return -1;
+            }
+            break;
+        case FORM_JUMP:
+            if (need_target(as, ops[0], name)) return -1;
+            break;
+        case FORM_NONE:
+            break;
+    }
+
+    MIPSMachine *machine = as->machine;
+    if (machine->count == machine->capacity) {
+        machine->capacity = machine->capacity ? machine->capacity * 2 : 256;
+        machine->code = (SimInstruction *)safe_realloc(machine->code,
+                                                        machine->capacity * sizeof(SimInstruction));
+    }
+    machine->code[machine->count++] = instr;
+    return 0;
+}
+
+/* Strip a comment, ignoring '#' inside quotes */
+static void strip_comment(char *line) {
+    int quoted = 0;
+    for (char *p = line; *p; p++) {
+        if (*p == '\\' && quoted && p[1]) {
+            p++;
+        } else if (*p == '"') {
+            quoted = !quoted;
+        } else if (*p == '#' && !quoted) {
+            *p = '\0';
+            return;
+        }
+    }
+}
+
+static int assemble_line(Assembler *as, char *line) {
+    strip_comment(line);
+    char *text = trim(line);
+
+    /* Any number of leading labels */
+    for (;;) {
+        char *colon = text;
+        while (*colon && (isalnum((unsigned char)*colon) || *colon == '_' ||
+                          *colon == '.' || *colon == '$')) {
+            colon++;
+        }
+        if (*colon != ':' || colon == text) break;
+        *colon = '\0';
+        if (!is_label_name(text)) return load_error(as, "bad label '%s'", text);
+        if (define_label(as, text) != 0) return -1;
+        text = trim(colon + 1);
+    }
+    if (*text == '\0') return 0;
+
+    char *rest = text;
+    while (*rest && !isspace((unsigned char)*rest)) rest++;
+    if (*rest) *rest++ = '\0';
+
+    if (text[0] == '.') {
+        return assemble_directive(as, text, rest);
+    }
+    return assemble_instruction(as, text, rest);
+}
+
+static const SimLabel *find_label(MIPSMachine *machine, const char *name) {
+    for (int i = 0; i < machine->label_count; i++) {
+        if (strcmp(machine->labels[i].name, name) == 0) return &machine->labels[i];
+    }
+    return NULL;
+}
+
+static int resolve_fixups(Assembler *as) {
+    MIPSMachine *machine = as->machine;
+    for (int i = 0; i < as->fixup_count; i++) {
+        Fixup *fixup = &as->fixups[i];
+        const SimLabel *label = find_label(machine, fixup->name);
+        as->line = fixup->line;
+        if (label == NULL) {
+            return load_error(as, "undefined label '%s'", fixup->name);
+        }
+        uint32_t address = label->in_text ? SIM_TEXT_BASE + 4 * label->value : label->value;
+        address += (uint32_t)fixup->addend;
+
+        if (fixup->kind == FIXUP_TARGET) {
+            if (!label->in_text) {
+                return load_error(as, "'%s' is not a code label", fixup->name);
+            }
+            machine->code[fixup->index].target = (int)label->value;
+        } else if (fixup->kind == FIXUP_ADDRESS) {
+            machine->code[fixup->index].imm += (int32_t)address;
+        } else {
+            store_bytes(machine->data + fixup->index, address, 4);
+        }
+    }
+    return 0;
+}
+
+static int compare_functions(const void *a, const void *b) {
+    return ((const SimFunction *)a)->start - ((const SimFunction *)b)->start;
+}
+
+/* Functions are main and every jal target; each owns the code up to the next */
+static void find_functions(MIPSMachine *machine) {
+    char *is_entry = (char *)safe_calloc(machine->count + 1, 1);
+    const SimLabel *main_label = find_label(machine, "main");
+    if (main_label && main_label->in_text) {
+        is_entry[main_label->value] = 1;
+    }
+    for (int i = 0; i < machine->count; i++) {
+        if (machine->code[i].op == SIM_JAL) {
+            is_entry[machine->code[i].target] = 1;
+        }
+    }
+
+    machine->functions = (SimFunction *)safe_calloc(machine->label_count + 1, sizeof(SimFunction));
+    for (int l = 0; l < machine->label_count; l++) {
+        SimLabel *label = &machine->labels[l];
+        if (label->in_text && is_entry[label->value]) {
+            is_entry[label->value] = 0;        /* First label at an address names it */
+            SimFunction *function = &machine->functions[machine->function_count++];
+            function->name = label->name;
+            function->start = (int)label->value;
+        }
+    }
+    qsort(machine->functions, machine->function_count, sizeof(SimFunction), compare_functions);
+
+    int f = -1;
+    for (int i = 0; i < machine->count; i++) {
+        while (f + 1 < machine->function_count && machine->functions[f + 1].start <= i) {
+            f++;
+        }
+        machine->code[i].function = f;
+    }
+    free(is_entry);
+}
+
+/* Load an assembly file */
+int sim_load(MIPSMachine *machine, const char *filename) {
+    memset(machine, 0, sizeof(MIPSMachine));
+    machine->input = stdin;
+    machine->output = stdout;
+
+    Assembler as;
+    memset(&as, 0, sizeof(as));
+    as.machine = machine;
+    as.filename = filename;
+    as.in_text = 1;
+
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        snprintf(machine->error, sizeof(machine->error), "Cannot open %s", filename);
+        return -1;
+    }
+
+    int status = 0;
+    char *line = NULL;
+    size_t line_capacity = 0;
+    while (status == 0 && getline(&line, &line_capacity, file) != -1) {
+        as.line++;
+        status = assemble_line(&as, line);
+    }
+    free(line);
+    fclose(file);
+
+    if (status == 0) {
+        align_data(&as, 1);
+        status = resolve_fixups(&as);
+    }
+    if (status == 0) {
+        find_functions(machine);
+    }
+
+    for (int i = 0; i < as.fixup_count; i++) {
+        free(as.fixups[i].name);
+    }
+    free(as.fixups);
+    free(as.pending);
+    return status;
+}
+
+/* Record a run-time error at the current instruction; always returns -1 */
+static int run_error(MIPSMachine *machine, const SimInstruction *instr, const char *format, ...) {
+    char message[200];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    snprintf(machine->error, sizeof(machine->error), "line %d: %s", instr->line, message);
+    return -1;
+}
+
+/* Host address of size bytes at a simulated address, NULL if unmapped */
+static unsigned char *memory_at(MIPSMachine *machine, uint32_t address, uint32_t size) {
+    if (address >= SIM_DATA_BASE && address - SIM_DATA_BASE <= machine->data_size &&
+        machine->data_size - (address - SIM_DATA_BASE) >= size) {
+        return machine->data + (address - SIM_DATA_BASE);
+    }
+    if (address >= SIM_STACK_BASE && address - SIM_STACK_BASE <= SIM_STACK_SIZE - size) {
+        return machine->stack + (address - SIM_STACK_BASE);
+    }
+    return NULL;
+}
+
+static int32_t alu(SimOpcode op, int32_t a, int32_t b) {
+    uint32_t ua = (uint32_t)a, ub = (uint32_t)b;
+    switch (op) {
+        case SIM_ADD:  return (int32_t)(ua + ub);
+        case SIM_SUB:  return (int32_t)(ua - ub);
+        case SIM_AND:  return a & b;
+        case SIM_OR:   return a | b;
+        case SIM_XOR:  return a ^ b;
+        case SIM_NOR:  return ~(a | b);
+        case SIM_SLT:  return a < b;
+        case SIM_SLTU: return ua < ub;
+        case SIM_SLE:  return a <= b;
+        case SIM_SLEU: return ua <= ub;
+        case SIM_SGT:  return a > b;
+        case SIM_SGTU: return ua > ub;
+        case SIM_SGE:  return a >= b;
+        case SIM_SGEU: return ua >= ub;
+        case SIM_SEQ:  return a == b;
+        case SIM_SNE:  return a != b;
+        case SIM_MUL:  return (int32_t)(ua * ub);
+        case SIM_SLL:  return (int32_t)(ua << (ub & 31));
+        case SIM_SRL:  return (int32_t)(ua >> (ub & 31));
+        case SIM_SRA:  return (a < 0) ? ~(~a >> (ub & 31)) : a >> (ub & 31);
+        default:       return 0;
+    }
+}
+
+static int compare(SimOpcode op, int32_t a, int32_t b) {
+    uint32_t ua = (uint32_t)a, ub = (uint32_t)b;
+    switch (op) {
+        case SIM_BEQ:  return a == b;
+        case SIM_BNE:  return a != b;
+        case SIM_BLT:  return a < b;
+        case SIM_BLE:  return a <= b;
+        case SIM_BGT:  return a > b;
+        case SIM_BGE:  return a >= b;
+        case SIM_BLTU: return ua < ub;
+        case SIM_BLEU: return ua <= ub;
+        case SIM_BGTU: return ua > ub;
+        default:       return ua >= ub;
+    }
+}
+
+/* Signed division as the hardware does it, without C's overflow */
+static void divide(int32_t a, int32_t b, int32_t *quotient, int32_t *remainder) {
+    if (b == -1) {
+        *quotient = (int32_t)(0u - (uint32_t)a);
+        *remainder = 0;
+    } else {
+        *quotient = a / b;
+        *remainder = a % b;
+    }
+}
+
+/* Jump to a code address held in a register */
+static int jump_to(MIPSMachine *machine, const SimInstruction *instr, uint32_t address, int *done) {
+    if (address == RETURN_TO_SYSTEM) {
+        *done = 1;
+        return 0;
+    }
+    uint32_t index = (address - SIM_TEXT_BASE) / 4;
+    if (address < SIM_TEXT_BASE || address % 4 != 0 || index >= (uint32_t)machine->count) {
+        return run_error(machine, instr, "jump to bad address 0x%08x", address);
+    }
+    machine->pc = (int)index;
+    return 0;
+}
+
+static int read_int(MIPSMachine *machine) {
+    char line[64];
+    if (fgets(line, sizeof(line), machine->input) == NULL) return 0;
+    return (int)strtol(line, NULL, 10);
+}
+
+static int do_syscall(MIPSMachine *machine, const SimInstruction *instr, int *done) {
+    int32_t *regs = machine->regs;
+    switch (regs[2]) {
+        case 1:                                /* print_int */
+            fprintf(machine->output, "%d", regs[4]);
+            break;
+        case 4: {                              /* print_string */
+            uint32_t address = (uint32_t)regs[4];
+            unsigned char *c;
+            while ((c = memory_at(machine, address, 1)) != NULL && *c != 0) {
+                fputc(*c, machine->output);
+                address++;
+            }
+            if (c == NULL) {
+                return run_error(machine, instr, "print_string past the end of memory");
+            }
+            break;
+        }
+        case 5:                                /* read_int */
+            fflush(machine->output);
+            regs[2] = read_int(machine);
+            break;
+        case 8: {                              /* read_string */
+            uint32_t address = (uint32_t)regs[4];
+            int32_t length = regs[5];
+            unsigned char *buffer = (length > 0) ? memory_at(machine, address, (uint32_t)length) : NULL;
+            if (buffer == NULL) {
+                return run_error(machine, instr, "read_string into bad buffer 0x%08x", address);
+            }
+            fflush(machine->output);
+            if (fgets((char *)buffer, length, machine->input) == NULL) buffer[0] = 0;
+            break;
+        }
+        case 10:                               /* exit */
+            *done = 1;
+            break;
+        case 11:                               /* print_char */
+            fputc(regs[4] & 0xff, machine->output);
+            break;
+        case 12: {                             /* read_char */
+            fflush(machine->output);
+            int c = fgetc(machine->input);
+            regs[2] = (c == EOF) ? 0 : c;
+            break;
+        }
+        case 17:                               /* exit2 */
+            machine->exit_code = regs[4];
+            *done = 1;
+            break;
+        default:
+            return run_error(machine, instr, "unsupported syscall %d", regs[2]);
+    }
+    return 0;
+}
+
+/* Run from main until the program exits */
+int sim_run(MIPSMachine *machine) {
+    const SimLabel *entry = find_label(machine, "main");
+    if (entry == NULL || !entry->in_text) {
+        snprintf(machine->error, sizeof(machine->error), "no main label in .text");
+        return -1;
+    }
+    if (machine->stack == NULL) {
+        machine->stack = (unsigned char *)safe_calloc(SIM_STACK_SIZE, 1);
+    }
+
+    int32_t *regs = machine->regs;
+    memset(regs, 0, sizeof(machine->regs));
+    regs[28] = (int32_t)0x10008000u;
+    regs[29] = (int32_t)(SIM_STACK_TOP & ~7u);
+    regs[31] = (int32_t)RETURN_TO_SYSTEM;
+    machine->pc = (int)entry->value;
+    memset(&machine->stats, 0, sizeof(SimStats));
+    machine->exit_code = 0;
+
+    SimStats *stats = &machine->stats;
+    SimFunction *functions = machine->functions;
+    if (machine->code[machine->pc].function >= 0) {
+        functions[machine->code[machine->pc].function].calls++;
+    }
+
+    int done = 0;
+    while (!done) {
+        if (machine->pc >= machine->count) {
+            snprintf(machine->error, sizeof(machine->error), "ran off the end of .text");
+            return -1;
+        }
+        const SimInstruction *instr = &machine->code[machine->pc++];
+        if (machine->max_steps > 0 && stats->instructions >= machine->max_steps) {
+            return run_error(machine, instr, "stopped after %lld instructions", stats->instructions);
+        }
+        stats->instructions++;
+        stats->native += instr->native;
+        if (instr->function >= 0) {
+            functions[instr->function].instructions++;
+        }
+
+        int32_t a = regs[instr->rs];
+        int32_t b = instr->use_imm ? instr->imm : regs[instr->rt];
+        int32_t result = 0, remainder = 0;
+        unsigned char *at;
+
+        switch (instr->op) {
+            case SIM_ADD: case SIM_SUB: case SIM_AND: case SIM_OR: case SIM_XOR: case SIM_NOR:
+            case SIM_SLT: case SIM_SLTU: case SIM_SLE: case SIM_SLEU: case SIM_SGT: case SIM_SGTU:
+            case SIM_SGE: case SIM_SGEU: case SIM_SEQ: case SIM_SNE: case SIM_MUL:
+            case SIM_SLL: case SIM_SRL: case SIM_SRA:
+                regs[instr->rd] = alu(instr->op, a, b);
+                break;
+
+            case SIM_QUOT: case SIM_REM: case SIM_QUOTU: case SIM_REMU:
+                if (b == 0) {
+                    return run_error(machine, instr, "division by zero");
+                }
+                if (instr->op == SIM_QUOT || instr->op == SIM_REM) {
+                    divide(a, b, &result, &remainder);
+                } else {
+                    result = (int32_t)((uint32_t)a / (uint32_t)b);
+                    remainder = (int32_t)((uint32_t)a % (uint32_t)b);
+                }
+                regs[instr->rd] = (instr->op == SIM_QUOT || instr->op == SIM_QUOTU) ? result : remainder;
+                break;
+
+            case SIM_MOVE: regs[instr->rd] = a; break;
+            case SIM_NEG:  regs[instr->rd] = (int32_t)(0u - (uint32_t)a); break;
+            case SIM_NOT:  regs[instr->rd] = ~a; break;
+            case SIM_LI:   regs[instr->rd] = instr->imm; break;
+
+            case SIM_MULT: {
+                int64_t product = (int64_t)a * (int64_t)b;
+                machine->lo = (int32_t)(uint32_t)product;
+                machine->hi = (int32_t)(uint32_t)((uint64_t)product >> 32);
+                break;
+            }
+            case SIM_MULTU: {
+                uint64_t product = (uint64_t)(uint32_t)a * (uint64_t)(uint32_t)b;
+                machine->lo = (int32_t)(uint32_t)product;
+                machine->hi = (int32_t)(uint32_t)(product >> 32);
+                break;
+            }
+            case SIM_DIV:
+                /* The hardware leaves HI and LO unpredictable on a zero divisor */
+                if (b != 0) divide(a, b, &machine->lo, &machine->hi);
+                break;
+            case SIM_DIVU:
+                if (b != 0) {
+                    machine->lo = (int32_t)((uint32_t)a / (uint32_t)b);
+                    machine->hi = (int32_t)((uint32_t)a % (uint32_t)b);
+                }
+                break;
+            case SIM_MFHI: regs[instr->rd] = machine->hi; break;
+            case SIM_MFLO: regs[instr->rd] = machine->lo; break;
+            case SIM_MTHI: machine->hi = a; break;
+            case SIM_MTLO: machine->lo = a; break;
+
+            case SIM_LW: case SIM_LH: case SIM_LHU: case SIM_LB: case SIM_LBU: {
+                uint32_t size = (instr->op == SIM_LW) ? 4 : (instr->op == SIM_LH || instr->op == SIM_LHU) ? 2 : 1;
+                uint32_t address = (uint32_t)a + (uint32_t)instr->imm;
+                if (address % size != 0 || (at = memory_at(machine, address, size)) == NULL) {
+                    return run_error(machine, instr, "load from bad address 0x%08x", address);
+                }
+                uint32_t value = 0;
+                for (uint32_t i = 0; i < size; i++) {
+                    value |= (uint32_t)at[i] << (8 * i);
+                }
+                if (instr->op == SIM_LH) value = (uint32_t)(int32_t)(int16_t)value;
+                if (instr->op == SIM_LB) value = (uint32_t)(int32_t)(int8_t)value;
+                regs[instr->rt] = (int32_t)value;
+                stats->loads++;
+                break;
+            }
+            case SIM_SW: case SIM_SH: case SIM_SB: {
+                uint32_t size = (instr->op == SIM_SW) ? 4 : (instr->op == SIM_SH) ? 2 : 1;
+                uint32_t address = (uint32_t)a + (uint32_t)instr->imm;
+                if (address % size != 0 || (at = memory_at(machine, address, size)) == NULL) {
+                    return run_error(machine, instr, "store to bad address 0x%08x", address);
+                }
+                store_bytes(at, (uint32_t)regs[instr->rt], (int)size);
+                stats->stores++;
+                break;
+            }
+
+            case SIM_BEQ: case SIM_BNE: case SIM_BLT: case SIM_BLE: case SIM_BGT: case SIM_BGE:
+            case SIM_BLTU: case SIM_BLEU: case SIM_BGTU: case SIM_BGEU:
+                stats->branches++;
+                if (compare(instr->op, a, b)) {
+                    stats->taken++;
+                    machine->pc = instr->target;
+                }
+                break;
+
+            case SIM_J:
+                stats->jumps++;
+                machine->pc = instr->target;
+                break;
+            case SIM_JAL:
+                stats->jumps++;
+                stats->calls++;
+                regs[31] = (int32_t)(SIM_TEXT_BASE + 4 * (uint32_t)machine->pc);
+                machine->pc = instr->target;
+                if (machine->code[instr->target].function >= 0) {
+                    functions[machine->code[instr->target].function].calls++;
+                }
+                break;
+            case SIM_JR:
+                stats->jumps++;
+                if (jump_to(machine, instr, (uint32_t)a, &done) != 0) return -1;
+                break;
+            case SIM_JALR:
+                stats->jumps++;
+                stats->calls++;
+                regs[instr->rd] = (int32_t)(SIM_TEXT_BASE + 4 * (uint32_t)machine->pc);
+                if (jump_to(machine, instr, (uint32_t)a, &done) != 0) return -1;
+                break;
+
+            case SIM_SYSCALL:
+                stats->syscalls++;
+                if (do_syscall(machine, instr, &done) != 0) return -1;
+                break;
+            case SIM_NOP:
+                break;
+        }
+        regs[0] = 0;
+    }
+
+    fflush(machine->output);
+    return 0;
+}
+
+/* Machine words the loaded program's text expands to */
+int sim_code_words(MIPSMachine *machine) {
+    int words = 0;
+    for (int i = 0; i < machine->count; i++) {
+        words += machine->code[i].native;
+    }
+    return words;
+}
+
+void sim_free(MIPSMachine *machine) {
+    for (int i = 0; i < machine->label_count; i++) {
+        free(machine->labels[i].name);
+    }
+    free(machine->labels);
+    free(machine->code);
+    free(machine->functions);
+    free(machine->data);
+    free(machine->stack);
+    memset(machine, 0, sizeof(MIPSMachine));
+}
@@ -0,0 +1,175 @@
+/*
+ * MIPS Simulator Driver
+ * CST-405 Compiler Design
+ *
+ * cminus-sim runs the assembly cminus writes, without SPIM or MARS, and
+ * reports what it executed: instructions (as written and as machine
+ * instructions), loads, stores, branches and calls.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "sim.h"
+
+/* Statistics output */
+typedef enum {
+    STATS_TEXT,
+    STATS_JSON,
+    STATS_NONE
+} StatsFormat;
+
+static int compare_profile(const void *a, const void *b) {
+    const SimFunction *fa = (const SimFunction *)a;
+    const SimFunction *fb = (const SimFunction *)b;
+    if (fa->instructions != fb->instructions) {
+        return (fa->instructions < fb->instructions) ? 1 : -1;
+    }
+    return fa->start - fb->start;
+}
+
+static void print_stats(MIPSMachine *machine, const char *filename, StatsFormat format, FILE *out) {
+    SimStats *stats = &machine->stats;
+    int words = sim_code_words(machine);
+
+    if (format == STATS_JSON) {
+        fprintf(out, "{\"file\": \"%s\", \"exit_code\": %d, \"instructions\": %lld, "
+                     "\"machine_instructions\": %lld, \"loads\": %lld, \"stores\": %lld, "
+                     "\"branches\": %lld, \"branches_taken\": %lld, \"jumps\": %lld, "
+                     "\"calls\": %lld, \"syscalls\": %lld, \"code_instructions\": %d, "
+                     "\"code_words\": %d}\n",
+                filename, machine->exit_code, stats->instructions, stats->native,
+                stats->loads, stats->stores, stats->branches, stats->taken, stats->jumps,
+                stats->calls, stats->syscalls, machine->count, words);
+        return;
+    }
+
+    fprintf(out, "\n=== SIMULATION STATISTICS ===\n");
+    fprintf(out, "Instructions executed:  %lld\n", stats->instructions);
+    fprintf(out, "Machine instructions:   %lld\n", stats->native);
+    fprintf(out, "Loads:                  %lld\n", stats->loads);
+    fprintf(out, "Stores:                 %lld\n", stats->stores);
+    fprintf(out, "Branches:               %lld (%lld taken)\n", stats->branches, stats->taken);
+    fprintf(out, "Jumps:                  %lld (%lld calls)\n", stats->jumps, stats->calls);
+    fprintf(out, "Syscalls:               %lld\n", stats->syscalls);
+    fprintf(out, "Code size:              %d instructions, %d machine words\n",
+            machine->count, words);
+}
+
+static void print_profile(MIPSMachine *machine, FILE *out) {
+    SimFunction *sorted = (SimFunction *)malloc((machine->function_count + 1) * sizeof(SimFunction));
+    if (sorted == NULL) return;
+    memcpy(sorted, machine->functions, machine->function_count * sizeof(SimFunction));
+    qsort(sorted, machine->function_count, sizeof(SimFunction), compare_profile);
+
+    fprintf(out, "\n=== PROFILE ===\n");
+    fprintf(out, "%-24s %12s %14s %8s\n", "Function", "Calls", "Instructions", "Share");
+    for (int f = 0; f < machine->function_count; f++) {
+        double share = machine->stats.instructions
+                     ? 100.0 * sorted[f].instructions / machine->stats.instructions : 0;
+        fprintf(out, "%-24s %12lld %14lld %7.1f%%\n", sorted[f].name, sorted[f].calls,
+                sorted[f].instructions, share);
+    }
+    free(sorted);
+}
+
+static void print_usage(const char *program_name) {
+    printf("\nUsage: %s [options] program.s\n", program_name);
+    printf("\nRuns MIPS assembly from cminus. Program output goes to standard output,\n");
+    printf("statistics to standard error.\n");
+    printf("\nOptions:\n");
+    printf("  -h, --help           Show this help message\n");
+    printf("  -i, --input <file>   Read the program's input from file\n");
+    printf("  -m, --max-steps <n>  Stop with an error after n instructions\n");
+    printf("  -p, --profile        Show instructions executed per function\n");
+    printf("  -j, --json           Statistics as one JSON line\n");
+    printf("  -q, --quiet          No statistics\n");
+    printf("\nExit status is the program's (0 unless it uses exit2), or 1 if the\n");
+    printf("program cannot be loaded or faults.\n\n");
+}
+
+int main(int argc, char *argv[]) {
+    static struct option long_options[] = {
+        {"help",      no_argument,       0, 'h'},
+        {"input",     required_argument, 0, 'i'},
+        {"max-steps", required_argument, 0, 'm'},
+        {"profile",   no_argument,       0, 'p'},
+        {"json",      no_argument,       0, 'j'},
+        {"quiet",     no_argument,       0, 'q'},
+        {0, 0, 0, 0}
+    };
+
+    const char *input_name = NULL;
+    long long max_steps = 0;
+    int profile = 0;
+    StatsFormat format = STATS_TEXT;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "hi:m:pjq", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            case 'i':
+                input_name = optarg;
+                break;
+            case 'm':
+                max_steps = atoll(optarg);
+                break;
+            case 'p':
+                profile = 1;
+                break;
+            case 'j':
+                format = STATS_JSON;
+                break;
+            case 'q':
+                format = STATS_NONE;
+                break;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "Error: expected one assembly file\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+    const char *filename = argv[optind];
+
+    MIPSMachine machine;
+    if (sim_load(&machine, filename) != 0) {
+        fprintf(stderr, "Error: %s\n", machine.error);
+        sim_free(&machine);
+        return 1;
+    }
+    if (input_name != NULL) {
+        machine.input = fopen(input_name, "r");
+        if (machine.input == NULL) {
+            fprintf(stderr, "Error: Cannot open input file %s\n", input_name);
+            sim_free(&machine);
+            return 1;
+        }
+    }
+    machine.max_steps = max_steps;
+
+    int status = sim_run(&machine);
+    fflush(stdout);
+    if (status != 0) {
+        fprintf(stderr, "Error: %s: %s\n", filename, machine.error);
+    }
+    if (format != STATS_NONE) {
+        print_stats(&machine, filename, format, stderr);
+    }
+    if (profile) {
+        print_profile(&machine, stderr);
+    }
+
+    int exit_code = (status != 0) ? 1 : machine.exit_code;
+    if (input_name != NULL) {
+        fclose(machine.input);
+    }
+    sim_free(&machine);
+    return exit_code;
+}
@@ -0,0 +1,97 @@
+/*
+ * Source Input Implementation
+ * CST-405 Compiler Design
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "source.h"
+
+/* Map a regular file followed by two zero bytes
+ *
+ * A zeroed anonymous region covering the text and both sentinels is
+ * reserved first and the file is mapped over its front. The tail of the
+ * file's last page reads as zero, and so do the reserved pages past it,
+ * so the sentinels are in place however the size falls against a page
+ * boundary. The mapping is private and writable because flex briefly
+ * stores a NUL after each token it matches, so every page is eventually
+ * copied on write.
+ */
+static int map_source(int fd, size_t size, SourceInput *source) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t length = (size + 2 + page - 1) & ~(page - 1);
+
+    char *base = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return 0;
+    }
+
+    if (size > 0) {
+        if (mmap(base, size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            munmap(base, length);
+            return 0;
+        }
+#ifdef MADV_POPULATE_WRITE
+        /* Take the copy-on-write faults in one call rather than one per page */
+        madvise(base, size, MADV_POPULATE_WRITE);
+#else
+        madvise(base, size, MADV_SEQUENTIAL);
+#endif
+    }
+
+    source->text = base;
+    source->size = size;
+    source->mapped = length;
+    return 1;
+}
+
+/* Open a source file, mapping it when possible */
+int open_source(const char *filename, SourceInput *source, Boolean allow_map) {
+    source->text = NULL;
+    source->size = 0;
+    source->mapped = 0;
+    source->file = NULL;
+
+    if (strcmp(filename, "-") == 0) {
+        source->file = stdin;
+        return 0;
+    }
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat info;
+    if (allow_map && fstat(fd, &info) == 0 && S_ISREG(info.st_mode) &&
+        map_source(fd, (size_t)info.st_size, source)) {
+        close(fd);
+        return 0;
+    }
+
+    /* Pipes, devices, or a failed mapping: fall back to buffered reads */
+    source->file = fdopen(fd, "r");
+    if (source->file == NULL) {
+        close(fd);
+        return -1;
+    }
+    return 0;
+}
+
+/* Release a source opened with open_source */
+void close_source(SourceInput *source) {
+    if (source->text) {
+        munmap(source->text, source->mapped);
+    } else if (source->file && source->file != stdin) {
+        fclose(source->file);
+    }
+    source->text = NULL;
+    source->file = NULL;
+}
@@ -6,165 +6,210 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "symtab.h"
-#include "globals.h"
+#include "context.h"
 
-/* Global variables */
-Scope *current_scope = NULL;
-Scope *global_scope = NULL;
-static int global_offset = 0;
+/*
+ * The table lives in the compilation context. Every entry ever inserted is
+ * also kept in symbol_list, indexed by its ID: entries outlive their scope
+ * so later phases can refer to them by ID.
+ */
+
+/* Hash function for symbol table
+ * Names are interned, so their dense ID is already a perfect hash.
+ */
+int hash_function(CompilationContext *ctx, char *name) {
+    return intern_id(name) & (ctx->symtab.binding_capacity - 1);
+}
 
-/* Hash function for symbol table */
-int hash_function(char *name) {
-    unsigned int hash = 0;
-    while (*name) {
-        hash = (hash << 4) + *name++;
-        unsigned int g = hash & 0xf0000000;
-        if (g) {
-            hash ^= g >> 24;
-            hash &= ~g;
+/* Find the slot for a name: its own slot, or the empty one it would take */
+static Binding *find_binding(SymbolTable *table, char *name) {
+    int index = intern_id(name) & (table->binding_capacity - 1);
+    while (table->bindings[index].name && table->bindings[index].name != name) {
+        index = (index + 1) & (table->binding_capacity - 1);
+    }
+    return &table->bindings[index];
+}
+
+/* Double the binding table and reinsert every name */
+static void grow_bindings(SymbolTable *table) {
+    Binding *old = table->bindings;
+    int old_capacity = table->binding_capacity;
+    
+    table->binding_capacity = old_capacity ? old_capacity * 2 : SYMTAB_SIZE;
+    table->bindings = (Binding *)safe_calloc(table->binding_capacity, sizeof(Binding));
+    for (int i = 0; i < old_capacity; i++) {
+        if (old[i].name) {
+            *find_binding(table, old[i].name) = old[i];
         }
     }
-    return hash % SYMTAB_SIZE;
+    free(old);
+}
+
+/* Create an empty scope nested in the current one */
+static Scope *new_scope(CompilationContext *ctx) {
+    SymbolTable *table = &ctx->symtab;
+    Scope *scope = (Scope *)arena_alloc(REGION(ctx, REGION_SEMANTIC), sizeof(Scope));
+    scope->level = table->current_scope ? table->current_scope->level + 1 : 0;
+    scope->offset = 0;
+    scope->parent = table->current_scope;
+    scope->entries = NULL;
+    scope->last_entry = NULL;
+    return scope;
 }
 
 /* Initialize symbol table */
-void init_symbol_table(void) {
-    global_scope = (Scope *)malloc(sizeof(Scope));
-    global_scope->level = 0;
-    global_scope->offset = 0;
-    global_scope->parent = NULL;
-    global_scope->table = (SymbolEntry **)calloc(SYMTAB_SIZE, sizeof(SymbolEntry *));
-    current_scope = global_scope;
+void init_symbol_table(CompilationContext *ctx) {
+    SymbolTable *table = &ctx->symtab;
+    free(table->bindings);
+    table->bindings = NULL;
+    table->binding_capacity = 0;
+    table->binding_count = 0;
+    grow_bindings(table);
+    table->symbol_count = 0;
+    
+    table->current_scope = NULL;
+    table->global_scope = new_scope(ctx);
+    table->current_scope = table->global_scope;
     
     /* Insert built-in functions */
-    SymbolEntry *input_func = insert_symbol("input", SYMBOL_FUNCTION, TYPE_FUNCTION);
+    SymbolEntry *input_func = insert_symbol(ctx, intern_string(ctx, "input"), SYMBOL_FUNCTION, TYPE_FUNCTION);
     input_func->param_count = 0;
     
-    SymbolEntry *output_func = insert_symbol("output", SYMBOL_FUNCTION, TYPE_FUNCTION);
+    SymbolEntry *output_func = insert_symbol(ctx, intern_string(ctx, "output"), SYMBOL_FUNCTION, TYPE_FUNCTION);
     output_func->param_count = 1;
-    SymbolEntry *output_param = (SymbolEntry *)malloc(sizeof(SymbolEntry));
-    output_param->name = copy_string("value");
+    SymbolEntry *output_param = (SymbolEntry *)arena_calloc(REGION(ctx, REGION_SEMANTIC),
+                                                            1, sizeof(SymbolEntry));
+    output_param->name = intern_string(ctx, "value");
     output_param->kind = SYMBOL_PARAM;
     output_param->type = TYPE_INT;
     output_param->next = NULL;
     output_func->params = output_param;
+    
+    table->input_func = input_func;
+    table->output_func = output_func;
+    table->main_func = NULL;
 }
 
 /* Enter a new scope */
-void enter_scope(void) {
-    Scope *new_scope = (Scope *)malloc(sizeof(Scope));
-    new_scope->level = current_scope->level + 1;
-    new_scope->offset = 0;
-    new_scope->parent = current_scope;
-    new_scope->table = (SymbolEntry **)calloc(SYMTAB_SIZE, sizeof(SymbolEntry *));
-    current_scope = new_scope;
+void enter_scope(CompilationContext *ctx) {
+    ctx->symtab.current_scope = new_scope(ctx);
 }
 
-/* Exit current scope */
-void exit_scope(void) {
-    if (current_scope != global_scope) {
-        Scope *old_scope = current_scope;
-        current_scope = current_scope->parent;
+/* Exit current scope, popping the bindings it declared */
+void exit_scope(CompilationContext *ctx) {
+    SymbolTable *table = &ctx->symtab;
+    if (table->current_scope != table->global_scope) {
+        Scope *old_scope = table->current_scope;
+        table->current_scope = table->current_scope->parent;
         
-        /* Check for unused symbols before freeing */
-        for (int i = 0; i < SYMTAB_SIZE; i++) {
-            SymbolEntry *entry = old_scope->table[i];
-            while (entry) {
-                if (!entry->is_used && entry->kind != SYMBOL_FUNCTION) {
-                    warning("Variable '%s' declared but never used (line %d)", 
-                            entry->name, entry->line_number);
-                }
-                entry = entry->next;
+        for (SymbolEntry *entry = old_scope->entries; entry; entry = entry->scope_next) {
+            /* Check for unused symbols before popping */
+            if (!entry->is_used && entry->kind != SYMBOL_FUNCTION) {
+                warning(ctx, "Variable '%s' declared but never used (line %d)", 
+                        entry->name, entry->line_number);
             }
+            
+            find_binding(table, entry->name)->binding = entry->shadowed;
         }
         
-        /* Note: In a real compiler, we might want to keep the scope
-           for later phases, but for demonstration we'll free it */
-        free(old_scope->table);
-        free(old_scope);
+        /* The scope itself lives in the semantic region and is
+           released together with the rest of the symbol table */
     }
 }
 
-/* Insert a symbol into the current scope */
-SymbolEntry *insert_symbol(char *name, SymbolKind kind, DataType type) {
-    int index = hash_function(name);
+/* Insert a symbol into the current scope (name must be interned) */
+SymbolEntry *insert_symbol(CompilationContext *ctx, char *name, SymbolKind kind, DataType type) {
+    SymbolTable *table = &ctx->symtab;
+    if (2 * (table->binding_count + 1) > table->binding_capacity) {
+        grow_bindings(table);
+    }
     
     /* Check if symbol already exists in current scope */
-    SymbolEntry *entry = current_scope->table[index];
-    while (entry) {
-        if (strcmp(entry->name, name) == 0) {
-            error("Symbol '%s' already declared in this scope", name);
-            return NULL;
-        }
-        entry = entry->next;
+    Binding *slot = find_binding(table, name);
+    if (slot->binding && slot->binding->scope_level == table->current_scope->level) {
+        error(ctx, "Symbol '%s' already declared in this scope", name);
+        return NULL;
     }
     
     /* Create new symbol entry */
-    SymbolEntry *new_entry = (SymbolEntry *)malloc(sizeof(SymbolEntry));
-    new_entry->name = copy_string(name);
+    SymbolEntry *new_entry = (SymbolEntry *)arena_alloc(REGION(ctx, REGION_SEMANTIC),
+                                                        sizeof(SymbolEntry));
+    new_entry->name = name;
     new_entry->kind = kind;
     new_entry->type = type;
-    new_entry->scope_level = current_scope->level;
-    new_entry->line_number = linenum;
+    new_entry->scope_level = table->current_scope->level;
+    new_entry->line_number = ctx->line;
     new_entry->is_used = 0;
     new_entry->params = NULL;
     new_entry->param_count = 0;
+    new_entry->frame_size = 0;
+    new_entry->next = NULL;
+    new_entry->scope_next = NULL;
     
     /* Allocate memory based on kind and scope */
     if (kind == SYMBOL_VAR || kind == SYMBOL_PARAM) {
         new_entry->size = 1;
-        if (current_scope->level == 0) {
-            new_entry->memory_location = global_offset;
-            global_offset += 4;  /* 4 bytes for int */
+        if (table->current_scope->level == 0) {
+            new_entry->memory_location = table->global_offset;
+            table->global_offset += 4;  /* 4 bytes for int */
         } else {
-            new_entry->memory_location = current_scope->offset;
-            current_scope->offset += 4;
+            new_entry->memory_location = table->current_scope->offset;
+            table->current_scope->offset += 4;
         }
     } else if (kind == SYMBOL_ARRAY) {
         /* Size will be set separately */
         new_entry->size = 0;
-        new_entry->memory_location = current_scope->offset;
+        new_entry->memory_location = table->current_scope->offset;
     } else if (kind == SYMBOL_FUNCTION) {
         new_entry->memory_location = -1;  /* Functions don't have memory location */
     }
     
-    /* Insert at beginning of hash chain */
-    new_entry->next = current_scope->table[index];
-    current_scope->table[index] = new_entry;
+    /* Assign the next dense ID */
+    if (table->symbol_count >= table->symbol_capacity) {
+        table->symbol_capacity = table->symbol_capacity ? table->symbol_capacity * 2 : SYMTAB_SIZE;
+        table->symbol_list = (SymbolEntry **)safe_realloc(table->symbol_list,
+                                                   table->symbol_capacity * sizeof(SymbolEntry *));
+    }
+    new_entry->id = table->symbol_count;
+    table->symbol_list[table->symbol_count++] = new_entry;
+    
+    /* Push onto the name's binding stack */
+    if (slot->name == NULL) {
+        slot->name = name;
+        table->binding_count++;
+    }
+    new_entry->shadowed = slot->binding;
+    slot->binding = new_entry;
+    
+    /* Record in the scope's undo log */
+    if (table->current_scope->last_entry) {
+        table->current_scope->last_entry->scope_next = new_entry;
+    } else {
+        table->current_scope->entries = new_entry;
+    }
+    table->current_scope->last_entry = new_entry;
     
     return new_entry;
 }
 
-/* Lookup a symbol in all visible scopes */
-SymbolEntry *lookup_symbol(char *name) {
-    Scope *scope = current_scope;
-    
-    while (scope) {
-        SymbolEntry *entry = lookup_symbol_in_scope(name, scope);
-        if (entry) {
-            entry->is_used = 1;
-            return entry;
-        }
-        scope = scope->parent;
+/* Lookup a symbol in all visible scopes (name must be interned) */
+SymbolEntry *lookup_symbol(CompilationContext *ctx, char *name) {
+    SymbolEntry *entry = find_binding(&ctx->symtab, name)->binding;
+    if (entry) {
+        entry->is_used = 1;
     }
-    
-    return NULL;
+    return entry;
 }
 
 /* Lookup a symbol in a specific scope */
-SymbolEntry *lookup_symbol_in_scope(char *name, Scope *scope) {
-    int index = hash_function(name);
-    SymbolEntry *entry = scope->table[index];
+SymbolEntry *lookup_symbol_in_scope(CompilationContext *ctx, char *name, Scope *scope) {
+    SymbolEntry *entry = find_binding(&ctx->symtab, name)->binding;
     
-    while (entry) {
-        if (strcmp(entry->name, name) == 0) {
-            return entry;
-        }
-        entry = entry->next;
+    while (entry && entry->scope_level > scope->level) {
+        entry = entry->shadowed;
     }
     
-    return NULL;
+    return (entry && entry->scope_level == scope->level) ? entry : NULL;
 }
 
 /* Set the type of a symbol */
@@ -190,34 +235,47 @@ void add_param_to_function(SymbolEntry *func, SymbolEntry *param) {
     }
 }
 
+/* Get a symbol by its ID */
+SymbolEntry *symbol_by_id(CompilationContext *ctx, int id) {
+    return ctx->symtab.symbol_list[id];
+}
+
+/* Check whether a symbol has static storage */
+int is_global_symbol(SymbolEntry *symbol) {
+    return symbol->scope_level == 0;
+}
+
+/* Check whether a symbol is the built-in input or output routine */
+int is_builtin_function(CompilationContext *ctx, SymbolEntry *symbol) {
+    return symbol != NULL &&
+           (symbol == ctx->symtab.input_func || symbol == ctx->symtab.output_func);
+}
+
 /* Print entire symbol table */
-void print_symbol_table(void) {
-    printf("\n=== SYMBOL TABLE ===\n");
-    printf("%-15s %-10s %-10s %-8s %-8s %-8s\n", 
-           "Name", "Kind", "Type", "Scope", "Memory", "Line");
-    printf("----------------------------------------------------------------\n");
+void print_symbol_table(CompilationContext *ctx) {
+    SymbolTable *table = &ctx->symtab;
+    fprintf(ctx->report, "\n=== SYMBOL TABLE ===\n");
+    fprintf(ctx->report, "%-15s %-10s %-10s %-8s %-8s %-8s\n", 
+            "Name", "Kind", "Type", "Scope", "Memory", "Line");
+    fprintf(ctx->report, "----------------------------------------------------------------\n");
     
-    Scope *scope = current_scope;
+    Scope *scope = table->current_scope;
     while (scope) {
-        print_scope(scope);
+        print_scope(ctx, scope);
         scope = scope->parent;
     }
-    printf("\n");
+    fprintf(ctx->report, "\n");
 }
 
 /* Print a specific scope */
-void print_scope(Scope *scope) {
-    for (int i = 0; i < SYMTAB_SIZE; i++) {
-        SymbolEntry *entry = scope->table[i];
-        while (entry) {
-            print_symbol(entry);
-            entry = entry->next;
-        }
+void print_scope(CompilationContext *ctx, Scope *scope) {
+    for (SymbolEntry *entry = scope->entries; entry; entry = entry->scope_next) {
+        print_symbol(ctx, entry);
     }
 }
 
 /* Print a single symbol */
-void print_symbol(SymbolEntry *symbol) {
+void print_symbol(CompilationContext *ctx, SymbolEntry *symbol) {
     char *kind_str;
     switch (symbol->kind) {
         case SYMBOL_VAR: kind_str = "Variable"; break;
@@ -236,34 +294,32 @@ void print_symbol(SymbolEntry *symbol) {
         default: type_str = "error"; break;
     }
     
-    printf("%-15s %-10s %-10s %-8d %-8d %-8d", 
-           symbol->name, kind_str, type_str,
-           symbol->scope_level, symbol->memory_location, symbol->line_number);
+    fprintf(ctx->report, "%-15s %-10s %-10s %-8d %-8d %-8d", 
+            symbol->name, kind_str, type_str,
+            symbol->scope_level, symbol->memory_location, symbol->line_number);
     
     if (symbol->kind == SYMBOL_FUNCTION) {
-        printf(" [%d params]", symbol->param_count);
+        fprintf(ctx->report, " [%d params]", symbol->param_count);
     } else if (symbol->kind == SYMBOL_ARRAY) {
-        printf(" [size: %d]", symbol->size);
+        fprintf(ctx->report, " [size: %d]", symbol->size);
     }
     
-    printf("\n");
+    fprintf(ctx->report, "\n");
 }
 
 /* Check for unused symbols */
-void check_unused_symbols(void) {
-    Scope *scope = current_scope;
+void check_unused_symbols(CompilationContext *ctx) {
+    SymbolTable *table = &ctx->symtab;
+    Scope *scope = table->current_scope;
+    char *main_name = intern_string(ctx, "main");
     
     while (scope) {
-        for (int i = 0; i < SYMTAB_SIZE; i++) {
-            SymbolEntry *entry = scope->table[i];
-            while (entry) {
-                if (!entry->is_used && 
-                    entry->kind != SYMBOL_FUNCTION &&
-                    strcmp(entry->name, "main") != 0) {
-                    warning("Symbol '%s' declared but never used (line %d)",
-                            entry->name, entry->line_number);
-                }
-                entry = entry->next;
+        for (SymbolEntry *entry = scope->entries; entry; entry = entry->scope_next) {
+            if (!entry->is_used && 
+                entry->kind != SYMBOL_FUNCTION &&
+                entry->name != main_name) {
+                warning(ctx, "Symbol '%s' declared but never used (line %d)",
+                        entry->name, entry->line_number);
             }
         }
         scope = scope->parent;
@@ -271,17 +327,14 @@ void check_unused_symbols(void) {
 }
 
 /* Get total symbol count */
-int get_symbol_count(void) {
+int get_symbol_count(CompilationContext *ctx) {
+    SymbolTable *table = &ctx->symtab;
     int count = 0;
-    Scope *scope = current_scope;
+    Scope *scope = table->current_scope;
     
     while (scope) {
-        for (int i = 0; i < SYMTAB_SIZE; i++) {
-            SymbolEntry *entry = scope->table[i];
-            while (entry) {
-                count++;
-                entry = entry->next;
-            }
+        for (SymbolEntry *entry = scope->entries; entry; entry = entry->scope_next) {
+            count++;
         }
         scope = scope->parent;
     }
@@ -290,24 +343,40 @@ int get_symbol_count(void) {
 }
 
 /* Get current scope depth */
-int get_scope_depth(void) {
-    return current_scope ? current_scope->level : -1;
+int get_scope_depth(CompilationContext *ctx) {
+    return ctx->symtab.current_scope ? ctx->symtab.current_scope->level : -1;
 }
 
 /* Allocate memory */
-int allocate_memory(int size) {
-    int location = current_scope->offset;
-    current_scope->offset += size;
+int allocate_memory(CompilationContext *ctx, int size) {
+    SymbolTable *table = &ctx->symtab;
+    int location = table->current_scope->offset;
+    table->current_scope->offset += size;
     return location;
 }
 
 /* Get current offset */
-int get_current_offset(void) {
-    return current_scope->offset;
+int get_current_offset(CompilationContext *ctx) {
+    return ctx->symtab.current_scope->offset;
 }
 
 /* Free symbol table */
-void free_symbol_table(void) {
-    /* In a real implementation, we would properly free all memory */
-    /* For now, this is a placeholder */
+void free_symbol_table(CompilationContext *ctx) {
+    SymbolTable *table = &ctx->symtab;
+    /* Scopes and entries all live in the semantic region */
+    arena_release(REGION(ctx, REGION_SEMANTIC));
+    free(table->bindings);
+    table->bindings = NULL;
+    table->binding_capacity = 0;
+    table->binding_count = 0;
+    free(table->symbol_list);
+    table->symbol_list = NULL;
+    table->symbol_capacity = 0;
+    table->symbol_count = 0;
+    table->current_scope = NULL;
+    table->global_scope = NULL;
+    table->global_offset = 0;
+    table->input_func = NULL;
+    table->output_func = NULL;
+    table->main_func = NULL;
 }
\ No newline at end of file
@@ -0,0 +1,178 @@
+/*
+ * Phase Timing Implementation
+ * CST-405 Compiler Design
+ *
+ * Records wall time, CPU time and region allocations per compiler phase
+ * for --time-report.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "context.h"
+
+/* Read a clock in seconds */
+static double clock_seconds(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* CPU time to charge to a compilation
+ *
+ * A file compiled on its own is the only work in the process, so process
+ * time also covers threads lowering its functions. Batch units and
+ * function contexts share the process and use their thread's time.
+ */
+static double cpu_seconds(CompilationContext *ctx) {
+    return clock_seconds(ctx->timing.thread_cpu ? CLOCK_THREAD_CPUTIME_ID
+                                                : CLOCK_PROCESS_CPUTIME_ID);
+}
+
+/* Row for a phase at a nesting level, added on first use */
+static PhaseTiming *find_phase(TimeReport *report, const char *name, int depth) {
+    for (int i = 0; i < report->count; i++) {
+        if (report->phases[i].depth == depth && strcmp(report->phases[i].name, name) == 0) {
+            return &report->phases[i];
+        }
+    }
+    if (report->count == MAX_TIMED_PHASES) {
+        return NULL;
+    }
+    
+    PhaseTiming *phase = &report->phases[report->count++];
+    memset(phase, 0, sizeof(PhaseTiming));
+    phase->name = name;
+    phase->depth = depth;
+    return phase;
+}
+
+/* Start timing a phase; phases begun before it ends nest under it */
+void begin_phase(CompilationContext *ctx, PhaseClock *clock, const char *name) {
+    clock->index = -1;
+    if (time_report == TIME_REPORT_NONE) return;
+    
+    TimeReport *report = &ctx->timing;
+    PhaseTiming *phase = find_phase(report, name, report->depth);
+    if (phase == NULL) return;
+    clock->index = (int)(phase - report->phases);
+    report->depth++;
+    
+    /* Track the phase's own high-water mark from what is live now */
+    RegionUsage *usage = &ctx->memory.usage;
+    clock->allocations = usage->alloc_count;
+    clock->outer_peak = usage->peak_bytes;
+    usage->peak_bytes = usage->live_bytes;
+    
+    clock->cpu = cpu_seconds(ctx);
+    clock->wall = clock_seconds(CLOCK_MONOTONIC);
+}
+
+/* Stop timing a phase and add its cost to the report */
+void end_phase(CompilationContext *ctx, PhaseClock *clock) {
+    if (clock->index < 0) return;
+    
+    double wall = clock_seconds(CLOCK_MONOTONIC);
+    double cpu = cpu_seconds(ctx);
+    TimeReport *report = &ctx->timing;
+    PhaseTiming *phase = &report->phases[clock->index];
+    RegionUsage *usage = &ctx->memory.usage;
+    
+    phase->runs++;
+    phase->wall += wall - clock->wall;
+    phase->cpu += cpu - clock->cpu;
+    phase->allocations += usage->alloc_count - clock->allocations;
+    if (usage->peak_bytes > phase->peak_bytes) {
+        phase->peak_bytes = usage->peak_bytes;
+    }
+    if (clock->outer_peak > usage->peak_bytes) {
+        usage->peak_bytes = clock->outer_peak;
+    }
+    report->depth--;
+}
+
+/* Add another report's phases under the phases open in this one */
+void merge_time_report(TimeReport *report, const TimeReport *other) {
+    for (int i = 0; i < other->count; i++) {
+        const PhaseTiming *from = &other->phases[i];
+        PhaseTiming *phase = find_phase(report, from->name, report->depth + from->depth);
+        if (phase == NULL) continue;
+        
+        phase->runs += from->runs;
+        phase->wall += from->wall;
+        phase->cpu += from->cpu;
+        phase->allocations += from->allocations;
+        if (from->peak_bytes > phase->peak_bytes) {
+            phase->peak_bytes = from->peak_bytes;
+        }
+    }
+}
+
+/* Write a string as a JSON string literal */
+static void write_json_string(FILE *out, const char *s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fprintf(out, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(out, "\\u%04x", c);
+        } else {
+            fputc(c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+/* Print the report as a table, or as one line of JSON
+ *
+ * Totals add up the outermost phases. Nested rows for optimizer passes
+ * are summed over every function, so with --threads they can add up to
+ * more wall time than the phase around them.
+ */
+void print_time_report(CompilationContext *ctx, FILE *out) {
+    TimeReport *report = &ctx->timing;
+    double total_wall = 0, total_cpu = 0;
+    size_t total_allocations = 0, total_peak = 0;
+    for (int i = 0; i < report->count; i++) {
+        PhaseTiming *phase = &report->phases[i];
+        if (phase->depth > 0) continue;
+        total_wall += phase->wall;
+        total_cpu += phase->cpu;
+        total_allocations += phase->allocations;
+        if (phase->peak_bytes > total_peak) total_peak = phase->peak_bytes;
+    }
+    
+    if (time_report == TIME_REPORT_JSON) {
+        fprintf(out, "{\"file\": ");
+        write_json_string(out, ctx->filename);
+        fprintf(out, ", \"phases\": [");
+        for (int i = 0; i < report->count; i++) {
+            PhaseTiming *phase = &report->phases[i];
+            fprintf(out, "%s{\"name\": ", i > 0 ? ", " : "");
+            write_json_string(out, phase->name);
+            fprintf(out, ", \"depth\": %d, \"runs\": %d, \"wall_ms\": %.3f, \"cpu_ms\": %.3f, "
+                         "\"allocations\": %zu, \"peak_bytes\": %zu}",
+                    phase->depth, phase->runs, phase->wall * 1e3, phase->cpu * 1e3,
+                    phase->allocations, phase->peak_bytes);
+        }
+        fprintf(out, "], \"total\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f, "
+                     "\"allocations\": %zu, \"peak_bytes\": %zu}}\n",
+                total_wall * 1e3, total_cpu * 1e3, total_allocations, total_peak);
+        return;
+    }
+    
+    fprintf(out, "\n=== TIME REPORT: %s ===\n", ctx->filename);
+    fprintf(out, "%-28s %6s %10s %10s %10s %12s\n",
+            "Phase", "Runs", "Wall ms", "CPU ms", "Allocs", "Peak bytes");
+    fprintf(out, "---------------------------------------------------------------------------------\n");
+    for (int i = 0; i < report->count; i++) {
+        PhaseTiming *phase = &report->phases[i];
+        fprintf(out, "%*s%-*s %6d %10.3f %10.3f %10zu %12zu\n",
+                2 * phase->depth, "", 28 - 2 * phase->depth, phase->name, phase->runs,
+                phase->wall * 1e3, phase->cpu * 1e3, phase->allocations, phase->peak_bytes);
+    }
+    fprintf(out, "---------------------------------------------------------------------------------\n");
+    fprintf(out, "%-28s %6s %10.3f %10.3f %10zu %12zu\n",
+            "total", "", total_wall * 1e3, total_cpu * 1e3, total_allocations, total_peak);
+}
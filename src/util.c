@@ -7,12 +7,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <unistd.h>
 #include "util.h"
 #include "globals.h"
-
-/* Global error counters */
-int error_count = 0;
-int warning_count = 0;
+#include "context.h"
 
 /* Debug mode flag */
 static int debug_mode = 0;
@@ -52,29 +52,29 @@ int string_equal(const char *s1, const char *s2) {
 }
 
 /* Report an error */
-void error(const char *format, ...) {
+void error(CompilationContext *ctx, const char *format, ...) {
     va_list args;
     va_start(args, format);
     
-    fprintf(stderr, "Error: ");
-    vfprintf(stderr, format, args);
-    fprintf(stderr, "\n");
+    fprintf(ctx->diagnostics, "Error: ");
+    vfprintf(ctx->diagnostics, format, args);
+    fprintf(ctx->diagnostics, "\n");
     
     va_end(args);
-    error_count++;
+    ctx->error_count++;
 }
 
 /* Report a warning */
-void warning(const char *format, ...) {
+void warning(CompilationContext *ctx, const char *format, ...) {
     va_list args;
     va_start(args, format);
     
-    fprintf(stderr, "Warning: ");
-    vfprintf(stderr, format, args);
-    fprintf(stderr, "\n");
+    fprintf(ctx->diagnostics, "Warning: ");
+    vfprintf(ctx->diagnostics, format, args);
+    fprintf(ctx->diagnostics, "\n");
     
     va_end(args);
-    warning_count++;
+    ctx->warning_count++;
 }
 
 /* Report a fatal error and exit */
@@ -117,6 +117,444 @@ void *safe_realloc(void *ptr, size_t size) {
     return new_ptr;
 }
 
+/* Region allocator
+ *
+ * Chunks of released regions are kept on their compilation's free list
+ * and reused by the next phase, so a full compile touches malloc only a
+ * handful of times.
+ */
+#define ARENA_CHUNK_SIZE (64 * 1024)
+#define ARENA_ALIGN _Alignof(max_align_t)
+
+static const char *region_names[REGION_COUNT] = {
+    "parse", "semantic", "tac", "optimize", "backend", "names"
+};
+
+/* Initialize an empty region */
+void arena_init(Arena *arena, const char *name, ArenaChunk **free_list) {
+    memset(arena, 0, sizeof(Arena));
+    arena->name = name;
+    arena->free_list = free_list;
+}
+
+/* Get a chunk with at least 'size' usable bytes */
+static ArenaChunk *arena_new_chunk(Arena *arena, size_t size) {
+    if (size < ARENA_CHUNK_SIZE) size = ARENA_CHUNK_SIZE;
+
+    /* Reuse the first chunk from a released region that is big enough */
+    for (ArenaChunk **link = arena->free_list; link && *link; link = &(*link)->next) {
+        ArenaChunk *chunk = *link;
+        if (chunk->size >= size) {
+            *link = chunk->next;
+            chunk->used = 0;
+            chunk->next = NULL;
+            return chunk;
+        }
+    }
+
+    ArenaChunk *chunk = (ArenaChunk *)safe_malloc(sizeof(ArenaChunk) + size);
+    chunk->size = size;
+    chunk->used = 0;
+    chunk->next = NULL;
+    return chunk;
+}
+
+#define ARENA_ROUND(size) (((size) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+/* Count bytes handed out by a region */
+static void arena_account(Arena *arena, size_t size) {
+    arena->bytes_used += size;
+    if (arena->bytes_used > arena->peak_bytes) {
+        arena->peak_bytes = arena->bytes_used;
+    }
+
+    RegionUsage *usage = arena->usage;
+    if (usage) {
+        usage->live_bytes += size;
+        if (usage->live_bytes > usage->peak_bytes) {
+            usage->peak_bytes = usage->live_bytes;
+        }
+    }
+}
+
+/* Allocate uninitialized memory from a region */
+void *arena_alloc(Arena *arena, size_t size) {
+    size = ARENA_ROUND(size);
+
+    ArenaChunk *chunk = arena->head;
+    if (chunk == NULL || chunk->size - chunk->used < size) {
+        chunk = arena_new_chunk(arena, size);
+        chunk->next = arena->head;
+        if (arena->head == NULL) arena->tail = chunk;
+        arena->head = chunk;
+        arena->bytes_reserved += chunk->size;
+    }
+
+    void *ptr = chunk->data + chunk->used;
+    chunk->used += size;
+
+    arena->alloc_count++;
+    if (arena->usage) arena->usage->alloc_count++;
+    arena_account(arena, size);
+    return ptr;
+}
+
+/* Grow a block of old_size bytes from a region to new_size bytes
+ *
+ * The region's latest block grows in place while its chunk has room,
+ * and a block larger than a chunk, which has one to itself, is resized
+ * along with it. Any other block is copied to a new one, and the old
+ * block is reclaimed when the region is released. ptr may be NULL.
+ */
+void *arena_grow(Arena *arena, void *ptr, size_t old_size, size_t new_size) {
+    old_size = ARENA_ROUND(old_size);
+    new_size = ARENA_ROUND(new_size);
+
+    ArenaChunk *chunk = arena->head;
+    if (ptr && chunk && (char *)ptr + old_size == chunk->data + chunk->used &&
+        chunk->size - chunk->used >= new_size - old_size) {
+        chunk->used += new_size - old_size;
+        arena_account(arena, new_size - old_size);
+        return ptr;
+    }
+
+    for (ArenaChunk **link = &arena->head; ptr && old_size > ARENA_CHUNK_SIZE && *link;
+         link = &(*link)->next) {
+        chunk = *link;
+        if (chunk->data != ptr) continue;
+        if (chunk->used != old_size) break;
+        ArenaChunk *moved = (ArenaChunk *)safe_realloc(chunk, sizeof(ArenaChunk) + new_size);
+        if (arena->tail == chunk) arena->tail = moved;
+        *link = moved;
+        arena->bytes_reserved += new_size - moved->size;
+        moved->size = new_size;
+        moved->used = new_size;
+        arena_account(arena, new_size - old_size);
+        return moved->data;
+    }
+
+    void *grown = arena_alloc(arena, new_size);
+    if (ptr) memcpy(grown, ptr, old_size);
+    return grown;
+}
+
+/* Allocate zeroed memory from a region */
+void *arena_calloc(Arena *arena, size_t count, size_t size) {
+    void *ptr = arena_alloc(arena, count * size);
+    memset(ptr, 0, count * size);
+    return ptr;
+}
+
+/* Copy a string into a region */
+char *arena_strdup(Arena *arena, const char *s) {
+    if (s == NULL) return NULL;
+
+    size_t len = strlen(s) + 1;
+    char *copy = (char *)arena_alloc(arena, len);
+    memcpy(copy, s, len);
+    return copy;
+}
+
+/* Release everything allocated from a region in O(1) */
+void arena_release(Arena *arena) {
+    if (arena->head && arena->free_list) {
+        arena->tail->next = *arena->free_list;
+        *arena->free_list = arena->head;
+    } else {
+        while (arena->head) {
+            ArenaChunk *next = arena->head->next;
+            free(arena->head);
+            arena->head = next;
+        }
+    }
+    if (arena->usage) {
+        arena->usage->live_bytes -= arena->bytes_used;
+    }
+    arena->head = NULL;
+    arena->tail = NULL;
+    arena->bytes_used = 0;
+    arena->bytes_reserved = 0;
+    arena->release_count++;
+}
+
+/* Set up an empty set of per-phase regions */
+void init_region_set(RegionSet *memory) {
+    memory->free_chunks = NULL;
+    memset(&memory->usage, 0, sizeof(RegionUsage));
+    for (int i = 0; i < REGION_COUNT; i++) {
+        arena_init(&memory->regions[i], region_names[i], &memory->free_chunks);
+        memory->regions[i].usage = &memory->usage;
+    }
+}
+
+/* Release every region of a set and return cached chunks to the system */
+void release_region_set(RegionSet *memory) {
+    for (int i = 0; i < REGION_COUNT; i++) {
+        arena_release(&memory->regions[i]);
+    }
+
+    while (memory->free_chunks) {
+        ArenaChunk *next = memory->free_chunks->next;
+        free(memory->free_chunks);
+        memory->free_chunks = next;
+    }
+}
+
+/* Set up a compilation's per-phase regions and name table */
+void init_regions(CompilationContext *ctx) {
+    init_region_set(&ctx->memory);
+    memset(&ctx->names, 0, sizeof(InternTable));
+}
+
+/* Release every region and the name table */
+void release_all_regions(CompilationContext *ctx) {
+    reset_intern_table(ctx);
+    release_region_set(&ctx->memory);
+}
+
+/* Fold the usage counters of another set's regions into this set's
+ *
+ * The other set's peak is counted on top of what this set holds now, as
+ * it would be had its allocations been made here.
+ */
+void merge_region_usage(RegionSet *memory, const RegionSet *other) {
+    for (int i = 0; i < REGION_COUNT; i++) {
+        Arena *arena = &memory->regions[i];
+        const Arena *from = &other->regions[i];
+        arena->alloc_count += from->alloc_count;
+        if (from->peak_bytes > arena->peak_bytes) {
+            arena->peak_bytes = from->peak_bytes;
+        }
+    }
+
+    memory->usage.alloc_count += other->usage.alloc_count;
+    if (memory->usage.live_bytes + other->usage.peak_bytes > memory->usage.peak_bytes) {
+        memory->usage.peak_bytes = memory->usage.live_bytes + other->usage.peak_bytes;
+    }
+}
+
+/* Print bytes used per region */
+void print_region_report(CompilationContext *ctx, FILE *out) {
+    fprintf(out, "\n=== MEMORY REGIONS ===\n");
+    fprintf(out, "%-10s %12s %12s %12s\n", "Region", "Peak bytes", "Live bytes", "Allocations");
+    fprintf(out, "-----------------------------------------------------\n");
+
+    size_t total_peak = 0;
+    size_t total_allocs = 0;
+    for (int i = 0; i < REGION_COUNT; i++) {
+        Arena *arena = REGION(ctx, i);
+        fprintf(out, "%-10s %12zu %12zu %12zu\n", arena->name,
+                arena->peak_bytes, arena->bytes_used, arena->alloc_count);
+        total_peak += arena->peak_bytes;
+        total_allocs += arena->alloc_count;
+    }
+    fprintf(out, "%-10s %12zu %12s %12zu\n", "total", total_peak, "", total_allocs);
+}
+
+/* Identifier interning
+ *
+ * Open-addressing hash table of InternEntry pointers, kept at most half
+ * full. Entries live in the names region; the slot and ID arrays grow
+ * geometrically.
+ */
+
+/* FNV-1a hash of a string */
+static unsigned int intern_hash(const char *s, size_t *length) {
+    unsigned int hash = 2166136261u;
+    const char *p = s;
+    while (*p) {
+        hash ^= (unsigned char)*p++;
+        hash *= 16777619u;
+    }
+    *length = (size_t)(p - s);
+    return hash;
+}
+
+/* Double the slot array and reinsert every entry */
+static void intern_grow(InternTable *table) {
+    int new_capacity = table->capacity ? table->capacity * 2 : 1024;
+    InternEntry **new_slots = (InternEntry **)safe_calloc(new_capacity, sizeof(InternEntry *));
+
+    for (int i = 0; i < table->count; i++) {
+        InternEntry *entry = table->by_id[i];
+        int slot = entry->hash & (new_capacity - 1);
+        while (new_slots[slot]) {
+            slot = (slot + 1) & (new_capacity - 1);
+        }
+        new_slots[slot] = entry;
+    }
+
+    free(table->slots);
+    table->slots = new_slots;
+    table->capacity = new_capacity;
+}
+
+/* Return the canonical copy of a string, adding it if needed */
+char *intern_string(CompilationContext *ctx, const char *s) {
+    if (s == NULL) return NULL;
+
+    InternTable *table = &ctx->names;
+    if (2 * (table->count + 1) > table->capacity) {
+        intern_grow(table);
+    }
+
+    size_t length;
+    unsigned int hash = intern_hash(s, &length);
+    int slot = hash & (table->capacity - 1);
+
+    while (table->slots[slot]) {
+        InternEntry *entry = table->slots[slot];
+        if (entry->hash == hash && strcmp(entry->name, s) == 0) {
+            return entry->name;
+        }
+        slot = (slot + 1) & (table->capacity - 1);
+    }
+
+    InternEntry *entry = (InternEntry *)arena_alloc(REGION(ctx, REGION_NAMES),
+                                                    sizeof(InternEntry) + length + 1);
+    entry->hash = hash;
+    entry->id = table->count;
+    memcpy(entry->name, s, length + 1);
+    table->slots[slot] = entry;
+
+    if (table->count == table->id_capacity) {
+        table->id_capacity = table->id_capacity ? table->id_capacity * 2 : 1024;
+        table->by_id = (InternEntry **)safe_realloc(table->by_id,
+                                                    table->id_capacity * sizeof(InternEntry *));
+    }
+    table->by_id[table->count++] = entry;
+
+    return entry->name;
+}
+
+/* Get the name for a dense ID */
+char *intern_name(CompilationContext *ctx, int id) {
+    if (id < 0 || id >= ctx->names.count) return NULL;
+    return ctx->names.by_id[id]->name;
+}
+
+/* Get the dense ID of an interned string */
+int intern_id(const char *interned) {
+    const InternEntry *entry = (const InternEntry *)(interned - offsetof(InternEntry, name));
+    return entry->id;
+}
+
+/* Number of distinct names interned so far */
+int intern_count(CompilationContext *ctx) {
+    return ctx->names.count;
+}
+
+/* Forget every interned name */
+void reset_intern_table(CompilationContext *ctx) {
+    free(ctx->names.slots);
+    free(ctx->names.by_id);
+    memset(&ctx->names, 0, sizeof(InternTable));
+    arena_release(REGION(ctx, REGION_NAMES));
+}
+
+/* Create an empty work stack */
+void stack_init(WorkStack *stack, size_t item_size) {
+    stack->items = NULL;
+    stack->item_size = item_size;
+    stack->count = 0;
+    stack->capacity = 0;
+    stack->arena = NULL;
+}
+
+/* Create an empty work stack whose items live in a region
+ * stack_free is then optional; the items go with the region.
+ */
+void stack_init_in(WorkStack *stack, size_t item_size, Arena *arena) {
+    stack_init(stack, item_size);
+    stack->arena = arena;
+}
+
+/* Push an uninitialized item and return it
+ * The pointer is valid until the next push.
+ */
+void *stack_push(WorkStack *stack) {
+    if (stack->count == stack->capacity) {
+        int capacity = stack->capacity ? stack->capacity * 2 : 64;
+        if (stack->arena) {
+            stack->items = (char *)arena_grow(stack->arena, stack->items, stack->capacity * stack->item_size,
+                                              capacity * stack->item_size);
+        } else {
+            stack->items = (char *)safe_realloc(stack->items, capacity * stack->item_size);
+        }
+        stack->capacity = capacity;
+    }
+    return stack->items + (size_t)stack->count++ * stack->item_size;
+}
+
+/* Get the top item without removing it */
+void *stack_top(WorkStack *stack) {
+    return stack->items + (size_t)(stack->count - 1) * stack->item_size;
+}
+
+/* Remove the top item and return it
+ * The pointer is valid until the next push.
+ */
+void *stack_pop(WorkStack *stack) {
+    return stack->items + (size_t)--stack->count * stack->item_size;
+}
+
+/* Free a work stack's storage */
+void stack_free(WorkStack *stack) {
+    Arena *arena = stack->arena;
+    if (arena == NULL) free(stack->items);
+    stack_init_in(stack, stack->item_size, arena);
+}
+
+/* Shared state of one run_parallel call */
+typedef struct {
+    void (*task)(void *arg, int index);
+    void *arg;
+    int count;
+    int next;                  /* Next index to claim */
+} ParallelLoop;
+
+/* Claim and run indices until none are left */
+static void *parallel_worker(void *data) {
+    ParallelLoop *loop = (ParallelLoop *)data;
+    int index;
+    while ((index = __atomic_fetch_add(&loop->next, 1, __ATOMIC_RELAXED)) < loop->count) {
+        loop->task(loop->arg, index);
+    }
+    return NULL;
+}
+
+/* Run task(arg, i) for every i in [0, count) on up to 'jobs' threads
+ *
+ * The calling thread takes part, so with one job (or one item) no thread
+ * is started and the items simply run in order. Returns once every call
+ * has finished. A job count of zero or less means one per online core.
+ */
+void run_parallel(int count, int jobs, void (*task)(void *arg, int index), void *arg) {
+    if (jobs <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = (cores > 0) ? (int)cores : 1;
+    }
+    if (jobs > count) jobs = count;
+
+    ParallelLoop loop = { task, arg, count, 0 };
+    if (jobs <= 1) {
+        parallel_worker(&loop);
+        return;
+    }
+
+    pthread_t *workers = (pthread_t *)safe_malloc((jobs - 1) * sizeof(pthread_t));
+    int started = 0;
+    while (started < jobs - 1 &&
+           pthread_create(&workers[started], NULL, parallel_worker, &loop) == 0) {
+        started++;
+    }
+    parallel_worker(&loop);
+    for (int w = 0; w < started; w++) {
+        pthread_join(workers[w], NULL);
+    }
+    free(workers);
+}
+
 /* Open a file */
 FILE *open_file(const char *filename, const char *mode) {
     FILE *file = fopen(filename, mode);
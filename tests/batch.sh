@@ -0,0 +1,59 @@
+#!/bin/sh
+#
+# Batch test: compile the test programs once per process and then in one
+# batch run, with one worker and with several. The assembly must match
+# the single-file compiles and the batch report must not depend on the
+# number of workers. With -q a successful batch prints nothing.
+#
+# Usage: tests/batch.sh [compiler] [jobs]
+
+CMINUS=${1:-./cminus}
+JOBS=${2:-4}
+case "$CMINUS" in
+    /*) ;;
+    *) CMINUS="$(pwd)/$CMINUS" ;;
+esac
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+cp tests/*.cm "$tmp/"
+cd "$tmp" || exit 1
+ls *.cm > units.txt
+
+status=0
+for level in -O0 -O2; do
+    for prog in *.cm; do
+        "$CMINUS" $level "$prog" > /dev/null 2>&1
+        mv "${prog%.cm}.s" "${prog%.cm}.expected"
+    done
+
+    for jobs in 1 "$JOBS"; do
+        printf "Batch %s with %s worker(s)... " "$level" "$jobs"
+        "$CMINUS" $level -j "$jobs" @units.txt 2>&1 \
+            | sed 's/[0-9]* worker(s)/N worker(s)/' > "report.$jobs"
+        result=ok
+        for prog in *.cm; do
+            cmp -s "${prog%.cm}.s" "${prog%.cm}.expected" || result="FAILED ($prog differs)"
+        done
+        if [ "$jobs" != 1 ] && ! cmp -s report.1 "report.$jobs"; then
+            result="FAILED (report differs from one worker)"
+        fi
+        echo "$result"
+        [ "$result" = ok ] || status=1
+    done
+done
+
+printf "Batch -q with %s worker(s)... " "$JOBS"
+"$CMINUS" -q -j "$JOBS" @units.txt > quiet.log 2>&1
+if [ $? != 0 ]; then
+    echo "FAILED (exit status)"
+    status=1
+elif [ -s quiet.log ]; then
+    echo "FAILED (printed output on success)"
+    status=1
+else
+    echo ok
+fi
+
+exit $status
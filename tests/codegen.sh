@@ -0,0 +1,166 @@
+#!/bin/sh
+#
+# Code generation test: compile programs that the back end once got
+# wrong, run each under cminus-sim at every optimization level and check
+# its output.
+#
+# Usage: tests/codegen.sh [compiler] [simulator]
+
+CMINUS=${1:-./cminus}
+SIM=${2:-./cminus-sim}
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+status=0
+
+# check NAME EXPECTED-OUTPUT
+#   The program is read from standard input; its output lines are
+#   joined with spaces.
+check() {
+    cat > "$tmp/$1.cm"
+    for level in -O0 -O1 -O2 -O3; do
+        printf "Run %-20s %s... " "$1" "$level"
+        rm -f "$tmp/$1.s"
+        if ! "$CMINUS" -q $level "$tmp/$1.cm" > "$tmp/$1.log" 2>&1; then
+            result="FAILED (does not compile)"
+        else
+            output=$("$SIM" -q -m 1000000 "$tmp/$1.s" < /dev/null 2>&1 | tr '\n' ' ')
+            if [ "$output" = "$2 " ]; then
+                result=ok
+            else
+                result="FAILED (output '$output')"
+            fi
+        fi
+        echo "$result"
+        [ "$result" = ok ] || status=1
+    done
+}
+
+# Both operands constant once propagation has run; they need two
+# scratch registers
+check constants "5 12 1" <<'CM'
+void main(void) {
+    int a;
+    int b;
+    a = 7;
+    b = 2;
+    output(a - b);
+    output(a + 5);
+    output(b < a);
+}
+CM
+
+# Values cached in registers must reach memory before a label, a
+# branch or a call, and nothing cached survives a label or a call
+check flush "6 19 4" <<'CM'
+int triple(int a) {
+    int y;
+    y = a * 3;
+    return y;
+}
+void main(void) {
+    int i;
+    int s;
+    i = 0;
+    s = 0;
+    while (i < 4) {
+        s = s + i;
+        i = i + 1;
+    }
+    output(s);
+    i = 4;
+    s = triple(5);
+    output(s + i);
+    output(i);
+}
+CM
+
+# Arguments past the fourth get stack space of their own instead of
+# the caller's locals
+check arguments "15 7" <<'CM'
+int sum(int a, int b, int c, int d, int e) {
+    return a + b + c + d + e;
+}
+void main(void) {
+    int x;
+    x = 7;
+    output(sum(1, 2, 3, 4, 5));
+    output(x);
+}
+CM
+
+# Operands are read before the destination gets a register, and a
+# register the instruction reads is never handed out for its result
+check operands "3 27 20" <<'CM'
+void main(void) {
+    int a;
+    int b;
+    int c;
+    int d;
+    int e;
+    int f;
+    int g;
+    int h;
+    int i;
+    a = 1;
+    b = 2;
+    c = 3;
+    d = 4;
+    e = 5;
+    f = 6;
+    g = 7;
+    h = 8;
+    i = 9;
+    a = a + b;
+    c = c + a;
+    e = e + c;
+    g = g + e;
+    i = i + g;
+    output(a);
+    output(i);
+    output(h + d + f + b);
+}
+CM
+
+# More temporaries live at once than there are registers: each spilled
+# temporary needs a slot of its own to come back from
+check temporaries "65" <<'CM'
+void main(void) {
+    int a;
+    int b;
+    int c;
+    int d;
+    a = 1;
+    b = 2;
+    c = 3;
+    d = 4;
+    output(a * b + (c * d + (a * c + (b * d + (a * d + (b * c + (a * a + (b * b + (c * c + d * d)))))))));
+}
+CM
+
+# A copy and its source share a register, a dead copy is dropped, and
+# a copy live across a call keeps a register of its own
+check copies "33 3" <<'CM'
+int twice(int a) {
+    return a + a;
+}
+void main(void) {
+    int i;
+    int m;
+    int s;
+    int dead;
+    i = 0;
+    s = 0;
+    while (i < 5) {
+        m = (i + 3) / 2;
+        dead = m;
+        s = s + twice(m) + m;
+        i = i + 1;
+    }
+    output(s);
+    output(m);
+}
+CM
+
+exit $status
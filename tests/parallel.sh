@@ -0,0 +1,42 @@
+#!/bin/sh
+#
+# Parallel back end test: a program with many functions must compile to
+# the same assembly and report whether its functions are optimized and
+# lowered on one thread or on several.
+#
+# Usage: tests/parallel.sh [compiler] [threads] [functions]
+
+CMINUS=${1:-./cminus}
+THREADS=${2:-8}
+FUNCTIONS=${3:-300}
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+awk -v n="$FUNCTIONS" 'BEGIN {
+    print "int total; int table[10];";
+    for (f = 0; f < n; f++) {
+        printf "int f%d(int a, int b) { int x; int y; x = a * %d + b; y = 0;", f, f % 7 + 1;
+        printf " while (x > 10) { if (x != 3) { x = x - 3; y = y + 1; } else { x = x / 2; } }";
+        printf " table[%d] = x + y; total = total + y; return x + y * 2; }\n", f % 10;
+    }
+    print "void main(void) { int s; s = 0;";
+    for (f = 0; f < n; f++) printf "s = s + f%d(%d, s);\n", f, f;
+    print "output(s); }";
+}' > "$tmp/functions.cm"
+
+status=0
+for level in -O0 -O1 -O2 -O3; do
+    printf "Parallel %s with %s thread(s)... " "$level" "$THREADS"
+    "$CMINUS" $level -t 1 -o "$tmp/functions.s" "$tmp/functions.cm" > "$tmp/serial.log" 2>&1
+    mv "$tmp/functions.s" "$tmp/serial.s"
+    "$CMINUS" $level -t "$THREADS" -o "$tmp/functions.s" "$tmp/functions.cm" > "$tmp/parallel.log" 2>&1
+    if cmp -s "$tmp/serial.s" "$tmp/functions.s" && cmp -s "$tmp/serial.log" "$tmp/parallel.log"; then
+        echo "ok"
+    else
+        echo "FAILED (output differs from one thread)"
+        status=1
+    fi
+done
+
+exit $status
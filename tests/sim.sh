@@ -0,0 +1,138 @@
+#!/bin/sh
+#
+# Simulator test: run hand-written MIPS programs under cminus-sim and
+# check their output, exit status and dynamic counts.
+#
+# Usage: tests/sim.sh [simulator]
+
+SIM=${1:-./cminus-sim}
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+status=0
+
+# check NAME EXPECTED-OUTPUT EXPECTED-STATS [INPUT]
+#   EXPECTED-STATS is a list of "key": value fragments from the JSON line
+check() {
+    printf "Simulate %-22s... " "$1"
+    printf '%b' "${4:-}" | "$SIM" --json "$tmp/$1.s" > "$tmp/$1.out" 2> "$tmp/$1.stats"
+    code=$?
+    result=ok
+    if [ "$code" != 0 ]; then
+        result="FAILED (exit $code)"
+    elif [ "$(cat "$tmp/$1.out")" != "$2" ]; then
+        result="FAILED (output '$(cat "$tmp/$1.out")')"
+    else
+        for field in $3; do
+            grep -q "$(echo "$field" | sed 's/=/": /; s/^/"/')" "$tmp/$1.stats" \
+                || result="FAILED (expected $field)"
+        done
+    fi
+    echo "$result"
+    [ "$result" = ok ] || { cat "$tmp/$1.stats"; status=1; }
+}
+
+# Sum a .word array in a loop: 3 setup + 3 x 7 loop + 8 tail instructions
+cat > "$tmp/sum.s" <<'ASM'
+.data
+values: .word 3, 4, 5
+msg:    .asciiz "sum="
+.text
+.globl main
+main:
+    la $t0, values
+    li $t1, 0
+    li $t2, 0
+loop:
+    sll $t3, $t2, 2
+    add $t3, $t3, $t0
+    lw $t4, 0($t3)
+    add $t1, $t1, $t4
+    addi $t2, $t2, 1
+    slt $t5, $t2, 3          # pseudo form with an immediate
+    bnez $t5, loop
+    li $v0, 4
+    la $a0, msg
+    syscall
+    move $a0, $t1
+    li $v0, 1
+    syscall
+    li $v0, 10
+    syscall
+ASM
+check sum "sum=12" "instructions=32 loads=3 stores=0 branches=3 branches_taken=2 syscalls=3"
+
+# Calls, the stack, set pseudo-instructions and input
+cat > "$tmp/calls.s" <<'ASM'
+.data
+newline: .asciiz "\n"
+.text
+main:
+    li $v0, 5
+    syscall
+    move $a0, $v0
+    jal twice
+    move $s0, $v0
+    sle $t0, $s0, 10
+    sgt $t1, $s0, 10
+    seq $t2, $s0, 14
+    sne $t3, $s0, 14
+    sge $t4, $s0, 14
+    li $t5, 1000
+    mul $t0, $t0, $t5
+    li $t5, 100
+    mul $t1, $t1, $t5
+    li $t5, 10
+    mul $t2, $t2, $t5
+    add $a0, $t0, $t1
+    add $a0, $a0, $t2
+    add $a0, $a0, $t3
+    add $a0, $a0, $t4
+    li $v0, 1
+    syscall
+    li $v0, 4
+    la $a0, newline
+    syscall
+    div $s0, $s0, 4
+    rem $a0, $s0, 2
+    li $v0, 17
+    syscall
+twice:
+    addi $sp, $sp, -8
+    sw $ra, 4($sp)
+    sw $a0, 0($sp)
+    lw $t0, 0($sp)
+    add $v0, $t0, $t0
+    lw $ra, 4($sp)
+    addi $sp, $sp, 8
+    jr $ra
+ASM
+printf "Simulate %-22s... " "exit2"
+printf '7\n' | "$SIM" -q "$tmp/calls.s" > "$tmp/exit.out" 2>&1
+if [ $? = 1 ]; then echo ok; else echo "FAILED (expected exit status 1)"; status=1; fi
+check calls "1001" "calls=1 loads=2 stores=2 syscalls=4" "5\n"
+
+# Faults are reported, not crashed through
+cat > "$tmp/fault.s" <<'ASM'
+.text
+main:
+    li $t0, 64
+    lw $t1, 0($t0)
+ASM
+printf "Simulate %-22s... " "bad address"
+if "$SIM" -q "$tmp/fault.s" 2> "$tmp/fault.err" || ! grep -q "bad address" "$tmp/fault.err"; then
+    echo "FAILED"
+    status=1
+else
+    echo ok
+fi
+
+# The hand-written examples
+cp examples/hello_mips.s examples/simple_math.s "$tmp/"
+check hello_mips "Hello from MIPS!
+42" "syscalls=4"
+check simple_math "Computing 5 + 3 = 8
+Computing 10 * 4 = 40" "branches=0"
+
+exit $status
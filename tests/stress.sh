@@ -0,0 +1,82 @@
+#!/bin/sh
+#
+# Stress test: compile very deeply nested programs under a fixed memory
+# budget. The compiler must succeed without running out of stack, both
+# with code generation (-O0, -O2) and with analysis only (-n).
+#
+# Usage: tests/stress.sh [compiler] [depth]
+#   STRESS_MEMORY_KB overrides the address-space budget (default 1 GiB).
+
+CMINUS=${1:-./cminus}
+DEPTH=${2:-1000000}
+BUDGET_KB=${STRESS_MEMORY_KB:-1048576}
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+# x = (1 + (1 + ( ... 1 ... )))
+awk -v n="$DEPTH" 'BEGIN {
+    printf "void main(void) { int x; x = ";
+    for (i = 0; i < n; i++) printf "(1 + ";
+    printf "1";
+    for (i = 0; i < n; i++) printf ")";
+    print "; output(x); }";
+}' > "$tmp/nested.cm"
+
+# x = 1 + 1 + ... + 1 (left-deep)
+awk -v n="$DEPTH" 'BEGIN {
+    printf "void main(void) { int x; x = 1";
+    for (i = 1; i < n; i++) printf " + 1";
+    print "; output(x); }";
+}' > "$tmp/chain.cm"
+
+# if (...) ... else if (...) ... (one tenth of the depth)
+awk -v n="$DEPTH" 'BEGIN {
+    print "void main(void) { int x; x = input();";
+    for (i = 0; i < n / 10; i++) printf "if (x == %d) output(%d); else ", i, i;
+    print "output(0-1); }";
+}' > "$tmp/elseif.cm"
+
+# if (x) { if (x) { ... output(x); ... } } (one tenth of the depth)
+awk -v n="$DEPTH" 'BEGIN {
+    print "void main(void) { int x; x = input();";
+    for (i = 0; i < n / 10; i++) printf "if (x) {\n";
+    print "output(x);";
+    for (i = 0; i < n / 10; i++) printf "}\n";
+    print "}";
+}' > "$tmp/if.cm"
+
+# while (x) { while (x) { ... x = x - 1; ... } } (one tenth of the depth)
+awk -v n="$DEPTH" 'BEGIN {
+    print "void main(void) { int x; x = input();";
+    for (i = 0; i < n / 10; i++) printf "while (x) {\n";
+    print "x = x - 1;";
+    for (i = 0; i < n / 10; i++) printf "}\n";
+    print "output(x); }";
+}' > "$tmp/while.cm"
+
+# { { ... output(x); ... } } (one tenth of the depth)
+awk -v n="$DEPTH" 'BEGIN {
+    print "void main(void) { int x; x = input();";
+    for (i = 0; i < n / 10; i++) printf "{\n";
+    print "output(x);";
+    for (i = 0; i < n / 10; i++) printf "}\n";
+    print "}";
+}' > "$tmp/block.cm"
+
+status=0
+for prog in nested chain elseif if while block; do
+    for level in -n -O0 -O2; do
+        printf "Stress %-8s %s (depth %d)... " "$prog" "$level" "$DEPTH"
+        if (ulimit -v "$BUDGET_KB"; "$CMINUS" $level -o "$tmp/$prog.s" "$tmp/$prog.cm") \
+                > "$tmp/log" 2>&1; then
+            echo "ok"
+        else
+            echo "FAILED"
+            tail -5 "$tmp/log"
+            status=1
+        fi
+    done
+done
+
+exit $status